@@ -4,13 +4,29 @@
 
 #include <wheels/allocators/cstdlib_allocator.hpp>
 #include <wheels/containers/array.hpp>
+#include <wheels/containers/bloom_filter.hpp>
+#include <wheels/containers/concurrent_hash_map.hpp>
+#include <wheels/containers/dense_hash_map.hpp>
+#include <wheels/containers/frozen_hash_map.hpp>
+#include <wheels/containers/hash_map.hpp>
 #include <wheels/containers/hash_set.hpp>
+#include <wheels/containers/hybrid_set.hpp>
+#include <wheels/containers/mpmc_queue.hpp>
 #include <wheels/containers/pair.hpp>
+#include <wheels/containers/ring_buffer.hpp>
+#include <wheels/containers/small_array.hpp>
 #include <wheels/containers/small_map.hpp>
 #include <wheels/containers/small_set.hpp>
+#include <wheels/containers/spsc_queue.hpp>
+#include <wheels/containers/string.hpp>
 #include <wheels/containers/inline_array.hpp>
+#include <wheels/containers/node_hash_map.hpp>
+#include <wheels/owning_ptr.hpp>
 
+#include <cmath>
 #include <cstdlib>
+#include <mutex>
+#include <thread>
 #include <unordered_set>
 
 using namespace wheels;
@@ -182,6 +198,226 @@ BENCHMARK(empty_array_push_uint32_t)
     ->Arg(2048)
     ->Arg(8096);
 
+// Hides CstdlibAllocator::reallocate to compare against the allocate + copy
+// growth path
+class NoReallocateAllocator : public Allocator
+{
+  public:
+    [[nodiscard]] virtual void *allocate(size_t num_bytes) noexcept override
+    {
+        return m_allocator.allocate(num_bytes);
+    }
+
+    virtual void deallocate(void *ptr) noexcept override
+    {
+        m_allocator.deallocate(ptr);
+    }
+
+  private:
+    CstdlibAllocator m_allocator;
+};
+
+template <typename Alloc>
+static void large_array_push_uint32_t(benchmark::State &state)
+{
+    Alloc allocator;
+
+    uint32_t const object_count = (uint32_t)state.range(0);
+
+    for (auto _ : state)
+    {
+        Array<uint32_t> arr{allocator, 0};
+        for (uint32_t i = 0; i < object_count; ++i)
+            arr.push_back(i);
+        benchmark::DoNotOptimize(arr.data());
+    }
+}
+BENCHMARK(large_array_push_uint32_t<CstdlibAllocator>)
+    ->Arg(100'000'000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(large_array_push_uint32_t<NoReallocateAllocator>)
+    ->Arg(100'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+template <typename Growth>
+static void array_growth_push_uint32_t(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    uint32_t const object_count = (uint32_t)state.range(0);
+
+    size_t capacity = 0;
+    for (auto _ : state)
+    {
+        Array<uint32_t, Growth> arr{allocator, 0};
+        for (uint32_t i = 0; i < object_count; ++i)
+            arr.push_back(i);
+        benchmark::DoNotOptimize(arr.data());
+        capacity = arr.capacity();
+    }
+    state.counters["overshoot"] = (double)capacity / (double)object_count;
+}
+BENCHMARK(array_growth_push_uint32_t<ArrayGrowth<2, 1>>)
+    ->Arg(10'000'000)
+    ->Arg(17'000'000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(array_growth_push_uint32_t<ArrayGrowth<3, 2>>)
+    ->Arg(10'000'000)
+    ->Arg(17'000'000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(array_growth_push_uint32_t<PageRoundedGrowth<ArrayGrowth<3, 2>>>)
+    ->Arg(10'000'000)
+    ->Arg(17'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+// Builds a batch of short lists, like the typical adjacency or per-item lists
+template <typename Arr>
+static void short_lists_push_uint32_t(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    uint32_t const list_length = (uint32_t)state.range(0);
+    uint32_t const list_count = 1000;
+
+    for (auto _ : state)
+    {
+        for (uint32_t j = 0; j < list_count; ++j)
+        {
+            Arr arr{allocator};
+            for (uint32_t i = 0; i < list_length; ++i)
+                arr.push_back(i);
+            benchmark::DoNotOptimize(arr.data());
+        }
+    }
+}
+BENCHMARK(short_lists_push_uint32_t<Array<uint32_t>>)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
+BENCHMARK(short_lists_push_uint32_t<SmallArray<uint32_t, 8>>)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
+
+// Filtering pass that drops every third value
+static void array_filter_erase_loop(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    uint32_t const object_count = (uint32_t)state.range(0);
+    Array<uint32_t> arr{allocator, object_count};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        arr.clear();
+        for (uint32_t i = 0; i < object_count; ++i)
+            arr.push_back(i);
+        state.ResumeTiming();
+
+        for (size_t i = 0; i < arr.size();)
+        {
+            if (arr[i] % 3 == 0)
+                arr.erase(i);
+            else
+                i++;
+        }
+        benchmark::DoNotOptimize(arr.data());
+    }
+}
+BENCHMARK(array_filter_erase_loop)->Arg(1000)->Arg(10000)->Arg(100000);
+
+static void array_filter_erase_if(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    uint32_t const object_count = (uint32_t)state.range(0);
+    Array<uint32_t> arr{allocator, object_count};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        arr.clear();
+        for (uint32_t i = 0; i < object_count; ++i)
+            arr.push_back(i);
+        state.ResumeTiming();
+
+        size_t const removed_count =
+            arr.erase_if([](uint32_t const &v) { return v % 3 == 0; });
+        benchmark::DoNotOptimize(removed_count);
+        benchmark::DoNotOptimize(arr.data());
+    }
+}
+BENCHMARK(array_filter_erase_if)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Streaming stage that keeps a window of the latest values, pushing one to the
+// back and consuming one from the front per step
+static void array_queue_push_pop_front(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    uint32_t const window_size = (uint32_t)state.range(0);
+    Array<uint32_t> queue{allocator, window_size + 1};
+    for (uint32_t i = 0; i < window_size; ++i)
+        queue.push_back(i);
+
+    uint32_t value = window_size;
+    for (auto _ : state)
+    {
+        queue.push_back(value++);
+        uint32_t const front = queue.front();
+        queue.erase(0);
+        benchmark::DoNotOptimize(front);
+    }
+}
+BENCHMARK(array_queue_push_pop_front)->Arg(16)->Arg(1000)->Arg(100000);
+
+static void ring_buffer_push_pop_front(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    uint32_t const window_size = (uint32_t)state.range(0);
+    RingBuffer<uint32_t> queue{allocator, window_size + 1};
+    for (uint32_t i = 0; i < window_size; ++i)
+        queue.push_back(i);
+
+    uint32_t value = window_size;
+    for (auto _ : state)
+    {
+        queue.push_back(value++);
+        uint32_t const front = queue.pop_front();
+        benchmark::DoNotOptimize(front);
+    }
+}
+BENCHMARK(ring_buffer_push_pop_front)->Arg(16)->Arg(1000)->Arg(100000);
+
+// Simulates reusing a buffer for reads where the contents are overwritten
+// right after the resize
+template <bool Uninitialized>
+static void string_resize_overwrite(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    size_t const byte_count = (size_t)state.range(0);
+    String str{allocator, byte_count};
+
+    for (auto _ : state)
+    {
+        str.clear();
+        if constexpr (Uninitialized)
+            str.resize_uninitialized(byte_count);
+        else
+            str.resize(byte_count);
+        memset(str.data(), 'a', byte_count);
+        benchmark::DoNotOptimize(str.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(string_resize_overwrite<false>)->Arg(1 << 16)->Arg(1 << 26);
+BENCHMARK(string_resize_overwrite<true>)->Arg(1 << 16)->Arg(1 << 26);
+
 static void reserved_std_vector_push_clear_uint32_t(benchmark::State &state)
 {
     CstdlibAllocator allocator;
@@ -392,12 +628,81 @@ BENCHMARK(hash_set_insert<uint32_t, 8096>);
 BENCHMARK(hash_set_insert<DtorObj, 8096>);
 
 template <typename T, uint32_t N>
+static void hash_set_insert_grow(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    while (state.KeepRunning())
+    {
+        HashSet<T, Hash<T>> set{allocator};
+        INLINE_ASM("nop # Start loop");
+        INLINE_ASM("nop");
+        INLINE_ASM("nop");
+        for (uint32_t i = 0; i < N; ++i)
+            set.insert(T{i});
+        INLINE_ASM("nop");
+        INLINE_ASM("nop");
+        INLINE_ASM("nop # End loop");
+    }
+}
+BENCHMARK(hash_set_insert_grow<uint32_t, 128>);
+BENCHMARK(hash_set_insert_grow<DtorObj, 128>);
+BENCHMARK(hash_set_insert_grow<uint32_t, 2048>);
+BENCHMARK(hash_set_insert_grow<DtorObj, 2048>);
+BENCHMARK(hash_set_insert_grow<uint32_t, 8096>);
+BENCHMARK(hash_set_insert_grow<DtorObj, 8096>);
+BENCHMARK(hash_set_insert_grow<uint32_t, 262144>);
+
+// Builds sets of mostly a few values with the occasional large one
+template <class Set>
+static void set_insert_mixed_sizes(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    uint32_t const large_size = (uint32_t)state.range(0);
+    uint32_t iteration = 0;
+    while (state.KeepRunning())
+    {
+        uint32_t const size = iteration++ % 64 == 0 ? large_size : 3;
+        Set set{allocator};
+        for (uint32_t i = 0; i < size; ++i)
+            set.insert(i);
+        benchmark::DoNotOptimize(set.contains(size / 2));
+    }
+}
+BENCHMARK(set_insert_mixed_sizes<HashSet<uint32_t>>)->Arg(3)->Arg(1000);
+BENCHMARK(set_insert_mixed_sizes<HybridSet<uint32_t, 8>>)->Arg(3)->Arg(1000);
+
+template <typename K, typename V, uint32_t N>
+static void hash_map_insert_grow(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    while (state.KeepRunning())
+    {
+        HashMap<K, V> map{allocator};
+        INLINE_ASM("nop # Start loop");
+        INLINE_ASM("nop");
+        INLINE_ASM("nop");
+        for (uint32_t i = 0; i < N; ++i)
+            map.insert_or_assign(K{i}, V{i});
+        INLINE_ASM("nop");
+        INLINE_ASM("nop");
+        INLINE_ASM("nop # End loop");
+    }
+}
+BENCHMARK(hash_map_insert_grow<uint32_t, uint32_t, 2048>);
+BENCHMARK(hash_map_insert_grow<uint32_t, DtorObj, 2048>);
+BENCHMARK(hash_map_insert_grow<uint32_t, uint32_t, 262144>);
+
+template <
+    typename T, uint32_t N, SmallStorage Storage = SmallStorage::Unsorted>
 static void small_set_insert(benchmark::State &state)
 {
 
     while (state.KeepRunning())
     {
-        SmallSet<T, N> set;
+        SmallSet<T, N, Storage> set;
         INLINE_ASM("nop # Start loop");
         INLINE_ASM("nop");
         INLINE_ASM("nop");
@@ -416,8 +721,13 @@ BENCHMARK(small_set_insert<uint32_t, 16>);
 BENCHMARK(small_set_insert<DtorObj, 16>);
 BENCHMARK(small_set_insert<uint32_t, 32>);
 BENCHMARK(small_set_insert<DtorObj, 32>);
+BENCHMARK(small_set_insert<uint32_t, 64>);
+BENCHMARK(small_set_insert<DtorObj, 64>);
 BENCHMARK(small_set_insert<uint32_t, 128>);
 BENCHMARK(small_set_insert<DtorObj, 128>);
+BENCHMARK(small_set_insert<uint32_t, 32, SmallStorage::Sorted>);
+BENCHMARK(small_set_insert<uint32_t, 64, SmallStorage::Sorted>);
+BENCHMARK(small_set_insert<uint32_t, 128, SmallStorage::Sorted>);
 
 template <typename T, uint32_t N>
 static void unordered_set_contains_seq_numbers(benchmark::State &state)
@@ -471,10 +781,11 @@ BENCHMARK(hash_set_contains_seq_numbers<DtorObj, 2048>);
 BENCHMARK(hash_set_contains_seq_numbers<uint32_t, 8096>);
 BENCHMARK(hash_set_contains_seq_numbers<DtorObj, 8096>);
 
-template <typename T, uint32_t N>
+template <
+    typename T, uint32_t N, SmallStorage Storage = SmallStorage::Unsorted>
 static void small_set_contains_seq_numbers(benchmark::State &state)
 {
-    SmallSet<T, N> set;
+    SmallSet<T, N, Storage> set;
     for (uint32_t i = 0; i < N; ++i)
         set.insert(i);
 
@@ -489,8 +800,13 @@ BENCHMARK(small_set_contains_seq_numbers<uint32_t, 16>);
 BENCHMARK(small_set_contains_seq_numbers<DtorObj, 16>);
 BENCHMARK(small_set_contains_seq_numbers<uint32_t, 32>);
 BENCHMARK(small_set_contains_seq_numbers<DtorObj, 32>);
+BENCHMARK(small_set_contains_seq_numbers<uint32_t, 64>);
+BENCHMARK(small_set_contains_seq_numbers<DtorObj, 64>);
 BENCHMARK(small_set_contains_seq_numbers<uint32_t, 128>);
 BENCHMARK(small_set_contains_seq_numbers<DtorObj, 128>);
+BENCHMARK(small_set_contains_seq_numbers<uint32_t, 32, SmallStorage::Sorted>);
+BENCHMARK(small_set_contains_seq_numbers<uint32_t, 64, SmallStorage::Sorted>);
+BENCHMARK(small_set_contains_seq_numbers<uint32_t, 128, SmallStorage::Sorted>);
 
 template <typename T, uint32_t N>
 static void unordered_set_doesnt_contain_uint32_t(benchmark::State &state)
@@ -565,6 +881,833 @@ BENCHMARK(small_set_doesnt_contain<DtorObj, 32>);
 BENCHMARK(small_set_doesnt_contain<uint32_t, 128>);
 BENCHMARK(small_set_doesnt_contain<DtorObj, 128>);
 
+template <typename K, typename V, class Layout, uint32_t N>
+static void hash_map_find_hit(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<K, V, Hash<K>, Layout> map{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+        map.insert_or_assign(K{i}, V{i});
+
+    while (state.KeepRunning())
+    {
+        V const *value = map.find(K{(uint32_t)rand() % N});
+        benchmark::DoNotOptimize(*value);
+    }
+}
+BENCHMARK(hash_map_find_hit<uint32_t, uint32_t, SplitLayout, 128>);
+BENCHMARK(hash_map_find_hit<uint32_t, uint32_t, InterleavedLayout, 128>);
+BENCHMARK(hash_map_find_hit<uint32_t, uint32_t, SplitLayout, 8096>);
+BENCHMARK(hash_map_find_hit<uint32_t, uint32_t, InterleavedLayout, 8096>);
+BENCHMARK(hash_map_find_hit<uint32_t, uint32_t, SplitLayout, 262144>);
+BENCHMARK(hash_map_find_hit<uint32_t, uint32_t, InterleavedLayout, 262144>);
+BENCHMARK(hash_map_find_hit<uint32_t, DtorObj, SplitLayout, 128>);
+BENCHMARK(hash_map_find_hit<uint32_t, DtorObj, InterleavedLayout, 128>);
+BENCHMARK(hash_map_find_hit<uint32_t, DtorObj, SplitLayout, 8096>);
+BENCHMARK(hash_map_find_hit<uint32_t, DtorObj, InterleavedLayout, 8096>);
+BENCHMARK(hash_map_find_hit<uint32_t, DtorObj, SplitLayout, 262144>);
+BENCHMARK(hash_map_find_hit<uint32_t, DtorObj, InterleavedLayout, 262144>);
+BENCHMARK(hash_map_find_hit<DtorObj, uint32_t, SplitLayout, 128>);
+BENCHMARK(hash_map_find_hit<DtorObj, uint32_t, InterleavedLayout, 128>);
+BENCHMARK(hash_map_find_hit<DtorObj, uint32_t, SplitLayout, 8096>);
+BENCHMARK(hash_map_find_hit<DtorObj, uint32_t, InterleavedLayout, 8096>);
+BENCHMARK(hash_map_find_hit<DtorObj, uint32_t, SplitLayout, 262144>);
+BENCHMARK(hash_map_find_hit<DtorObj, uint32_t, InterleavedLayout, 262144>);
+BENCHMARK(hash_map_find_hit<DtorObj, DtorObj, SplitLayout, 128>);
+BENCHMARK(hash_map_find_hit<DtorObj, DtorObj, InterleavedLayout, 128>);
+BENCHMARK(hash_map_find_hit<DtorObj, DtorObj, SplitLayout, 8096>);
+BENCHMARK(hash_map_find_hit<DtorObj, DtorObj, InterleavedLayout, 8096>);
+BENCHMARK(hash_map_find_hit<DtorObj, DtorObj, SplitLayout, 262144>);
+BENCHMARK(hash_map_find_hit<DtorObj, DtorObj, InterleavedLayout, 262144>);
+
+template <uint32_t N>
+static void frozen_hash_map_find_hit(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint32_t> map{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+        map.insert_or_assign(i, i);
+
+    Array<uint8_t> const data =
+        FrozenHashMap<uint32_t, uint32_t>::freeze(allocator, map);
+    FrozenHashMap<uint32_t, uint32_t> const frozen =
+        *FrozenHashMap<uint32_t, uint32_t>::view(data.span());
+
+    while (state.KeepRunning())
+    {
+        uint32_t const *value = frozen.find((uint32_t)rand() % N);
+        benchmark::DoNotOptimize(*value);
+    }
+}
+BENCHMARK(frozen_hash_map_find_hit<128>);
+BENCHMARK(frozen_hash_map_find_hit<8096>);
+BENCHMARK(frozen_hash_map_find_hit<262144>);
+
+template <uint32_t N>
+static void dense_hash_map_find_hit(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    DenseHashMap<uint32_t, uint32_t> map{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+        map.insert_or_assign(i, i);
+
+    while (state.KeepRunning())
+    {
+        uint32_t const *value = map.find((uint32_t)rand() % N);
+        benchmark::DoNotOptimize(*value);
+    }
+}
+BENCHMARK(dense_hash_map_find_hit<128>);
+BENCHMARK(dense_hash_map_find_hit<8096>);
+BENCHMARK(dense_hash_map_find_hit<262144>);
+
+template <uint32_t N>
+static void node_hash_map_find_hit(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    NodeHashMap<uint32_t, uint32_t> map{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+        map.insert_or_assign(i, i);
+
+    while (state.KeepRunning())
+    {
+        uint32_t const *value = map.find((uint32_t)rand() % N);
+        benchmark::DoNotOptimize(*value);
+    }
+}
+BENCHMARK(node_hash_map_find_hit<128>);
+BENCHMARK(node_hash_map_find_hit<8096>);
+BENCHMARK(node_hash_map_find_hit<262144>);
+
+// Stable value pointers through HashMap need a separate allocation per value
+template <uint32_t N>
+static void hash_map_owning_ptr_find_hit(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, OwningPtr<uint32_t>> map{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+        map.insert_or_assign(i, OwningPtr<uint32_t>{allocator, i});
+
+    while (state.KeepRunning())
+    {
+        OwningPtr<uint32_t> const *value = map.find((uint32_t)rand() % N);
+        benchmark::DoNotOptimize(**value);
+    }
+}
+BENCHMARK(hash_map_owning_ptr_find_hit<128>);
+BENCHMARK(hash_map_owning_ptr_find_hit<8096>);
+BENCHMARK(hash_map_owning_ptr_find_hit<262144>);
+
+template <uint32_t N>
+static void node_hash_map_insert(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    while (state.KeepRunning())
+    {
+        NodeHashMap<uint32_t, uint32_t> map{allocator};
+        for (uint32_t i = 0; i < N; ++i)
+            map.insert_or_assign(i, i);
+        benchmark::DoNotOptimize(map.size());
+    }
+}
+BENCHMARK(node_hash_map_insert<8096>);
+
+template <uint32_t N>
+static void hash_map_owning_ptr_insert(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    while (state.KeepRunning())
+    {
+        HashMap<uint32_t, OwningPtr<uint32_t>> map{allocator};
+        for (uint32_t i = 0; i < N; ++i)
+            map.insert_or_assign(i, OwningPtr<uint32_t>{allocator, i});
+        benchmark::DoNotOptimize(map.size());
+    }
+}
+BENCHMARK(hash_map_owning_ptr_insert<8096>);
+
+// Iterates a map that has had most of its entries removed
+template <class Map, uint32_t N>
+static void hash_map_iterate_sparse(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    Map map{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+        map.insert_or_assign(i, i);
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        if (i % 8 != 0)
+            map.remove(i);
+    }
+
+    while (state.KeepRunning())
+    {
+        uint32_t sum = 0;
+        for (auto const kv : map)
+            sum += *kv.second;
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(hash_map_iterate_sparse<HashMap<uint32_t, uint32_t>, 8096>);
+BENCHMARK(hash_map_iterate_sparse<DenseHashMap<uint32_t, uint32_t>, 8096>);
+BENCHMARK(hash_map_iterate_sparse<HashMap<uint32_t, uint32_t>, 262144>);
+BENCHMARK(hash_map_iterate_sparse<DenseHashMap<uint32_t, uint32_t>, 262144>);
+
+template <uint32_t N>
+static void hash_map_for_each_sparse(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint32_t> map{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+        map.insert_or_assign(i, i);
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        if (i % 8 != 0)
+            map.remove(i);
+    }
+
+    while (state.KeepRunning())
+    {
+        uint32_t sum = 0;
+        map.for_each([&](uint32_t const &, uint32_t const &value)
+                     { sum += value; });
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(hash_map_for_each_sparse<8096>);
+BENCHMARK(hash_map_for_each_sparse<262144>);
+
+// Expiry sweep that drops a quarter of the entries, refilled between sweeps
+template <uint32_t N>
+static void hash_map_erase_if(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint32_t> map{allocator, N};
+    uint32_t next_key = 0;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        while (map.size() < N)
+        {
+            map.insert_or_assign(next_key, next_key);
+            next_key++;
+        }
+        state.ResumeTiming();
+
+        uint32_t const threshold = next_key - N + N / 4;
+        size_t const erased = map.erase_if(
+            [&](uint32_t const &, uint32_t const &value)
+            { return value < threshold; });
+        benchmark::DoNotOptimize(erased);
+    }
+}
+BENCHMARK(hash_map_erase_if<8096>);
+BENCHMARK(hash_map_erase_if<262144>);
+
+// Misses probe until an Empty slot so they show the probe length of the load
+// policy best
+template <class Policy, uint32_t N>
+static void hash_map_policy_find_miss(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint32_t, Hash<uint32_t>, SplitLayout, Policy> map{
+        allocator};
+    for (uint32_t i = 0; i < N; ++i)
+        map.insert_or_assign(i, i);
+
+    while (state.KeepRunning())
+    {
+        uint32_t const *value = map.find(N + (uint32_t)rand() % N);
+        benchmark::DoNotOptimize(value);
+    }
+
+    state.counters["capacity"] = (double)map.capacity();
+}
+BENCHMARK(hash_map_policy_find_miss<DefaultHashPolicy, 7600>);
+BENCHMARK(hash_map_policy_find_miss<HashPolicy<7, 8>, 7600>);
+BENCHMARK(hash_map_policy_find_miss<HashPolicy<1, 2>, 7600>);
+
+// Reused table that grew large once and holds a few items between clears
+template <class Policy>
+static void hash_map_clear_reused(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint32_t, Hash<uint32_t>, SplitLayout, Policy> map{
+        allocator};
+    for (uint32_t i = 0; i < 1 << 16; ++i)
+        map.insert_or_assign(i, i);
+    map.clear();
+
+    uint32_t key = 0;
+    while (state.KeepRunning())
+    {
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            map.insert_or_assign(key, i);
+            key++;
+        }
+        map.clear();
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.counters["capacity"] = (double)map.capacity();
+}
+BENCHMARK(hash_map_clear_reused<DefaultHashPolicy>);
+BENCHMARK(hash_map_clear_reused<HashPolicy<15, 16, HashClear::Tracked>>);
+BENCHMARK(hash_map_clear_reused<HashPolicy<15, 16, HashClear::Shrink>>);
+
+// Overlapping sets where half of the smaller set is in the larger one
+template <uint32_t N>
+static void hash_set_intersection(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t> a{allocator};
+    HashSet<uint32_t> b{allocator};
+    for (uint32_t i = 0; i < N; ++i)
+        a.insert(i);
+    for (uint32_t i = 0; i < N / 4; ++i)
+        b.insert(2 * i);
+
+    while (state.KeepRunning())
+    {
+        HashSet<uint32_t> const result = intersection(allocator, a, b);
+        benchmark::DoNotOptimize(result.size());
+    }
+}
+BENCHMARK(hash_set_intersection<1024>);
+BENCHMARK(hash_set_intersection<65536>);
+
+template <uint32_t N>
+static void unordered_set_intersection(benchmark::State &state)
+{
+    std::unordered_set<uint32_t, Hash<uint32_t>> a;
+    std::unordered_set<uint32_t, Hash<uint32_t>> b;
+    for (uint32_t i = 0; i < N; ++i)
+        a.insert(i);
+    for (uint32_t i = 0; i < N / 4; ++i)
+        b.insert(2 * i);
+
+    while (state.KeepRunning())
+    {
+        std::unordered_set<uint32_t, Hash<uint32_t>> result;
+        for (uint32_t const v : b)
+        {
+            if (a.contains(v))
+                result.insert(v);
+        }
+        benchmark::DoNotOptimize(result.size());
+    }
+}
+BENCHMARK(unordered_set_intersection<1024>);
+BENCHMARK(unordered_set_intersection<65536>);
+
+template <uint32_t N>
+static void hash_set_difference(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t> a{allocator};
+    HashSet<uint32_t> b{allocator};
+    for (uint32_t i = 0; i < N; ++i)
+        a.insert(i);
+    for (uint32_t i = 0; i < N / 4; ++i)
+        b.insert(2 * i);
+
+    while (state.KeepRunning())
+    {
+        HashSet<uint32_t> const result = difference(allocator, a, b);
+        benchmark::DoNotOptimize(result.size());
+    }
+}
+BENCHMARK(hash_set_difference<1024>);
+BENCHMARK(hash_set_difference<65536>);
+
+template <uint32_t N>
+static void unordered_set_difference(benchmark::State &state)
+{
+    std::unordered_set<uint32_t, Hash<uint32_t>> a;
+    std::unordered_set<uint32_t, Hash<uint32_t>> b;
+    for (uint32_t i = 0; i < N; ++i)
+        a.insert(i);
+    for (uint32_t i = 0; i < N / 4; ++i)
+        b.insert(2 * i);
+
+    while (state.KeepRunning())
+    {
+        std::unordered_set<uint32_t, Hash<uint32_t>> result;
+        for (uint32_t const v : a)
+        {
+            if (!b.contains(v))
+                result.insert(v);
+        }
+        benchmark::DoNotOptimize(result.size());
+    }
+}
+BENCHMARK(unordered_set_difference<1024>);
+BENCHMARK(unordered_set_difference<65536>);
+
+template <uint32_t N>
+static void hash_set_merge(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t> a{allocator};
+    HashSet<uint32_t> b{allocator};
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        a.insert(2 * i);
+        b.insert(3 * i);
+    }
+
+    while (state.KeepRunning())
+    {
+        HashSet<uint32_t> result{allocator};
+        result.merge(a);
+        result.merge(b);
+        benchmark::DoNotOptimize(result.size());
+    }
+}
+BENCHMARK(hash_set_merge<1024>);
+BENCHMARK(hash_set_merge<65536>);
+
+template <uint32_t N>
+static void unordered_set_merge(benchmark::State &state)
+{
+    std::unordered_set<uint32_t, Hash<uint32_t>> a;
+    std::unordered_set<uint32_t, Hash<uint32_t>> b;
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        a.insert(2 * i);
+        b.insert(3 * i);
+    }
+
+    while (state.KeepRunning())
+    {
+        std::unordered_set<uint32_t, Hash<uint32_t>> result;
+        result.insert(a.begin(), a.end());
+        result.insert(b.begin(), b.end());
+        benchmark::DoNotOptimize(result.size());
+    }
+}
+BENCHMARK(unordered_set_merge<1024>);
+BENCHMARK(unordered_set_merge<65536>);
+
+// Negative cache lookups where most queries miss
+template <uint32_t N>
+static void hash_set_negative_lookup(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint64_t> set{allocator};
+    for (uint64_t i = 0; i < N; ++i)
+        set.insert(2 * i);
+
+    uint64_t i = 0;
+    while (state.KeepRunning())
+    {
+        bool const found = set.contains((uint64_t)rand() % (4 * N));
+        benchmark::DoNotOptimize(found);
+        i++;
+    }
+
+    state.counters["bytes"] =
+        (double)(set.capacity() * (sizeof(uint64_t) + 1));
+}
+BENCHMARK(hash_set_negative_lookup<8096>);
+BENCHMARK(hash_set_negative_lookup<1048576>);
+
+template <uint32_t N>
+static void bloom_filter_negative_lookup(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    BloomFilter<uint64_t> filter{allocator, N};
+    for (uint64_t i = 0; i < N; ++i)
+        filter.insert(2 * i);
+
+    while (state.KeepRunning())
+    {
+        bool const found = filter.maybe_contains((uint64_t)rand() % (4 * N));
+        benchmark::DoNotOptimize(found);
+    }
+
+    uint32_t false_positives = 0;
+    for (uint64_t i = 0; i < N; ++i)
+    {
+        if (filter.maybe_contains(2 * i + 1))
+            false_positives++;
+    }
+    state.counters["bytes"] = (double)(filter.bit_count() / 8);
+    state.counters["fpr"] = (double)false_positives / N;
+}
+BENCHMARK(bloom_filter_negative_lookup<8096>);
+BENCHMARK(bloom_filter_negative_lookup<1048576>);
+
+template <uint32_t N>
+static void bloom_filter_batch_lookup(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    BloomFilter<uint64_t> filter{allocator, N};
+    for (uint64_t i = 0; i < N; ++i)
+        filter.insert(2 * i);
+
+    Array<uint64_t> queries{allocator, 1024};
+    for (uint32_t i = 0; i < 1024; ++i)
+        queries.push_back((uint64_t)rand() % (4 * N));
+    Array<bool> results{allocator};
+    results.resize(queries.size());
+
+    while (state.KeepRunning())
+    {
+        filter.maybe_contains(queries, results.mut_span());
+        benchmark::DoNotOptimize(results.data());
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(bloom_filter_batch_lookup<8096>);
+BENCHMARK(bloom_filter_batch_lookup<1048576>);
+
+// Path-like keys that share a long prefix so that both hashing and comparing
+// them is expensive
+String long_string_key(Allocator &allocator, uint32_t i, uint32_t length)
+{
+    String key{allocator, length};
+    for (uint32_t j = 0; j + 16 < length; ++j)
+        key.push_back((char)('a' + j % 26));
+    for (uint32_t j = 0; j < 16; ++j)
+    {
+        key.push_back((char)('a' + i % 16));
+        i /= 16;
+    }
+    return key;
+}
+
+template <class Hasher, uint32_t Length, uint32_t N>
+static void hash_map_string_insert_grow(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    Array<String> keys{allocator, N};
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        keys.clear();
+        for (uint32_t i = 0; i < N; ++i)
+            keys.push_back(long_string_key(allocator, i, Length));
+        state.ResumeTiming();
+
+        HashMap<String, uint32_t, Hasher> map{allocator};
+        for (uint32_t i = 0; i < N; ++i)
+            map.insert_or_assign(WHEELS_MOV(keys[i]), uint32_t{i});
+        benchmark::DoNotOptimize(map.size());
+    }
+}
+BENCHMARK(hash_map_string_insert_grow<Hash<String>, 32, 16384>);
+BENCHMARK(hash_map_string_insert_grow<StoredHash<Hash<String>>, 32, 16384>);
+BENCHMARK(hash_map_string_insert_grow<Hash<String>, 256, 16384>);
+BENCHMARK(hash_map_string_insert_grow<StoredHash<Hash<String>>, 256, 16384>);
+BENCHMARK(hash_map_string_insert_grow<Hash<String>, 1024, 16384>);
+BENCHMARK(hash_map_string_insert_grow<StoredHash<Hash<String>>, 1024, 16384>);
+
+template <class Hasher, uint32_t Length, uint32_t N>
+static void hash_map_string_find_hit(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<String, uint32_t, Hasher> map{allocator};
+    Array<String> keys{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        keys.push_back(long_string_key(allocator, i, Length));
+        map.insert_or_assign(
+            long_string_key(allocator, i, Length), uint32_t{i});
+    }
+
+    while (state.KeepRunning())
+    {
+        uint32_t const *value = map.find(keys[(uint32_t)rand() % N]);
+        benchmark::DoNotOptimize(*value);
+    }
+}
+BENCHMARK(hash_map_string_find_hit<Hash<String>, 32, 16384>);
+BENCHMARK(hash_map_string_find_hit<StoredHash<Hash<String>>, 32, 16384>);
+BENCHMARK(hash_map_string_find_hit<Hash<String>, 1024, 16384>);
+BENCHMARK(hash_map_string_find_hit<StoredHash<Hash<String>>, 1024, 16384>);
+
+// Lookup through three cache layers where the key is usually in the last one
+template <bool SharedHash, uint32_t Length, uint32_t N>
+static void hash_map_string_layered_find(benchmark::State &state)
+{
+    CstdlibAllocator allocator;
+
+    HashMap<String, uint32_t> layers[3]{
+        HashMap<String, uint32_t>{allocator},
+        HashMap<String, uint32_t>{allocator},
+        HashMap<String, uint32_t>{allocator},
+    };
+    Array<String> keys{allocator, N};
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        keys.push_back(long_string_key(allocator, i, Length));
+        uint32_t const layer = i % 8 == 0 ? 0 : i % 8 == 1 ? 1 : 2;
+        layers[layer].insert_or_assign(
+            long_string_key(allocator, i, Length), uint32_t{i});
+    }
+
+    while (state.KeepRunning())
+    {
+        String const &key = keys[(uint32_t)rand() % N];
+        uint32_t const *value = nullptr;
+        if constexpr (SharedHash)
+        {
+            uint64_t const hash = layers[0].hash_of(key);
+            for (uint32_t i = 0; i < 3 && value == nullptr; ++i)
+                value = layers[i].find_with_hash(key, hash);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < 3 && value == nullptr; ++i)
+                value = layers[i].find(key);
+        }
+        benchmark::DoNotOptimize(*value);
+    }
+}
+BENCHMARK(hash_map_string_layered_find<false, 32, 16384>);
+BENCHMARK(hash_map_string_layered_find<true, 32, 16384>);
+BENCHMARK(hash_map_string_layered_find<false, 1024, 16384>);
+BENCHMARK(hash_map_string_layered_find<true, 1024, 16384>);
+
+constexpr uint32_t s_concurrent_key_count = 1 << 16;
+
+struct MutexHashMap
+{
+    MutexHashMap(Allocator &allocator) noexcept
+    : map{allocator}
+    {
+    }
+
+    std::mutex lock;
+    HashMap<uint32_t, uint32_t> map;
+};
+
+template <class Map> Map &concurrent_bench_map()
+{
+    static CstdlibAllocator allocator;
+    static Map map{allocator};
+    // Function statics are initialized once even with multiple threads
+    static bool const populated = [&]()
+    {
+        for (uint32_t i = 0; i < s_concurrent_key_count; ++i)
+        {
+            if constexpr (std::is_same_v<Map, MutexHashMap>)
+                map.map.insert_or_assign(i, i);
+            else
+                map.insert_or_assign(i, i);
+        }
+        return true;
+    }();
+    (void)populated;
+    return map;
+}
+
+// Read percentage is given as the argument
+template <class Map> static void concurrent_map_mixed(benchmark::State &state)
+{
+    Map &map = concurrent_bench_map<Map>();
+    uint32_t const read_percentage = (uint32_t)state.range(0);
+
+    // rand() takes a lock so use a thread local xorshift instead
+    uint32_t rng = 2463534242u + (uint32_t)state.thread_index();
+    while (state.KeepRunning())
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        uint32_t const key = rng % s_concurrent_key_count;
+        bool const read = (rng >> 16) % 100 < read_percentage;
+
+        if constexpr (std::is_same_v<Map, MutexHashMap>)
+        {
+            std::lock_guard const _lock{map.lock};
+            if (read)
+                benchmark::DoNotOptimize(map.map.find(key));
+            else
+                map.map.insert_or_assign(key, rng);
+        }
+        else
+        {
+            if (read)
+                benchmark::DoNotOptimize(map.find(key));
+            else
+                map.insert_or_assign(key, rng);
+        }
+    }
+}
+BENCHMARK(concurrent_map_mixed<MutexHashMap>)
+    ->Arg(50)
+    ->Arg(90)
+    ->Arg(99)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK(concurrent_map_mixed<ConcurrentHashMap<uint32_t, uint32_t>>)
+    ->Arg(50)
+    ->Arg(90)
+    ->Arg(99)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+constexpr size_t s_queue_capacity = 1024;
+constexpr size_t s_queue_batch_size = 32;
+
+// Bounded queue behind a lock, like the mutex guarded arrays that the lock-free
+// queues replace
+struct MutexQueue
+{
+    MutexQueue() noexcept
+    : queue{allocator, s_queue_capacity}
+    {
+    }
+
+    bool try_push(uint32_t value) noexcept
+    {
+        std::lock_guard const _lock{lock};
+        if (queue.size() == s_queue_capacity)
+            return false;
+        queue.push_back(value);
+        return true;
+    }
+
+    Optional<uint32_t> try_pop() noexcept
+    {
+        std::lock_guard const _lock{lock};
+        if (queue.empty())
+            return Optional<uint32_t>{};
+        return Optional<uint32_t>{queue.pop_front()};
+    }
+
+    CstdlibAllocator allocator;
+    std::mutex lock;
+    RingBuffer<uint32_t> queue;
+};
+
+// Yield instead of busy waiting so that the benchmarks don't stall when there
+// are fewer cores than threads
+template <class Queue> void queue_push_wait(Queue &queue, uint32_t value)
+{
+    while (!queue.try_push(value))
+        std::this_thread::yield();
+}
+
+template <class Queue> uint32_t queue_pop_wait(Queue &queue)
+{
+    Optional<uint32_t> value = queue.try_pop();
+    while (!value.has_value())
+    {
+        std::this_thread::yield();
+        value = queue.try_pop();
+    }
+    return *value;
+}
+
+// Even threads push and odd threads pop a value per iteration. All threads run
+// the same number of iterations so every pushed value gets popped.
+template <class Queue> static void queue_throughput(benchmark::State &state)
+{
+    static Queue queue;
+    bool const producer = state.thread_index() % 2 == 0;
+
+    uint32_t value = 0;
+    for (auto _ : state)
+    {
+        if (producer)
+            queue_push_wait(queue, value++);
+        else
+            benchmark::DoNotOptimize(queue_pop_wait(queue));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(queue_throughput<MutexQueue>)->ThreadRange(2, 8)->UseRealTime();
+BENCHMARK(queue_throughput<SpscQueue<uint32_t, s_queue_capacity>>)
+    ->Threads(2)
+    ->UseRealTime();
+BENCHMARK(queue_throughput<MpmcQueue<uint32_t, s_queue_capacity>>)
+    ->ThreadRange(2, 8)
+    ->UseRealTime();
+
+// Like queue_throughput but pushes and pops s_queue_batch_size values at a time
+template <class Queue>
+static void queue_batch_throughput(benchmark::State &state)
+{
+    static Queue queue;
+    bool const producer = state.thread_index() % 2 == 0;
+
+    uint32_t batch[s_queue_batch_size]{};
+    for (auto _ : state)
+    {
+        size_t count = 0;
+        while (count < s_queue_batch_size)
+        {
+            size_t const batch_count =
+                producer ? queue.try_push_batch(Span<uint32_t const>{
+                               batch + count, s_queue_batch_size - count})
+                         : queue.try_pop_batch(Span<uint32_t>{
+                               batch + count, s_queue_batch_size - count});
+            if (batch_count == 0)
+                std::this_thread::yield();
+            count += batch_count;
+        }
+        benchmark::DoNotOptimize(batch);
+    }
+    state.SetItemsProcessed(state.iterations() * s_queue_batch_size);
+}
+BENCHMARK(queue_batch_throughput<SpscQueue<uint32_t, s_queue_capacity>>)
+    ->Threads(2)
+    ->UseRealTime();
+BENCHMARK(queue_batch_throughput<MpmcQueue<uint32_t, s_queue_capacity>>)
+    ->ThreadRange(2, 8)
+    ->UseRealTime();
+
+// Latency of a handoff and back, the first thread sends a value through one
+// queue and the second one echoes it back through another
+template <class Queue> static void queue_round_trip(benchmark::State &state)
+{
+    static Queue requests;
+    static Queue responses;
+    bool const sender = state.thread_index() == 0;
+
+    uint32_t value = 0;
+    for (auto _ : state)
+    {
+        if (sender)
+        {
+            queue_push_wait(requests, value++);
+            benchmark::DoNotOptimize(queue_pop_wait(responses));
+        }
+        else
+            queue_push_wait(responses, queue_pop_wait(requests));
+    }
+}
+BENCHMARK(queue_round_trip<MutexQueue>)->Threads(2)->UseRealTime();
+BENCHMARK(queue_round_trip<SpscQueue<uint32_t, s_queue_capacity>>)
+    ->Threads(2)
+    ->UseRealTime();
+BENCHMARK(queue_round_trip<MpmcQueue<uint32_t, s_queue_capacity>>)
+    ->Threads(2)
+    ->UseRealTime();
+
 template <typename T> static void std_hash(benchmark::State &state)
 {
     std::hash<T> hash;
@@ -592,7 +1735,173 @@ BENCHMARK(wheels_hash<uint8_t>);
 BENCHMARK(wheels_hash<uint16_t>);
 BENCHMARK(wheels_hash<uint32_t>);
 BENCHMARK(wheels_hash<uint64_t>);
-BENCHMARK(std_hash<float>);
-BENCHMARK(std_hash<double>);
+BENCHMARK(wheels_hash<float>);
+BENCHMARK(wheels_hash<double>);
 BENCHMARK(wheels_hash<uint64_t *>);
 BENCHMARK(wheels_hash<uint64_t const *>);
+
+template <typename T> static void mix_hash(benchmark::State &state)
+{
+    MixHash<T> hash;
+    T value = 0;
+    while (state.KeepRunning())
+        benchmark::DoNotOptimize(hash(value++));
+}
+BENCHMARK(mix_hash<uint8_t>);
+BENCHMARK(mix_hash<uint16_t>);
+BENCHMARK(mix_hash<uint32_t>);
+BENCHMARK(mix_hash<uint64_t>);
+BENCHMARK(mix_hash<uint64_t *>);
+BENCHMARK(mix_hash<uint64_t const *>);
+
+enum class KeyPattern
+{
+    Sequential,
+    // Multiples of 4096 like page or aligned allocation addresses
+    Strided,
+    Random,
+};
+
+template <typename T, KeyPattern Pattern> T pattern_key(uint32_t i)
+{
+    uint64_t bits = 0;
+    if constexpr (Pattern == KeyPattern::Sequential)
+        bits = i;
+    else if constexpr (Pattern == KeyPattern::Strided)
+        bits = (uint64_t)i * 4096;
+    else
+        bits = wyhash64(i, 0);
+
+    if constexpr (std::is_pointer_v<T>)
+        return reinterpret_cast<T>((uintptr_t)bits);
+    else
+        return (T)bits;
+}
+
+template <typename T> T flip_key_bit(T key, uint32_t bit)
+{
+    if constexpr (std::is_pointer_v<T>)
+        return reinterpret_cast<T>((uintptr_t)key ^ ((uintptr_t)1 << bit));
+    else
+        return (T)(key ^ ((T)1 << bit));
+}
+
+// Measures hashing speed over the key set and reports the hash quality as
+// counters:
+//   avalanche_bias: Worst deviation from a 50% chance of an output bit
+//                   flipping when an input bit flips. 0 is ideal, 1 means
+//                   some output bit ignores some input bit or copies it.
+//                   ~0.15 is the sampling noise floor of an ideal hash.
+//   probe_mean/max: Slots touched by a successful lookup in a HashSet-like
+//                   linear probing table at its 15/16 max load
+template <class Hasher, typename T, KeyPattern Pattern>
+static void hash_quality(benchmark::State &state)
+{
+    Hasher const hash;
+
+    constexpr uint32_t s_avalanche_samples = 1024;
+    constexpr uint32_t s_key_bits = sizeof(T) * 8;
+    uint32_t flip_counts[s_key_bits][64] = {};
+    for (uint32_t i = 0; i < s_avalanche_samples; ++i)
+    {
+        T const key = pattern_key<T, Pattern>(i);
+        uint64_t const key_hash = (uint64_t)hash(key);
+        for (uint32_t in_bit = 0; in_bit < s_key_bits; ++in_bit)
+        {
+            uint64_t const diff =
+                key_hash ^ (uint64_t)hash(flip_key_bit(key, in_bit));
+            for (uint32_t out_bit = 0; out_bit < 64; ++out_bit)
+                flip_counts[in_bit][out_bit] += (diff >> out_bit) & 1;
+        }
+    }
+    double max_bias = 0.0;
+    for (uint32_t in_bit = 0; in_bit < s_key_bits; ++in_bit)
+    {
+        for (uint32_t out_bit = 0; out_bit < 64; ++out_bit)
+        {
+            double const p =
+                (double)flip_counts[in_bit][out_bit] / s_avalanche_samples;
+            double const bias = std::abs(2.0 * p - 1.0);
+            if (bias > max_bias)
+                max_bias = bias;
+        }
+    }
+
+    // Same position and probing as HashSet
+    constexpr uint32_t s_capacity = 1 << 16;
+    constexpr uint32_t s_key_count = s_capacity / 16 * 15;
+    CstdlibAllocator allocator;
+    Array<uint8_t> full{allocator, s_capacity};
+    full.resize(s_capacity, 0);
+    uint64_t probe_sum = 0;
+    uint64_t probe_max = 0;
+    for (uint32_t i = 0; i < s_key_count; ++i)
+    {
+        uint64_t const key_hash = (uint64_t)hash(pattern_key<T, Pattern>(i));
+        size_t pos = (key_hash >> 7) & (s_capacity - 1);
+        uint64_t probes = 1;
+        while (full[pos] != 0)
+        {
+            pos = (pos + 1) & (s_capacity - 1);
+            probes++;
+        }
+        full[pos] = 1;
+        probe_sum += probes;
+        if (probes > probe_max)
+            probe_max = probes;
+    }
+
+    constexpr uint32_t s_speed_key_count = 4096;
+    Array<T> keys{allocator, s_speed_key_count};
+    for (uint32_t i = 0; i < s_speed_key_count; ++i)
+        keys.push_back(pattern_key<T, Pattern>(i));
+
+    uint32_t i = 0;
+    while (state.KeepRunning())
+        benchmark::DoNotOptimize(hash(keys[i++ % s_speed_key_count]));
+
+    state.counters["avalanche_bias"] = max_bias;
+    state.counters["probe_mean"] = (double)probe_sum / s_key_count;
+    state.counters["probe_max"] = (double)probe_max;
+}
+
+#define HASH_QUALITY_BENCHMARKS(T)                                             \
+    BENCHMARK(hash_quality<std::hash<T>, T, KeyPattern::Sequential>);          \
+    BENCHMARK(hash_quality<Hash<T>, T, KeyPattern::Sequential>);               \
+    BENCHMARK(hash_quality<MixHash<T>, T, KeyPattern::Sequential>);            \
+    BENCHMARK(hash_quality<std::hash<T>, T, KeyPattern::Strided>);             \
+    BENCHMARK(hash_quality<Hash<T>, T, KeyPattern::Strided>);                  \
+    BENCHMARK(hash_quality<MixHash<T>, T, KeyPattern::Strided>);               \
+    BENCHMARK(hash_quality<std::hash<T>, T, KeyPattern::Random>);              \
+    BENCHMARK(hash_quality<Hash<T>, T, KeyPattern::Random>);                   \
+    BENCHMARK(hash_quality<MixHash<T>, T, KeyPattern::Random>)
+
+HASH_QUALITY_BENCHMARKS(uint32_t);
+HASH_QUALITY_BENCHMARKS(uint64_t);
+HASH_QUALITY_BENCHMARKS(uint64_t *);
+
+#undef HASH_QUALITY_BENCHMARKS
+
+template <class Hasher, KeyPattern Pattern>
+static void hash_set_find_pattern(benchmark::State &state)
+{
+    constexpr uint32_t s_key_count = 1 << 16;
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t, Hasher> set{allocator};
+    for (uint32_t i = 0; i < s_key_count; ++i)
+        set.insert(pattern_key<uint32_t, Pattern>(i));
+
+    uint32_t i = 0;
+    while (state.KeepRunning())
+    {
+        uint32_t const key = pattern_key<uint32_t, Pattern>(i++ % s_key_count);
+        benchmark::DoNotOptimize(set.contains(key));
+    }
+}
+BENCHMARK(hash_set_find_pattern<Hash<uint32_t>, KeyPattern::Sequential>);
+BENCHMARK(hash_set_find_pattern<MixHash<uint32_t>, KeyPattern::Sequential>);
+BENCHMARK(hash_set_find_pattern<Hash<uint32_t>, KeyPattern::Strided>);
+BENCHMARK(hash_set_find_pattern<MixHash<uint32_t>, KeyPattern::Strided>);
+BENCHMARK(hash_set_find_pattern<Hash<uint32_t>, KeyPattern::Random>);
+BENCHMARK(hash_set_find_pattern<MixHash<uint32_t>, KeyPattern::Random>);
@@ -6,13 +6,42 @@
 namespace wheels
 {
 
+struct AllocationResult
+{
+    void *ptr{nullptr};
+    size_t num_bytes{0};
+};
+
 class Allocator
 {
   public:
     virtual ~Allocator() { }
     [[nodiscard]] virtual void *allocate(size_t num_bytes) noexcept = 0;
-    // No reallocate because it would require extra bookkeeping from bump
-    // allocators.
+    // Like allocate() but also returns the usable size of the allocation. It
+    // can be larger than num_bytes if the allocator rounds requests up, and
+    // the caller is free to use all of it.
+    [[nodiscard]] virtual AllocationResult allocate_at_least(
+        size_t num_bytes) noexcept
+    {
+        return AllocationResult{
+            .ptr = allocate(num_bytes),
+            .num_bytes = num_bytes,
+        };
+    }
+    // Resizes the allocation at ptr to num_bytes, moving it if it can't be
+    // resized in place. Contents up to the smaller of the sizes are preserved
+    // and ptr is invalidated on success.
+    // Returns nullptr if the allocator doesn't support reallocation or it
+    // failed, in which case ptr is left untouched and still owned by the
+    // caller. Not supported by default because it would require extra
+    // bookkeeping from bump allocators.
+    [[nodiscard]] virtual void *reallocate(
+        void *ptr, size_t num_bytes) noexcept
+    {
+        (void)ptr;
+        (void)num_bytes;
+        return nullptr;
+    }
     virtual void deallocate(void *ptr) noexcept = 0;
 };
 
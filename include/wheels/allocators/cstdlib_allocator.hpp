@@ -21,7 +21,8 @@ class CstdlibAllocator : public Allocator
 
     // Input ptr is invalidated if reallocation succeeds. The user needs to free
     // it after a failure.
-    [[nodiscard]] void *reallocate(void *ptr, size_t num_bytes) noexcept
+    [[nodiscard]] virtual void *reallocate(
+        void *ptr, size_t num_bytes) noexcept override
     {
         return std::realloc(ptr, num_bytes);
     }
@@ -54,9 +54,14 @@ class TlsfAllocator : public Allocator
     void destroy();
 
     [[nodiscard]] virtual void *allocate(size_t num_bytes) noexcept override;
+    // Returns the whole block, which can have up to s_min_block_size bytes of
+    // slack when the remainder was too small to split off
+    [[nodiscard]] virtual AllocationResult allocate_at_least(
+        size_t num_bytes) noexcept override;
     // Input ptr is invalidated if reallocation succeeds. The user needs to free
     // it after a failure.
-    [[nodiscard]] void *reallocate(void *ptr, size_t num_bytes) noexcept;
+    [[nodiscard]] virtual void *reallocate(
+        void *ptr, size_t num_bytes) noexcept override;
     virtual void deallocate(void *ptr) noexcept override;
 
     Stats const &stats() const noexcept;
@@ -397,6 +402,30 @@ inline void *TlsfAllocator::allocate(size_t num_bytes) noexcept
     return allocate_internal(num_bytes);
 }
 
+inline AllocationResult TlsfAllocator::allocate_at_least(
+    size_t num_bytes) noexcept
+{
+    WHEELS_ASSERT_LOCK_NOT_NECESSARY(m_assert_lock);
+    WHEELS_ASSERT(
+        m_data != nullptr && "init() not called or destroy() already called?");
+
+    void *ptr = allocate_internal(num_bytes);
+    if (ptr == nullptr)
+        return AllocationResult{};
+
+    uintptr_t const ptr_to_front_addr = (uintptr_t)ptr - sizeof(void *);
+    FreeBlock const *block = *(FreeBlock const **)ptr_to_front_addr;
+    // Match what reallocate() copies over so that the slack is preserved
+    size_t const usable_byte_count =
+        block->tag.byte_count - block_padding_num_bytes(block->tag.byte_count);
+    WHEELS_ASSERT(usable_byte_count >= num_bytes);
+
+    return AllocationResult{
+        .ptr = ptr,
+        .num_bytes = usable_byte_count,
+    };
+}
+
 inline void *TlsfAllocator::allocate_internal(size_t num_bytes) noexcept
 {
     size_t const internal_byte_count = padded_num_bytes(num_bytes);
@@ -813,7 +842,8 @@ class TlsfAllocator : public Allocator
     [[nodiscard]] virtual void *allocate(size_t num_bytes) noexcept override;
     // Input ptr is invalidated if reallocation succeeds. The user needs to free
     // it after a failure.
-    [[nodiscard]] void *reallocate(void *ptr, size_t num_bytes) noexcept;
+    [[nodiscard]] virtual void *reallocate(
+        void *ptr, size_t num_bytes) noexcept override;
     virtual void deallocate(void *ptr) noexcept override;
 
     Stats const &stats() const noexcept;
@@ -870,30 +900,28 @@ inline void *TlsfAllocator::reallocate(void *ptr, size_t num_bytes) noexcept
 
     void *new_ptr = std::realloc(ptr, num_bytes);
     WHEELS_ASSERT(new_ptr != nullptr);
-    if (new_ptr != ptr)
+    // Stats need to be updated even if the allocation was resized in place
+    if (ptr != nullptr)
     {
-        if (ptr != nullptr)
-        {
-            WHEELS_ASSERT(m_allocations.contains(ptr));
+        WHEELS_ASSERT(m_allocations.contains(ptr));
 
-            const size_t prev_num_bytes = m_allocations.find(ptr)->second;
-            m_stats.allocated_byte_count -= prev_num_bytes;
-            m_stats.free_byte_count += prev_num_bytes;
+        const size_t prev_num_bytes = m_allocations.find(ptr)->second;
+        m_stats.allocated_byte_count -= prev_num_bytes;
+        m_stats.free_byte_count += prev_num_bytes;
 
-            m_allocations.erase(ptr);
-            // realloc already freed the original pointer
-        }
-        else
-            m_stats.allocation_count++;
+        m_allocations.erase(ptr);
+        // realloc already freed the original pointer if it moved
+    }
+    else
+        m_stats.allocation_count++;
 
-        m_stats.allocated_byte_count += num_bytes;
-        m_stats.free_byte_count -= num_bytes;
-        m_stats.allocated_byte_count_high_watermark = std::max(
-            m_stats.allocated_byte_count,
-            m_stats.allocated_byte_count_high_watermark);
+    m_stats.allocated_byte_count += num_bytes;
+    m_stats.free_byte_count -= num_bytes;
+    m_stats.allocated_byte_count_high_watermark = std::max(
+        m_stats.allocated_byte_count,
+        m_stats.allocated_byte_count_high_watermark);
 
-        m_allocations.emplace(new_ptr, num_bytes);
-    }
+    m_allocations.emplace(new_ptr, num_bytes);
 
     return new_ptr;
 }
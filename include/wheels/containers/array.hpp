@@ -7,13 +7,16 @@
 #include "../utils.hpp"
 #include "concepts.hpp"
 #include "span.hpp"
+#include "utils.hpp"
 
 #include <cstring>
 
 namespace wheels
 {
 
-template <typename T> class Array
+// Growth is a policy like ArrayGrowth that picks the capacity to grow to when
+// push_back(), emplace_back() or extend() run out of it
+template <typename T, typename Growth = DefaultArrayGrowth> class Array
 {
     // Use a static assert instead of a concepts constraint as this will produce
     // a more understandable error message
@@ -28,10 +31,10 @@ template <typename T> class Array
     Array(Allocator &allocator, size_t initial_capacity = 0) noexcept;
     ~Array();
 
-    Array(Array<T> const &) = delete;
-    Array(Array<T> &&other) noexcept;
-    Array<T> &operator=(Array<T> const &) = delete;
-    Array<T> &operator=(Array<T> &&other) noexcept;
+    Array(Array<T, Growth> const &) = delete;
+    Array(Array<T, Growth> &&other) noexcept;
+    Array<T, Growth> &operator=(Array<T, Growth> const &) = delete;
+    Array<T, Growth> &operator=(Array<T, Growth> &&other) noexcept;
 
     [[nodiscard]] T &operator[](size_t i) noexcept;
     [[nodiscard]] T const &operator[](size_t i) const noexcept;
@@ -60,6 +63,8 @@ template <typename T> class Array
     [[nodiscard]] size_t size() const noexcept;
     void reserve(size_t capacity) noexcept;
     [[nodiscard]] size_t capacity() const noexcept;
+    // Frees the unused capacity, or the whole allocation if empty
+    void shrink_to_fit() noexcept;
 
     void clear() noexcept;
 
@@ -72,18 +77,38 @@ template <typename T> class Array
 
     void extend(Span<const T> values) noexcept;
 
+    // Inserts the values before index, shifting the ones after it. values
+    // can't point into this array.
+    void insert(size_t index, Span<const T> values) noexcept;
+
     T pop_back() noexcept;
     // Preserves the order, takes O(n) for n elements after index
     void erase(size_t index) noexcept;
     // Doesn't preserve the order, runs in O(1)
     void erase_swap_last(size_t index) noexcept;
+    // Erases [begin_i, end_i) and shifts the rest over it in one go
+    void erase(size_t begin_i, size_t end_i) noexcept;
+    // Removes the values for which pred(T const &) returns true in a single
+    // pass, preserving the order of the rest. Returns the number of removed
+    // values.
+    template <typename F> size_t erase_if(F &&pred) noexcept;
+    // Keeps only the values for which pred(T const &) returns true. Returns the
+    // number of removed values.
+    template <typename F> size_t retain(F &&pred) noexcept;
 
     void resize(size_t size) noexcept;
     void resize(size_t size, T const &value) noexcept;
+    // Like resize() but leaves the new values uninitialized, for buffers that
+    // are written to right after
+    void resize_uninitialized(size_t size) noexcept;
+    // Adds count uninitialized values to the back and returns a span for
+    // filling them in
+    [[nodiscard]] Span<T> append_uninitialized(size_t count) noexcept;
 
     operator Span<T const>() const noexcept;
 
   private:
+    void grow(size_t required_capacity) noexcept;
     void reallocate(size_t capacity) noexcept;
     void destroy() noexcept;
 
@@ -93,8 +118,15 @@ template <typename T> class Array
     size_t m_size{0};
 };
 
-template <typename T>
-Array<T>::Array(Allocator &allocator, size_t initial_capacity) noexcept
+// Only points to its heap allocation and the allocator, neither of which move
+// with the array
+template <typename T, typename Growth>
+struct is_trivially_relocatable<Array<T, Growth>> : std::true_type
+{
+};
+
+template <typename T, typename Growth>
+Array<T, Growth>::Array(Allocator &allocator, size_t initial_capacity) noexcept
 : m_allocator{allocator}
 {
     static_assert(
@@ -105,10 +137,10 @@ Array<T>::Array(Allocator &allocator, size_t initial_capacity) noexcept
         reallocate(initial_capacity);
 }
 
-template <typename T> Array<T>::~Array() { destroy(); }
+template <typename T, typename Growth> Array<T, Growth>::~Array() { destroy(); }
 
-template <typename T>
-Array<T>::Array(Array<T> &&other) noexcept
+template <typename T, typename Growth>
+Array<T, Growth>::Array(Array<T, Growth> &&other) noexcept
 : m_allocator{other.m_allocator}
 , m_data{other.m_data}
 , m_capacity{other.m_capacity}
@@ -117,7 +149,8 @@ Array<T>::Array(Array<T> &&other) noexcept
     other.m_data = nullptr;
 }
 
-template <typename T> Array<T> &Array<T>::operator=(Array<T> &&other) noexcept
+template <typename T, typename Growth>
+Array<T, Growth> &Array<T, Growth>::operator=(Array<T, Growth> &&other) noexcept
 {
     WHEELS_ASSERT(
         &m_allocator == &other.m_allocator &&
@@ -137,108 +170,140 @@ template <typename T> Array<T> &Array<T>::operator=(Array<T> &&other) noexcept
     return *this;
 }
 
-template <typename T> T &Array<T>::operator[](size_t i) noexcept
+template <typename T, typename Growth>
+T &Array<T, Growth>::operator[](size_t i) noexcept
 {
     WHEELS_ASSERT(i < m_size);
     return m_data[i];
 }
 
-template <typename T> T const &Array<T>::operator[](size_t i) const noexcept
+template <typename T, typename Growth>
+T const &Array<T, Growth>::operator[](size_t i) const noexcept
 {
     WHEELS_ASSERT(i < m_size);
     return m_data[i];
 }
 
-template <typename T> T &Array<T>::front() noexcept
+template <typename T, typename Growth> T &Array<T, Growth>::front() noexcept
 {
     WHEELS_ASSERT(m_size > 0);
     return *m_data;
 }
 
-template <typename T> T const &Array<T>::front() const noexcept
+template <typename T, typename Growth>
+T const &Array<T, Growth>::front() const noexcept
 {
     WHEELS_ASSERT(m_size > 0);
     return *m_data;
 }
 
-template <typename T> T &Array<T>::back() noexcept
+template <typename T, typename Growth> T &Array<T, Growth>::back() noexcept
 {
     WHEELS_ASSERT(m_size > 0);
     return m_data[m_size - 1];
 }
 
-template <typename T> T const &Array<T>::back() const noexcept
+template <typename T, typename Growth>
+T const &Array<T, Growth>::back() const noexcept
 {
     WHEELS_ASSERT(m_size > 0);
     return m_data[m_size - 1];
 }
 
-template <typename T> T *Array<T>::data() noexcept { return m_data; }
+template <typename T, typename Growth>
+T *Array<T, Growth>::data() noexcept { return m_data; }
 
-template <typename T> T const *Array<T>::data() const noexcept
+template <typename T, typename Growth>
+T const *Array<T, Growth>::data() const noexcept
 {
     return m_data;
 }
 
-template <typename T> T *Array<T>::begin() noexcept { return m_data; }
+template <typename T, typename Growth>
+T *Array<T, Growth>::begin() noexcept { return m_data; }
 
-template <typename T> T const *Array<T>::begin() const noexcept
+template <typename T, typename Growth>
+T const *Array<T, Growth>::begin() const noexcept
 {
     return m_data;
 }
 
-template <typename T> T *Array<T>::end() noexcept { return m_data + m_size; }
+template <typename T, typename Growth>
+T *Array<T, Growth>::end() noexcept { return m_data + m_size; }
 
-template <typename T> T const *Array<T>::end() const noexcept
+template <typename T, typename Growth>
+T const *Array<T, Growth>::end() const noexcept
 {
     return m_data + m_size;
 }
 
-template <typename T> Span<T> Array<T>::mut_span() noexcept
+template <typename T, typename Growth>
+Span<T> Array<T, Growth>::mut_span() noexcept
 {
     return Span{begin(), m_size};
 }
 
-template <typename T> Span<T const> Array<T>::span() const noexcept
+template <typename T, typename Growth>
+Span<T const> Array<T, Growth>::span() const noexcept
 {
     return Span<T const>{begin(), m_size};
 }
 
-template <typename T>
-Span<T> Array<T>::mut_span(size_t begin_i, size_t end_i) noexcept
+template <typename T, typename Growth>
+Span<T> Array<T, Growth>::mut_span(size_t begin_i, size_t end_i) noexcept
 {
     WHEELS_ASSERT(begin_i < m_size);
     WHEELS_ASSERT(end_i <= m_size);
     return Span{begin() + begin_i, end_i - begin_i};
 }
 
-template <typename T>
-Span<T const> Array<T>::span(size_t begin_i, size_t end_i) const noexcept
+template <typename T, typename Growth>
+Span<T const> Array<T, Growth>::span(
+    size_t begin_i, size_t end_i) const noexcept
 {
     WHEELS_ASSERT(begin_i < m_size);
     WHEELS_ASSERT(end_i <= m_size);
     return Span{begin() + begin_i, end_i - begin_i};
 }
 
-template <typename T> bool Array<T>::empty() const noexcept
+template <typename T, typename Growth>
+bool Array<T, Growth>::empty() const noexcept
 {
     return m_size == 0;
 }
 
-template <typename T> size_t Array<T>::size() const noexcept { return m_size; }
+template <typename T, typename Growth>
+size_t Array<T, Growth>::size() const noexcept { return m_size; }
 
-template <typename T> void Array<T>::reserve(size_t capacity) noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::reserve(size_t capacity) noexcept
 {
     if (capacity > m_capacity)
         reallocate(capacity);
 }
 
-template <typename T> size_t Array<T>::capacity() const noexcept
+template <typename T, typename Growth>
+size_t Array<T, Growth>::capacity() const noexcept
 {
     return m_capacity;
 }
 
-template <typename T> void Array<T>::clear() noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::shrink_to_fit() noexcept
+{
+    if (m_size == m_capacity)
+        return;
+
+    if (m_size == 0)
+    {
+        destroy();
+        m_capacity = 0;
+    }
+    else
+        reallocate(m_size);
+}
+
+template <typename T, typename Growth> void Array<T, Growth>::clear() noexcept
 {
     if constexpr (!std::is_trivially_destructible_v<T>)
     {
@@ -248,37 +313,33 @@ template <typename T> void Array<T>::clear() noexcept
     m_size = 0;
 }
 
-template <typename T>
+template <typename T, typename Growth>
 template <typename U>
     requires SameAs<U, T>
-void Array<T>::push_back(U &&value) noexcept
+void Array<T, Growth>::push_back(U &&value) noexcept
 {
     if (m_size == m_capacity)
-        reallocate(m_capacity * 2);
+        grow(m_size + 1);
 
     new (m_data + m_size++) T{WHEELS_FWD(value)};
 }
 
-template <typename T>
+template <typename T, typename Growth>
 template <typename... Args>
-void Array<T>::emplace_back(Args &&...args) noexcept
+void Array<T, Growth>::emplace_back(Args &&...args) noexcept
 {
     if (m_size == m_capacity)
-        reallocate(m_capacity * 2);
+        grow(m_size + 1);
 
     new (m_data + m_size++) T{WHEELS_FWD(args)...};
 }
 
-template <typename T> void Array<T>::extend(Span<const T> values) noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::extend(Span<const T> values) noexcept
 {
     const size_t required_size = m_size + values.size();
     if (required_size > m_capacity)
-    {
-        if (required_size <= m_capacity * 2)
-            reallocate(m_capacity * 2);
-        else
-            reallocate(required_size);
-    }
+        grow(required_size);
 
     if constexpr (std::is_trivially_copyable_v<T>)
         memcpy(m_data + m_size, values.data(), values.size() * sizeof(T));
@@ -290,7 +351,37 @@ template <typename T> void Array<T>::extend(Span<const T> values) noexcept
     m_size += values.size();
 }
 
-template <typename T> T Array<T>::pop_back() noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::insert(size_t index, Span<const T> values) noexcept
+{
+    WHEELS_ASSERT(index <= m_size);
+    WHEELS_ASSERT(
+        (values.data() + values.size() <= data() ||
+         values.data() >= data() + capacity()) &&
+        "Inserting values from the array itself isn't supported");
+
+    size_t const count = values.size();
+    if (count == 0)
+        return;
+
+    size_t const required_size = m_size + count;
+    if (required_size > m_capacity)
+        grow(required_size);
+
+    relocate_overlapping(
+        m_data + index + count, m_data + index, m_size - index);
+
+    if constexpr (std::is_trivially_copyable_v<T>)
+        memcpy(m_data + index, values.data(), count * sizeof(T));
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            new (m_data + index + i) T{values[i]};
+    }
+    m_size += count;
+}
+
+template <typename T, typename Growth> T Array<T, Growth>::pop_back() noexcept
 {
     WHEELS_ASSERT(m_size > 0);
     m_size--;
@@ -303,36 +394,50 @@ template <typename T> T Array<T>::pop_back() noexcept
     return ret;
 }
 
-template <typename T> void Array<T>::erase(size_t index) noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::erase(size_t index) noexcept
 {
     WHEELS_ASSERT(index < m_size);
 
-    if constexpr (!std::is_trivially_destructible_v<T>)
-        m_data[index].~T();
+    erase(index, index + 1);
+}
 
-    if constexpr (std::is_trivially_copyable_v<T>)
-    {
-        static_assert(
-            std::is_trivially_destructible_v<T>,
-            "No dtors are called in this path");
-        memcpy(
-            m_data + index, m_data + index + 1,
-            (m_size - index - 1) * sizeof(T));
-    }
-    else
+template <typename T, typename Growth>
+void Array<T, Growth>::erase(size_t begin_i, size_t end_i) noexcept
+{
+    WHEELS_ASSERT(begin_i <= end_i);
+    WHEELS_ASSERT(end_i <= m_size);
+
+    if constexpr (!std::is_trivially_destructible_v<T>)
     {
-        for (size_t i = index + 1; i < m_size; ++i)
-        {
-            new (m_data + i - 1) T{WHEELS_MOV(m_data[i])};
-            if constexpr (!std::is_trivially_destructible_v<T>)
-                // Moved from value might still require dtor
-                m_data[i].~T();
-        }
+        for (size_t i = begin_i; i < end_i; ++i)
+            m_data[i].~T();
     }
-    m_size--;
+
+    relocate_overlapping(m_data + begin_i, m_data + end_i, m_size - end_i);
+    m_size -= end_i - begin_i;
+}
+
+template <typename T, typename Growth>
+template <typename F>
+size_t Array<T, Growth>::erase_if(F &&pred) noexcept
+{
+    size_t const kept_count = remove_values_if(m_data, m_size, pred);
+    size_t const removed_count = m_size - kept_count;
+    m_size = kept_count;
+
+    return removed_count;
 }
 
-template <typename T> void Array<T>::erase_swap_last(size_t index) noexcept
+template <typename T, typename Growth>
+template <typename F>
+size_t Array<T, Growth>::retain(F &&pred) noexcept
+{
+    return erase_if([&](T const &value) { return !pred(value); });
+}
+
+template <typename T, typename Growth>
+void Array<T, Growth>::erase_swap_last(size_t index) noexcept
 {
     WHEELS_ASSERT(index < m_size);
 
@@ -359,7 +464,8 @@ template <typename T> void Array<T>::erase_swap_last(size_t index) noexcept
     m_size--;
 }
 
-template <typename T> void Array<T>::resize(size_t size) noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::resize(size_t size) noexcept
 {
     if (size < m_size)
     {
@@ -382,8 +488,8 @@ template <typename T> void Array<T>::resize(size_t size) noexcept
     }
 }
 
-template <typename T>
-void Array<T>::resize(size_t size, T const &value) noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::resize(size_t size, T const &value) noexcept
 {
     if (size < m_size)
     {
@@ -406,23 +512,54 @@ void Array<T>::resize(size_t size, T const &value) noexcept
     }
 }
 
-template <typename T> void Array<T>::reallocate(size_t capacity) noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::grow(size_t required_capacity) noexcept
 {
-    if (capacity == 0)
-        capacity = 4;
+    size_t const capacity =
+        Growth::grown_capacity(m_capacity, required_capacity, sizeof(T));
+    WHEELS_ASSERT(capacity >= required_capacity);
 
-    T *data = (T *)m_allocator.allocate(capacity * sizeof(T));
-    WHEELS_ASSERT(data != nullptr);
+    reallocate(capacity);
+}
 
-    if (m_data != nullptr)
+template <typename T, typename Growth>
+void Array<T, Growth>::reallocate(size_t capacity) noexcept
+{
+    WHEELS_ASSERT(capacity > 0);
+
+    if constexpr (is_trivially_relocatable_v<T>)
     {
-        if constexpr (std::is_trivially_copyable_v<T>)
+        if (m_data != nullptr)
         {
-            static_assert(
-                std::is_trivially_destructible_v<T>,
-                "No dtors are called in this path");
-            memcpy(data, m_data, m_size * sizeof(T));
+            // Allocators that support it might be able to grow in place or
+            // remap the pages instead of copying everything over
+            T *data =
+                (T *)m_allocator.reallocate(m_data, capacity * sizeof(T));
+            if (data != nullptr)
+            {
+                m_data = data;
+                m_capacity = capacity;
+                return;
+            }
         }
+    }
+
+    AllocationResult allocation;
+    if constexpr (Growth::s_use_allocation_slack)
+        allocation = m_allocator.allocate_at_least(capacity * sizeof(T));
+    else
+        allocation = AllocationResult{
+            .ptr = m_allocator.allocate(capacity * sizeof(T)),
+            .num_bytes = capacity * sizeof(T),
+        };
+    T *data = (T *)allocation.ptr;
+    WHEELS_ASSERT(data != nullptr);
+
+    if (m_data != nullptr)
+    {
+        if constexpr (is_trivially_relocatable_v<T>)
+            // No dtors are called for relocated values
+            memcpy((void *)data, (void const *)m_data, m_size * sizeof(T));
         else
         {
             for (size_t i = 0; i < m_size; ++i)
@@ -437,10 +574,10 @@ template <typename T> void Array<T>::reallocate(size_t capacity) noexcept
     }
 
     m_data = data;
-    m_capacity = capacity;
+    m_capacity = allocation.num_bytes / sizeof(T);
 }
 
-template <typename T> void Array<T>::destroy() noexcept
+template <typename T, typename Growth> void Array<T, Growth>::destroy() noexcept
 {
     if (m_data != nullptr)
     {
@@ -450,7 +587,44 @@ template <typename T> void Array<T>::destroy() noexcept
     }
 }
 
-template <typename T> Array<T>::operator Span<T const>() const noexcept
+template <typename T, typename Growth>
+void Array<T, Growth>::resize_uninitialized(size_t size) noexcept
+{
+    static_assert(
+        std::is_trivially_default_constructible_v<T>,
+        "Skipping initialization is only valid for trivially default "
+        "constructible types");
+
+    if (size <= m_size)
+        resize(size);
+    else
+    {
+        if (size > m_capacity)
+            grow(size);
+        m_size = size;
+    }
+}
+
+template <typename T, typename Growth>
+Span<T> Array<T, Growth>::append_uninitialized(size_t count) noexcept
+{
+    static_assert(
+        std::is_trivially_default_constructible_v<T>,
+        "Skipping initialization is only valid for trivially default "
+        "constructible types");
+
+    size_t const required_size = m_size + count;
+    if (required_size > m_capacity)
+        grow(required_size);
+
+    Span<T> const ret{m_data + m_size, count};
+    m_size = required_size;
+
+    return ret;
+}
+
+template <typename T, typename Growth>
+Array<T, Growth>::operator Span<T const>() const noexcept
 {
     return Span<T const>{m_data, m_size};
 }
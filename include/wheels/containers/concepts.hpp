@@ -11,6 +11,13 @@ namespace wheels
 template <typename T, typename U>
 concept SameAs = std::same_as<std::remove_cvref_t<T>, std::remove_cvref_t<U>>;
 
+// Keys that compare equal exactly when their bytes do so lookups can compare
+// many of them at once with SIMD byte compares
+template <typename T>
+concept SimdSearchable =
+    (std::is_integral_v<T> || std::is_pointer_v<T>) &&
+    (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
 template <class Hasher, typename Key>
 concept InvocableHash = std::is_invocable_v<Hasher, Key>;
 
@@ -18,6 +25,11 @@ template <class Hasher, typename Key>
 concept CorrectHashRetVal = std::is_same_v<
     typename std::invoke_result_t<Hasher, Key const &>, uint64_t>;
 
+// Hashers opt into having hash containers store the full hash of each slot by
+// defining static constexpr bool s_store_hash = true
+template <class Hasher>
+concept StoresHash = requires { requires Hasher::s_store_hash; };
+
 } // namespace wheels
 
 #endif // WHEELS_CONTAINERS_CONCEPTS
@@ -0,0 +1,239 @@
+#ifndef WHEELS_CONTAINERS_CONCURRENT_HASH_MAP_HPP
+#define WHEELS_CONTAINERS_CONCURRENT_HASH_MAP_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "hash.hpp"
+#include "hash_map.hpp"
+#include "inline_array.hpp"
+#include "optional.hpp"
+
+#include <bit>
+#include <mutex>
+#include <shared_mutex>
+
+namespace wheels
+{
+
+// Splits the keys into ShardCount HashMaps that are each protected by their own
+// reader-writer lock. Readers only block writers of the same shard and
+// operations on different shards never touch the same cache lines.
+// The shard is picked from the top bits of the hash while the shard tables
+// use the bottom bits so the two don't correlate. The key is hashed once and
+// the same hash drives the shard table probe.
+// Values are copied out on lookup because a pointer into a shard could be
+// invalidated by a concurrent insert that grows it. visit() can be used to
+// read large values in place while holding the shard lock.
+// The allocator has to be thread-safe since all shards allocate through it.
+
+template <
+    typename Key, typename Value, class Hasher = Hash<Key>,
+    size_t ShardCount = 64>
+class ConcurrentHashMap
+{
+    static_assert(
+        std::has_single_bit(ShardCount),
+        "Shard count has to be a power of two");
+
+  public:
+    using key_type = Key;
+    // Wording clashes with the STL counterpats, but is consistent with the
+    // template interface
+    using value_type = Value;
+
+    // initial_capacity is split evenly between the shards
+    ConcurrentHashMap(
+        Allocator &allocator, size_t initial_capacity = 0) noexcept;
+    ~ConcurrentHashMap() = default;
+
+    // Locks aren't movable
+    ConcurrentHashMap(ConcurrentHashMap const &other) = delete;
+    ConcurrentHashMap(ConcurrentHashMap &&other) = delete;
+    ConcurrentHashMap &operator=(ConcurrentHashMap const &other) = delete;
+    ConcurrentHashMap &operator=(ConcurrentHashMap &&other) = delete;
+
+    // These are only a snapshot if there are concurrent writers
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] static constexpr size_t shard_count() noexcept
+    {
+        return ShardCount;
+    }
+
+    [[nodiscard]] bool contains(Key const &key) const noexcept;
+    [[nodiscard]] Optional<Value> find(Key const &key) const noexcept;
+    // Calls f(Value const &) with the shard read locked if key is found.
+    // Returns true if key was found.
+    template <typename F>
+    bool visit(Key const &key, F &&f) const noexcept;
+    // Calls f(Key const &, Value const &) for each pair. Shards are read
+    // locked one at a time so writes to other shards can be interleaved.
+    template <typename F> void for_each(F &&f) const noexcept;
+
+    void clear() noexcept;
+
+    template <typename K, typename V>
+    // Let's be pedantic and disallow implicit conversions
+        requires(SameAs<K, Key> && SameAs<V, Value>)
+    void insert_or_assign(K &&key, V &&value) noexcept;
+
+    void remove(Key const &key) noexcept;
+
+  private:
+    // Avoid false sharing between the shard locks
+    static constexpr size_t s_cache_line_size = 64;
+
+    struct alignas(s_cache_line_size) Shard
+    {
+        Shard(Allocator &allocator, size_t initial_capacity) noexcept
+        : map{allocator, initial_capacity}
+        {
+        }
+
+        mutable std::shared_mutex lock;
+        HashMap<Key, Value, Hasher> map;
+    };
+
+    [[nodiscard]] Shard &shard(uint64_t hash) noexcept;
+    [[nodiscard]] Shard const &shard(uint64_t hash) const noexcept;
+
+    InlineArray<Shard, ShardCount> m_shards;
+    Hasher m_hasher{};
+};
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+ConcurrentHashMap<Key, Value, Hasher, ShardCount>::ConcurrentHashMap(
+    Allocator &allocator, size_t initial_capacity) noexcept
+{
+    size_t const shard_capacity =
+        (initial_capacity + ShardCount - 1) / ShardCount;
+    for (size_t i = 0; i < ShardCount; ++i)
+        m_shards.emplace_back(allocator, shard_capacity);
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+bool ConcurrentHashMap<Key, Value, Hasher, ShardCount>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+size_t ConcurrentHashMap<Key, Value, Hasher, ShardCount>::size() const noexcept
+{
+    size_t ret = 0;
+    for (Shard const &s : m_shards)
+    {
+        std::shared_lock const _lock{s.lock};
+        ret += s.map.size();
+    }
+    return ret;
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+bool ConcurrentHashMap<Key, Value, Hasher, ShardCount>::contains(
+    Key const &key) const noexcept
+{
+    uint64_t const hash = m_hasher(key);
+    Shard const &s = shard(hash);
+    std::shared_lock const _lock{s.lock};
+    return s.map.contains_with_hash(key, hash);
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+Optional<Value> ConcurrentHashMap<Key, Value, Hasher, ShardCount>::find(
+    Key const &key) const noexcept
+{
+    uint64_t const hash = m_hasher(key);
+    Shard const &s = shard(hash);
+    std::shared_lock const _lock{s.lock};
+    if (Value const *value = s.map.find_with_hash(key, hash); value != nullptr)
+        return Optional<Value>{*value};
+    return Optional<Value>{};
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+template <typename F>
+bool ConcurrentHashMap<Key, Value, Hasher, ShardCount>::visit(
+    Key const &key, F &&f) const noexcept
+{
+    uint64_t const hash = m_hasher(key);
+    Shard const &s = shard(hash);
+    std::shared_lock const _lock{s.lock};
+    if (Value const *value = s.map.find_with_hash(key, hash); value != nullptr)
+    {
+        f(*value);
+        return true;
+    }
+    return false;
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+template <typename F>
+void ConcurrentHashMap<Key, Value, Hasher, ShardCount>::for_each(
+    F &&f) const noexcept
+{
+    for (Shard const &s : m_shards)
+    {
+        std::shared_lock const _lock{s.lock};
+        s.map.for_each(f);
+    }
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+void ConcurrentHashMap<Key, Value, Hasher, ShardCount>::clear() noexcept
+{
+    for (Shard &s : m_shards)
+    {
+        std::unique_lock const _lock{s.lock};
+        s.map.clear();
+    }
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+template <typename K, typename V>
+    requires(SameAs<K, Key> && SameAs<V, Value>)
+void ConcurrentHashMap<Key, Value, Hasher, ShardCount>::insert_or_assign(
+    K &&key, V &&value) noexcept
+{
+    uint64_t const hash = m_hasher(key);
+    Shard &s = shard(hash);
+    std::unique_lock const _lock{s.lock};
+    s.map.insert_or_assign_with_hash(WHEELS_FWD(key), WHEELS_FWD(value), hash);
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+void ConcurrentHashMap<Key, Value, Hasher, ShardCount>::remove(
+    Key const &key) noexcept
+{
+    uint64_t const hash = m_hasher(key);
+    Shard &s = shard(hash);
+    std::unique_lock const _lock{s.lock};
+    s.map.remove_with_hash(key, hash);
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+typename ConcurrentHashMap<Key, Value, Hasher, ShardCount>::Shard &
+ConcurrentHashMap<Key, Value, Hasher, ShardCount>::shard(
+    uint64_t hash) noexcept
+{
+    if constexpr (ShardCount == 1)
+        return m_shards[0];
+    else
+        return m_shards[hash >> (64 - std::countr_zero(ShardCount))];
+}
+
+template <typename Key, typename Value, class Hasher, size_t ShardCount>
+typename ConcurrentHashMap<Key, Value, Hasher, ShardCount>::Shard const &
+ConcurrentHashMap<Key, Value, Hasher, ShardCount>::shard(
+    uint64_t hash) const noexcept
+{
+    if constexpr (ShardCount == 1)
+        return m_shards[0];
+    else
+        return m_shards[hash >> (64 - std::countr_zero(ShardCount))];
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_CONCURRENT_HASH_MAP_HPP
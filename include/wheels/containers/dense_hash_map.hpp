@@ -0,0 +1,632 @@
+#ifndef WHEELS_CONTAINERS_DENSE_HASH_MAP_HPP
+#define WHEELS_CONTAINERS_DENSE_HASH_MAP_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "array.hpp"
+#include "concepts.hpp"
+#include "hash.hpp"
+#include "pair.hpp"
+#include "span.hpp"
+#include "utils.hpp"
+
+#include <cstring>
+
+namespace wheels
+{
+
+// Stores the keys and values densely in two parallel arrays and looks them up
+// through a SwissMap style index table that maps hashes to entry indices.
+// Iteration is a linear sweep over the entries in insertion order and the
+// values can be processed in bulk through values()/mut_values().
+// Removal moves the last entry into the removed one's place so it breaks the
+// insertion order and invalidates pointers to the last entry. Pointers to
+// entries are also invalidated by inserts that grow the arrays.
+// Lookups touch one more cache line than in HashMap for the index table.
+
+template <typename Key, typename Value, class Hasher = Hash<Key>>
+class DenseHashMap
+{
+    static_assert(
+        InvocableHash<Hasher, Key>, "Hasher has to be invocable with Key");
+    static_assert(
+        CorrectHashRetVal<Hasher, Key>,
+        "Hasher return type has to match Hash<T>");
+
+  public:
+    using key_type = Key;
+    // Wording clashes with the STL counterpats, but is consistent with the
+    // template interface
+    using value_type = Value;
+
+    struct Iterator
+    {
+        Iterator operator++() noexcept;
+        Iterator operator++(int) noexcept;
+        // Only value is mutable because changing the key could require
+        // rehashing
+        [[nodiscard]] Pair<Key const *, Value *> operator*() noexcept;
+        [[nodiscard]] Pair<Key const *, Value const *> operator*()
+            const noexcept;
+        [[nodiscard]] bool operator!=(Iterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(Iterator const &other) const noexcept;
+
+        DenseHashMap &map;
+        size_t pos{0};
+    };
+
+    struct ConstIterator
+    {
+        ConstIterator operator++() noexcept;
+        ConstIterator operator++(int) noexcept;
+        [[nodiscard]] Pair<Key const *, Value const *> operator*()
+            const noexcept;
+        [[nodiscard]] bool operator!=(
+            ConstIterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(
+            ConstIterator const &other) const noexcept;
+
+        DenseHashMap const &map;
+        size_t pos{0};
+    };
+
+  public:
+    DenseHashMap(Allocator &allocator, size_t initial_capacity = 0) noexcept;
+    ~DenseHashMap();
+
+    DenseHashMap(DenseHashMap const &other) = delete;
+    DenseHashMap(DenseHashMap &&other) noexcept;
+    DenseHashMap &operator=(DenseHashMap const &other) = delete;
+    DenseHashMap &operator=(DenseHashMap &&other) noexcept;
+
+    [[nodiscard]] Iterator begin() noexcept;
+    [[nodiscard]] ConstIterator begin() const noexcept;
+    [[nodiscard]] Iterator end() noexcept;
+    [[nodiscard]] ConstIterator end() const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    // Capacity of the index table
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    // The entries in iteration order. keys()[i] maps to values()[i].
+    [[nodiscard]] Span<Key const> keys() const noexcept;
+    [[nodiscard]] Span<Value const> values() const noexcept;
+    [[nodiscard]] Span<Value> mut_values() noexcept;
+
+    [[nodiscard]] bool contains(Key const &key) const noexcept;
+    [[nodiscard]] Value const *find(Key const &key) const noexcept;
+    [[nodiscard]] Value *find(Key const &key) noexcept;
+
+    void clear() noexcept;
+
+    template <typename K, typename V>
+    // Let's be pedantic and disallow implicit conversions
+        requires(SameAs<K, Key> && SameAs<V, Value>)
+    Value *insert_or_assign(K &&key, V &&value) noexcept;
+
+    void remove(Key const &key) noexcept;
+
+  private:
+    // Returns the index table position of key or m_capacity if it isn't in
+    // the map
+    [[nodiscard]] size_t find_pos(
+        uint64_t hash, Key const &key) const noexcept;
+    // Returns the index table position that points to entry index
+    [[nodiscard]] size_t find_index_pos(
+        uint64_t hash, uint32_t index) const noexcept;
+    [[nodiscard]] bool is_over_max_load() const noexcept;
+    // Rebuilds the index table with at least the given capacity, also dropping
+    // the Deleted slots
+    void rehash(size_t capacity) noexcept;
+    void destroy() noexcept;
+
+    enum class Ctrl : uint8_t
+    {
+        Empty = 0b10000000,
+        Deleted = 0b11111111,
+        // Full = 0b0XXXXXXX, H2 hash
+    };
+    [[nodiscard]] static constexpr bool s_empty_pos(
+        uint8_t const *metadata, size_t pos) noexcept
+    {
+        return (metadata[pos] & (uint8_t)Ctrl::Empty) == (uint8_t)Ctrl::Empty;
+    }
+
+    [[nodiscard]] static constexpr uint64_t s_h1(uint64_t hash) noexcept
+    {
+        return hash >> 7;
+    }
+
+    [[nodiscard]] static constexpr uint8_t s_h2(uint64_t hash) noexcept
+    {
+        return (uint8_t)(hash & 0x7F);
+    }
+
+    Allocator &m_allocator;
+    Array<Key> m_keys;
+    Array<Value> m_values;
+    // Entry indices of the index table, metadata points to the end of the
+    // same allocation
+    uint32_t *m_indices{nullptr};
+    uint8_t *m_metadata{nullptr};
+    size_t m_capacity{0};
+    size_t m_deleted_count{0};
+    Hasher m_hasher{};
+};
+
+template <typename Key, typename Value, class Hasher>
+DenseHashMap<Key, Value, Hasher>::DenseHashMap(
+    Allocator &allocator, size_t initial_capacity) noexcept
+: m_allocator{allocator}
+, m_keys{allocator, initial_capacity}
+, m_values{allocator, initial_capacity}
+{
+    if (initial_capacity > 0)
+        rehash(initial_capacity);
+}
+
+template <typename Key, typename Value, class Hasher>
+DenseHashMap<Key, Value, Hasher>::~DenseHashMap()
+{
+    destroy();
+}
+
+template <typename Key, typename Value, class Hasher>
+DenseHashMap<Key, Value, Hasher>::DenseHashMap(DenseHashMap &&other) noexcept
+: m_allocator{other.m_allocator}
+, m_keys{WHEELS_MOV(other.m_keys)}
+, m_values{WHEELS_MOV(other.m_values)}
+, m_indices{other.m_indices}
+, m_metadata{other.m_metadata}
+, m_capacity{other.m_capacity}
+, m_deleted_count{other.m_deleted_count}
+, m_hasher{WHEELS_MOV(other.m_hasher)}
+{
+    other.m_indices = nullptr;
+    other.m_metadata = nullptr;
+    other.m_capacity = 0;
+    other.m_deleted_count = 0;
+}
+
+template <typename Key, typename Value, class Hasher>
+DenseHashMap<Key, Value, Hasher> &DenseHashMap<Key, Value, Hasher>::operator=(
+    DenseHashMap &&other) noexcept
+{
+    WHEELS_ASSERT(
+        &m_allocator == &other.m_allocator &&
+        "Move assigning a container with different allocators can lead to "
+        "nasty bugs. Use the same allocator or copy the content instead.");
+
+    if (this != &other)
+    {
+        destroy();
+
+        m_keys = WHEELS_MOV(other.m_keys);
+        m_values = WHEELS_MOV(other.m_values);
+        m_indices = other.m_indices;
+        m_metadata = other.m_metadata;
+        m_capacity = other.m_capacity;
+        m_deleted_count = other.m_deleted_count;
+        m_hasher = WHEELS_MOV(other.m_hasher);
+
+        other.m_indices = nullptr;
+        other.m_metadata = nullptr;
+        other.m_capacity = 0;
+        other.m_deleted_count = 0;
+    }
+    return *this;
+}
+
+template <typename Key, typename Value, class Hasher>
+typename DenseHashMap<Key, Value, Hasher>::Iterator DenseHashMap<
+    Key, Value, Hasher>::begin() noexcept
+{
+    return Iterator{
+        .map = *this,
+        .pos = 0,
+    };
+}
+
+template <typename Key, typename Value, class Hasher>
+typename DenseHashMap<Key, Value, Hasher>::ConstIterator DenseHashMap<
+    Key, Value, Hasher>::begin() const noexcept
+{
+    return ConstIterator{
+        .map = *this,
+        .pos = 0,
+    };
+}
+
+template <typename Key, typename Value, class Hasher>
+typename DenseHashMap<Key, Value, Hasher>::Iterator DenseHashMap<
+    Key, Value, Hasher>::end() noexcept
+{
+    return Iterator{
+        .map = *this,
+        .pos = size(),
+    };
+}
+
+template <typename Key, typename Value, class Hasher>
+typename DenseHashMap<Key, Value, Hasher>::ConstIterator DenseHashMap<
+    Key, Value, Hasher>::end() const noexcept
+{
+    return ConstIterator{
+        .map = *this,
+        .pos = size(),
+    };
+}
+
+template <typename Key, typename Value, class Hasher>
+bool DenseHashMap<Key, Value, Hasher>::empty() const noexcept
+{
+    return m_keys.empty();
+}
+
+template <typename Key, typename Value, class Hasher>
+size_t DenseHashMap<Key, Value, Hasher>::size() const noexcept
+{
+    return m_keys.size();
+}
+
+template <typename Key, typename Value, class Hasher>
+size_t DenseHashMap<Key, Value, Hasher>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template <typename Key, typename Value, class Hasher>
+Span<Key const> DenseHashMap<Key, Value, Hasher>::keys() const noexcept
+{
+    return m_keys.span();
+}
+
+template <typename Key, typename Value, class Hasher>
+Span<Value const> DenseHashMap<Key, Value, Hasher>::values() const noexcept
+{
+    return m_values.span();
+}
+
+template <typename Key, typename Value, class Hasher>
+Span<Value> DenseHashMap<Key, Value, Hasher>::mut_values() noexcept
+{
+    return m_values.mut_span();
+}
+
+template <typename Key, typename Value, class Hasher>
+bool DenseHashMap<Key, Value, Hasher>::contains(Key const &key) const noexcept
+{
+    return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, class Hasher>
+Value const *DenseHashMap<Key, Value, Hasher>::find(
+    Key const &key) const noexcept
+{
+    if (empty())
+        return nullptr;
+
+    size_t const pos = find_pos(m_hasher(key), key);
+    if (pos == m_capacity)
+        return nullptr;
+    return &m_values[m_indices[pos]];
+}
+
+template <typename Key, typename Value, class Hasher>
+Value *DenseHashMap<Key, Value, Hasher>::find(Key const &key) noexcept
+{
+    if (empty())
+        return nullptr;
+
+    size_t const pos = find_pos(m_hasher(key), key);
+    if (pos == m_capacity)
+        return nullptr;
+    return &m_values[m_indices[pos]];
+}
+
+template <typename Key, typename Value, class Hasher>
+void DenseHashMap<Key, Value, Hasher>::clear() noexcept
+{
+    m_keys.clear();
+    m_values.clear();
+    if (m_metadata != nullptr)
+        memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
+    m_deleted_count = 0;
+}
+
+template <typename Key, typename Value, class Hasher>
+template <typename K, typename V>
+    requires(SameAs<K, Key> && SameAs<V, Value>)
+Value *DenseHashMap<Key, Value, Hasher>::insert_or_assign(
+    K &&key, V &&value) noexcept
+{
+    if (is_over_max_load())
+        // Just clean up in place if most of the load is Deleted slots
+        rehash(m_deleted_count > size() ? m_capacity : m_capacity * 2);
+
+    uint64_t const hash = m_hasher(key);
+    uint8_t const h2 = s_h2(hash);
+    // Capacity is a power of 2 so this mask just works
+    size_t pos = s_h1(hash) & (m_capacity - 1);
+    // The key could be after a Deleted slot so we can't claim the first free
+    // slot before hitting an Empty one
+    size_t free_pos = m_capacity;
+    while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
+    {
+        uint8_t const meta = m_metadata[pos];
+        if (h2 == meta && key == m_keys[m_indices[pos]])
+        {
+            Value *slot = &m_values[m_indices[pos]];
+            slot->~Value();
+            new (slot) Value{WHEELS_FWD(value)};
+            return slot;
+        }
+        if (meta == (uint8_t)Ctrl::Deleted && free_pos == m_capacity)
+            free_pos = pos;
+
+        // Capacity is a power of 2 so this mask just works
+        pos = (pos + 1) & (m_capacity - 1);
+    }
+
+    if (free_pos == m_capacity)
+        free_pos = pos;
+    else
+        m_deleted_count--;
+
+    WHEELS_ASSERT(size() < 0xFFFF'FFFF && "Entry indices are 32bit");
+    m_metadata[free_pos] = h2;
+    m_indices[free_pos] = (uint32_t)size();
+    m_keys.emplace_back(WHEELS_FWD(key));
+    m_values.emplace_back(WHEELS_FWD(value));
+
+    return &m_values.back();
+}
+
+template <typename Key, typename Value, class Hasher>
+void DenseHashMap<Key, Value, Hasher>::remove(Key const &key) noexcept
+{
+    if (empty())
+        return;
+
+    size_t const pos = find_pos(m_hasher(key), key);
+    if (pos == m_capacity)
+        return;
+
+    uint32_t const index = m_indices[pos];
+    uint32_t const last_index = (uint32_t)(size() - 1);
+    if (index != last_index)
+    {
+        // The last entry moves into the removed one's place so its index slot
+        // has to be pointed there
+        size_t const last_pos =
+            find_index_pos(m_hasher(m_keys[last_index]), last_index);
+        m_indices[last_pos] = index;
+    }
+    m_keys.erase_swap_last(index);
+    m_values.erase_swap_last(index);
+
+    // Probing for other keys can stop at this slot if the next one is Empty
+    // as no probe sequence continued past it
+    size_t const next_pos = (pos + 1) & (m_capacity - 1);
+    if (m_metadata[next_pos] == (uint8_t)Ctrl::Empty)
+        m_metadata[pos] = (uint8_t)Ctrl::Empty;
+    else
+    {
+        m_metadata[pos] = (uint8_t)Ctrl::Deleted;
+        m_deleted_count++;
+    }
+}
+
+template <typename Key, typename Value, class Hasher>
+size_t DenseHashMap<Key, Value, Hasher>::find_pos(
+    uint64_t hash, Key const &key) const noexcept
+{
+    uint8_t const h2 = s_h2(hash);
+    // The max load includes the Deleted slots so there's always an Empty slot
+    // to end the probe at.
+    // Capacity is a power of 2 so this mask just works
+    size_t pos = s_h1(hash) & (m_capacity - 1);
+    while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
+    {
+        if (h2 == m_metadata[pos] && key == m_keys[m_indices[pos]])
+            return pos;
+
+        // Capacity is a power of 2 so this mask just works
+        pos = (pos + 1) & (m_capacity - 1);
+    }
+
+    return m_capacity;
+}
+
+template <typename Key, typename Value, class Hasher>
+size_t DenseHashMap<Key, Value, Hasher>::find_index_pos(
+    uint64_t hash, uint32_t index) const noexcept
+{
+    uint8_t const h2 = s_h2(hash);
+    // Capacity is a power of 2 so this mask just works
+    size_t pos = s_h1(hash) & (m_capacity - 1);
+    while (m_metadata[pos] != h2 || m_indices[pos] != index)
+    {
+        WHEELS_ASSERT(m_metadata[pos] != (uint8_t)Ctrl::Empty);
+        // Capacity is a power of 2 so this mask just works
+        pos = (pos + 1) & (m_capacity - 1);
+    }
+    return pos;
+}
+
+template <typename Key, typename Value, class Hasher>
+bool DenseHashMap<Key, Value, Hasher>::is_over_max_load() const noexcept
+{
+    // Same 15/16 as HashMap, but Deleted slots count towards the load so that
+    // probes always end in an Empty slot
+    return m_capacity == 0 ||
+           16 * (size() + m_deleted_count) >= 15 * m_capacity;
+}
+
+template <typename Key, typename Value, class Hasher>
+void DenseHashMap<Key, Value, Hasher>::rehash(size_t capacity) noexcept
+{
+    // Our max load factor is 15/16 so we have to have 32 as the capacity to
+    // ensure we always grow in time so that there always is at least 1 Empty
+    // slot to end find iteration
+    if (capacity < 32)
+        capacity = 32;
+    // Have capacity be a power of two so we can avoid modulus operations on
+    // the hash
+    capacity = round_up_power_of_two(capacity);
+
+    WHEELS_ASSERT(capacity >= m_capacity);
+
+    if (capacity > m_capacity)
+    {
+        if (m_indices != nullptr)
+            m_allocator.deallocate(m_indices);
+
+        uint8_t *data = (uint8_t *)m_allocator.allocate(
+            capacity * (sizeof(uint32_t) + sizeof(uint8_t)));
+        WHEELS_ASSERT(data != nullptr);
+
+        m_indices = (uint32_t *)data;
+        m_metadata = data + capacity * sizeof(uint32_t);
+        m_capacity = capacity;
+    }
+
+    memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
+    m_deleted_count = 0;
+
+    // The entries stay where they are, only the index table is rebuilt. The
+    // keys are unique so each can go to the first free slot without equality
+    // checks.
+    size_t const entry_count = size();
+    for (size_t i = 0; i < entry_count; ++i)
+    {
+        uint64_t const hash = m_hasher(m_keys[i]);
+        // Capacity is a power of 2 so this mask just works
+        size_t pos = s_h1(hash) & (m_capacity - 1);
+        while (!s_empty_pos(m_metadata, pos))
+            pos = (pos + 1) & (m_capacity - 1);
+
+        m_metadata[pos] = s_h2(hash);
+        m_indices[pos] = (uint32_t)i;
+    }
+}
+
+template <typename Key, typename Value, class Hasher>
+void DenseHashMap<Key, Value, Hasher>::destroy() noexcept
+{
+    m_keys.clear();
+    m_values.clear();
+    if (m_indices != nullptr)
+    {
+        m_allocator.deallocate(m_indices);
+        m_indices = nullptr;
+        m_metadata = nullptr;
+        m_capacity = 0;
+        m_deleted_count = 0;
+    }
+}
+
+template <typename Key, typename Value, class Hasher>
+typename DenseHashMap<Key, Value, Hasher>::Iterator DenseHashMap<
+    Key, Value, Hasher>::Iterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < map.size());
+    pos++;
+    return *this;
+}
+
+template <typename Key, typename Value, class Hasher>
+typename DenseHashMap<Key, Value, Hasher>::Iterator DenseHashMap<
+    Key, Value, Hasher>::Iterator::operator++(int) noexcept
+{
+    Iterator const ret = *this;
+    WHEELS_ASSERT(pos < map.size());
+    pos++;
+    return ret;
+}
+
+template <typename Key, typename Value, class Hasher>
+Pair<Key const *, Value *> DenseHashMap<
+    Key, Value, Hasher>::Iterator::operator*() noexcept
+{
+    WHEELS_ASSERT(pos < map.size());
+
+    Key const *key = &map.m_keys[pos];
+    Value *value = &map.m_values[pos];
+    return make_pair(key, value);
+};
+
+template <typename Key, typename Value, class Hasher>
+Pair<Key const *, Value const *> DenseHashMap<
+    Key, Value, Hasher>::Iterator::operator*() const noexcept
+{
+    WHEELS_ASSERT(pos < map.size());
+
+    Key const *key = &map.m_keys[pos];
+    Value const *value = &map.m_values[pos];
+    return make_pair(key, value);
+};
+
+template <typename Key, typename Value, class Hasher>
+bool DenseHashMap<Key, Value, Hasher>::Iterator::operator!=(
+    Iterator const &other) const noexcept
+{
+    return pos != other.pos;
+};
+
+template <typename Key, typename Value, class Hasher>
+bool DenseHashMap<Key, Value, Hasher>::Iterator::operator==(
+    Iterator const &other) const noexcept
+{
+    return pos == other.pos;
+};
+
+template <typename Key, typename Value, class Hasher>
+typename DenseHashMap<Key, Value, Hasher>::ConstIterator DenseHashMap<
+    Key, Value, Hasher>::ConstIterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < map.size());
+    pos++;
+    return *this;
+}
+
+template <typename Key, typename Value, class Hasher>
+typename DenseHashMap<Key, Value, Hasher>::ConstIterator DenseHashMap<
+    Key, Value, Hasher>::ConstIterator::operator++(int) noexcept
+{
+    ConstIterator const ret = *this;
+    WHEELS_ASSERT(pos < map.size());
+    pos++;
+    return ret;
+}
+
+template <typename Key, typename Value, class Hasher>
+Pair<Key const *, Value const *> DenseHashMap<
+    Key, Value, Hasher>::ConstIterator::operator*() const noexcept
+{
+    WHEELS_ASSERT(pos < map.size());
+
+    Key const *key = &map.m_keys[pos];
+    Value const *value = &map.m_values[pos];
+    return make_pair(key, value);
+};
+
+template <typename Key, typename Value, class Hasher>
+bool DenseHashMap<Key, Value, Hasher>::ConstIterator::operator!=(
+    ConstIterator const &other) const noexcept
+{
+    return pos != other.pos;
+};
+
+template <typename Key, typename Value, class Hasher>
+bool DenseHashMap<Key, Value, Hasher>::ConstIterator::operator==(
+    ConstIterator const &other) const noexcept
+{
+    return pos == other.pos;
+};
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_DENSE_HASH_MAP_HPP
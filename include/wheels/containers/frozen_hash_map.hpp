@@ -0,0 +1,444 @@
+#ifndef WHEELS_CONTAINERS_FROZEN_HASH_MAP_HPP
+#define WHEELS_CONTAINERS_FROZEN_HASH_MAP_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "array.hpp"
+#include "hash.hpp"
+#include "hash_map.hpp"
+#include "optional.hpp"
+#include "span.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace wheels
+{
+
+// Immutable snapshot of a HashMap with trivially copyable keys and values.
+// freeze() packs the pairs into a flat buffer that has no pointers in it so it
+// can be written to a file as is. FrozenHashMap is a view that queries such a
+// buffer in place, e.g. straight from an mmap'd file, without deserializing it.
+//
+// The table is a hash-and-displace perfect hash: keys are split into small
+// buckets and each bucket stores a pilot value that was searched for at freeze
+// time so that the bucket's keys land in free slots. A lookup reads one pilot
+// and one slot without any probing, and the table is ~98% full. Slots that are
+// left free hold a copy of some stored pair so that a miss is just a failed
+// key compare, the occupancy bits are only used when iterating.
+// The buffer is only valid for the same Key, Value and Hasher it was frozen
+// with. The hasher has to produce the same hashes across processes, which the
+// wyhash based default ones do. Data is in native byte order.
+//
+// Layout
+//   FrozenHashMapHeader
+//   uint32_t pilots[bucket_count]
+//   uint64_t occupancy[(capacity + 63) / 64]
+//   padding to alignof(Slot)
+//   Slot slots[capacity], Slot is {Key, Value}
+
+struct FrozenHashMapHeader
+{
+    static constexpr uint32_t s_magic = 0x4D464857; // "WHFM"
+    static constexpr uint32_t s_version = 1;
+
+    uint32_t magic{s_magic};
+    uint32_t version{s_version};
+    uint32_t key_size{0};
+    uint32_t value_size{0};
+    uint32_t slot_size{0};
+    uint32_t slot_align{0};
+    uint64_t size{0};
+    uint64_t capacity{0};
+    uint64_t bucket_count{0};
+    uint64_t byte_count{0};
+};
+
+template <typename Key, typename Value, class Hasher = Hash<Key>>
+class FrozenHashMap
+{
+    static_assert(
+        std::is_trivially_copyable_v<Key>,
+        "Frozen keys are stored as raw bytes");
+    static_assert(
+        std::is_trivially_copyable_v<Value>,
+        "Frozen values are stored as raw bytes");
+
+  public:
+    using key_type = Key;
+    // Wording clashes with the STL counterpats, but is consistent with the
+    // template interface
+    using value_type = Value;
+
+    struct Slot
+    {
+        Key key;
+        Value value;
+    };
+
+    // Viewed buffers have to be aligned for the header and the slots
+    static constexpr size_t s_required_alignment =
+        alignof(Slot) > alignof(FrozenHashMapHeader)
+            ? alignof(Slot)
+            : alignof(FrozenHashMapHeader);
+
+    // Empty view
+    FrozenHashMap() noexcept = default;
+    ~FrozenHashMap() = default;
+
+    FrozenHashMap(FrozenHashMap const &other) noexcept = default;
+    FrozenHashMap &operator=(FrozenHashMap const &other) noexcept = default;
+
+    // Returns an empty Optional if data doesn't hold a frozen map of this
+    // type. data has to be aligned to s_required_alignment and it has to
+    // outlive the view.
+    [[nodiscard]] static Optional<FrozenHashMap> view(
+        Span<uint8_t const> data) noexcept;
+
+    // Packs the pairs in map into a buffer that view() accepts. The allocator
+    // is also used for temporaries. Keys with equal 64bit hashes can't be
+    // frozen, an empty buffer is returned for them and if the pilot search
+    // fails. view() rejects the empty buffer.
+    template <class Layout, class Policy>
+    [[nodiscard]] static Array<uint8_t> freeze(
+        Allocator &allocator,
+        HashMap<Key, Value, Hasher, Layout, Policy> const &map) noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    [[nodiscard]] bool contains(Key const &key) const noexcept;
+    [[nodiscard]] Value const *find(Key const &key) const noexcept;
+    // Calls f(Key const &, Value const &) for each pair
+    template <typename F> void for_each(F &&f) const noexcept;
+
+  private:
+    struct BufferLayout
+    {
+        size_t pilots_offset{0};
+        size_t occupancy_offset{0};
+        size_t slots_offset{0};
+        size_t byte_count{0};
+    };
+
+    [[nodiscard]] static size_t s_capacity(size_t size) noexcept
+    {
+        // A little slack keeps the pilot search short for the last buckets
+        return size == 0 ? 0 : size + size / 64 + 1;
+    }
+
+    [[nodiscard]] static size_t s_bucket_count(size_t size) noexcept
+    {
+        // ~4 keys per bucket on average
+        return (size + 3) / 4;
+    }
+
+    [[nodiscard]] static BufferLayout s_buffer_layout(
+        size_t bucket_count, size_t capacity) noexcept
+    {
+        BufferLayout ret;
+        ret.pilots_offset = sizeof(FrozenHashMapHeader);
+        size_t const pilots_end =
+            ret.pilots_offset + bucket_count * sizeof(uint32_t);
+        ret.occupancy_offset = (pilots_end + alignof(uint64_t) - 1) &
+                               ~(alignof(uint64_t) - 1);
+        size_t const occupancy_end =
+            ret.occupancy_offset + (capacity + 63) / 64 * sizeof(uint64_t);
+        ret.slots_offset =
+            (occupancy_end + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+        ret.byte_count = ret.slots_offset + capacity * sizeof(Slot);
+        return ret;
+    }
+
+    // 60% of the keys go into 30% of the buckets. The large buckets are then
+    // placed while the table is still mostly empty, which cuts the total pilot
+    // search by a third compared to uniform buckets.
+    // The bucket doesn't correlate with the slot as the latter is mixed with
+    // the pilot.
+    [[nodiscard]] static size_t s_bucket(
+        uint64_t hash, size_t bucket_count) noexcept
+    {
+        size_t const dense_count = bucket_count * 3 / 10;
+        // The split is a coin flip so keep it branchless
+        bool const dense = hash < 0x9999'9999'9999'9999 && dense_count > 0;
+        size_t const first = dense ? 0 : dense_count;
+        size_t const count = dense ? dense_count : bucket_count - dense_count;
+        uint64_t const low = hash & 0xFFFF'FFFF;
+        return first + (size_t)((low * count) >> 32);
+    }
+
+    [[nodiscard]] static size_t s_slot(
+        uint64_t hash, uint32_t pilot, size_t capacity) noexcept
+    {
+        return (size_t)wy2u0k(wyhash64(hash, pilot), capacity);
+    }
+
+    uint32_t const *m_pilots{nullptr};
+    uint64_t const *m_occupancy{nullptr};
+    Slot const *m_slots{nullptr};
+    size_t m_size{0};
+    size_t m_capacity{0};
+    size_t m_bucket_count{0};
+    Hasher m_hasher{};
+};
+
+template <typename Key, typename Value, class Hasher>
+Optional<FrozenHashMap<Key, Value, Hasher>> FrozenHashMap<
+    Key, Value, Hasher>::view(Span<uint8_t const> data) noexcept
+{
+    WHEELS_ASSERT(
+        ((uintptr_t)data.data() & (s_required_alignment - 1)) == 0 &&
+        "Frozen map data isn't aligned");
+
+    if (data.size() < sizeof(FrozenHashMapHeader))
+        return Optional<FrozenHashMap>{};
+
+    FrozenHashMapHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != FrozenHashMapHeader::s_magic ||
+        header.version != FrozenHashMapHeader::s_version ||
+        header.key_size != sizeof(Key) || header.value_size != sizeof(Value) ||
+        header.slot_size != sizeof(Slot) || header.slot_align != alignof(Slot))
+        return Optional<FrozenHashMap>{};
+
+    // Check the size against the data before using it to avoid overflows
+    if (header.size > data.size() / sizeof(Slot) ||
+        header.capacity != s_capacity(header.size) ||
+        header.bucket_count != s_bucket_count(header.size))
+        return Optional<FrozenHashMap>{};
+
+    BufferLayout const layout =
+        s_buffer_layout(header.bucket_count, header.capacity);
+    if (header.byte_count != layout.byte_count ||
+        header.byte_count > data.size())
+        return Optional<FrozenHashMap>{};
+
+    FrozenHashMap ret;
+    ret.m_pilots =
+        reinterpret_cast<uint32_t const *>(data.data() + layout.pilots_offset);
+    ret.m_occupancy = reinterpret_cast<uint64_t const *>(
+        data.data() + layout.occupancy_offset);
+    ret.m_slots =
+        reinterpret_cast<Slot const *>(data.data() + layout.slots_offset);
+    ret.m_size = header.size;
+    ret.m_capacity = header.capacity;
+    ret.m_bucket_count = header.bucket_count;
+
+    return Optional<FrozenHashMap>{ret};
+}
+
+template <typename Key, typename Value, class Hasher>
+template <class Layout, class Policy>
+Array<uint8_t> FrozenHashMap<Key, Value, Hasher>::freeze(
+    Allocator &allocator,
+    HashMap<Key, Value, Hasher, Layout, Policy> const &map) noexcept
+{
+    size_t const size = map.size();
+
+    FrozenHashMapHeader header;
+    header.key_size = sizeof(Key);
+    header.value_size = sizeof(Value);
+    header.slot_size = sizeof(Slot);
+    header.slot_align = alignof(Slot);
+    header.size = size;
+    header.capacity = s_capacity(size);
+    header.bucket_count = s_bucket_count(size);
+
+    size_t const capacity = header.capacity;
+    size_t const bucket_count = header.bucket_count;
+    BufferLayout const layout = s_buffer_layout(bucket_count, capacity);
+    header.byte_count = layout.byte_count;
+
+    Array<uint8_t> ret{allocator, layout.byte_count};
+    // Zero the padding so that the output is deterministic
+    ret.resize(layout.byte_count, 0);
+    WHEELS_ASSERT(
+        ((uintptr_t)ret.data() & (s_required_alignment - 1)) == 0 &&
+        "Allocator doesn't align enough for the frozen slots");
+
+    memcpy(ret.data(), &header, sizeof(header));
+    if (size == 0)
+        return ret;
+
+    struct Entry
+    {
+        uint64_t hash{0};
+        Key const *key{nullptr};
+        Value const *value{nullptr};
+    };
+    Array<Entry> entries{allocator, size};
+    Hasher const hasher{};
+    for (auto const kv : map)
+        entries.push_back(Entry{
+            .hash = hasher(*kv.first),
+            .key = kv.first,
+            .value = kv.second,
+        });
+
+    // Counting sort the entries into their buckets
+    Array<size_t> bucket_starts{allocator, bucket_count + 1};
+    bucket_starts.resize(bucket_count + 1, 0);
+    for (Entry const &e : entries)
+        bucket_starts[s_bucket(e.hash, bucket_count) + 1]++;
+    size_t max_bucket_size = 0;
+    for (size_t b = 0; b < bucket_count; ++b)
+    {
+        size_t const bucket_size = bucket_starts[b + 1];
+        if (bucket_size > max_bucket_size)
+            max_bucket_size = bucket_size;
+        bucket_starts[b + 1] += bucket_starts[b];
+    }
+
+    Array<size_t> bucketed{allocator, size};
+    bucketed.resize(size);
+    Array<uint64_t> bucketed_hashes{allocator, size};
+    bucketed_hashes.resize(size);
+    {
+        Array<size_t> cursors{allocator, bucket_count};
+        cursors.extend(Span<size_t const>{bucket_starts.data(), bucket_count});
+        for (size_t i = 0; i < size; ++i)
+        {
+            size_t const bucket = s_bucket(entries[i].hash, bucket_count);
+            size_t const j = cursors[bucket]++;
+            bucketed[j] = i;
+            bucketed_hashes[j] = entries[i].hash;
+        }
+    }
+
+    uint8_t *pilots = ret.data() + layout.pilots_offset;
+    uint64_t *occupancy =
+        reinterpret_cast<uint64_t *>(ret.data() + layout.occupancy_offset);
+    Slot *slots = reinterpret_cast<Slot *>(ret.data() + layout.slots_offset);
+
+    // The occupancy bits double as the taken slots while placing
+    Array<size_t> positions{allocator, max_bucket_size};
+
+    // Place the largest buckets first while there's still plenty of room
+    for (size_t bucket_size = max_bucket_size; bucket_size > 0; --bucket_size)
+    {
+        for (size_t b = 0; b < bucket_count; ++b)
+        {
+            size_t const begin = bucket_starts[b];
+            size_t const end = bucket_starts[b + 1];
+            if (end - begin != bucket_size)
+                continue;
+
+            // No pilot can separate these so bail out instead of searching
+            // forever
+            for (size_t i = begin; i < end; ++i)
+            {
+                for (size_t j = i + 1; j < end; ++j)
+                {
+                    if (bucketed_hashes[i] == bucketed_hashes[j])
+                        return Array<uint8_t>{allocator};
+                }
+            }
+
+            uint32_t pilot = 0;
+            while (true)
+            {
+                positions.clear();
+                for (size_t i = begin; i < end; ++i)
+                {
+                    size_t const pos =
+                        s_slot(bucketed_hashes[i], pilot, capacity);
+                    uint64_t const bit = (uint64_t)1 << (pos % 64);
+                    if ((occupancy[pos / 64] & bit) != 0)
+                        break;
+                    // Also catches collisions within the bucket
+                    occupancy[pos / 64] |= bit;
+                    positions.push_back(pos);
+                }
+                if (positions.size() == bucket_size)
+                    break;
+
+                for (size_t pos : positions)
+                    occupancy[pos / 64] &= ~((uint64_t)1 << (pos % 64));
+                if (pilot == UINT32_MAX)
+                    return Array<uint8_t>{allocator};
+                pilot++;
+            }
+
+            memcpy(pilots + b * sizeof(uint32_t), &pilot, sizeof(pilot));
+            for (size_t i = 0; i < bucket_size; ++i)
+            {
+                Entry const &e = entries[bucketed[begin + i]];
+                size_t const pos = positions[i];
+                memcpy(&slots[pos].key, e.key, sizeof(Key));
+                memcpy(&slots[pos].value, e.value, sizeof(Value));
+            }
+        }
+    }
+
+    // Free slots repeat a stored pair so lookups can skip the occupancy check.
+    // A lookup for that key can't end up here and if it did, the pair would
+    // still be correct.
+    for (size_t pos = 0; pos < capacity; ++pos)
+    {
+        if ((occupancy[pos / 64] & ((uint64_t)1 << (pos % 64))) == 0)
+        {
+            memcpy(&slots[pos].key, entries[0].key, sizeof(Key));
+            memcpy(&slots[pos].value, entries[0].value, sizeof(Value));
+        }
+    }
+
+    return ret;
+}
+
+template <typename Key, typename Value, class Hasher>
+bool FrozenHashMap<Key, Value, Hasher>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <typename Key, typename Value, class Hasher>
+size_t FrozenHashMap<Key, Value, Hasher>::size() const noexcept
+{
+    return m_size;
+}
+
+template <typename Key, typename Value, class Hasher>
+size_t FrozenHashMap<Key, Value, Hasher>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template <typename Key, typename Value, class Hasher>
+bool FrozenHashMap<Key, Value, Hasher>::contains(Key const &key) const noexcept
+{
+    return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, class Hasher>
+Value const *FrozenHashMap<Key, Value, Hasher>::find(
+    Key const &key) const noexcept
+{
+    if (m_size == 0)
+        return nullptr;
+
+    uint64_t const hash = m_hasher(key);
+    uint32_t const pilot = m_pilots[s_bucket(hash, m_bucket_count)];
+    Slot const &slot = m_slots[s_slot(hash, pilot, m_capacity)];
+    if (slot.key == key)
+        return &slot.value;
+
+    return nullptr;
+}
+
+template <typename Key, typename Value, class Hasher>
+template <typename F>
+void FrozenHashMap<Key, Value, Hasher>::for_each(F &&f) const noexcept
+{
+    for (size_t pos = 0; pos < m_capacity; ++pos)
+    {
+        if ((m_occupancy[pos / 64] & ((uint64_t)1 << (pos % 64))) != 0)
+            f(m_slots[pos].key, m_slots[pos].value);
+    }
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_FROZEN_HASH_MAP_HPP
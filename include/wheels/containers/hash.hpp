@@ -1,7 +1,9 @@
 #ifndef WHEELS_CONTAINERS_HASH_HPP
 #define WHEELS_CONTAINERS_HASH_HPP
 
+#include <cstdint>
 #include <functional>
+#include <type_traits>
 #include <wyhash.h>
 
 namespace wheels
@@ -31,8 +33,8 @@ template <typename T> struct Hash<T *>
         }                                                                      \
     }
 
-// TODO: Faster small value hashes? Only casting seems bad as these might get
-// used with strided values
+// These hash the bytes so that the hashes are stable for serialized containers.
+// MixHash is a faster alternative for integer keys.
 WHEELS_HASH_DEFINE_IMPLEMENTATION(int8_t);
 WHEELS_HASH_DEFINE_IMPLEMENTATION(uint8_t);
 WHEELS_HASH_DEFINE_IMPLEMENTATION(int16_t);
@@ -46,6 +48,56 @@ WHEELS_HASH_DEFINE_IMPLEMENTATION(double);
 
 #undef WHEELS_HASH_DEFINE_IMPLEMENTATION
 
+// Constant time hash for integers and pointers that mixes the value with two
+// 64x64->128bit multiplies. A single multiply is as fast, but leaves output
+// bits that barely depend on some input bits. Cheaper than the byte hash in
+// Hash<T> and still spreads sequential and strided keys over both the probe
+// position and the H2 bits of the hash containers. Selected per container,
+// e.g. HashSet<uint32_t, MixHash<uint32_t>>.
+template <typename T> struct MixHash
+{
+    static_assert(
+        std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>,
+        "MixHash is only implemented for integers and pointers");
+
+    [[nodiscard]] uint64_t operator()(T const &value) const noexcept
+    {
+        uint64_t bits = 0;
+        if constexpr (std::is_pointer_v<T>)
+            bits = (uint64_t)(uintptr_t)value;
+        else
+            bits = (uint64_t)value;
+        return wyhash64(bits, 0);
+    }
+};
+
+// Folds the hash of the next field of a composite value into seed. Order
+// matters so that e.g. Pair{a, b} and Pair{b, a} hash differently.
+[[nodiscard]] inline uint64_t hash_combine(
+    uint64_t seed, uint64_t hash) noexcept
+{
+    return wyhash64(seed, hash);
+}
+
+// True for types whose values are equal exactly when their bytes are. Composite
+// hashes use a single wyhash over their bytes when all fields are byte hashable
+// and there's no padding between them, and combine the field hashes otherwise.
+// Floats aren't byte hashable as 0.0 == -0.0. Containers specialize this for
+// themselves.
+template <typename T>
+inline constexpr bool byte_hashable =
+    std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>;
+
+// Makes HashMap and HashSet store the full hash next to each slot, e.g.
+// HashMap<String, uint32_t, StoredHash<Hash<String>>>. Growing then reuses the
+// stored hashes instead of hashing every key again and lookups compare the
+// hashes before the keys. Worth the extra 8 bytes per slot when hashing or
+// comparing keys is expensive, like with long strings.
+template <class Hasher> struct StoredHash : Hasher
+{
+    static constexpr bool s_store_hash = true;
+};
+
 } // namespace wheels
 
 #endif // WHEELS_CONTAINERS_HASH_HPP
@@ -14,11 +14,93 @@
 namespace wheels
 {
 
+// Slot layouts for HashMap
+// Split stores keys, values and metadata in separate arrays. Probing only
+// touches the keys so this is better for misses and large values.
+struct SplitLayout
+{
+};
+// Interleaved stores Pair<Key, Value> slots and metadata in a single
+// allocation. A hit touches the key and value in the same cache line for small
+// enough pairs.
+struct InterleavedLayout
+{
+};
+
+template <typename Key, typename Value, class Layout> struct HashMapSlots;
+
+template <typename Key, typename Value>
+struct HashMapSlots<Key, Value, SplitLayout>
+{
+    Key *keys{nullptr};
+    Value *values{nullptr};
+    uint8_t *metadata{nullptr};
+
+    [[nodiscard]] Key *key(size_t pos) const noexcept { return keys + pos; }
+    [[nodiscard]] Value *value(size_t pos) const noexcept
+    {
+        return values + pos;
+    }
+
+    void allocate(Allocator &allocator, size_t capacity) noexcept
+    {
+        keys = (Key *)allocator.allocate(capacity * sizeof(Key));
+        WHEELS_ASSERT(keys != nullptr);
+        values = (Value *)allocator.allocate(capacity * sizeof(Value));
+        WHEELS_ASSERT(values != nullptr);
+        metadata = (uint8_t *)allocator.allocate(capacity * sizeof(uint8_t));
+        WHEELS_ASSERT(metadata != nullptr);
+    }
+
+    void deallocate(Allocator &allocator) const noexcept
+    {
+        allocator.deallocate(keys);
+        allocator.deallocate(values);
+        allocator.deallocate(metadata);
+    }
+};
+
+template <typename Key, typename Value>
+struct HashMapSlots<Key, Value, InterleavedLayout>
+{
+    Pair<Key, Value> *slots{nullptr};
+    // Points to the end of the slots in the same allocation
+    uint8_t *metadata{nullptr};
+
+    [[nodiscard]] Key *key(size_t pos) const noexcept
+    {
+        return &slots[pos].first;
+    }
+    [[nodiscard]] Value *value(size_t pos) const noexcept
+    {
+        return &slots[pos].second;
+    }
+
+    void allocate(Allocator &allocator, size_t capacity) noexcept
+    {
+        size_t const slots_byte_count = capacity * sizeof(Pair<Key, Value>);
+        uint8_t *data = (uint8_t *)allocator.allocate(
+            slots_byte_count + capacity * sizeof(uint8_t));
+        WHEELS_ASSERT(data != nullptr);
+
+        slots = (Pair<Key, Value> *)data;
+        metadata = data + slots_byte_count;
+    }
+
+    void deallocate(Allocator &allocator) const noexcept
+    {
+        allocator.deallocate(slots);
+    }
+};
+
 // Based on Google's SwissMap cppcon 2017 talk by Matt Kulukundis
 // without the SIMD magic for now
 // https://www.youtube.com/watch?v=ncHmEUmJZf4
 
-template <typename Key, typename Value, class Hasher = Hash<Key>> class HashMap
+template <
+    typename Key, typename Value, class Hasher = Hash<Key>,
+    class Layout = SplitLayout, class Policy = DefaultHashPolicy>
+class HashMap
 {
     static_assert(
         InvocableHash<Hasher, Key>, "Hasher has to be invocable with Key");
@@ -41,10 +123,8 @@ template <typename Key, typename Value, class Hasher = Hash<Key>> class HashMap
         [[nodiscard]] Pair<Key const *, Value *> operator*() noexcept;
         [[nodiscard]] Pair<Key const *, Value const *> operator*()
             const noexcept;
-        [[nodiscard]] bool operator!=(
-            HashMap<Key, Value, Hasher>::Iterator const &other) const noexcept;
-        [[nodiscard]] bool operator==(
-            HashMap<Key, Value, Hasher>::Iterator const &other) const noexcept;
+        [[nodiscard]] bool operator!=(Iterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(Iterator const &other) const noexcept;
 
         HashMap const &map;
         size_t pos{0};
@@ -57,11 +137,9 @@ template <typename Key, typename Value, class Hasher = Hash<Key>> class HashMap
         [[nodiscard]] Pair<Key const *, Value const *> operator*()
             const noexcept;
         [[nodiscard]] bool operator!=(
-            HashMap<Key, Value, Hasher>::ConstIterator const &other)
-            const noexcept;
+            ConstIterator const &other) const noexcept;
         [[nodiscard]] bool operator==(
-            HashMap<Key, Value, Hasher>::ConstIterator const &other)
-            const noexcept;
+            ConstIterator const &other) const noexcept;
 
         HashMap const &map;
         size_t pos{0};
@@ -74,12 +152,10 @@ template <typename Key, typename Value, class Hasher = Hash<Key>> class HashMap
     HashMap(Allocator &allocator, size_t initial_capacity = 0) noexcept;
     ~HashMap();
 
-    HashMap(HashMap<Key, Value, Hasher> const &other) = delete;
-    HashMap(HashMap<Key, Value, Hasher> &&other) noexcept;
-    HashMap<Key, Value, Hasher> &operator=(
-        HashMap<Key, Value, Hasher> const &other) = delete;
-    HashMap<Key, Value, Hasher> &operator=(
-        HashMap<Key, Value, Hasher> &&other) noexcept;
+    HashMap(HashMap const &other) = delete;
+    HashMap(HashMap &&other) noexcept;
+    HashMap &operator=(HashMap const &other) = delete;
+    HashMap &operator=(HashMap &&other) noexcept;
 
     [[nodiscard]] Iterator begin() noexcept;
     [[nodiscard]] ConstIterator begin() const noexcept;
@@ -90,26 +166,82 @@ template <typename Key, typename Value, class Hasher = Hash<Key>> class HashMap
     [[nodiscard]] size_t size() const noexcept;
     [[nodiscard]] size_t capacity() const noexcept;
 
+    // Grows the table so that it fits at least size items without growing
+    // again
+    void reserve(size_t size) noexcept;
+    // Moves the items into the smallest table that fits them or frees the
+    // table if the map is empty
+    void shrink_to_fit() noexcept;
+    // Moves the items into a table of at least the given capacity, also
+    // dropping the Deleted slots. Capacity is raised to what the current items
+    // need so this can also shrink the table.
+    void rehash(size_t capacity) noexcept;
+
     [[nodiscard]] bool contains(Key const &key) const noexcept;
     [[nodiscard]] Value const *find(Key const &key) const noexcept;
     [[nodiscard]] Value *find(Key const &key) noexcept;
 
+    // Returns the hash the map uses for key. It can be computed once for
+    // lookups into several maps that use the same hasher, or ahead of the
+    // probes in a separate pass.
+    [[nodiscard]] uint64_t hash_of(Key const &key) const noexcept;
+    // The *_with_hash versions skip hashing the key. hash has to be
+    // hash_of(key).
+    [[nodiscard]] bool contains_with_hash(
+        Key const &key, uint64_t hash) const noexcept;
+    [[nodiscard]] Value const *find_with_hash(
+        Key const &key, uint64_t hash) const noexcept;
+    [[nodiscard]] Value *find_with_hash(Key const &key, uint64_t hash) noexcept;
+
     void clear() noexcept;
 
     template <typename K, typename V>
     // Let's be pedantic and disallow implicit conversions
         requires(SameAs<K, Key> && SameAs<V, Value>)
     Value *insert_or_assign(K &&key, V &&value) noexcept;
+    template <typename K, typename V>
+        requires(SameAs<K, Key> && SameAs<V, Value>)
+    Value *insert_or_assign_with_hash(
+        K &&key, V &&value, uint64_t hash) noexcept;
     // Don't have a pair insert for now as it would have to either copy every
     // time or I'd have to write two versions: one for lvalue that copies and
     // one for rvalue that moves
 
     void remove(Key const &key) noexcept;
+    void remove_with_hash(Key const &key, uint64_t hash) noexcept;
+
+    // Calls f(Key const &, Value &) for each pair. f can't modify the map.
+    template <typename F> void for_each(F &&f) noexcept;
+    // Calls f(Key const &, Value const &) for each pair. f can't modify the
+    // map.
+    template <typename F> void for_each(F &&f) const noexcept;
+    // Removes the pairs for which pred(Key const &, Value const &) returns
+    // true. Returns the number of removed pairs. pred can't modify the map.
+    template <typename F> size_t erase_if(F &&pred) noexcept;
 
   private:
     [[nodiscard]] bool is_over_max_load() const noexcept;
 
-    void grow(size_t capacity) noexcept;
+    // Returns m_capacity if the key isn't in the map
+    [[nodiscard]] size_t find_pos(
+        uint64_t hash, Key const &key) const noexcept;
+    // Claims the first free slot for a key that isn't in the map yet. The
+    // caller has to construct the key and value, and update the size.
+    [[nodiscard]] size_t insert_unique_slot(uint64_t hash) noexcept;
+    // Compares the stored hash first if there is one
+    [[nodiscard]] bool key_matches(
+        size_t pos, uint64_t hash, Key const &key) const noexcept;
+    // Logs the group of pos if the slot is about to become the first
+    // non-Empty one in it. Has to be called before the control byte is
+    // written.
+    void track_group(size_t pos) noexcept;
+    // Calls the dtors of the items in the Full slots of the group
+    void destroy_group_items(size_t group_pos) noexcept;
+    // Moves the items into a new table of at least the given capacity, also
+    // dropping the Deleted slots
+    void reallocate(size_t capacity) noexcept;
+    // Frees the table without calling any dtors
+    void deallocate_table() noexcept;
     void destroy() noexcept;
 
     enum class Ctrl : uint8_t
@@ -136,16 +268,21 @@ template <typename Key, typename Value, class Hasher = Hash<Key>> class HashMap
     }
 
     Allocator &m_allocator;
-    Key *m_keys{nullptr};
-    Value *m_values{nullptr};
-    uint8_t *m_metadata{nullptr};
+    HashMapSlots<Key, Value, Layout> m_slots;
+    // Only allocated if the hasher opts into StoresHash
+    uint64_t *m_hashes{nullptr};
+    // Only allocated if the policy uses HashClear::Tracked. Indices of the
+    // groups that have had values inserted since the last clear.
+    uint32_t *m_dirty_groups{nullptr};
+    size_t m_dirty_group_count{0};
     size_t m_size{0};
     size_t m_capacity{0};
     Hasher m_hasher{};
 };
 
-template <typename Key, typename Value, class Hasher>
-HashMap<Key, Value, Hasher>::HashMap(
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+HashMap<Key, Value, Hasher, Layout, Policy>::HashMap(
     Allocator &allocator, size_t initial_capacity) noexcept
 : m_allocator{allocator}
 {
@@ -155,32 +292,40 @@ HashMap<Key, Value, Hasher>::HashMap(
         "Aligned allocations beyond std::max_align_t aren't supported");
 
     if (initial_capacity > 0)
-        grow(initial_capacity);
+        reallocate(initial_capacity);
 }
 
-template <typename Key, typename Value, class Hasher>
-HashMap<Key, Value, Hasher>::~HashMap()
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+HashMap<Key, Value, Hasher, Layout, Policy>::~HashMap()
 {
     destroy();
 }
 
-template <typename Key, typename Value, class Hasher>
-HashMap<Key, Value, Hasher>::HashMap(
-    HashMap<Key, Value, Hasher> &&other) noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+HashMap<Key, Value, Hasher, Layout, Policy>::HashMap(HashMap &&other) noexcept
 : m_allocator{other.m_allocator}
-, m_keys{other.m_keys}
-, m_values{other.m_values}
-, m_metadata{other.m_metadata}
+, m_slots{other.m_slots}
+, m_hashes{other.m_hashes}
+, m_dirty_groups{other.m_dirty_groups}
+, m_dirty_group_count{other.m_dirty_group_count}
 , m_size{other.m_size}
 , m_capacity{other.m_capacity}
 , m_hasher{WHEELS_MOV(other.m_hasher)}
 {
-    other.m_keys = nullptr;
+    other.m_slots = HashMapSlots<Key, Value, Layout>{};
+    other.m_hashes = nullptr;
+    other.m_dirty_groups = nullptr;
+    other.m_dirty_group_count = 0;
+    other.m_size = 0;
+    other.m_capacity = 0;
 }
 
-template <typename Key, typename Value, class Hasher>
-HashMap<Key, Value, Hasher> &HashMap<Key, Value, Hasher>::operator=(
-    HashMap<Key, Value, Hasher> &&other) noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+HashMap<Key, Value, Hasher, Layout, Policy> &HashMap<
+    Key, Value, Hasher, Layout, Policy>::operator=(HashMap &&other) noexcept
 {
     WHEELS_ASSERT(
         &m_allocator == &other.m_allocator &&
@@ -191,59 +336,50 @@ HashMap<Key, Value, Hasher> &HashMap<Key, Value, Hasher>::operator=(
     {
         destroy();
 
-        m_keys = other.m_keys;
-        m_values = other.m_values;
-        m_metadata = other.m_metadata;
+        m_slots = other.m_slots;
+        m_hashes = other.m_hashes;
+        m_dirty_groups = other.m_dirty_groups;
+        m_dirty_group_count = other.m_dirty_group_count;
         m_size = other.m_size;
         m_capacity = other.m_capacity;
         m_hasher = WHEELS_MOV(other.m_hasher);
 
-        other.m_keys = nullptr;
+        other.m_slots = HashMapSlots<Key, Value, Layout>{};
+        other.m_hashes = nullptr;
+        other.m_dirty_groups = nullptr;
+        other.m_dirty_group_count = 0;
+        other.m_size = 0;
+        other.m_capacity = 0;
     }
     return *this;
 }
 
-template <typename Key, typename Value, class Hasher>
-typename HashMap<Key, Value, Hasher>::Iterator HashMap<
-    Key, Value, Hasher>::begin() noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+typename HashMap<Key, Value, Hasher, Layout, Policy>::Iterator HashMap<
+    Key, Value, Hasher, Layout, Policy>::begin() noexcept
 {
-    Iterator iter{
+    return Iterator{
         .map = *this,
-        .pos = 0,
+        .pos = next_full_ctrl(m_slots.metadata, 0, m_capacity),
     };
-
-    if (m_capacity == 0)
-        return iter;
-
-    if (s_empty_pos(m_metadata, iter.pos))
-        iter++;
-    WHEELS_ASSERT(iter == end() || !s_empty_pos(m_metadata, iter.pos));
-
-    return iter;
 }
 
-template <typename Key, typename Value, class Hasher>
-typename HashMap<Key, Value, Hasher>::ConstIterator HashMap<
-    Key, Value, Hasher>::begin() const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+typename HashMap<Key, Value, Hasher, Layout, Policy>::ConstIterator HashMap<
+    Key, Value, Hasher, Layout, Policy>::begin() const noexcept
 {
-    ConstIterator iter{
+    return ConstIterator{
         .map = *this,
-        .pos = 0,
+        .pos = next_full_ctrl(m_slots.metadata, 0, m_capacity),
     };
-
-    if (m_capacity == 0)
-        return iter;
-
-    if (s_empty_pos(m_metadata, iter.pos))
-        iter++;
-    WHEELS_ASSERT(iter == end() || !s_empty_pos(m_metadata, iter.pos));
-
-    return iter;
 }
 
-template <typename Key, typename Value, class Hasher>
-typename HashMap<Key, Value, Hasher>::Iterator HashMap<
-    Key, Value, Hasher>::end() noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+typename HashMap<Key, Value, Hasher, Layout, Policy>::Iterator HashMap<
+    Key, Value, Hasher, Layout, Policy>::end() noexcept
 {
     return Iterator{
         .map = *this,
@@ -251,9 +387,10 @@ typename HashMap<Key, Value, Hasher>::Iterator HashMap<
     };
 }
 
-template <typename Key, typename Value, class Hasher>
-typename HashMap<Key, Value, Hasher>::ConstIterator HashMap<
-    Key, Value, Hasher>::end() const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+typename HashMap<Key, Value, Hasher, Layout, Policy>::ConstIterator HashMap<
+    Key, Value, Hasher, Layout, Policy>::end() const noexcept
 {
     return ConstIterator{
         .map = *this,
@@ -261,371 +398,704 @@ typename HashMap<Key, Value, Hasher>::ConstIterator HashMap<
     };
 }
 
-template <typename Key, typename Value, class Hasher>
-bool HashMap<Key, Value, Hasher>::empty() const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::empty() const noexcept
 {
     return m_size == 0;
 }
 
-template <typename Key, typename Value, class Hasher>
-size_t HashMap<Key, Value, Hasher>::size() const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+size_t HashMap<Key, Value, Hasher, Layout, Policy>::size() const noexcept
 {
     return m_size;
 }
 
-template <typename Key, typename Value, class Hasher>
-size_t HashMap<Key, Value, Hasher>::capacity() const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+size_t HashMap<Key, Value, Hasher, Layout, Policy>::capacity() const noexcept
 {
     return m_capacity;
 }
 
-template <typename Key, typename Value, class Hasher>
-bool HashMap<Key, Value, Hasher>::contains(Key const &key) const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::reserve(size_t size) noexcept
+{
+    size_t const capacity = Policy::s_capacity_for(size);
+    if (capacity > m_capacity)
+        reallocate(capacity);
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::shrink_to_fit() noexcept
+{
+    if (m_size == 0)
+        destroy();
+    else
+    {
+        size_t const capacity = Policy::s_capacity_for(m_size);
+        if (capacity < m_capacity)
+            reallocate(capacity);
+    }
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::rehash(
+    size_t capacity) noexcept
+{
+    size_t const min_capacity = Policy::s_capacity_for(m_size);
+    reallocate(capacity < min_capacity ? min_capacity : capacity);
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::contains(
+    Key const &key) const noexcept
 {
     return find(key) != nullptr;
 }
 
-template <typename Key, typename Value, class Hasher>
-Value const *HashMap<Key, Value, Hasher>::find(Key const &key) const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+Value const *HashMap<Key, Value, Hasher, Layout, Policy>::find(
+    Key const &key) const noexcept
 {
     if (m_size == 0)
         return nullptr;
 
-    uint64_t const hash = m_hasher(key);
-    uint8_t const h2 = s_h2(hash);
-    // Keep track of start pos so we can break out before looping again if all
-    // slots are full or deleted.
-    // Capacity is a power of 2 so this mask just works
-    size_t const start_pos = s_h1(hash) & (m_capacity - 1);
-    size_t pos = start_pos;
-    while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
-    {
-        uint8_t const meta = m_metadata[pos];
-        if (h2 == meta && key == m_keys[pos])
-            return &m_values[pos];
+    return find_with_hash(key, m_hasher(key));
+}
 
-        // capacity is a power of 2 so this mask just works
-        pos = (pos + 1) & (m_capacity - 1);
-        if (pos == start_pos) [[unlikely]]
-            break;
-    }
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+Value *HashMap<Key, Value, Hasher, Layout, Policy>::find(
+    Key const &key) noexcept
+{
+    if (m_size == 0)
+        return nullptr;
+
+    return find_with_hash(key, m_hasher(key));
+}
 
-    return nullptr;
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+uint64_t HashMap<Key, Value, Hasher, Layout, Policy>::hash_of(
+    Key const &key) const noexcept
+{
+    return m_hasher(key);
 }
 
-template <typename Key, typename Value, class Hasher>
-Value *HashMap<Key, Value, Hasher>::find(Key const &key) noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::contains_with_hash(
+    Key const &key, uint64_t hash) const noexcept
+{
+    return find_with_hash(key, hash) != nullptr;
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+Value const *HashMap<Key, Value, Hasher, Layout, Policy>::find_with_hash(
+    Key const &key, uint64_t hash) const noexcept
 {
     if (m_size == 0)
         return nullptr;
 
-    uint64_t const hash = m_hasher(key);
-    uint8_t const h2 = s_h2(hash);
-    // Keep track of start pos so we can break out before looping again if all
-    // slots are full or deleted.
-    // Capacity is a power of 2 so this mask just works
-    size_t const start_pos = s_h1(hash) & (m_capacity - 1);
-    size_t pos = start_pos;
-    while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
-    {
-        uint8_t const meta = m_metadata[pos];
-        if (h2 == meta && key == m_keys[pos])
-            return &m_values[pos];
+    size_t const pos = find_pos(hash, key);
+    if (pos == m_capacity)
+        return nullptr;
 
-        // capacity is a power of 2 so this mask just works
-        pos = (pos + 1) & (m_capacity - 1);
-        if (pos == start_pos) [[unlikely]]
-            break;
-    }
+    return m_slots.value(pos);
+}
 
-    return nullptr;
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+Value *HashMap<Key, Value, Hasher, Layout, Policy>::find_with_hash(
+    Key const &key, uint64_t hash) noexcept
+{
+    if (m_size == 0)
+        return nullptr;
+
+    size_t const pos = find_pos(hash, key);
+    if (pos == m_capacity)
+        return nullptr;
+
+    return m_slots.value(pos);
 }
 
-template <typename Key, typename Value, class Hasher>
-void HashMap<Key, Value, Hasher>::clear() noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::clear() noexcept
 {
-    if (m_size > 0)
+    // There's no table before the first insert or after shrink_to_fit()
+    if (m_slots.metadata == nullptr)
+        return;
+
+    size_t const size = m_size;
+    m_size = 0;
+
+    if constexpr (Policy::s_clear == HashClear::Tracked)
+    {
+        // Only the logged groups can have Full or Deleted slots
+        for (size_t i = 0; i < m_dirty_group_count; ++i)
+        {
+            size_t const group_pos =
+                (size_t)m_dirty_groups[i] * s_ctrl_group_width;
+            if (size > 0)
+                destroy_group_items(group_pos);
+            memset(
+                m_slots.metadata + group_pos, (uint8_t)Ctrl::Empty,
+                s_ctrl_group_width * sizeof(uint8_t));
+        }
+        m_dirty_group_count = 0;
+    }
+    else
     {
-        if constexpr (
-            !std::is_trivially_destructible_v<Key> ||
-            !std::is_trivially_destructible_v<Value>)
+        if (size > 0)
         {
-            for (size_t i = 0; i < m_capacity; ++i)
+            for (size_t group_pos = 0; group_pos < m_capacity;
+                 group_pos += s_ctrl_group_width)
+                destroy_group_items(group_pos);
+        }
+
+        if constexpr (Policy::s_clear == HashClear::Shrink)
+        {
+            // A fresh table only needs to reset the control bytes for the
+            // smaller capacity
+            size_t const capacity = Policy::s_capacity_for(size);
+            if (size > 0 &&
+                m_capacity > Policy::s_clear_shrink_factor * capacity)
             {
-                if (!s_empty_pos(m_metadata, i))
-                {
-                    if constexpr (!std::is_trivially_destructible_v<Key>)
-                        m_keys[i].~Key();
-                    if constexpr (!std::is_trivially_destructible_v<Value>)
-                        m_values[i].~Value();
-                }
+                deallocate_table();
+                reallocate(capacity);
+                return;
             }
         }
-        m_size = 0;
+
+        memset(
+            m_slots.metadata, (uint8_t)Ctrl::Empty,
+            m_capacity * sizeof(uint8_t));
     }
-    memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
 }
 
-template <typename Key, typename Value, class Hasher>
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
 template <typename K, typename V>
     requires(SameAs<K, Key> && SameAs<V, Value>)
-Value *HashMap<Key, Value, Hasher>::insert_or_assign(
+Value *HashMap<Key, Value, Hasher, Layout, Policy>::insert_or_assign(
     K &&key, V &&value) noexcept
+{
+    uint64_t const hash = m_hasher(key);
+    return insert_or_assign_with_hash(WHEELS_FWD(key), WHEELS_FWD(value), hash);
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+template <typename K, typename V>
+    requires(SameAs<K, Key> && SameAs<V, Value>)
+Value *HashMap<Key, Value, Hasher, Layout, Policy>::insert_or_assign_with_hash(
+    K &&key, V &&value, uint64_t hash) noexcept
 {
     if (is_over_max_load())
-        grow(m_capacity * 2);
+        reallocate(m_capacity * 2);
 
-    uint64_t const hash = m_hasher(key);
     uint8_t const h2 = s_h2(hash);
+    // The whole probe sequence has to be checked for the key before a Deleted
+    // slot can be reused or the key could end up in the map twice
     // Capacity is a power of 2 so this mask just works
-    size_t pos = s_h1(hash) & (m_capacity - 1);
-    while (true)
+    size_t const start_pos = s_h1(hash) & (m_capacity - 1);
+    size_t pos = start_pos;
+    size_t free_pos = m_capacity;
+    while (m_slots.metadata[pos] != (uint8_t)Ctrl::Empty)
     {
-        if (s_empty_pos(m_metadata, pos))
-        {
-            new (m_keys + pos) Key{WHEELS_FWD(key)};
-            new (m_values + pos) Value{WHEELS_FWD(value)};
-            m_metadata[pos] = h2;
-            m_size++;
-            return &m_values[pos];
-        }
-        else if (h2 == m_metadata[pos] && key == m_keys[pos])
+        uint8_t const meta = m_slots.metadata[pos];
+        if (h2 == meta && key_matches(pos, hash, key))
         {
-            m_values[pos].~Value();
-            new (m_values + pos) Value{WHEELS_FWD(value)};
-            return &m_values[pos];
+            m_slots.value(pos)->~Value();
+            new (m_slots.value(pos)) Value{WHEELS_FWD(value)};
+            return m_slots.value(pos);
         }
+        if (meta == (uint8_t)Ctrl::Deleted && free_pos == m_capacity)
+            free_pos = pos;
 
         // Capacity is a power of 2 so this mask just works
         pos = (pos + 1) & (m_capacity - 1);
+        if (pos == start_pos) [[unlikely]]
+            break;
     }
+    if (free_pos == m_capacity)
+        free_pos = pos;
+    WHEELS_ASSERT(s_empty_pos(m_slots.metadata, free_pos));
+
+    new (m_slots.key(free_pos)) Key{WHEELS_FWD(key)};
+    new (m_slots.value(free_pos)) Value{WHEELS_FWD(value)};
+    track_group(free_pos);
+    m_slots.metadata[free_pos] = h2;
+    if constexpr (StoresHash<Hasher>)
+        m_hashes[free_pos] = hash;
+    m_size++;
+
+    return m_slots.value(free_pos);
 }
 
-template <typename Key, typename Value, class Hasher>
-void HashMap<Key, Value, Hasher>::remove(Key const &key) noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::remove(
+    Key const &key) noexcept
 {
     if (m_size == 0)
         return;
 
-    uint64_t const hash = m_hasher(key);
+    remove_with_hash(key, m_hasher(key));
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::remove_with_hash(
+    Key const &key, uint64_t hash) noexcept
+{
+    if (m_size == 0)
+        return;
+
+    size_t const pos = find_pos(hash, key);
+    if (pos == m_capacity)
+        return;
+
+    if constexpr (!std::is_trivially_destructible_v<Key>)
+        m_slots.key(pos)->~Key();
+    if constexpr (!std::is_trivially_destructible_v<Value>)
+        m_slots.value(pos)->~Value();
+    m_slots.metadata[pos] = (uint8_t)Ctrl::Deleted;
+    m_size--;
+
+    // Find for missing value gets really bad if all slots are Deleted so let's
+    // clean up to be safe
+    if (m_size == 0) [[unlikely]]
+        clear();
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+template <typename F>
+void HashMap<Key, Value, Hasher, Layout, Policy>::for_each(F &&f) noexcept
+{
+    // Full slots are found a group of control bytes at a time so sparse tables
+    // are cheap to scan
+    for (size_t group_pos = 0; group_pos < m_capacity;
+         group_pos += s_ctrl_group_width)
+    {
+        uint64_t full_mask = full_ctrl_mask(m_slots.metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            Key const &key = *m_slots.key(pos);
+            f(key, *m_slots.value(pos));
+        }
+    }
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+template <typename F>
+void HashMap<Key, Value, Hasher, Layout, Policy>::for_each(F &&f) const noexcept
+{
+    // Full slots are found a group of control bytes at a time so sparse tables
+    // are cheap to scan
+    for (size_t group_pos = 0; group_pos < m_capacity;
+         group_pos += s_ctrl_group_width)
+    {
+        uint64_t full_mask = full_ctrl_mask(m_slots.metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            Key const &key = *m_slots.key(pos);
+            Value const &value = *m_slots.value(pos);
+            f(key, value);
+        }
+    }
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+template <typename F>
+size_t HashMap<Key, Value, Hasher, Layout, Policy>::erase_if(F &&pred) noexcept
+{
+    size_t erased_count = 0;
+    for (size_t group_pos = 0; group_pos < m_capacity;
+         group_pos += s_ctrl_group_width)
+    {
+        uint64_t full_mask = full_ctrl_mask(m_slots.metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            Key const &key = *m_slots.key(pos);
+            Value const &value = *m_slots.value(pos);
+            if (pred(key, value))
+            {
+                if constexpr (!std::is_trivially_destructible_v<Key>)
+                    m_slots.key(pos)->~Key();
+                if constexpr (!std::is_trivially_destructible_v<Value>)
+                    m_slots.value(pos)->~Value();
+                m_slots.metadata[pos] = (uint8_t)Ctrl::Deleted;
+                erased_count++;
+            }
+        }
+    }
+    m_size -= erased_count;
+
+    // Find for missing value gets really bad if all slots are Deleted so let's
+    // clean up to be safe
+    if (m_size == 0 && erased_count > 0) [[unlikely]]
+        clear();
+
+    return erased_count;
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::is_over_max_load()
+    const noexcept
+{
+    return m_capacity == 0 || Policy::s_over_max_load(m_size, m_capacity);
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+size_t HashMap<Key, Value, Hasher, Layout, Policy>::find_pos(
+    uint64_t hash, Key const &key) const noexcept
+{
     uint8_t const h2 = s_h2(hash);
     // Keep track of start pos so we can break out before looping again if all
     // slots are full or deleted.
     // Capacity is a power of 2 so this mask just works
     size_t const start_pos = s_h1(hash) & (m_capacity - 1);
     size_t pos = start_pos;
-    while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
+    while (m_slots.metadata[pos] != (uint8_t)Ctrl::Empty)
     {
-        uint8_t const meta = m_metadata[pos];
-        if (h2 == meta && key == m_keys[pos])
-        {
-            if constexpr (!std::is_trivially_destructible_v<Key>)
-                m_keys[pos].~Key();
-            if constexpr (!std::is_trivially_destructible_v<Value>)
-                m_values[pos].~Value();
-            m_metadata[pos] = (uint8_t)Ctrl::Deleted;
-            m_size--;
-
-            // Find for missing value gets really bad if all slots are Deleted
-            // so let's clean up to be safe
-            if (m_size == 0) [[unlikely]]
-                clear();
-
-            return;
-        }
+        uint8_t const meta = m_slots.metadata[pos];
+        if (h2 == meta && key_matches(pos, hash, key))
+            return pos;
 
         // Capacity is a power of 2 so this mask just works
         pos = (pos + 1) & (m_capacity - 1);
         if (pos == start_pos) [[unlikely]]
             break;
     }
+
+    return m_capacity;
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+size_t HashMap<Key, Value, Hasher, Layout, Policy>::insert_unique_slot(
+    uint64_t hash) noexcept
+{
+    // Capacity is a power of 2 so this mask just works
+    size_t pos = s_h1(hash) & (m_capacity - 1);
+    while (!s_empty_pos(m_slots.metadata, pos))
+        pos = (pos + 1) & (m_capacity - 1);
+
+    track_group(pos);
+    m_slots.metadata[pos] = s_h2(hash);
+    if constexpr (StoresHash<Hasher>)
+        m_hashes[pos] = hash;
+    return pos;
 }
 
-template <typename Key, typename Value, class Hasher>
-bool HashMap<Key, Value, Hasher>::is_over_max_load() const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::key_matches(
+    size_t pos, uint64_t hash, Key const &key) const noexcept
 {
-    // Magic factor from the talk, matching the arbitrary offmap SSE version
-    // as reading one metadata byte at a time is basically the same
-    // size / capacity > 15 / 16
-    return m_capacity == 0 || 16 * m_size > 15 * m_capacity;
+    if constexpr (StoresHash<Hasher>)
+    {
+        if (m_hashes[pos] != hash)
+            return false;
+    }
+    return key == *m_slots.key(pos);
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::track_group(
+    size_t pos) noexcept
+{
+    if constexpr (Policy::s_clear == HashClear::Tracked)
+    {
+        size_t const group_pos = pos & ~(s_ctrl_group_width - 1);
+        if (empty_ctrl_group(m_slots.metadata + group_pos))
+        {
+            WHEELS_ASSERT(
+                m_dirty_group_count < m_capacity / s_ctrl_group_width);
+            m_dirty_groups[m_dirty_group_count++] =
+                (uint32_t)(group_pos / s_ctrl_group_width);
+        }
+    }
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::destroy_group_items(
+    size_t group_pos) noexcept
+{
+    if constexpr (
+        !std::is_trivially_destructible_v<Key> ||
+        !std::is_trivially_destructible_v<Value>)
+    {
+        uint64_t full_mask = full_ctrl_mask(m_slots.metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            if constexpr (!std::is_trivially_destructible_v<Key>)
+                m_slots.key(pos)->~Key();
+            if constexpr (!std::is_trivially_destructible_v<Value>)
+                m_slots.value(pos)->~Value();
+        }
+    }
 }
 
-template <typename Key, typename Value, class Hasher>
-void HashMap<Key, Value, Hasher>::grow(size_t capacity) noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::reallocate(
+    size_t capacity) noexcept
 {
-    // Our max load factor is 15/16 so we have to have 32 as the capacity to
-    // ensure we always grow in time so that there always is at least 1 Empty
-    // slot to end find iteration
-    if (capacity < 32)
-        capacity = 32;
+    // The policy's min capacity ensures we always grow in time so that there
+    // always is at least 1 Empty slot to end find iteration
+    if (capacity < Policy::s_min_capacity)
+        capacity = Policy::s_min_capacity;
     // Have capacity be a power of two so we can avoid modulus operations on
     // the hash
     capacity = round_up_power_of_two(capacity);
 
-    WHEELS_ASSERT(capacity > m_capacity);
+    WHEELS_ASSERT(!Policy::s_over_max_load(m_size, capacity));
 
-    Key *old_keys = m_keys;
-    Value *old_values = m_values;
-    uint8_t *old_metadata = m_metadata;
+    HashMapSlots<Key, Value, Layout> const old_slots = m_slots;
+    uint64_t *old_hashes = m_hashes;
+    uint32_t *old_dirty_groups = m_dirty_groups;
     size_t const old_capacity = m_capacity;
 
-    m_keys = (Key *)m_allocator.allocate(capacity * sizeof(Key));
-    WHEELS_ASSERT(m_keys != nullptr);
-    m_values = (Value *)m_allocator.allocate(capacity * sizeof(Value));
-    WHEELS_ASSERT(m_values != nullptr);
-    m_metadata = (uint8_t *)m_allocator.allocate(capacity * sizeof(uint8_t));
-    WHEELS_ASSERT(m_metadata != nullptr);
-
-    m_size = 0;
+    m_slots.allocate(m_allocator, capacity);
+    if constexpr (StoresHash<Hasher>)
+    {
+        m_hashes =
+            (uint64_t *)m_allocator.allocate(capacity * sizeof(uint64_t));
+        WHEELS_ASSERT(m_hashes != nullptr);
+    }
+    if constexpr (Policy::s_clear == HashClear::Tracked)
+    {
+        // The relocated items log their groups again
+        m_dirty_groups = (uint32_t *)m_allocator.allocate(
+            capacity / s_ctrl_group_width * sizeof(uint32_t));
+        WHEELS_ASSERT(m_dirty_groups != nullptr);
+        m_dirty_group_count = 0;
+    }
     m_capacity = capacity;
 
-    memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
+    memset(
+        m_slots.metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
 
-    for (size_t pos = 0; pos < old_capacity; ++pos)
+    // The old keys are unique so they can be moved to the first free slot
+    // without any equality checks. Full slots are found a group of control
+    // bytes at a time as the old table is usually at max load. Deleted slots
+    // are dropped.
+    WHEELS_ASSERT(old_capacity % s_ctrl_group_width == 0);
+    for (size_t group_pos = 0; group_pos < old_capacity;
+         group_pos += s_ctrl_group_width)
     {
-        if (s_empty_pos(old_metadata, pos))
-            continue;
-
-        // TODO: We know these are unique, could skip find and just assign
-        insert_or_assign(
-            WHEELS_MOV(old_keys[pos]), WHEELS_MOV(old_values[pos]));
-        if constexpr (!std::is_trivially_destructible_v<Key>)
-            // Moved from value might still require dtor
-            old_keys[pos].~Key();
-        if constexpr (!std::is_trivially_destructible_v<Value>)
-            // Moved from value might still require dtor
-            old_values[pos].~Value();
+        uint64_t full_mask = full_ctrl_mask(old_slots.metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const old_pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            Key *old_key = old_slots.key(old_pos);
+            uint64_t hash;
+            if constexpr (StoresHash<Hasher>)
+                hash = old_hashes[old_pos];
+            else
+                hash = m_hasher(*old_key);
+            size_t const pos = insert_unique_slot(hash);
+            relocate(m_slots.key(pos), old_key);
+            relocate(m_slots.value(pos), old_slots.value(old_pos));
+        }
     }
 
-    // No need to call dtors as we moved the values
-    m_allocator.deallocate(old_keys);
-    m_allocator.deallocate(old_values);
-    m_allocator.deallocate(old_metadata);
+    // No need to call dtors as we relocated the values
+    if (old_slots.metadata != nullptr)
+        old_slots.deallocate(m_allocator);
+    if (old_hashes != nullptr)
+        m_allocator.deallocate(old_hashes);
+    if (old_dirty_groups != nullptr)
+        m_allocator.deallocate(old_dirty_groups);
 }
 
-template <typename Key, typename Value, class Hasher>
-void HashMap<Key, Value, Hasher>::destroy() noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::deallocate_table() noexcept
 {
-    if (m_keys != nullptr)
+    if (m_slots.metadata != nullptr)
     {
-        clear();
-        m_allocator.deallocate(m_keys);
-        m_allocator.deallocate(m_values);
-        m_allocator.deallocate(m_metadata);
-        m_keys = nullptr;
+        m_slots.deallocate(m_allocator);
+        m_slots = HashMapSlots<Key, Value, Layout>{};
+        if (m_hashes != nullptr)
+        {
+            m_allocator.deallocate(m_hashes);
+            m_hashes = nullptr;
+        }
+        if (m_dirty_groups != nullptr)
+        {
+            m_allocator.deallocate(m_dirty_groups);
+            m_dirty_groups = nullptr;
+        }
+        m_dirty_group_count = 0;
+        m_capacity = 0;
     }
 }
 
-template <typename Key, typename Value, class Hasher>
-typename HashMap<Key, Value, Hasher>::Iterator HashMap<
-    Key, Value, Hasher>::Iterator::operator++() noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+void HashMap<Key, Value, Hasher, Layout, Policy>::destroy() noexcept
 {
-    WHEELS_ASSERT(pos < map.capacity());
-    do
+    if (m_slots.metadata != nullptr)
     {
-        pos++;
-    } while (pos < map.capacity() && map.s_empty_pos(map.m_metadata, pos));
+        if (m_size > 0)
+        {
+            for (size_t group_pos = 0; group_pos < m_capacity;
+                 group_pos += s_ctrl_group_width)
+                destroy_group_items(group_pos);
+            m_size = 0;
+        }
+        deallocate_table();
+    }
+}
+
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+typename HashMap<Key, Value, Hasher, Layout, Policy>::Iterator HashMap<
+    Key, Value, Hasher, Layout, Policy>::Iterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < map.capacity());
+    pos = next_full_ctrl(map.m_slots.metadata, pos + 1, map.capacity());
     return *this;
 }
 
-template <typename Key, typename Value, class Hasher>
-typename HashMap<Key, Value, Hasher>::Iterator HashMap<
-    Key, Value, Hasher>::Iterator::operator++(int) noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+typename HashMap<Key, Value, Hasher, Layout, Policy>::Iterator HashMap<
+    Key, Value, Hasher, Layout, Policy>::Iterator::operator++(int) noexcept
 {
-    HashMap<Key, Value, Hasher>::Iterator const ret = *this;
+    Iterator const ret = *this;
     WHEELS_ASSERT(pos < map.capacity());
-    do
-    {
-        pos++;
-    } while (pos < map.capacity() && map.s_empty_pos(map.m_metadata, pos));
+    pos = next_full_ctrl(map.m_slots.metadata, pos + 1, map.capacity());
     return ret;
 }
 
-template <typename Key, typename Value, class Hasher>
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
 Pair<Key const *, Value *> HashMap<
-    Key, Value, Hasher>::Iterator::operator*() noexcept
+    Key, Value, Hasher, Layout, Policy>::Iterator::operator*() noexcept
 {
     WHEELS_ASSERT(pos < map.capacity());
-    WHEELS_ASSERT(!map.s_empty_pos(map.m_metadata, pos));
+    WHEELS_ASSERT(!map.s_empty_pos(map.m_slots.metadata, pos));
 
-    Key const *key = map.m_keys + pos;
-    Value *value = map.m_values + pos;
+    Key const *key = map.m_slots.key(pos);
+    Value *value = map.m_slots.value(pos);
     return make_pair(key, value);
 };
 
-template <typename Key, typename Value, class Hasher>
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
 Pair<Key const *, Value const *> HashMap<
-    Key, Value, Hasher>::Iterator::operator*() const noexcept
+    Key, Value, Hasher, Layout, Policy>::Iterator::operator*() const noexcept
 {
     WHEELS_ASSERT(pos < map.capacity());
-    WHEELS_ASSERT(!map.s_empty_pos(map.m_metadata, pos));
+    WHEELS_ASSERT(!map.s_empty_pos(map.m_slots.metadata, pos));
 
-    Key const *key = map.m_keys + pos;
-    Value const *value = map.m_values + pos;
+    Key const *key = map.m_slots.key(pos);
+    Value const *value = map.m_slots.value(pos);
     return make_pair(key, value);
 };
 
-template <typename Key, typename Value, class Hasher>
-bool HashMap<Key, Value, Hasher>::Iterator::operator!=(
-    HashMap<Key, Value, Hasher>::Iterator const &other) const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::Iterator::operator!=(
+    Iterator const &other) const noexcept
 {
     return pos != other.pos;
 };
 
-template <typename Key, typename Value, class Hasher>
-bool HashMap<Key, Value, Hasher>::Iterator::operator==(
-    HashMap<Key, Value, Hasher>::Iterator const &other) const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::Iterator::operator==(
+    Iterator const &other) const noexcept
 {
     return pos == other.pos;
 };
 
-template <typename Key, typename Value, class Hasher>
-typename HashMap<Key, Value, Hasher>::ConstIterator HashMap<
-    Key, Value, Hasher>::ConstIterator::operator++() noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+typename HashMap<Key, Value, Hasher, Layout, Policy>::ConstIterator HashMap<
+    Key, Value, Hasher, Layout, Policy>::ConstIterator::operator++() noexcept
 {
     WHEELS_ASSERT(pos < map.capacity());
-    do
-    {
-        pos++;
-    } while (pos < map.capacity() && map.s_empty_pos(map.m_metadata, pos));
+    pos = next_full_ctrl(map.m_slots.metadata, pos + 1, map.capacity());
     return *this;
 }
 
-template <typename Key, typename Value, class Hasher>
-typename HashMap<Key, Value, Hasher>::ConstIterator HashMap<
-    Key, Value, Hasher>::ConstIterator::operator++(int) noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+typename HashMap<Key, Value, Hasher, Layout, Policy>::ConstIterator HashMap<
+    Key, Value, Hasher, Layout, Policy>::ConstIterator::operator++(int) noexcept
 {
-    HashMap<Key, Value, Hasher>::ConstIterator const ret = *this;
+    ConstIterator const ret = *this;
     WHEELS_ASSERT(pos < map.capacity());
-    do
-    {
-        pos++;
-    } while (pos < map.capacity() && map.s_empty_pos(map.m_metadata, pos));
+    pos = next_full_ctrl(map.m_slots.metadata, pos + 1, map.capacity());
     return ret;
 }
 
-template <typename Key, typename Value, class Hasher>
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
 Pair<Key const *, Value const *> HashMap<
-    Key, Value, Hasher>::ConstIterator::operator*() const noexcept
+    Key, Value, Hasher, Layout, Policy>::ConstIterator::operator*()
+    const noexcept
 {
     WHEELS_ASSERT(pos < map.capacity());
-    WHEELS_ASSERT(!map.s_empty_pos(map.m_metadata, pos));
+    WHEELS_ASSERT(!map.s_empty_pos(map.m_slots.metadata, pos));
 
-    Key const *key = map.m_keys + pos;
-    Value const *value = map.m_values + pos;
+    Key const *key = map.m_slots.key(pos);
+    Value const *value = map.m_slots.value(pos);
     return make_pair(key, value);
 };
 
-template <typename Key, typename Value, class Hasher>
-bool HashMap<Key, Value, Hasher>::ConstIterator::operator!=(
-    HashMap<Key, Value, Hasher>::ConstIterator const &other) const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::ConstIterator::operator!=(
+    ConstIterator const &other) const noexcept
 {
     return pos != other.pos;
 };
 
-template <typename Key, typename Value, class Hasher>
-bool HashMap<Key, Value, Hasher>::ConstIterator::operator==(
-    HashMap<Key, Value, Hasher>::ConstIterator const &other) const noexcept
+template <
+    typename Key, typename Value, class Hasher, class Layout, class Policy>
+bool HashMap<Key, Value, Hasher, Layout, Policy>::ConstIterator::operator==(
+    ConstIterator const &other) const noexcept
 {
     return pos == other.pos;
 };
@@ -17,7 +17,9 @@ namespace wheels
 // without the SIMD magic for now
 // https://www.youtube.com/watch?v=ncHmEUmJZf4
 
-template <typename T, class Hasher = Hash<T>> class HashSet
+template <
+    typename T, class Hasher = Hash<T>, class Policy = DefaultHashPolicy>
+class HashSet
 {
     static_assert(
         InvocableHash<Hasher, T>, "Hasher has to be invocable with Key");
@@ -35,9 +37,9 @@ template <typename T, class Hasher = Hash<T>> class HashSet
         [[nodiscard]] T const &operator*() const noexcept;
         [[nodiscard]] T const *operator->() const noexcept;
         [[nodiscard]] bool operator!=(
-            HashSet<T, Hasher>::ConstIterator const &other) const noexcept;
+            ConstIterator const &other) const noexcept;
         [[nodiscard]] bool operator==(
-            HashSet<T, Hasher>::ConstIterator const &other) const noexcept;
+            ConstIterator const &other) const noexcept;
 
         HashSet const &set;
         size_t pos{0};
@@ -49,10 +51,10 @@ template <typename T, class Hasher = Hash<T>> class HashSet
     HashSet(Allocator &allocator, size_t initial_capacity = 0) noexcept;
     ~HashSet();
 
-    HashSet(HashSet<T, Hasher> const &other) = delete;
-    HashSet(HashSet<T, Hasher> &&other) noexcept;
-    HashSet<T, Hasher> &operator=(HashSet<T, Hasher> const &other) = delete;
-    HashSet<T, Hasher> &operator=(HashSet<T, Hasher> &&other) noexcept;
+    HashSet(HashSet const &other) = delete;
+    HashSet(HashSet &&other) noexcept;
+    HashSet &operator=(HashSet const &other) = delete;
+    HashSet &operator=(HashSet &&other) noexcept;
 
     [[nodiscard]] ConstIterator begin() const noexcept;
     [[nodiscard]] ConstIterator end() const noexcept;
@@ -61,6 +63,17 @@ template <typename T, class Hasher = Hash<T>> class HashSet
     [[nodiscard]] size_t size() const noexcept;
     [[nodiscard]] size_t capacity() const noexcept;
 
+    // Grows the table so that it fits at least size values without growing
+    // again
+    void reserve(size_t size) noexcept;
+    // Moves the values into the smallest table that fits them or frees the
+    // table if the set is empty
+    void shrink_to_fit() noexcept;
+    // Moves the values into a table of at least the given capacity, also
+    // dropping the Deleted slots. Capacity is raised to what the current
+    // values need so this can also shrink the table.
+    void rehash(size_t capacity) noexcept;
+
     [[nodiscard]] bool contains(T const &value) const noexcept;
     [[nodiscard]] ConstIterator find(T const &value) const noexcept;
 
@@ -73,10 +86,87 @@ template <typename T, class Hasher = Hash<T>> class HashSet
 
     void remove(T const &value) noexcept;
 
+    // Returns the hash the set uses for value. It can be computed once for
+    // lookups into several sets that use the same hasher, or ahead of the
+    // probes in a separate pass.
+    [[nodiscard]] uint64_t hash_of(T const &value) const noexcept;
+    // The *_with_hash versions skip hashing the value. hash has to be
+    // hash_of(value).
+    [[nodiscard]] bool contains_with_hash(
+        T const &value, uint64_t hash) const noexcept;
+    [[nodiscard]] ConstIterator find_with_hash(
+        T const &value, uint64_t hash) const noexcept;
+    template <typename U>
+        requires SameAs<U, T>
+    void insert_with_hash(U &&value, uint64_t hash) noexcept;
+    void remove_with_hash(T const &value, uint64_t hash) noexcept;
+
+    // Calls f(T const &) for each value. f can't modify the set.
+    template <typename F> void for_each(F &&f) const noexcept;
+    // Removes the values for which pred(T const &) returns true. Returns the
+    // number of removed values. pred can't modify the set.
+    template <typename F> size_t erase_if(F &&pred) noexcept;
+
+    // Inserts the values of other. The table is grown up front to fit both
+    // sets so the inserts don't rehash along the way.
+    void merge(HashSet const &other) noexcept;
+    // Moves the values of other that aren't in this set yet, leaving other
+    // empty
+    void merge(HashSet &&other) noexcept;
+    // Removes the values that aren't in other
+    void intersect_with(HashSet const &other) noexcept;
+    // Removes the values that are in other. Iterates the smaller set.
+    void subtract(HashSet const &other) noexcept;
+
+    // Iterates the smaller set and probes the larger one. The result is
+    // allocated from the given allocator.
+    template <typename U, class H, class P>
+    friend HashSet<U, H, P> intersection(
+        Allocator &allocator, HashSet<U, H, P> const &a,
+        HashSet<U, H, P> const &b) noexcept;
+    // Values of a that aren't in b. The result is allocated from the given
+    // allocator.
+    template <typename U, class H, class P>
+    friend HashSet<U, H, P> difference(
+        Allocator &allocator, HashSet<U, H, P> const &a,
+        HashSet<U, H, P> const &b) noexcept;
+
   private:
     [[nodiscard]] bool is_over_max_load() const noexcept;
 
-    void grow(size_t capacity) noexcept;
+    // Returns the stored hash if there is one
+    [[nodiscard]] uint64_t hash_at(size_t pos) const noexcept;
+    // Returns m_capacity if the value isn't in the set
+    [[nodiscard]] size_t find_pos(
+        uint64_t hash, T const &value) const noexcept;
+    // Inserts a value that isn't in the set yet without equality checks. The
+    // caller has to make sure the table has room for it.
+    template <typename U> void insert_unique(uint64_t hash, U &&value) noexcept;
+    // Destroys the value in a Full slot and marks the slot Deleted
+    void erase_pos(size_t pos) noexcept;
+    // Calls f(size_t pos) for each Full slot
+    template <typename F> void for_each_pos(F &&f) const noexcept;
+    // Erases the Full slots for which pred(size_t pos) returns true and
+    // returns the number of erased values
+    template <typename F> size_t erase_pos_if(F &&pred) noexcept;
+
+    // Claims the first free slot for a value that isn't in the set yet. The
+    // caller has to construct the value and update the size.
+    [[nodiscard]] size_t insert_unique_slot(uint64_t hash) noexcept;
+    // Compares the stored hash first if there is one
+    [[nodiscard]] bool value_matches(
+        size_t pos, uint64_t hash, T const &value) const noexcept;
+    // Logs the group of pos if the slot is about to become the first
+    // non-Empty one in it. Has to be called before the control byte is
+    // written.
+    void track_group(size_t pos) noexcept;
+    // Calls the dtors of the values in the Full slots of the group
+    void destroy_group_values(size_t group_pos) noexcept;
+    // Moves the values into a new table of at least the given capacity, also
+    // dropping the Deleted slots
+    void reallocate(size_t capacity) noexcept;
+    // Frees the table without calling any dtors
+    void deallocate_table() noexcept;
     void destroy() noexcept;
 
     enum class Ctrl : uint8_t
@@ -105,13 +195,19 @@ template <typename T, class Hasher = Hash<T>> class HashSet
     Allocator &m_allocator;
     T *m_data{nullptr};
     uint8_t *m_metadata{nullptr};
+    // Only allocated if the hasher opts into StoresHash
+    uint64_t *m_hashes{nullptr};
+    // Only allocated if the policy uses HashClear::Tracked. Indices of the
+    // groups that have had values inserted since the last clear.
+    uint32_t *m_dirty_groups{nullptr};
+    size_t m_dirty_group_count{0};
     size_t m_size{0};
     size_t m_capacity{0};
     Hasher m_hasher{};
 };
 
-template <typename T, class Hasher>
-HashSet<T, Hasher>::HashSet(
+template <typename T, class Hasher, class Policy>
+HashSet<T, Hasher, Policy>::HashSet(
     Allocator &allocator, size_t initial_capacity) noexcept
 : m_allocator{allocator}
 {
@@ -120,29 +216,39 @@ HashSet<T, Hasher>::HashSet(
         "Aligned allocations beyond std::max_align_t aren't supported");
 
     if (initial_capacity > 0)
-        grow(initial_capacity);
+        reallocate(initial_capacity);
 }
 
-template <typename T, class Hasher> HashSet<T, Hasher>::~HashSet()
+template <typename T, class Hasher, class Policy>
+HashSet<T, Hasher, Policy>::~HashSet()
 {
     destroy();
 }
 
-template <typename T, class Hasher>
-HashSet<T, Hasher>::HashSet(HashSet<T, Hasher> &&other) noexcept
+template <typename T, class Hasher, class Policy>
+HashSet<T, Hasher, Policy>::HashSet(HashSet &&other) noexcept
 : m_allocator{other.m_allocator}
 , m_data{other.m_data}
 , m_metadata{other.m_metadata}
+, m_hashes{other.m_hashes}
+, m_dirty_groups{other.m_dirty_groups}
+, m_dirty_group_count{other.m_dirty_group_count}
 , m_size{other.m_size}
 , m_capacity{other.m_capacity}
 , m_hasher{WHEELS_MOV(other.m_hasher)}
 {
     other.m_data = nullptr;
+    other.m_metadata = nullptr;
+    other.m_hashes = nullptr;
+    other.m_dirty_groups = nullptr;
+    other.m_dirty_group_count = 0;
+    other.m_size = 0;
+    other.m_capacity = 0;
 }
 
-template <typename T, class Hasher>
-HashSet<T, Hasher> &HashSet<T, Hasher>::operator=(
-    HashSet<T, Hasher> &&other) noexcept
+template <typename T, class Hasher, class Policy>
+HashSet<T, Hasher, Policy> &HashSet<T, Hasher, Policy>::operator=(
+    HashSet &&other) noexcept
 {
     WHEELS_ASSERT(
         &m_allocator == &other.m_allocator &&
@@ -155,37 +261,37 @@ HashSet<T, Hasher> &HashSet<T, Hasher>::operator=(
 
         m_data = other.m_data;
         m_metadata = other.m_metadata;
+        m_hashes = other.m_hashes;
+        m_dirty_groups = other.m_dirty_groups;
+        m_dirty_group_count = other.m_dirty_group_count;
         m_size = other.m_size;
         m_capacity = other.m_capacity;
         m_hasher = WHEELS_MOV(other.m_hasher);
 
         other.m_data = nullptr;
+        other.m_metadata = nullptr;
+        other.m_hashes = nullptr;
+        other.m_dirty_groups = nullptr;
+        other.m_dirty_group_count = 0;
+        other.m_size = 0;
+        other.m_capacity = 0;
     }
     return *this;
 }
 
-template <typename T, class Hasher>
-typename HashSet<T, Hasher>::ConstIterator HashSet<T, Hasher>::begin()
-    const noexcept
+template <typename T, class Hasher, class Policy>
+typename HashSet<T, Hasher, Policy>::ConstIterator HashSet<
+    T, Hasher, Policy>::begin() const noexcept
 {
-    ConstIterator iter{
+    return ConstIterator{
         .set = *this,
-        .pos = 0,
+        .pos = next_full_ctrl(m_metadata, 0, m_capacity),
     };
-
-    if (m_capacity == 0)
-        return iter;
-
-    if (s_empty_pos(m_metadata, iter.pos))
-        iter++;
-    WHEELS_ASSERT(iter == end() || !s_empty_pos(m_metadata, iter.pos));
-
-    return iter;
 }
 
-template <typename T, class Hasher>
-typename HashSet<T, Hasher>::ConstIterator HashSet<T, Hasher>::end()
-    const noexcept
+template <typename T, class Hasher, class Policy>
+typename HashSet<T, Hasher, Policy>::ConstIterator HashSet<
+    T, Hasher, Policy>::end() const noexcept
 {
     return ConstIterator{
         .set = *this,
@@ -193,117 +299,416 @@ typename HashSet<T, Hasher>::ConstIterator HashSet<T, Hasher>::end()
     };
 }
 
-template <typename T, class Hasher>
-bool HashSet<T, Hasher>::empty() const noexcept
+template <typename T, class Hasher, class Policy>
+bool HashSet<T, Hasher, Policy>::empty() const noexcept
 {
     return m_size == 0;
 }
 
-template <typename T, class Hasher>
-size_t HashSet<T, Hasher>::size() const noexcept
+template <typename T, class Hasher, class Policy>
+size_t HashSet<T, Hasher, Policy>::size() const noexcept
 {
     return m_size;
 }
 
-template <typename T, class Hasher>
-size_t HashSet<T, Hasher>::capacity() const noexcept
+template <typename T, class Hasher, class Policy>
+size_t HashSet<T, Hasher, Policy>::capacity() const noexcept
 {
     return m_capacity;
 }
 
-template <typename T, class Hasher>
-bool HashSet<T, Hasher>::contains(T const &value) const noexcept
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::reserve(size_t size) noexcept
+{
+    size_t const capacity = Policy::s_capacity_for(size);
+    if (capacity > m_capacity)
+        reallocate(capacity);
+}
+
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::shrink_to_fit() noexcept
+{
+    if (m_size == 0)
+        destroy();
+    else
+    {
+        size_t const capacity = Policy::s_capacity_for(m_size);
+        if (capacity < m_capacity)
+            reallocate(capacity);
+    }
+}
+
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::rehash(size_t capacity) noexcept
+{
+    size_t const min_capacity = Policy::s_capacity_for(m_size);
+    reallocate(capacity < min_capacity ? min_capacity : capacity);
+}
+
+template <typename T, class Hasher, class Policy>
+bool HashSet<T, Hasher, Policy>::contains(T const &value) const noexcept
 {
     return find(value) != end();
 }
 
-template <typename T, class Hasher>
-typename HashSet<T, Hasher>::ConstIterator HashSet<T, Hasher>::find(
-    T const &value) const noexcept
+template <typename T, class Hasher, class Policy>
+typename HashSet<T, Hasher, Policy>::ConstIterator HashSet<
+    T, Hasher, Policy>::find(T const &value) const noexcept
 {
     if (m_size == 0)
         return end();
 
+    return find_with_hash(value, m_hasher(value));
+}
+
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::clear() noexcept
+{
+    // There's no table before the first insert or after shrink_to_fit()
+    if (m_metadata == nullptr)
+        return;
+
+    size_t const size = m_size;
+    m_size = 0;
+
+    if constexpr (Policy::s_clear == HashClear::Tracked)
+    {
+        // Only the logged groups can have Full or Deleted slots
+        for (size_t i = 0; i < m_dirty_group_count; ++i)
+        {
+            size_t const group_pos =
+                (size_t)m_dirty_groups[i] * s_ctrl_group_width;
+            if (size > 0)
+                destroy_group_values(group_pos);
+            memset(
+                m_metadata + group_pos, (uint8_t)Ctrl::Empty,
+                s_ctrl_group_width * sizeof(uint8_t));
+        }
+        m_dirty_group_count = 0;
+    }
+    else
+    {
+        if (size > 0)
+        {
+            for (size_t group_pos = 0; group_pos < m_capacity;
+                 group_pos += s_ctrl_group_width)
+                destroy_group_values(group_pos);
+        }
+
+        if constexpr (Policy::s_clear == HashClear::Shrink)
+        {
+            // A fresh table only needs to reset the control bytes for the
+            // smaller capacity
+            size_t const capacity = Policy::s_capacity_for(size);
+            if (size > 0 &&
+                m_capacity > Policy::s_clear_shrink_factor * capacity)
+            {
+                deallocate_table();
+                reallocate(capacity);
+                return;
+            }
+        }
+
+        memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
+    }
+}
+
+template <typename T, class Hasher, class Policy>
+template <typename U>
+    requires SameAs<U, T>
+void HashSet<T, Hasher, Policy>::insert(U &&value) noexcept
+{
     uint64_t const hash = m_hasher(value);
+    insert_with_hash(WHEELS_FWD(value), hash);
+}
+
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::remove(T const &value) noexcept
+{
+    if (m_size == 0)
+        return;
+
+    remove_with_hash(value, m_hasher(value));
+}
+
+template <typename T, class Hasher, class Policy>
+uint64_t HashSet<T, Hasher, Policy>::hash_of(T const &value) const noexcept
+{
+    return m_hasher(value);
+}
+
+template <typename T, class Hasher, class Policy>
+bool HashSet<T, Hasher, Policy>::contains_with_hash(
+    T const &value, uint64_t hash) const noexcept
+{
+    return find_with_hash(value, hash) != end();
+}
+
+template <typename T, class Hasher, class Policy>
+typename HashSet<T, Hasher, Policy>::ConstIterator HashSet<
+    T, Hasher, Policy>::find_with_hash(T const &value, uint64_t hash)
+    const noexcept
+{
+    if (m_size == 0)
+        return end();
+
+    return ConstIterator{
+        .set = *this,
+        .pos = find_pos(hash, value),
+    };
+}
+
+template <typename T, class Hasher, class Policy>
+template <typename U>
+    requires SameAs<U, T>
+void HashSet<T, Hasher, Policy>::insert_with_hash(
+    U &&value, uint64_t hash) noexcept
+{
+    if (is_over_max_load())
+        reallocate(m_capacity * 2);
+
     uint8_t const h2 = s_h2(hash);
-    // Keep track of start pos so we can break out before looping again if all
-    // slots are full or deleted.
+    // The whole probe sequence has to be checked for the value before a
+    // Deleted slot can be reused or the value could end up in the set twice
     // Capacity is a power of 2 so this mask just works
     size_t const start_pos = s_h1(hash) & (m_capacity - 1);
     size_t pos = start_pos;
+    size_t free_pos = m_capacity;
     while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
     {
         uint8_t const meta = m_metadata[pos];
-        if (h2 == meta && value == m_data[pos])
-            return ConstIterator{
-                .set = *this,
-                .pos = pos,
-            };
+        if (h2 == meta && value_matches(pos, hash, value))
+            return;
+        if (meta == (uint8_t)Ctrl::Deleted && free_pos == m_capacity)
+            free_pos = pos;
 
-        // capacity is a power of 2 so this mask just works
+        // Capacity is a power of 2 so this mask just works
         pos = (pos + 1) & (m_capacity - 1);
         if (pos == start_pos) [[unlikely]]
             break;
     }
+    if (free_pos == m_capacity)
+        free_pos = pos;
+    WHEELS_ASSERT(s_empty_pos(m_metadata, free_pos));
+
+    new (m_data + free_pos) T{WHEELS_FWD(value)};
+    track_group(free_pos);
+    m_metadata[free_pos] = h2;
+    if constexpr (StoresHash<Hasher>)
+        m_hashes[free_pos] = hash;
+    m_size++;
+}
 
-    return end();
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::remove_with_hash(
+    T const &value, uint64_t hash) noexcept
+{
+    if (m_size == 0)
+        return;
+
+    size_t const pos = find_pos(hash, value);
+    if (pos == m_capacity)
+        return;
+
+    erase_pos(pos);
+
+    // Find for missing value gets really bad if all slots are Deleted so let's
+    // clean up to be safe
+    if (m_size == 0) [[unlikely]]
+        clear();
 }
 
-template <typename T, class Hasher> void HashSet<T, Hasher>::clear() noexcept
+template <typename T, class Hasher, class Policy>
+template <typename F>
+void HashSet<T, Hasher, Policy>::for_each(F &&f) const noexcept
 {
-    if (m_size > 0)
-    {
-        if constexpr (!std::is_trivially_destructible_v<T>)
+    for_each_pos(
+        [&](size_t pos)
         {
-            for (size_t i = 0; i < m_capacity; ++i)
-            {
-                if (!s_empty_pos(m_metadata, i))
-                {
-                    m_data[i].~T();
-                }
-            }
-        }
-        m_size = 0;
+            T const &value = m_data[pos];
+            f(value);
+        });
+}
+
+template <typename T, class Hasher, class Policy>
+template <typename F>
+size_t HashSet<T, Hasher, Policy>::erase_if(F &&pred) noexcept
+{
+    return erase_pos_if(
+        [&](size_t pos)
+        {
+            T const &value = m_data[pos];
+            return pred(value);
+        });
+}
+
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::merge(HashSet const &other) noexcept
+{
+    if (this == &other || other.m_size == 0)
+        return;
+
+    reserve(m_size + other.m_size);
+    // Stored hashes are reused, the values are only hashed if they aren't
+    // stored
+    other.for_each_pos(
+        [&](size_t pos)
+        { insert_with_hash(other.m_data[pos], other.hash_at(pos)); });
+}
+
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::merge(HashSet &&other) noexcept
+{
+    if (this == &other || other.m_size == 0)
+        return;
+
+    // Move the values of the larger set over if we're empty
+    if (m_size == 0 && other.m_capacity > m_capacity &&
+        &m_allocator == &other.m_allocator)
+    {
+        *this = WHEELS_MOV(other);
+        return;
     }
-    memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
+
+    reserve(m_size + other.m_size);
+    other.for_each_pos(
+        [&](size_t pos)
+        {
+            insert_with_hash(WHEELS_MOV(other.m_data[pos]), other.hash_at(pos));
+        });
+    other.clear();
 }
 
-template <typename T, class Hasher>
-template <typename U>
-    requires SameAs<U, T>
-void HashSet<T, Hasher>::insert(U &&value) noexcept
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::intersect_with(HashSet const &other) noexcept
 {
-    if (is_over_max_load())
-        grow(m_capacity * 2);
+    if (this == &other)
+        return;
 
-    uint64_t const hash = m_hasher(value);
-    uint8_t const h2 = s_h2(hash);
-    // Capacity is a power of 2 so this mask just works
-    size_t pos = s_h1(hash) & (m_capacity - 1);
-    while (true)
+    if (other.m_size == 0)
     {
-        if (s_empty_pos(m_metadata, pos))
+        clear();
+        return;
+    }
+
+    erase_pos_if(
+        [&](size_t pos)
         {
-            new (m_data + pos) T{WHEELS_FWD(value)};
-            m_metadata[pos] = h2;
-            m_size++;
-            return;
-        }
-        else if (h2 == m_metadata[pos] && value == m_data[pos])
-            return;
+            return other.find_pos(hash_at(pos), m_data[pos]) ==
+                   other.m_capacity;
+        });
+}
 
-        // Capacity is a power of 2 so this mask just works
-        pos = (pos + 1) & (m_capacity - 1);
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::subtract(HashSet const &other) noexcept
+{
+    if (this == &other)
+    {
+        clear();
+        return;
     }
+
+    if (m_size == 0 || other.m_size == 0)
+        return;
+
+    if (other.m_size < m_size)
+    {
+        other.for_each_pos(
+            [&](size_t other_pos)
+            {
+                size_t const pos =
+                    find_pos(other.hash_at(other_pos), other.m_data[other_pos]);
+                if (pos != m_capacity)
+                    erase_pos(pos);
+            });
+
+        // Find for missing value gets really bad if all slots are Deleted so
+        // let's clean up to be safe
+        if (m_size == 0) [[unlikely]]
+            clear();
+    }
+    else
+        erase_pos_if(
+            [&](size_t pos)
+            {
+                return other.find_pos(hash_at(pos), m_data[pos]) !=
+                       other.m_capacity;
+            });
 }
 
-template <typename T, class Hasher>
-void HashSet<T, Hasher>::remove(T const &value) noexcept
+template <typename T, class Hasher, class Policy>
+HashSet<T, Hasher, Policy> intersection(
+    Allocator &allocator, HashSet<T, Hasher, Policy> const &a,
+    HashSet<T, Hasher, Policy> const &b) noexcept
+{
+    HashSet<T, Hasher, Policy> const &smaller = a.m_size <= b.m_size ? a : b;
+    HashSet<T, Hasher, Policy> const &larger = a.m_size <= b.m_size ? b : a;
+
+    HashSet<T, Hasher, Policy> ret{allocator};
+    if (smaller.m_size == 0)
+        return ret;
+
+    // The result can't be larger than the smaller set and its values are
+    // unique so they can go to the first free slot
+    ret.reserve(smaller.m_size);
+    smaller.for_each_pos(
+        [&](size_t pos)
+        {
+            uint64_t const hash = smaller.hash_at(pos);
+            T const &value = smaller.m_data[pos];
+            if (larger.find_pos(hash, value) != larger.m_capacity)
+                ret.insert_unique(hash, value);
+        });
+
+    return ret;
+}
+
+template <typename T, class Hasher, class Policy>
+HashSet<T, Hasher, Policy> difference(
+    Allocator &allocator, HashSet<T, Hasher, Policy> const &a,
+    HashSet<T, Hasher, Policy> const &b) noexcept
+{
+    HashSet<T, Hasher, Policy> ret{allocator};
+    if (a.m_size == 0)
+        return ret;
+
+    // The result can't be larger than a and its values are unique so they can
+    // go to the first free slot
+    ret.reserve(a.m_size);
+    a.for_each_pos(
+        [&](size_t pos)
+        {
+            uint64_t const hash = a.hash_at(pos);
+            T const &value = a.m_data[pos];
+            if (b.find_pos(hash, value) == b.m_capacity)
+                ret.insert_unique(hash, value);
+        });
+
+    return ret;
+}
+
+template <typename T, class Hasher, class Policy>
+bool HashSet<T, Hasher, Policy>::is_over_max_load() const noexcept
+{
+    return m_capacity == 0 || Policy::s_over_max_load(m_size, m_capacity);
+}
+
+template <typename T, class Hasher, class Policy>
+uint64_t HashSet<T, Hasher, Policy>::hash_at(size_t pos) const noexcept
+{
+    if constexpr (StoresHash<Hasher>)
+        return m_hashes[pos];
+    else
+        return m_hasher(m_data[pos]);
+}
+
+template <typename T, class Hasher, class Policy>
+size_t HashSet<T, Hasher, Policy>::find_pos(
+    uint64_t hash, T const &value) const noexcept
 {
     if (m_size == 0)
-        return;
+        return m_capacity;
 
-    uint64_t const hash = m_hasher(value);
     uint8_t const h2 = s_h2(hash);
     // Keep track of start pos so we can break out before looping again if all
     // slots are full or deleted.
@@ -313,119 +718,285 @@ void HashSet<T, Hasher>::remove(T const &value) noexcept
     while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
     {
         uint8_t const meta = m_metadata[pos];
-        if (h2 == meta && value == m_data[pos])
-        {
-            if constexpr (!std::is_trivially_destructible_v<T>)
-                m_data[pos].~T();
-            m_metadata[pos] = (uint8_t)Ctrl::Deleted;
-            m_size--;
+        if (h2 == meta && value_matches(pos, hash, value))
+            return pos;
+
+        // capacity is a power of 2 so this mask just works
+        pos = (pos + 1) & (m_capacity - 1);
+        if (pos == start_pos) [[unlikely]]
+            break;
+    }
 
-            // Find for missing value gets really bad if all slots are Deleted
-            // so let's clean up to be safe
-            if (m_size == 0) [[unlikely]]
-                clear();
+    return m_capacity;
+}
 
-            return;
+template <typename T, class Hasher, class Policy>
+template <typename U>
+void HashSet<T, Hasher, Policy>::insert_unique(
+    uint64_t hash, U &&value) noexcept
+{
+    WHEELS_ASSERT(!Policy::s_over_max_load(m_size + 1, m_capacity));
+
+    size_t const pos = insert_unique_slot(hash);
+    new (m_data + pos) T{WHEELS_FWD(value)};
+    m_size++;
+}
+
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::erase_pos(size_t pos) noexcept
+{
+    WHEELS_ASSERT(pos < m_capacity);
+    WHEELS_ASSERT(!s_empty_pos(m_metadata, pos));
+
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        m_data[pos].~T();
+    m_metadata[pos] = (uint8_t)Ctrl::Deleted;
+    m_size--;
+}
+
+template <typename T, class Hasher, class Policy>
+template <typename F>
+void HashSet<T, Hasher, Policy>::for_each_pos(F &&f) const noexcept
+{
+    // Full slots are found a group of control bytes at a time so sparse tables
+    // are cheap to scan
+    for (size_t group_pos = 0; group_pos < m_capacity;
+         group_pos += s_ctrl_group_width)
+    {
+        uint64_t full_mask = full_ctrl_mask(m_metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            f(pos);
         }
+    }
+}
 
-        // Capacity is a power of 2 so this mask just works
+template <typename T, class Hasher, class Policy>
+template <typename F>
+size_t HashSet<T, Hasher, Policy>::erase_pos_if(F &&pred) noexcept
+{
+    size_t const start_size = m_size;
+    for_each_pos(
+        [&](size_t pos)
+        {
+            if (pred(pos))
+                erase_pos(pos);
+        });
+    size_t const erased_count = start_size - m_size;
+
+    // Find for missing value gets really bad if all slots are Deleted so let's
+    // clean up to be safe
+    if (m_size == 0 && erased_count > 0) [[unlikely]]
+        clear();
+
+    return erased_count;
+}
+
+template <typename T, class Hasher, class Policy>
+size_t HashSet<T, Hasher, Policy>::insert_unique_slot(uint64_t hash) noexcept
+{
+    // Capacity is a power of 2 so this mask just works
+    size_t pos = s_h1(hash) & (m_capacity - 1);
+    while (!s_empty_pos(m_metadata, pos))
         pos = (pos + 1) & (m_capacity - 1);
-        if (pos == start_pos) [[unlikely]]
-            break;
+
+    track_group(pos);
+    m_metadata[pos] = s_h2(hash);
+    if constexpr (StoresHash<Hasher>)
+        m_hashes[pos] = hash;
+    return pos;
+}
+
+template <typename T, class Hasher, class Policy>
+bool HashSet<T, Hasher, Policy>::value_matches(
+    size_t pos, uint64_t hash, T const &value) const noexcept
+{
+    if constexpr (StoresHash<Hasher>)
+    {
+        if (m_hashes[pos] != hash)
+            return false;
+    }
+    return value == m_data[pos];
+}
+
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::track_group(size_t pos) noexcept
+{
+    if constexpr (Policy::s_clear == HashClear::Tracked)
+    {
+        size_t const group_pos = pos & ~(s_ctrl_group_width - 1);
+        if (empty_ctrl_group(m_metadata + group_pos))
+        {
+            WHEELS_ASSERT(
+                m_dirty_group_count < m_capacity / s_ctrl_group_width);
+            m_dirty_groups[m_dirty_group_count++] =
+                (uint32_t)(group_pos / s_ctrl_group_width);
+        }
     }
 }
 
-template <typename T, class Hasher>
-bool HashSet<T, Hasher>::is_over_max_load() const noexcept
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::destroy_group_values(
+    size_t group_pos) noexcept
 {
-    // Magic factor from the talk, matching the arbitrary offset SSE version
-    // as reading one metadata byte at a time is basically the same
-    // size / capacity > 15 / 16
-    return m_capacity == 0 || 16 * m_size > 15 * m_capacity;
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        uint64_t full_mask = full_ctrl_mask(m_metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            m_data[pos].~T();
+        }
+    }
 }
 
-template <typename T, class Hasher>
-void HashSet<T, Hasher>::grow(size_t capacity) noexcept
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::reallocate(size_t capacity) noexcept
 {
-    // Our max load factor is 15/16 so we have to have 32 as the capacity to
-    // ensure we always grow in time so that there always is at least 1 Empty
-    // slot to end find iteration
-    if (capacity < 32)
-        capacity = 32;
+    // The policy's min capacity ensures we always grow in time so that there
+    // always is at least 1 Empty slot to end find iteration
+    if (capacity < Policy::s_min_capacity)
+        capacity = Policy::s_min_capacity;
     // Have capacity be a power of two so we can avoid modulus operations on
     // the hash
     capacity = round_up_power_of_two(capacity);
 
-    WHEELS_ASSERT(capacity > m_capacity);
+    WHEELS_ASSERT(!Policy::s_over_max_load(m_size, capacity));
 
     T *old_data = m_data;
     uint8_t *old_metadata = m_metadata;
+    uint64_t *old_hashes = m_hashes;
+    uint32_t *old_dirty_groups = m_dirty_groups;
     size_t const old_capacity = m_capacity;
 
     m_data = (T *)m_allocator.allocate(capacity * sizeof(T));
     WHEELS_ASSERT(m_data != nullptr);
     m_metadata = (uint8_t *)m_allocator.allocate(capacity * sizeof(uint8_t));
     WHEELS_ASSERT(m_metadata != nullptr);
+    if constexpr (StoresHash<Hasher>)
+    {
+        m_hashes =
+            (uint64_t *)m_allocator.allocate(capacity * sizeof(uint64_t));
+        WHEELS_ASSERT(m_hashes != nullptr);
+    }
+    if constexpr (Policy::s_clear == HashClear::Tracked)
+    {
+        // The relocated values log their groups again
+        m_dirty_groups = (uint32_t *)m_allocator.allocate(
+            capacity / s_ctrl_group_width * sizeof(uint32_t));
+        WHEELS_ASSERT(m_dirty_groups != nullptr);
+        m_dirty_group_count = 0;
+    }
 
-    m_size = 0;
     m_capacity = capacity;
 
     memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
 
-    for (size_t pos = 0; pos < old_capacity; ++pos)
+    // The old values are unique so they can be moved to the first free slot
+    // without any equality checks. Full slots are found a group of control
+    // bytes at a time as the old table is usually at max load. Deleted slots
+    // are dropped.
+    WHEELS_ASSERT(old_capacity % s_ctrl_group_width == 0);
+    for (size_t group_pos = 0; group_pos < old_capacity;
+         group_pos += s_ctrl_group_width)
     {
-        if (s_empty_pos(old_metadata, pos))
-            continue;
-
-        insert(WHEELS_MOV(old_data[pos]));
-        if constexpr (!std::is_trivially_destructible_v<T>)
-            // Moved from value might still require dtor
-            old_data[pos].~T();
+        uint64_t full_mask = full_ctrl_mask(old_metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const old_pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            uint64_t hash;
+            if constexpr (StoresHash<Hasher>)
+                hash = old_hashes[old_pos];
+            else
+                hash = m_hasher(old_data[old_pos]);
+            size_t const pos = insert_unique_slot(hash);
+            relocate(m_data + pos, old_data + old_pos);
+        }
     }
 
-    // No need to call dtors as we moved the values
-    m_allocator.deallocate(old_data);
-    m_allocator.deallocate(old_metadata);
+    // No need to call dtors as we relocated the values
+    if (old_data != nullptr)
+    {
+        m_allocator.deallocate(old_data);
+        m_allocator.deallocate(old_metadata);
+    }
+    if (old_hashes != nullptr)
+        m_allocator.deallocate(old_hashes);
+    if (old_dirty_groups != nullptr)
+        m_allocator.deallocate(old_dirty_groups);
 }
 
-template <typename T, class Hasher> void HashSet<T, Hasher>::destroy() noexcept
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::deallocate_table() noexcept
 {
     if (m_data != nullptr)
     {
-        clear();
         m_allocator.deallocate(m_data);
         m_allocator.deallocate(m_metadata);
         m_data = nullptr;
+        m_metadata = nullptr;
+        if (m_hashes != nullptr)
+        {
+            m_allocator.deallocate(m_hashes);
+            m_hashes = nullptr;
+        }
+        if (m_dirty_groups != nullptr)
+        {
+            m_allocator.deallocate(m_dirty_groups);
+            m_dirty_groups = nullptr;
+        }
+        m_dirty_group_count = 0;
+        m_capacity = 0;
     }
 }
 
-template <typename T, class Hasher>
-typename HashSet<T, Hasher>::ConstIterator HashSet<
-    T, Hasher>::ConstIterator::operator++() noexcept
+template <typename T, class Hasher, class Policy>
+void HashSet<T, Hasher, Policy>::destroy() noexcept
 {
-    WHEELS_ASSERT(pos < set.capacity());
-    do
+    if (m_data != nullptr)
     {
-        pos++;
-    } while (pos < set.capacity() && set.s_empty_pos(set.m_metadata, pos));
+        if (m_size > 0)
+        {
+            for (size_t group_pos = 0; group_pos < m_capacity;
+                 group_pos += s_ctrl_group_width)
+                destroy_group_values(group_pos);
+            m_size = 0;
+        }
+        deallocate_table();
+    }
+}
+
+template <typename T, class Hasher, class Policy>
+typename HashSet<T, Hasher, Policy>::ConstIterator HashSet<
+    T, Hasher, Policy>::ConstIterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < set.capacity());
+    pos = next_full_ctrl(set.m_metadata, pos + 1, set.capacity());
     return *this;
 }
 
-template <typename T, class Hasher>
-typename HashSet<T, Hasher>::ConstIterator HashSet<
-    T, Hasher>::ConstIterator::operator++(int) noexcept
+template <typename T, class Hasher, class Policy>
+typename HashSet<T, Hasher, Policy>::ConstIterator HashSet<
+    T, Hasher, Policy>::ConstIterator::operator++(int) noexcept
 {
-    HashSet<T, Hasher>::ConstIterator const ret = *this;
+    HashSet<T, Hasher, Policy>::ConstIterator const ret = *this;
     WHEELS_ASSERT(pos < set.capacity());
-    do
-    {
-        pos++;
-    } while (pos < set.capacity() && set.s_empty_pos(set.m_metadata, pos));
+    pos = next_full_ctrl(set.m_metadata, pos + 1, set.capacity());
     return ret;
 }
 
-template <typename T, class Hasher>
-T const &HashSet<T, Hasher>::ConstIterator::operator*() const noexcept
+template <typename T, class Hasher, class Policy>
+T const &HashSet<T, Hasher, Policy>::ConstIterator::operator*() const noexcept
 {
     WHEELS_ASSERT(pos < set.capacity());
     WHEELS_ASSERT(!set.s_empty_pos(set.m_metadata, pos));
@@ -433,22 +1004,22 @@ T const &HashSet<T, Hasher>::ConstIterator::operator*() const noexcept
     return set.m_data[pos];
 };
 
-template <typename T, class Hasher>
-T const *HashSet<T, Hasher>::ConstIterator::operator->() const noexcept
+template <typename T, class Hasher, class Policy>
+T const *HashSet<T, Hasher, Policy>::ConstIterator::operator->() const noexcept
 {
     return &**this;
 };
 
-template <typename T, class Hasher>
-bool HashSet<T, Hasher>::ConstIterator::operator!=(
-    HashSet<T, Hasher>::ConstIterator const &other) const noexcept
+template <typename T, class Hasher, class Policy>
+bool HashSet<T, Hasher, Policy>::ConstIterator::operator!=(
+    HashSet<T, Hasher, Policy>::ConstIterator const &other) const noexcept
 {
     return pos != other.pos;
 };
 
-template <typename T, class Hasher>
-bool HashSet<T, Hasher>::ConstIterator::operator==(
-    HashSet<T, Hasher>::ConstIterator const &other) const noexcept
+template <typename T, class Hasher, class Policy>
+bool HashSet<T, Hasher, Policy>::ConstIterator::operator==(
+    HashSet<T, Hasher, Policy>::ConstIterator const &other) const noexcept
 {
     return pos == other.pos;
 };
@@ -0,0 +1,564 @@
+#ifndef WHEELS_CONTAINERS_HYBRID_MAP_HPP
+#define WHEELS_CONTAINERS_HYBRID_MAP_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "hash.hpp"
+#include "hash_map.hpp"
+#include "pair.hpp"
+#include "small_map.hpp"
+#include "utils.hpp"
+
+#include <new>
+
+namespace wheels
+{
+
+// Stores up to N items inline in a SmallMap and moves them into a HashMap
+// allocated from the allocator when an insert would go past N. The two share
+// storage so the map only takes the space of the larger one. Stays in the
+// HashMap after that until shrink_to_fit() finds the items fit inline again.
+// Iteration order is insertion order while inline and table order after.
+
+template <
+    typename Key, typename Value, size_t N, class Hasher = Hash<Key>,
+    class Layout = SplitLayout, class Policy = DefaultHashPolicy>
+class HybridMap
+{
+  public:
+    using key_type = Key;
+    // Wording clashes with the STL counterpats, but is consistent with the
+    // template interface
+    using value_type = Value;
+
+    struct Iterator
+    {
+        Iterator operator++() noexcept;
+        Iterator operator++(int) noexcept;
+        // Only value is mutable because changing the key could require
+        // rehashing
+        [[nodiscard]] Pair<Key const *, Value *> operator*() noexcept;
+        [[nodiscard]] Pair<Key const *, Value const *> operator*()
+            const noexcept;
+        [[nodiscard]] bool operator!=(Iterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(Iterator const &other) const noexcept;
+
+        HybridMap &map;
+        // Index of the inline item or table position of the HashMap
+        size_t pos{0};
+    };
+
+    struct ConstIterator
+    {
+        ConstIterator operator++() noexcept;
+        ConstIterator operator++(int) noexcept;
+        [[nodiscard]] Pair<Key const *, Value const *> operator*()
+            const noexcept;
+        [[nodiscard]] bool operator!=(
+            ConstIterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(
+            ConstIterator const &other) const noexcept;
+
+        HybridMap const &map;
+        // Index of the inline item or table position of the HashMap
+        size_t pos{0};
+    };
+
+    friend struct Iterator;
+    friend struct ConstIterator;
+
+  public:
+    HybridMap(Allocator &allocator) noexcept;
+    ~HybridMap();
+
+    HybridMap(HybridMap const &other) = delete;
+    HybridMap(HybridMap &&other) noexcept;
+    HybridMap &operator=(HybridMap const &other) = delete;
+    HybridMap &operator=(HybridMap &&other) noexcept;
+
+    [[nodiscard]] Iterator begin() noexcept;
+    [[nodiscard]] ConstIterator begin() const noexcept;
+    [[nodiscard]] Iterator end() noexcept;
+    [[nodiscard]] ConstIterator end() const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+    [[nodiscard]] bool is_inline() const noexcept;
+
+    [[nodiscard]] bool contains(Key const &key) const noexcept;
+    [[nodiscard]] Value const *find(Key const &key) const noexcept;
+    [[nodiscard]] Value *find(Key const &key) noexcept;
+
+    // Keeps the HashMap if the items have spilled
+    void clear() noexcept;
+
+    template <typename K, typename V>
+    // Let's be pedantic and disallow implicit conversions
+        requires(SameAs<K, Key> && SameAs<V, Value>)
+    Value *insert_or_assign(K &&key, V &&value) noexcept;
+
+    void remove(Key const &key) noexcept;
+
+    // Moves the items back inline if they fit, shrinks the HashMap otherwise
+    void shrink_to_fit() noexcept;
+
+  private:
+    using Small = SmallMap<Key, Value, N>;
+    using Large = HashMap<Key, Value, Hasher, Layout, Policy>;
+
+    // Moves the inline items into a HashMap
+    void spill() noexcept;
+    void destroy() noexcept;
+    // Constructs the active storage of this from other's, leaving other empty
+    void take(HybridMap &&other) noexcept;
+
+    Allocator &m_allocator;
+    union
+    {
+        Small m_small;
+        Large m_large;
+    };
+    bool m_is_inline{true};
+};
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+HybridMap<Key, Value, N, Hasher, Layout, Policy>::HybridMap(
+    Allocator &allocator) noexcept
+: m_allocator{allocator}
+, m_small{}
+{
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+HybridMap<Key, Value, N, Hasher, Layout, Policy>::~HybridMap()
+{
+    destroy();
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+HybridMap<Key, Value, N, Hasher, Layout, Policy>::HybridMap(
+    HybridMap &&other) noexcept
+: m_allocator{other.m_allocator}
+{
+    take(WHEELS_MOV(other));
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+HybridMap<Key, Value, N, Hasher, Layout, Policy> &HybridMap<
+    Key, Value, N, Hasher, Layout, Policy>::operator=(
+    HybridMap &&other) noexcept
+{
+    WHEELS_ASSERT(
+        &m_allocator == &other.m_allocator &&
+        "Move assigning a container with different allocators can lead to "
+        "nasty bugs. Use the same allocator or copy the content instead.");
+
+    if (this != &other)
+    {
+        destroy();
+        take(WHEELS_MOV(other));
+    }
+    return *this;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+typename HybridMap<Key, Value, N, Hasher, Layout, Policy>::Iterator HybridMap<
+    Key, Value, N, Hasher, Layout, Policy>::begin() noexcept
+{
+    return Iterator{
+        .map = *this,
+        .pos = m_is_inline ? 0 : m_large.begin().pos,
+    };
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+typename HybridMap<Key, Value, N, Hasher, Layout, Policy>::ConstIterator
+HybridMap<Key, Value, N, Hasher, Layout, Policy>::begin() const noexcept
+{
+    return ConstIterator{
+        .map = *this,
+        .pos = m_is_inline ? 0 : m_large.begin().pos,
+    };
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+typename HybridMap<Key, Value, N, Hasher, Layout, Policy>::Iterator HybridMap<
+    Key, Value, N, Hasher, Layout, Policy>::end() noexcept
+{
+    return Iterator{
+        .map = *this,
+        .pos = m_is_inline ? m_small.size() : m_large.end().pos,
+    };
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+typename HybridMap<Key, Value, N, Hasher, Layout, Policy>::ConstIterator
+HybridMap<Key, Value, N, Hasher, Layout, Policy>::end() const noexcept
+{
+    return ConstIterator{
+        .map = *this,
+        .pos = m_is_inline ? m_small.size() : m_large.end().pos,
+    };
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+bool HybridMap<Key, Value, N, Hasher, Layout, Policy>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+size_t HybridMap<Key, Value, N, Hasher, Layout, Policy>::size() const noexcept
+{
+    return m_is_inline ? m_small.size() : m_large.size();
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+size_t HybridMap<Key, Value, N, Hasher, Layout, Policy>::capacity()
+    const noexcept
+{
+    return m_is_inline ? m_small.capacity() : m_large.capacity();
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+bool HybridMap<Key, Value, N, Hasher, Layout, Policy>::is_inline()
+    const noexcept
+{
+    return m_is_inline;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+bool HybridMap<Key, Value, N, Hasher, Layout, Policy>::contains(
+    Key const &key) const noexcept
+{
+    return m_is_inline ? m_small.contains(key) : m_large.contains(key);
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+Value const *HybridMap<Key, Value, N, Hasher, Layout, Policy>::find(
+    Key const &key) const noexcept
+{
+    return m_is_inline ? m_small.find(key) : m_large.find(key);
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+Value *HybridMap<Key, Value, N, Hasher, Layout, Policy>::find(
+    Key const &key) noexcept
+{
+    return m_is_inline ? m_small.find(key) : m_large.find(key);
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+void HybridMap<Key, Value, N, Hasher, Layout, Policy>::clear() noexcept
+{
+    if (m_is_inline)
+        m_small.clear();
+    else
+        m_large.clear();
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+template <typename K, typename V>
+    requires(SameAs<K, Key> && SameAs<V, Value>)
+Value *HybridMap<Key, Value, N, Hasher, Layout, Policy>::insert_or_assign(
+    K &&key, V &&value) noexcept
+{
+    if (m_is_inline)
+    {
+        // The common case only scans the items once in
+        // SmallMap::insert_or_assign
+        if (m_small.size() < N)
+            return m_small.insert_or_assign(WHEELS_FWD(key), WHEELS_FWD(value));
+        if (Value *v = m_small.find(key); v != nullptr)
+        {
+            *v = value;
+            return v;
+        }
+        spill();
+    }
+    return m_large.insert_or_assign(WHEELS_FWD(key), WHEELS_FWD(value));
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+void HybridMap<Key, Value, N, Hasher, Layout, Policy>::remove(
+    Key const &key) noexcept
+{
+    if (m_is_inline)
+        m_small.remove(key);
+    else
+        m_large.remove(key);
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+void HybridMap<Key, Value, N, Hasher, Layout, Policy>::shrink_to_fit() noexcept
+{
+    if (m_is_inline)
+        return;
+
+    if (m_large.size() > N)
+    {
+        m_large.shrink_to_fit();
+        return;
+    }
+
+    Large large{WHEELS_MOV(m_large)};
+    m_large.~Large();
+    new (&m_small) Small{};
+    m_is_inline = true;
+
+    // HashMap only hands out const keys so those have to be copied over
+    large.for_each([&](Key const &key, Value &value)
+                   { m_small.insert_or_assign(Key{key}, WHEELS_MOV(value)); });
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+void HybridMap<Key, Value, N, Hasher, Layout, Policy>::spill() noexcept
+{
+    WHEELS_ASSERT(m_is_inline);
+
+    // Leave room for as many items as were inline before growing again
+    Large large{m_allocator};
+    large.reserve(2 * N);
+    for (Pair<Key, Value> &kv : m_small)
+        large.insert_or_assign(WHEELS_MOV(kv.first), WHEELS_MOV(kv.second));
+
+    m_small.~Small();
+    new (&m_large) Large{WHEELS_MOV(large)};
+    m_is_inline = false;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+void HybridMap<Key, Value, N, Hasher, Layout, Policy>::destroy() noexcept
+{
+    if (m_is_inline)
+        m_small.~Small();
+    else
+        m_large.~Large();
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+void HybridMap<Key, Value, N, Hasher, Layout, Policy>::take(
+    HybridMap &&other) noexcept
+{
+    m_is_inline = other.m_is_inline;
+    if (m_is_inline)
+    {
+        new (&m_small) Small{WHEELS_MOV(other.m_small)};
+        // Trivially copyable items aren't cleared by the move
+        other.m_small.clear();
+    }
+    else
+        new (&m_large) Large{WHEELS_MOV(other.m_large)};
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+typename HybridMap<Key, Value, N, Hasher, Layout, Policy>::Iterator HybridMap<
+    Key, Value, N, Hasher, Layout, Policy>::Iterator::operator++() noexcept
+{
+    if (map.m_is_inline)
+    {
+        WHEELS_ASSERT(pos < map.m_small.size());
+        pos++;
+    }
+    else
+    {
+        typename Large::Iterator iter{
+            .map = map.m_large,
+            .pos = pos,
+        };
+        ++iter;
+        pos = iter.pos;
+    }
+    return *this;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+typename HybridMap<Key, Value, N, Hasher, Layout, Policy>::Iterator HybridMap<
+    Key, Value, N, Hasher, Layout, Policy>::Iterator::operator++(int) noexcept
+{
+    Iterator const ret = *this;
+    ++*this;
+    return ret;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+Pair<Key const *, Value *> HybridMap<
+    Key, Value, N, Hasher, Layout, Policy>::Iterator::operator*() noexcept
+{
+    if (map.m_is_inline)
+    {
+        WHEELS_ASSERT(pos < map.m_small.size());
+        Pair<Key, Value> &kv = map.m_small.begin()[pos];
+        Key const *key = &kv.first;
+        Value *value = &kv.second;
+        return make_pair(key, value);
+    }
+
+    return *typename Large::Iterator{
+        .map = map.m_large,
+        .pos = pos,
+    };
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+Pair<Key const *, Value const *> HybridMap<
+    Key, Value, N, Hasher, Layout, Policy>::Iterator::operator*() const noexcept
+{
+    return *ConstIterator{
+        .map = map,
+        .pos = pos,
+    };
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+bool HybridMap<Key, Value, N, Hasher, Layout, Policy>::Iterator::operator!=(
+    Iterator const &other) const noexcept
+{
+    return pos != other.pos;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+bool HybridMap<Key, Value, N, Hasher, Layout, Policy>::Iterator::operator==(
+    Iterator const &other) const noexcept
+{
+    return pos == other.pos;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+typename HybridMap<Key, Value, N, Hasher, Layout, Policy>::ConstIterator
+HybridMap<Key, Value, N, Hasher, Layout, Policy>::ConstIterator::
+operator++() noexcept
+{
+    if (map.m_is_inline)
+    {
+        WHEELS_ASSERT(pos < map.m_small.size());
+        pos++;
+    }
+    else
+    {
+        typename Large::ConstIterator iter{
+            .map = map.m_large,
+            .pos = pos,
+        };
+        ++iter;
+        pos = iter.pos;
+    }
+    return *this;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+typename HybridMap<Key, Value, N, Hasher, Layout, Policy>::ConstIterator
+HybridMap<Key, Value, N, Hasher, Layout, Policy>::ConstIterator::operator++(
+    int) noexcept
+{
+    ConstIterator const ret = *this;
+    ++*this;
+    return ret;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+Pair<Key const *, Value const *> HybridMap<
+    Key, Value, N, Hasher, Layout, Policy>::ConstIterator::operator*()
+    const noexcept
+{
+    if (map.m_is_inline)
+    {
+        WHEELS_ASSERT(pos < map.m_small.size());
+        Pair<Key, Value> const &kv = map.m_small.begin()[pos];
+        Key const *key = &kv.first;
+        Value const *value = &kv.second;
+        return make_pair(key, value);
+    }
+
+    return *typename Large::ConstIterator{
+        .map = map.m_large,
+        .pos = pos,
+    };
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+bool HybridMap<Key, Value, N, Hasher, Layout, Policy>::ConstIterator::
+operator!=(ConstIterator const &other) const noexcept
+{
+    return pos != other.pos;
+}
+
+template <
+    typename Key, typename Value, size_t N, class Hasher, class Layout,
+    class Policy>
+bool HybridMap<Key, Value, N, Hasher, Layout, Policy>::ConstIterator::
+operator==(ConstIterator const &other) const noexcept
+{
+    return pos == other.pos;
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_HYBRID_MAP_HPP
@@ -0,0 +1,355 @@
+#ifndef WHEELS_CONTAINERS_HYBRID_SET_HPP
+#define WHEELS_CONTAINERS_HYBRID_SET_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "hash.hpp"
+#include "hash_set.hpp"
+#include "small_set.hpp"
+#include "utils.hpp"
+
+#include <new>
+
+namespace wheels
+{
+
+// Stores up to N values inline in a SmallSet and moves them into a HashSet
+// allocated from the allocator when an insert would go past N. The two share
+// storage so the set only takes the space of the larger one. Stays in the
+// HashSet after that until shrink_to_fit() finds the values fit inline again.
+// Iteration order is insertion order while inline and table order after.
+
+template <
+    typename T, size_t N, class Hasher = Hash<T>,
+    class Policy = DefaultHashPolicy>
+class HybridSet
+{
+  public:
+    using value_type = T;
+
+    struct ConstIterator
+    {
+        ConstIterator operator++() noexcept;
+        ConstIterator operator++(int) noexcept;
+        [[nodiscard]] T const &operator*() const noexcept;
+        [[nodiscard]] T const *operator->() const noexcept;
+        [[nodiscard]] bool operator!=(
+            ConstIterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(
+            ConstIterator const &other) const noexcept;
+
+        HybridSet const &set;
+        // Index of the inline value or table position of the HashSet
+        size_t pos{0};
+    };
+
+    friend struct ConstIterator;
+
+  public:
+    HybridSet(Allocator &allocator) noexcept;
+    ~HybridSet();
+
+    HybridSet(HybridSet const &other) = delete;
+    HybridSet(HybridSet &&other) noexcept;
+    HybridSet &operator=(HybridSet const &other) = delete;
+    HybridSet &operator=(HybridSet &&other) noexcept;
+
+    [[nodiscard]] ConstIterator begin() const noexcept;
+    [[nodiscard]] ConstIterator end() const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+    [[nodiscard]] bool is_inline() const noexcept;
+
+    [[nodiscard]] bool contains(T const &value) const noexcept;
+
+    // Keeps the HashSet if the values have spilled
+    void clear() noexcept;
+
+    template <typename U>
+    // Let's be pedantic and disallow implicit conversions
+        requires SameAs<U, T>
+    void insert(U &&value) noexcept;
+
+    void remove(T const &value) noexcept;
+
+    // Moves the values back inline if they fit, shrinks the HashSet otherwise
+    void shrink_to_fit() noexcept;
+
+  private:
+    using Small = SmallSet<T, N>;
+    using Large = HashSet<T, Hasher, Policy>;
+
+    // Moves the inline values into a HashSet
+    void spill() noexcept;
+    void destroy() noexcept;
+    // Constructs the active storage of this from other's, leaving other empty
+    void take(HybridSet &&other) noexcept;
+
+    Allocator &m_allocator;
+    union
+    {
+        Small m_small;
+        Large m_large;
+    };
+    bool m_is_inline{true};
+};
+
+template <typename T, size_t N, class Hasher, class Policy>
+HybridSet<T, N, Hasher, Policy>::HybridSet(Allocator &allocator) noexcept
+: m_allocator{allocator}
+, m_small{}
+{
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+HybridSet<T, N, Hasher, Policy>::~HybridSet()
+{
+    destroy();
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+HybridSet<T, N, Hasher, Policy>::HybridSet(HybridSet &&other) noexcept
+: m_allocator{other.m_allocator}
+{
+    take(WHEELS_MOV(other));
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+HybridSet<T, N, Hasher, Policy> &HybridSet<T, N, Hasher, Policy>::operator=(
+    HybridSet &&other) noexcept
+{
+    WHEELS_ASSERT(
+        &m_allocator == &other.m_allocator &&
+        "Move assigning a container with different allocators can lead to "
+        "nasty bugs. Use the same allocator or copy the content instead.");
+
+    if (this != &other)
+    {
+        destroy();
+        take(WHEELS_MOV(other));
+    }
+    return *this;
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+typename HybridSet<T, N, Hasher, Policy>::ConstIterator HybridSet<
+    T, N, Hasher, Policy>::begin() const noexcept
+{
+    return ConstIterator{
+        .set = *this,
+        .pos = m_is_inline ? 0 : m_large.begin().pos,
+    };
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+typename HybridSet<T, N, Hasher, Policy>::ConstIterator HybridSet<
+    T, N, Hasher, Policy>::end() const noexcept
+{
+    return ConstIterator{
+        .set = *this,
+        .pos = m_is_inline ? m_small.size() : m_large.end().pos,
+    };
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+bool HybridSet<T, N, Hasher, Policy>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+size_t HybridSet<T, N, Hasher, Policy>::size() const noexcept
+{
+    return m_is_inline ? m_small.size() : m_large.size();
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+size_t HybridSet<T, N, Hasher, Policy>::capacity() const noexcept
+{
+    return m_is_inline ? m_small.capacity() : m_large.capacity();
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+bool HybridSet<T, N, Hasher, Policy>::is_inline() const noexcept
+{
+    return m_is_inline;
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+bool HybridSet<T, N, Hasher, Policy>::contains(T const &value) const noexcept
+{
+    return m_is_inline ? m_small.contains(value) : m_large.contains(value);
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+void HybridSet<T, N, Hasher, Policy>::clear() noexcept
+{
+    if (m_is_inline)
+        m_small.clear();
+    else
+        m_large.clear();
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+template <typename U>
+    requires SameAs<U, T>
+void HybridSet<T, N, Hasher, Policy>::insert(U &&value) noexcept
+{
+    if (m_is_inline)
+    {
+        // The common case only scans the values once in SmallSet::insert
+        if (m_small.size() < N)
+        {
+            m_small.insert(WHEELS_FWD(value));
+            return;
+        }
+        if (m_small.contains(value))
+            return;
+        spill();
+    }
+    m_large.insert(WHEELS_FWD(value));
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+void HybridSet<T, N, Hasher, Policy>::remove(T const &value) noexcept
+{
+    if (m_is_inline)
+        m_small.remove(value);
+    else
+        m_large.remove(value);
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+void HybridSet<T, N, Hasher, Policy>::shrink_to_fit() noexcept
+{
+    if (m_is_inline)
+        return;
+
+    if (m_large.size() > N)
+    {
+        m_large.shrink_to_fit();
+        return;
+    }
+
+    Large large{WHEELS_MOV(m_large)};
+    m_large.~Large();
+    new (&m_small) Small{};
+    m_is_inline = true;
+
+    // HashSet only hands out const values so they have to be copied over
+    large.for_each([&](T const &value) { m_small.insert(value); });
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+void HybridSet<T, N, Hasher, Policy>::spill() noexcept
+{
+    WHEELS_ASSERT(m_is_inline);
+
+    // Leave room for as many values as were inline before growing again
+    Large large{m_allocator};
+    large.reserve(2 * N);
+    for (T &value : m_small)
+        large.insert(WHEELS_MOV(value));
+
+    m_small.~Small();
+    new (&m_large) Large{WHEELS_MOV(large)};
+    m_is_inline = false;
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+void HybridSet<T, N, Hasher, Policy>::destroy() noexcept
+{
+    if (m_is_inline)
+        m_small.~Small();
+    else
+        m_large.~Large();
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+void HybridSet<T, N, Hasher, Policy>::take(HybridSet &&other) noexcept
+{
+    m_is_inline = other.m_is_inline;
+    if (m_is_inline)
+    {
+        new (&m_small) Small{WHEELS_MOV(other.m_small)};
+        // Trivially copyable values aren't cleared by the move
+        other.m_small.clear();
+    }
+    else
+        new (&m_large) Large{WHEELS_MOV(other.m_large)};
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+typename HybridSet<T, N, Hasher, Policy>::ConstIterator HybridSet<
+    T, N, Hasher, Policy>::ConstIterator::operator++() noexcept
+{
+    if (set.m_is_inline)
+    {
+        WHEELS_ASSERT(pos < set.m_small.size());
+        pos++;
+    }
+    else
+    {
+        typename Large::ConstIterator iter{
+            .set = set.m_large,
+            .pos = pos,
+        };
+        ++iter;
+        pos = iter.pos;
+    }
+    return *this;
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+typename HybridSet<T, N, Hasher, Policy>::ConstIterator HybridSet<
+    T, N, Hasher, Policy>::ConstIterator::operator++(int) noexcept
+{
+    ConstIterator const ret = *this;
+    ++*this;
+    return ret;
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+T const &HybridSet<T, N, Hasher, Policy>::ConstIterator::operator*()
+    const noexcept
+{
+    if (set.m_is_inline)
+    {
+        WHEELS_ASSERT(pos < set.m_small.size());
+        return set.m_small.begin()[pos];
+    }
+
+    return *typename Large::ConstIterator{
+        .set = set.m_large,
+        .pos = pos,
+    };
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+T const *HybridSet<T, N, Hasher, Policy>::ConstIterator::operator->()
+    const noexcept
+{
+    return &**this;
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+bool HybridSet<T, N, Hasher, Policy>::ConstIterator::operator!=(
+    ConstIterator const &other) const noexcept
+{
+    return pos != other.pos;
+}
+
+template <typename T, size_t N, class Hasher, class Policy>
+bool HybridSet<T, N, Hasher, Policy>::ConstIterator::operator==(
+    ConstIterator const &other) const noexcept
+{
+    return pos == other.pos;
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_HYBRID_SET_HPP
@@ -4,7 +4,9 @@
 
 #include "../assert.hpp"
 #include "../utils.hpp"
+#include "hash.hpp"
 #include "span.hpp"
+#include "utils.hpp"
 
 #include <cstring>
 #include <initializer_list>
@@ -17,16 +19,35 @@ template <typename T, size_t N> class InlineArray
   public:
     using value_type = T;
 
-    InlineArray() noexcept;
+    // User provided so that value-initialization doesn't zero the storage
+    InlineArray() noexcept {}
     InlineArray(T const (&elems)[N]) noexcept;
     // Takes in either a single default value for the entire array or a list of
     // values filling all slots
     explicit InlineArray(std::initializer_list<T> elems) noexcept;
+
+    // The array is trivially copyable when T is so that it can be memcpy'd as
+    // a part of larger structs. Moved from arrays keep their values then.
+    ~InlineArray()
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
     ~InlineArray();
 
+    InlineArray(InlineArray<T, N> const &other) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
     InlineArray(InlineArray<T, N> const &other) noexcept;
+    InlineArray(InlineArray<T, N> &&other) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
     InlineArray(InlineArray<T, N> &&other) noexcept;
+    InlineArray<T, N> &operator=(InlineArray<T, N> const &other) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
     InlineArray<T, N> &operator=(InlineArray<T, N> const &other) noexcept;
+    InlineArray<T, N> &operator=(InlineArray<T, N> &&other) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
     InlineArray<T, N> &operator=(InlineArray<T, N> &&other) noexcept;
 
     [[nodiscard]] T &operator[](size_t i) noexcept;
@@ -60,48 +81,55 @@ template <typename T, size_t N> class InlineArray
     void push_back(T const &value) noexcept;
     void push_back(T &&value) noexcept;
     template <typename... Args> void emplace_back(Args &&...args) noexcept;
+    // Constructs a value before index, shifting the ones after it. args can't
+    // point into this array.
+    template <typename... Args>
+    void emplace(size_t index, Args &&...args) noexcept;
+    // Inserts the values before index, shifting the ones after it. values
+    // can't point into this array.
+    void insert(size_t index, Span<const T> values) noexcept;
+
     T pop_back() noexcept;
+    // Preserves the order, takes O(n) for n elements after index
+    void erase(size_t index) noexcept;
+    // Erases [begin_i, end_i) and shifts the rest over it in one go
+    void erase(size_t begin_i, size_t end_i) noexcept;
+    // Removes the values for which pred(T const &) returns true in a single
+    // pass, preserving the order of the rest. Returns the number of removed
+    // values.
+    template <typename F> size_t erase_if(F &&pred) noexcept;
+    // Keeps only the values for which pred(T const &) returns true. Returns the
+    // number of removed values.
+    template <typename F> size_t retain(F &&pred) noexcept;
     void resize(size_t size) noexcept;
     void resize(size_t size, T const &value) noexcept;
 
     operator Span<T const>() const noexcept;
 
   private:
-#ifndef NDEBUG
-    const T *m_debug{nullptr};
-#endif // NDEBUG
     alignas(T) uint8_t m_data[N * sizeof(T)];
     size_t m_size{0};
 };
 
-template <typename T, size_t N>
-InlineArray<T, N>::InlineArray() noexcept
-#ifndef NDEBUG
-: m_debug{reinterpret_cast<const T *>(&m_data)}
-#endif // NDEBUG
-{
-}
-
 // Deduction from raw arrays
 template <typename T, size_t N>
 InlineArray(T const (&)[N]) -> InlineArray<T, N>;
 
 template <typename T, size_t N>
 InlineArray<T, N>::InlineArray(T const (&elems)[N]) noexcept
-:
-#ifndef NDEBUG
-    m_debug{reinterpret_cast<const T *>(&m_data)}
-,
-#endif // NDEBUG
-m_size{N}
-{
-    // TODO: memcpy for entire elems array if T is trivially copyable
-    for (size_t i = 0; i < N; ++i)
+: m_size{N}
+{
+    if constexpr (std::is_trivially_copyable_v<T>)
+        memcpy(m_data, elems, N * sizeof(T));
+    else
     {
-        new (((T *)m_data) + i) T{WHEELS_MOV(elems[i])};
-        if constexpr (!std::is_trivially_destructible_v<T>)
-            // Moved from value might still require dtor
-            elems[i].~T();
+        for (size_t i = 0; i < N; ++i)
+        {
+            new (((T *)m_data) + i) T{WHEELS_MOV(elems[i])};
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                // Moved from value might still require dtor
+                elems[i].~T();
+        }
     }
 }
 
@@ -111,12 +139,7 @@ InlineArray(T const &, Ts...) -> InlineArray<T, 1 + sizeof...(Ts)>;
 
 template <typename T, size_t N>
 InlineArray<T, N>::InlineArray(std::initializer_list<T> elems) noexcept
-:
-#ifndef NDEBUG
-    m_debug{reinterpret_cast<const T *>(&m_data)}
-,
-#endif // NDEBUG
-m_size{elems.size()}
+: m_size{elems.size()}
 {
     WHEELS_ASSERT(elems.size() == 1 || elems.size() == N);
 
@@ -127,9 +150,10 @@ m_size{elems.size()}
         for (size_t i = 0; i < N; ++i)
             new (((T *)m_data) + i) T{default_value};
     }
+    else if constexpr (std::is_trivially_copyable_v<T>)
+        memcpy(m_data, elems.begin(), N * sizeof(T));
     else
     {
-        // TODO: memcpy for entire elems array if T is trivially copyable
         size_t i = 0;
         auto const end = elems.end();
         for (auto iter = elems.begin(); iter != end; ++iter, ++i)
@@ -146,12 +170,7 @@ template <typename T, size_t N> InlineArray<T, N>::~InlineArray() { clear(); }
 
 template <typename T, size_t N>
 InlineArray<T, N>::InlineArray(InlineArray<T, N> const &other) noexcept
-:
-#ifndef NDEBUG
-    m_debug{reinterpret_cast<const T *>(&m_data)}
-,
-#endif // NDEBUG
-m_size{other.m_size}
+: m_size{other.m_size}
 {
     for (size_t i = 0; i < other.m_size; ++i)
         new ((T *)m_data + i) T{((T *)other.m_data)[i]};
@@ -159,12 +178,7 @@ m_size{other.m_size}
 
 template <typename T, size_t N>
 InlineArray<T, N>::InlineArray(InlineArray<T, N> &&other) noexcept
-:
-#ifndef NDEBUG
-    m_debug{reinterpret_cast<const T *>(&m_data)}
-,
-#endif // NDEBUG
-m_size{other.m_size}
+: m_size{other.m_size}
 {
     for (size_t i = 0; i < other.m_size; ++i)
     {
@@ -355,6 +369,47 @@ void InlineArray<T, N>::emplace_back(Args &&...args) noexcept
     new (((T *)m_data) + m_size++) T{WHEELS_FWD(args)...};
 }
 
+template <typename T, size_t N>
+template <typename... Args>
+void InlineArray<T, N>::emplace(size_t index, Args &&...args) noexcept
+{
+    WHEELS_ASSERT(index <= m_size);
+    WHEELS_ASSERT(m_size < N);
+
+    T *const elems = data();
+    relocate_overlapping(elems + index + 1, elems + index, m_size - index);
+    new (elems + index) T{WHEELS_FWD(args)...};
+    m_size++;
+}
+
+template <typename T, size_t N>
+void InlineArray<T, N>::insert(size_t index, Span<const T> values) noexcept
+{
+    WHEELS_ASSERT(index <= m_size);
+    WHEELS_ASSERT(
+        (values.data() + values.size() <= data() ||
+         values.data() >= data() + capacity()) &&
+        "Inserting values from the array itself isn't supported");
+
+    size_t const count = values.size();
+    if (count == 0)
+        return;
+
+    WHEELS_ASSERT(m_size + count <= N);
+
+    T *const elems = data();
+    relocate_overlapping(elems + index + count, elems + index, m_size - index);
+
+    if constexpr (std::is_trivially_copyable_v<T>)
+        memcpy(elems + index, values.data(), count * sizeof(T));
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            new (elems + index + i) T{values[i]};
+    }
+    m_size += count;
+}
+
 template <typename T, size_t N> T InlineArray<T, N>::pop_back() noexcept
 {
     WHEELS_ASSERT(m_size > 0);
@@ -368,6 +423,49 @@ template <typename T, size_t N> T InlineArray<T, N>::pop_back() noexcept
     return ret;
 }
 
+template <typename T, size_t N>
+void InlineArray<T, N>::erase(size_t index) noexcept
+{
+    WHEELS_ASSERT(index < m_size);
+
+    erase(index, index + 1);
+}
+
+template <typename T, size_t N>
+void InlineArray<T, N>::erase(size_t begin_i, size_t end_i) noexcept
+{
+    WHEELS_ASSERT(begin_i <= end_i);
+    WHEELS_ASSERT(end_i <= m_size);
+
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        for (size_t i = begin_i; i < end_i; ++i)
+            ((T *)m_data)[i].~T();
+    }
+
+    relocate_overlapping(
+        ((T *)m_data) + begin_i, ((T *)m_data) + end_i, m_size - end_i);
+    m_size -= end_i - begin_i;
+}
+
+template <typename T, size_t N>
+template <typename F>
+size_t InlineArray<T, N>::erase_if(F &&pred) noexcept
+{
+    size_t const kept_count = remove_values_if((T *)m_data, m_size, pred);
+    size_t const removed_count = m_size - kept_count;
+    m_size = kept_count;
+
+    return removed_count;
+}
+
+template <typename T, size_t N>
+template <typename F>
+size_t InlineArray<T, N>::retain(F &&pred) noexcept
+{
+    return erase_if([&](T const &value) { return !pred(value); });
+}
+
 template <typename T, size_t N>
 void InlineArray<T, N>::resize(size_t size) noexcept
 {
@@ -422,6 +520,40 @@ InlineArray<T, N>::operator Span<T const>() const noexcept
     return Span{(T const *)m_data, m_size};
 }
 
+template <typename T, size_t N>
+[[nodiscard]] bool operator==(
+    InlineArray<T, N> const &lhs, InlineArray<T, N> const &rhs) noexcept
+{
+    return lhs.span() == rhs.span();
+}
+
+template <typename T, size_t N>
+[[nodiscard]] bool operator!=(
+    InlineArray<T, N> const &lhs, InlineArray<T, N> const &rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+// Only the live elements are hashed so the hash doesn't depend on what was
+// left in the rest of the storage
+template <typename T, size_t N> struct Hash<InlineArray<T, N>>
+{
+    [[nodiscard]] uint64_t operator()(
+        InlineArray<T, N> const &value) const noexcept
+    {
+        if constexpr (byte_hashable<T>)
+            return wyhash(value.data(), value.size() * sizeof(T), 0, _wyp);
+        else
+        {
+            Hash<T> const hasher;
+            uint64_t ret = value.size();
+            for (T const &v : value)
+                ret = hash_combine(ret, hasher(v));
+            return ret;
+        }
+    }
+};
+
 } // namespace wheels
 
 #endif // WHEELS_CONTAINERS_INLINE_ARRAY_HPP
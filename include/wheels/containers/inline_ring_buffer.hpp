@@ -0,0 +1,588 @@
+
+#ifndef WHEELS_CONTAINERS_INLINE_RING_BUFFER_HPP
+#define WHEELS_CONTAINERS_INLINE_RING_BUFFER_HPP
+
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "pair.hpp"
+#include "span.hpp"
+#include "utils.hpp"
+
+#include <cstring>
+
+namespace wheels
+{
+
+// Fixed capacity version of RingBuffer with the values stored inline. Pushing
+// to a full buffer is an error.
+template <typename T, size_t N> class InlineRingBuffer
+{
+    static_assert(N > 0);
+
+  public:
+    using value_type = T;
+
+    struct Iterator
+    {
+        Iterator operator++() noexcept;
+        Iterator operator++(int) noexcept;
+        [[nodiscard]] T &operator*() const noexcept;
+        [[nodiscard]] T *operator->() const noexcept;
+        [[nodiscard]] bool operator!=(Iterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(Iterator const &other) const noexcept;
+
+        InlineRingBuffer &buffer;
+        // Index from the front of the buffer
+        size_t pos{0};
+    };
+
+    struct ConstIterator
+    {
+        ConstIterator operator++() noexcept;
+        ConstIterator operator++(int) noexcept;
+        [[nodiscard]] T const &operator*() const noexcept;
+        [[nodiscard]] T const *operator->() const noexcept;
+        [[nodiscard]] bool operator!=(
+            ConstIterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(
+            ConstIterator const &other) const noexcept;
+
+        InlineRingBuffer const &buffer;
+        // Index from the front of the buffer
+        size_t pos{0};
+    };
+
+    // User provided so that value-initialization doesn't zero the storage
+    InlineRingBuffer() noexcept {}
+
+    // The buffer is trivially copyable when T is so that it can be memcpy'd as
+    // a part of larger structs. Moved from buffers keep their values then.
+    ~InlineRingBuffer()
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
+    ~InlineRingBuffer();
+
+    InlineRingBuffer(InlineRingBuffer<T, N> const &other) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
+    InlineRingBuffer(InlineRingBuffer<T, N> const &other) noexcept;
+    InlineRingBuffer(InlineRingBuffer<T, N> &&other) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
+    InlineRingBuffer(InlineRingBuffer<T, N> &&other) noexcept;
+    InlineRingBuffer<T, N> &operator=(
+        InlineRingBuffer<T, N> const &other) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
+    InlineRingBuffer<T, N> &operator=(
+        InlineRingBuffer<T, N> const &other) noexcept;
+    InlineRingBuffer<T, N> &operator=(InlineRingBuffer<T, N> &&other) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    = default;
+    InlineRingBuffer<T, N> &operator=(InlineRingBuffer<T, N> &&other) noexcept;
+
+    // Indexed from the front
+    [[nodiscard]] T &operator[](size_t i) noexcept;
+    [[nodiscard]] T const &operator[](size_t i) const noexcept;
+    [[nodiscard]] T &front() noexcept;
+    [[nodiscard]] T const &front() const noexcept;
+    [[nodiscard]] T &back() noexcept;
+    [[nodiscard]] T const &back() const noexcept;
+
+    [[nodiscard]] Iterator begin() noexcept;
+    [[nodiscard]] ConstIterator begin() const noexcept;
+    [[nodiscard]] Iterator end() noexcept;
+    [[nodiscard]] ConstIterator end() const noexcept;
+
+    // Returns the values from front to back as two contiguous segments. The
+    // second one is empty unless the values wrap around the end of the
+    // storage.
+    [[nodiscard]] Pair<Span<T>, Span<T>> mut_spans() noexcept;
+    [[nodiscard]] Pair<Span<T const>, Span<T const>> spans() const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] bool full() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] static constexpr size_t capacity() noexcept { return N; }
+
+    void clear() noexcept;
+
+    template <typename U>
+    // Let's be pedantic and disallow implicit conversions
+        requires SameAs<U, T>
+    void push_back(U &&value) noexcept;
+    template <typename U>
+    // Let's be pedantic and disallow implicit conversions
+        requires SameAs<U, T>
+    void push_front(U &&value) noexcept;
+
+    template <typename... Args> void emplace_back(Args &&...args) noexcept;
+    template <typename... Args> void emplace_front(Args &&...args) noexcept;
+
+    // Copies the values to the back, with at most two memcpys if T is
+    // trivially copyable. values can't point into this buffer.
+    void extend(Span<T const> values) noexcept;
+
+    T pop_back() noexcept;
+    T pop_front() noexcept;
+    // Moves dst.size() values from the front into dst, with at most two
+    // memcpys if T is trivially copyable
+    void pop_front_into(Span<T> dst) noexcept;
+    // Destroys count values from the front, e.g. after reading them through
+    // spans()
+    void drop_front(size_t count) noexcept;
+
+  private:
+    // Maps an index from the front into the storage
+    [[nodiscard]] size_t wrap(size_t i) const noexcept;
+    [[nodiscard]] T *slot(size_t i) noexcept;
+    [[nodiscard]] T const *slot(size_t i) const noexcept;
+
+    alignas(T) uint8_t m_data[N * sizeof(T)];
+    size_t m_head{0};
+    size_t m_size{0};
+};
+
+template <typename T, size_t N>
+InlineRingBuffer<T, N>::~InlineRingBuffer()
+{
+    clear();
+}
+
+template <typename T, size_t N>
+InlineRingBuffer<T, N>::InlineRingBuffer(
+    InlineRingBuffer<T, N> const &other) noexcept
+: m_size{other.m_size}
+{
+    // Unwrap the values to the start of the storage
+    for (size_t i = 0; i < other.m_size; ++i)
+        new (slot(i)) T{other[i]};
+}
+
+template <typename T, size_t N>
+InlineRingBuffer<T, N>::InlineRingBuffer(
+    InlineRingBuffer<T, N> &&other) noexcept
+: m_size{other.m_size}
+{
+    for (size_t i = 0; i < other.m_size; ++i)
+        relocate(slot(i), other.slot(other.wrap(i)));
+    other.m_head = 0;
+    other.m_size = 0;
+}
+
+template <typename T, size_t N>
+InlineRingBuffer<T, N> &InlineRingBuffer<T, N>::operator=(
+    InlineRingBuffer<T, N> const &other) noexcept
+{
+    if (this != &other)
+    {
+        clear();
+
+        for (size_t i = 0; i < other.m_size; ++i)
+            new (slot(i)) T{other[i]};
+        m_size = other.m_size;
+    }
+    return *this;
+}
+
+template <typename T, size_t N>
+InlineRingBuffer<T, N> &InlineRingBuffer<T, N>::operator=(
+    InlineRingBuffer<T, N> &&other) noexcept
+{
+    if (this != &other)
+    {
+        clear();
+
+        for (size_t i = 0; i < other.m_size; ++i)
+            relocate(slot(i), other.slot(other.wrap(i)));
+        m_size = other.m_size;
+
+        other.m_head = 0;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+template <typename T, size_t N>
+T &InlineRingBuffer<T, N>::operator[](size_t i) noexcept
+{
+    WHEELS_ASSERT(i < m_size);
+    return *slot(wrap(i));
+}
+
+template <typename T, size_t N>
+T const &InlineRingBuffer<T, N>::operator[](size_t i) const noexcept
+{
+    WHEELS_ASSERT(i < m_size);
+    return *slot(wrap(i));
+}
+
+template <typename T, size_t N> T &InlineRingBuffer<T, N>::front() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return *slot(m_head);
+}
+
+template <typename T, size_t N>
+T const &InlineRingBuffer<T, N>::front() const noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return *slot(m_head);
+}
+
+template <typename T, size_t N> T &InlineRingBuffer<T, N>::back() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return *slot(wrap(m_size - 1));
+}
+
+template <typename T, size_t N>
+T const &InlineRingBuffer<T, N>::back() const noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return *slot(wrap(m_size - 1));
+}
+
+template <typename T, size_t N>
+typename InlineRingBuffer<T, N>::Iterator InlineRingBuffer<
+    T, N>::begin() noexcept
+{
+    return Iterator{
+        .buffer = *this,
+        .pos = 0,
+    };
+}
+
+template <typename T, size_t N>
+typename InlineRingBuffer<T, N>::ConstIterator InlineRingBuffer<
+    T, N>::begin() const noexcept
+{
+    return ConstIterator{
+        .buffer = *this,
+        .pos = 0,
+    };
+}
+
+template <typename T, size_t N>
+typename InlineRingBuffer<T, N>::Iterator InlineRingBuffer<T, N>::end() noexcept
+{
+    return Iterator{
+        .buffer = *this,
+        .pos = m_size,
+    };
+}
+
+template <typename T, size_t N>
+typename InlineRingBuffer<T, N>::ConstIterator InlineRingBuffer<
+    T, N>::end() const noexcept
+{
+    return ConstIterator{
+        .buffer = *this,
+        .pos = m_size,
+    };
+}
+
+template <typename T, size_t N>
+Pair<Span<T>, Span<T>> InlineRingBuffer<T, N>::mut_spans() noexcept
+{
+    size_t const first_size = m_size < N - m_head ? m_size : N - m_head;
+    return Pair<Span<T>, Span<T>>{
+        Span<T>{slot(m_head), first_size},
+        Span<T>{slot(0), m_size - first_size},
+    };
+}
+
+template <typename T, size_t N>
+Pair<Span<T const>, Span<T const>> InlineRingBuffer<T, N>::spans()
+    const noexcept
+{
+    size_t const first_size = m_size < N - m_head ? m_size : N - m_head;
+    return Pair<Span<T const>, Span<T const>>{
+        Span<T const>{slot(m_head), first_size},
+        Span<T const>{slot(0), m_size - first_size},
+    };
+}
+
+template <typename T, size_t N>
+bool InlineRingBuffer<T, N>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <typename T, size_t N>
+bool InlineRingBuffer<T, N>::full() const noexcept
+{
+    return m_size == N;
+}
+
+template <typename T, size_t N>
+size_t InlineRingBuffer<T, N>::size() const noexcept
+{
+    return m_size;
+}
+
+template <typename T, size_t N> void InlineRingBuffer<T, N>::clear() noexcept
+{
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        for (T &v : *this)
+            v.~T();
+    }
+    m_head = 0;
+    m_size = 0;
+}
+
+template <typename T, size_t N>
+template <typename U>
+    requires SameAs<U, T>
+void InlineRingBuffer<T, N>::push_back(U &&value) noexcept
+{
+    WHEELS_ASSERT(m_size < N);
+
+    new (slot(wrap(m_size))) T{WHEELS_FWD(value)};
+    m_size++;
+}
+
+template <typename T, size_t N>
+template <typename U>
+    requires SameAs<U, T>
+void InlineRingBuffer<T, N>::push_front(U &&value) noexcept
+{
+    WHEELS_ASSERT(m_size < N);
+
+    m_head = m_head == 0 ? N - 1 : m_head - 1;
+    new (slot(m_head)) T{WHEELS_FWD(value)};
+    m_size++;
+}
+
+template <typename T, size_t N>
+template <typename... Args>
+void InlineRingBuffer<T, N>::emplace_back(Args &&...args) noexcept
+{
+    WHEELS_ASSERT(m_size < N);
+
+    new (slot(wrap(m_size))) T{WHEELS_FWD(args)...};
+    m_size++;
+}
+
+template <typename T, size_t N>
+template <typename... Args>
+void InlineRingBuffer<T, N>::emplace_front(Args &&...args) noexcept
+{
+    WHEELS_ASSERT(m_size < N);
+
+    m_head = m_head == 0 ? N - 1 : m_head - 1;
+    new (slot(m_head)) T{WHEELS_FWD(args)...};
+    m_size++;
+}
+
+template <typename T, size_t N>
+void InlineRingBuffer<T, N>::extend(Span<T const> values) noexcept
+{
+    size_t const count = values.size();
+    WHEELS_ASSERT(m_size + count <= N);
+    if (count == 0)
+        return;
+
+    size_t const tail = wrap(m_size);
+    size_t const first_count = count < N - tail ? count : N - tail;
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+        memcpy(slot(tail), values.data(), first_count * sizeof(T));
+        memcpy(
+            slot(0), values.data() + first_count,
+            (count - first_count) * sizeof(T));
+    }
+    else
+    {
+        for (size_t i = 0; i < first_count; ++i)
+            new (slot(tail + i)) T{values[i]};
+        for (size_t i = first_count; i < count; ++i)
+            new (slot(i - first_count)) T{values[i]};
+    }
+    m_size += count;
+}
+
+template <typename T, size_t N> T InlineRingBuffer<T, N>::pop_back() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    m_size--;
+
+    T *value = slot(wrap(m_size));
+    T ret = WHEELS_MOV(*value);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        // Moved from value might still require dtor
+        value->~T();
+
+    return ret;
+}
+
+template <typename T, size_t N> T InlineRingBuffer<T, N>::pop_front() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+
+    T *value = slot(m_head);
+    T ret = WHEELS_MOV(*value);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        // Moved from value might still require dtor
+        value->~T();
+
+    m_head = wrap(1);
+    m_size--;
+
+    return ret;
+}
+
+template <typename T, size_t N>
+void InlineRingBuffer<T, N>::pop_front_into(Span<T> dst) noexcept
+{
+    size_t const count = dst.size();
+    WHEELS_ASSERT(count <= m_size);
+    if (count == 0)
+        return;
+
+    size_t const first_count = count < N - m_head ? count : N - m_head;
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+        memcpy(dst.data(), slot(m_head), first_count * sizeof(T));
+        memcpy(
+            dst.data() + first_count, slot(0),
+            (count - first_count) * sizeof(T));
+        m_head = wrap(count);
+        m_size -= count;
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = WHEELS_MOV((*this)[i]);
+        // Moved from values might still require dtors
+        drop_front(count);
+    }
+}
+
+template <typename T, size_t N>
+void InlineRingBuffer<T, N>::drop_front(size_t count) noexcept
+{
+    WHEELS_ASSERT(count <= m_size);
+
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        for (size_t i = 0; i < count; ++i)
+            slot(wrap(i))->~T();
+    }
+    m_head = count == m_size ? 0 : wrap(count);
+    m_size -= count;
+}
+
+template <typename T, size_t N>
+size_t InlineRingBuffer<T, N>::wrap(size_t i) const noexcept
+{
+    // Cheaper than a modulo as the index never goes past twice the capacity
+    size_t const ret = m_head + i;
+    return ret >= N ? ret - N : ret;
+}
+
+template <typename T, size_t N>
+T *InlineRingBuffer<T, N>::slot(size_t i) noexcept
+{
+    return (T *)m_data + i;
+}
+
+template <typename T, size_t N>
+T const *InlineRingBuffer<T, N>::slot(size_t i) const noexcept
+{
+    return (T const *)m_data + i;
+}
+
+template <typename T, size_t N>
+typename InlineRingBuffer<T, N>::Iterator InlineRingBuffer<
+    T, N>::Iterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < buffer.m_size);
+    pos++;
+    return *this;
+}
+
+template <typename T, size_t N>
+typename InlineRingBuffer<T, N>::Iterator InlineRingBuffer<
+    T, N>::Iterator::operator++(int) noexcept
+{
+    Iterator const ret = *this;
+    ++*this;
+    return ret;
+}
+
+template <typename T, size_t N>
+T &InlineRingBuffer<T, N>::Iterator::operator*() const noexcept
+{
+    return buffer[pos];
+}
+
+template <typename T, size_t N>
+T *InlineRingBuffer<T, N>::Iterator::operator->() const noexcept
+{
+    return &buffer[pos];
+}
+
+template <typename T, size_t N>
+bool InlineRingBuffer<T, N>::Iterator::operator!=(
+    Iterator const &other) const noexcept
+{
+    return pos != other.pos;
+}
+
+template <typename T, size_t N>
+bool InlineRingBuffer<T, N>::Iterator::operator==(
+    Iterator const &other) const noexcept
+{
+    return pos == other.pos;
+}
+
+template <typename T, size_t N>
+typename InlineRingBuffer<T, N>::ConstIterator InlineRingBuffer<
+    T, N>::ConstIterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < buffer.m_size);
+    pos++;
+    return *this;
+}
+
+template <typename T, size_t N>
+typename InlineRingBuffer<T, N>::ConstIterator InlineRingBuffer<
+    T, N>::ConstIterator::operator++(int) noexcept
+{
+    ConstIterator const ret = *this;
+    ++*this;
+    return ret;
+}
+
+template <typename T, size_t N>
+T const &InlineRingBuffer<T, N>::ConstIterator::operator*() const noexcept
+{
+    return buffer[pos];
+}
+
+template <typename T, size_t N>
+T const *InlineRingBuffer<T, N>::ConstIterator::operator->() const noexcept
+{
+    return &buffer[pos];
+}
+
+template <typename T, size_t N>
+bool InlineRingBuffer<T, N>::ConstIterator::operator!=(
+    ConstIterator const &other) const noexcept
+{
+    return pos != other.pos;
+}
+
+template <typename T, size_t N>
+bool InlineRingBuffer<T, N>::ConstIterator::operator==(
+    ConstIterator const &other) const noexcept
+{
+    return pos == other.pos;
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_INLINE_RING_BUFFER_HPP
@@ -0,0 +1,287 @@
+#ifndef WHEELS_CONTAINERS_MPMC_QUEUE_HPP
+#define WHEELS_CONTAINERS_MPMC_QUEUE_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "optional.hpp"
+#include "queue_storage.hpp"
+#include "span.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace wheels
+{
+
+// Bounded queue for any number of producer and consumer threads, after Dmitry
+// Vyukov's bounded MPMC queue. Doesn't lock, but a thread that is preempted
+// between claiming a slot and publishing it holds up the ones behind it.
+// Each slot has a sequence number that tells which lap of the queue it is
+// ready for. Producers and consumers claim positions with a CAS on their own
+// counter and only touch the sequence of the claimed slot after that, so the
+// two sides don't contend with each other unless the queue is nearly full or
+// empty. The batch versions claim a run of ready slots with a single CAS.
+// The values are stored inline when N is given and allocated from an Allocator
+// when it's 0. The capacity is a power of two.
+
+template <typename T, size_t N = 0> class MpmcQueue
+{
+  public:
+    using value_type = T;
+
+    MpmcQueue() noexcept
+        requires(N > 0);
+    // capacity is rounded up to a power of two
+    MpmcQueue(Allocator &allocator, size_t capacity) noexcept
+        requires(N == 0);
+    // Has to be quiescent when destroyed
+    ~MpmcQueue();
+
+    // Positions are atomics
+    MpmcQueue(MpmcQueue const &other) = delete;
+    MpmcQueue(MpmcQueue &&other) = delete;
+    MpmcQueue &operator=(MpmcQueue const &other) = delete;
+    MpmcQueue &operator=(MpmcQueue &&other) = delete;
+
+    // These are only a snapshot if there are active producers or consumers
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    // Returns false if the queue is full
+    template <typename U>
+    // Let's be pedantic and disallow implicit conversions
+        requires SameAs<U, T>
+    [[nodiscard]] bool try_push(U &&value) noexcept;
+    template <typename... Args>
+    [[nodiscard]] bool try_emplace(Args &&...args) noexcept;
+    // Pushes as many of the values as there are free slots in a row. Returns
+    // the number of pushed values.
+    [[nodiscard]] size_t try_push_batch(Span<T const> values) noexcept;
+
+    // Returns an empty Optional if the queue is empty
+    [[nodiscard]] Optional<T> try_pop() noexcept;
+    // Moves up to dst.size() values into dst, as many as there are ready in a
+    // row. Returns the number of popped values.
+    [[nodiscard]] size_t try_pop_batch(Span<T> dst) noexcept;
+
+  private:
+    // Avoid false sharing between the producers and the consumers
+    static constexpr size_t s_cache_line_size = 64;
+
+    struct Slot
+    {
+        // pos when free for the producer of pos, pos + 1 when the value is
+        // ready for the consumer of pos
+        std::atomic<size_t> sequence{0};
+        alignas(T) uint8_t value[sizeof(T)];
+    };
+
+    [[nodiscard]] Slot &slot(size_t pos) noexcept;
+    // Claims up to max_count positions from pos_counter whose slots have the
+    // sequence pos + sequence_offset. Returns the first claimed position and
+    // the number of claimed positions, 0 if there were none.
+    [[nodiscard]] size_t claim(
+        std::atomic<size_t> &pos_counter, size_t sequence_offset,
+        size_t max_count, size_t &claimed_pos) noexcept;
+
+    QueueStorage<Slot, N> m_slots;
+
+    alignas(s_cache_line_size) std::atomic<size_t> m_enqueue_pos{0};
+    alignas(s_cache_line_size) std::atomic<size_t> m_dequeue_pos{0};
+};
+
+template <typename T, size_t N>
+MpmcQueue<T, N>::MpmcQueue() noexcept
+    requires(N > 0)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        Slot *s = new (m_slots.data() + i) Slot;
+        s->sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T, size_t N>
+MpmcQueue<T, N>::MpmcQueue(Allocator &allocator, size_t capacity) noexcept
+    requires(N == 0)
+: m_slots{allocator, capacity}
+{
+    for (size_t i = 0; i < m_slots.capacity(); ++i)
+    {
+        Slot *s = new (m_slots.data() + i) Slot;
+        s->sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T, size_t N> MpmcQueue<T, N>::~MpmcQueue()
+{
+    size_t const enqueue_pos = m_enqueue_pos.load(std::memory_order_acquire);
+    for (size_t pos = m_dequeue_pos.load(std::memory_order_acquire);
+         pos < enqueue_pos; ++pos)
+    {
+        Slot &s = slot(pos);
+        WHEELS_ASSERT(
+            s.sequence.load(std::memory_order_acquire) == pos + 1 &&
+            "Queue destroyed while a push was in flight");
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            ((T *)s.value)->~T();
+    }
+
+    static_assert(std::is_trivially_destructible_v<Slot>);
+}
+
+template <typename T, size_t N> bool MpmcQueue<T, N>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <typename T, size_t N> size_t MpmcQueue<T, N>::size() const noexcept
+{
+    // Claimed pushes count as values and claimed pops don't. Pops can be
+    // claimed in between the loads so clamp instead of wrapping around.
+    size_t const dequeue_pos = m_dequeue_pos.load(std::memory_order_acquire);
+    size_t const enqueue_pos = m_enqueue_pos.load(std::memory_order_acquire);
+    return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+template <typename T, size_t N>
+size_t MpmcQueue<T, N>::capacity() const noexcept
+{
+    return m_slots.capacity();
+}
+
+template <typename T, size_t N>
+template <typename U>
+    requires SameAs<U, T>
+bool MpmcQueue<T, N>::try_push(U &&value) noexcept
+{
+    return try_emplace(WHEELS_FWD(value));
+}
+
+template <typename T, size_t N>
+template <typename... Args>
+bool MpmcQueue<T, N>::try_emplace(Args &&...args) noexcept
+{
+    size_t pos = 0;
+    if (claim(m_enqueue_pos, 0, 1, pos) == 0)
+        return false;
+
+    Slot &s = slot(pos);
+    new (s.value) T{WHEELS_FWD(args)...};
+    s.sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <typename T, size_t N>
+size_t MpmcQueue<T, N>::try_push_batch(Span<T const> values) noexcept
+{
+    size_t pos = 0;
+    size_t const count = claim(m_enqueue_pos, 0, values.size(), pos);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Slot &s = slot(pos + i);
+        new (s.value) T{values[i]};
+        s.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+
+    return count;
+}
+
+template <typename T, size_t N> Optional<T> MpmcQueue<T, N>::try_pop() noexcept
+{
+    size_t pos = 0;
+    if (claim(m_dequeue_pos, 1, 1, pos) == 0)
+        return Optional<T>{};
+
+    Slot &s = slot(pos);
+    T *value = (T *)s.value;
+    Optional<T> ret{WHEELS_MOV(*value)};
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        // Moved from value might still require dtor
+        value->~T();
+    // Free for the producer of the same slot on the next lap
+    s.sequence.store(pos + capacity(), std::memory_order_release);
+
+    return ret;
+}
+
+template <typename T, size_t N>
+size_t MpmcQueue<T, N>::try_pop_batch(Span<T> dst) noexcept
+{
+    size_t pos = 0;
+    size_t const count = claim(m_dequeue_pos, 1, dst.size(), pos);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Slot &s = slot(pos + i);
+        T *value = (T *)s.value;
+        dst[i] = WHEELS_MOV(*value);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            // Moved from value might still require dtor
+            value->~T();
+        s.sequence.store(pos + i + capacity(), std::memory_order_release);
+    }
+
+    return count;
+}
+
+template <typename T, size_t N>
+typename MpmcQueue<T, N>::Slot &MpmcQueue<T, N>::slot(size_t pos) noexcept
+{
+    return m_slots.data()[pos & (capacity() - 1)];
+}
+
+template <typename T, size_t N>
+size_t MpmcQueue<T, N>::claim(
+    std::atomic<size_t> &pos_counter, size_t sequence_offset, size_t max_count,
+    size_t &claimed_pos) noexcept
+{
+    if (max_count == 0)
+        return 0;
+    // Positions past a full lap would map to the same slots
+    if (max_count > capacity())
+        max_count = capacity();
+
+    size_t pos = pos_counter.load(std::memory_order_relaxed);
+    while (true)
+    {
+        size_t const sequence =
+            slot(pos).sequence.load(std::memory_order_acquire);
+        intptr_t const diff =
+            (intptr_t)sequence - (intptr_t)(pos + sequence_offset);
+        if (diff < 0)
+            // The slot is still a lap behind: full for producers, empty for
+            // consumers
+            return 0;
+        if (diff > 0)
+        {
+            // Another thread claimed pos
+            pos = pos_counter.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        // The slots after pos can only be claimed through pos_counter so
+        // they stay ready until the CAS either wins or fails
+        size_t count = 1;
+        while (count < max_count &&
+               slot(pos + count).sequence.load(std::memory_order_acquire) ==
+                   pos + count + sequence_offset)
+            count++;
+
+        if (pos_counter.compare_exchange_weak(
+                pos, pos + count, std::memory_order_relaxed))
+        {
+            claimed_pos = pos;
+            return count;
+        }
+    }
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_MPMC_QUEUE_HPP
@@ -0,0 +1,889 @@
+#ifndef WHEELS_CONTAINERS_NODE_HASH_MAP_HPP
+#define WHEELS_CONTAINERS_NODE_HASH_MAP_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "hash.hpp"
+#include "pair.hpp"
+#include "utils.hpp"
+
+#include <cstring>
+
+namespace wheels
+{
+
+// Uninitialized storage for objects of a single type, carved from slabs that
+// double in size up to s_max_slab_count objects. Freed storage goes to a free
+// list that is threaded through the storage itself so objects at least the
+// size of a pointer have no per-object overhead. Slabs are only returned to
+// the allocator by release() or the dtor.
+template <typename T> class NodePool
+{
+  public:
+    NodePool(Allocator &allocator) noexcept;
+    ~NodePool();
+
+    NodePool(NodePool const &other) = delete;
+    NodePool(NodePool &&other) noexcept;
+    NodePool &operator=(NodePool const &other) = delete;
+    NodePool &operator=(NodePool &&other) noexcept;
+
+    // Returns storage for one T. The caller has to construct the object.
+    [[nodiscard]] T *allocate() noexcept;
+    // Takes back storage returned by allocate(). The caller has to have
+    // destroyed the object.
+    void deallocate(T *ptr) noexcept;
+    // Makes sure the next count allocate() calls don't allocate
+    void reserve(size_t count) noexcept;
+    // Frees the slabs. The caller has to have destroyed the live objects.
+    void release() noexcept;
+
+  private:
+    union Node
+    {
+        Node *next;
+        alignas(T) uint8_t storage[sizeof(T)];
+    };
+
+    struct Slab
+    {
+        Slab *next{nullptr};
+    };
+
+    static constexpr size_t s_min_slab_count = 16;
+    static constexpr size_t s_max_slab_count = 4096;
+    // Nodes follow the header in the same allocation
+    static constexpr size_t s_slab_header_size =
+        (sizeof(Slab) + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+
+    void allocate_slab(size_t count) noexcept;
+
+    Allocator &m_allocator;
+    Slab *m_slabs{nullptr};
+    Node *m_free{nullptr};
+    size_t m_free_count{0};
+    // Untouched tail of the newest slab
+    Node *m_bump{nullptr};
+    Node *m_bump_end{nullptr};
+    size_t m_next_slab_count{s_min_slab_count};
+};
+
+// SwissMap style probe table of pointers to pool allocated key-value nodes.
+// Nodes don't move when the table grows so pointers to keys and values stay
+// valid until the item is removed. Lookups chase the node pointer on a
+// control byte match, so hits touch one more cache line than in HashMap and
+// iterating is slower.
+
+template <
+    typename Key, typename Value, class Hasher = Hash<Key>,
+    class Policy = DefaultHashPolicy>
+class NodeHashMap
+{
+    static_assert(
+        InvocableHash<Hasher, Key>, "Hasher has to be invocable with Key");
+    static_assert(
+        CorrectHashRetVal<Hasher, Key>,
+        "Hasher return type has to match Hash<T>");
+    static_assert(
+        Policy::s_clear == HashClear::Full,
+        "Clearing has to visit each node to free it so only HashClear::Full "
+        "is supported");
+
+  public:
+    using key_type = Key;
+    // Wording clashes with the STL counterpats, but is consistent with the
+    // template interface
+    using value_type = Value;
+
+    struct Iterator
+    {
+        Iterator operator++() noexcept;
+        Iterator operator++(int) noexcept;
+        // Only value is mutable because changing the key could require
+        // rehashing
+        [[nodiscard]] Pair<Key const *, Value *> operator*() noexcept;
+        [[nodiscard]] Pair<Key const *, Value const *> operator*()
+            const noexcept;
+        [[nodiscard]] bool operator!=(Iterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(Iterator const &other) const noexcept;
+
+        NodeHashMap const &map;
+        size_t pos{0};
+    };
+
+    struct ConstIterator
+    {
+        ConstIterator operator++() noexcept;
+        ConstIterator operator++(int) noexcept;
+        [[nodiscard]] Pair<Key const *, Value const *> operator*()
+            const noexcept;
+        [[nodiscard]] bool operator!=(
+            ConstIterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(
+            ConstIterator const &other) const noexcept;
+
+        NodeHashMap const &map;
+        size_t pos{0};
+    };
+
+    friend struct Iterator;
+    friend struct ConstIterator;
+
+  public:
+    NodeHashMap(Allocator &allocator, size_t initial_capacity = 0) noexcept;
+    ~NodeHashMap();
+
+    NodeHashMap(NodeHashMap const &other) = delete;
+    NodeHashMap(NodeHashMap &&other) noexcept;
+    NodeHashMap &operator=(NodeHashMap const &other) = delete;
+    NodeHashMap &operator=(NodeHashMap &&other) noexcept;
+
+    [[nodiscard]] Iterator begin() noexcept;
+    [[nodiscard]] ConstIterator begin() const noexcept;
+    [[nodiscard]] Iterator end() noexcept;
+    [[nodiscard]] ConstIterator end() const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    // Grows the table and the node pool so that they fit at least size items
+    // without allocating again
+    void reserve(size_t size) noexcept;
+
+    [[nodiscard]] bool contains(Key const &key) const noexcept;
+    [[nodiscard]] Value const *find(Key const &key) const noexcept;
+    [[nodiscard]] Value *find(Key const &key) noexcept;
+
+    // Keeps the node slabs around for reuse
+    void clear() noexcept;
+
+    // The returned pointer stays valid until the key is removed or the map is
+    // cleared
+    template <typename K, typename V>
+    // Let's be pedantic and disallow implicit conversions
+        requires(SameAs<K, Key> && SameAs<V, Value>)
+    Value *insert_or_assign(K &&key, V &&value) noexcept;
+
+    void remove(Key const &key) noexcept;
+
+    // Calls f(Key const &, Value &) for each pair. f can't modify the map.
+    template <typename F> void for_each(F &&f) noexcept;
+    // Calls f(Key const &, Value const &) for each pair. f can't modify the
+    // map.
+    template <typename F> void for_each(F &&f) const noexcept;
+
+  private:
+    using Node = Pair<Key, Value>;
+
+    [[nodiscard]] bool is_over_max_load() const noexcept;
+
+    // Returns m_capacity if the key isn't in the map
+    [[nodiscard]] size_t find_pos(
+        uint64_t hash, Key const &key) const noexcept;
+    // Claims the first free slot for a key that isn't in the map yet. The
+    // caller has to set the node and update the size.
+    [[nodiscard]] size_t insert_unique_slot(uint64_t hash) noexcept;
+    // Moves the node pointers into a new table of at least the given
+    // capacity, also dropping the Deleted slots
+    void reallocate(size_t capacity) noexcept;
+    void destroy() noexcept;
+
+    enum class Ctrl : uint8_t
+    {
+        Empty = 0b10000000,
+        Deleted = 0b11111111,
+        // Full = 0b0XXXXXXX, H2 hash
+    };
+    [[nodiscard]] static constexpr bool s_empty_pos(
+        uint8_t const *metadata, size_t pos) noexcept
+    {
+        return (metadata[pos] & (uint8_t)Ctrl::Empty) == (uint8_t)Ctrl::Empty;
+    }
+
+    [[nodiscard]] static constexpr uint64_t s_h1(uint64_t hash) noexcept
+    {
+        return hash >> 7;
+    }
+
+    [[nodiscard]] static constexpr uint8_t s_h2(uint64_t hash) noexcept
+    {
+        return (uint8_t)(hash & 0x7F);
+    }
+
+    Allocator &m_allocator;
+    NodePool<Node> m_pool;
+    // Points to the start of the table allocation, followed by the metadata
+    Node **m_nodes{nullptr};
+    uint8_t *m_metadata{nullptr};
+    size_t m_size{0};
+    size_t m_capacity{0};
+    Hasher m_hasher{};
+};
+
+template <typename T>
+NodePool<T>::NodePool(Allocator &allocator) noexcept
+: m_allocator{allocator}
+{
+    static_assert(
+        alignof(T) <= alignof(std::max_align_t) &&
+        "Aligned allocations beyond std::max_align_t aren't supported");
+}
+
+template <typename T> NodePool<T>::~NodePool() { release(); }
+
+template <typename T>
+NodePool<T>::NodePool(NodePool &&other) noexcept
+: m_allocator{other.m_allocator}
+, m_slabs{other.m_slabs}
+, m_free{other.m_free}
+, m_free_count{other.m_free_count}
+, m_bump{other.m_bump}
+, m_bump_end{other.m_bump_end}
+, m_next_slab_count{other.m_next_slab_count}
+{
+    other.m_slabs = nullptr;
+    other.m_free = nullptr;
+    other.m_free_count = 0;
+    other.m_bump = nullptr;
+    other.m_bump_end = nullptr;
+    other.m_next_slab_count = s_min_slab_count;
+}
+
+template <typename T>
+NodePool<T> &NodePool<T>::operator=(NodePool &&other) noexcept
+{
+    WHEELS_ASSERT(
+        &m_allocator == &other.m_allocator &&
+        "Move assigning a container with different allocators can lead to "
+        "nasty bugs. Use the same allocator or copy the content instead.");
+
+    if (this != &other)
+    {
+        release();
+
+        m_slabs = other.m_slabs;
+        m_free = other.m_free;
+        m_free_count = other.m_free_count;
+        m_bump = other.m_bump;
+        m_bump_end = other.m_bump_end;
+        m_next_slab_count = other.m_next_slab_count;
+
+        other.m_slabs = nullptr;
+        other.m_free = nullptr;
+        other.m_free_count = 0;
+        other.m_bump = nullptr;
+        other.m_bump_end = nullptr;
+        other.m_next_slab_count = s_min_slab_count;
+    }
+    return *this;
+}
+
+template <typename T> T *NodePool<T>::allocate() noexcept
+{
+    if (m_free != nullptr)
+    {
+        Node *node = m_free;
+        m_free = node->next;
+        m_free_count--;
+        return (T *)node->storage;
+    }
+
+    if (m_bump == m_bump_end)
+        allocate_slab(m_next_slab_count);
+
+    Node *node = m_bump++;
+    return (T *)node->storage;
+}
+
+template <typename T> void NodePool<T>::deallocate(T *ptr) noexcept
+{
+    WHEELS_ASSERT(ptr != nullptr);
+
+    Node *node = (Node *)ptr;
+    node->next = m_free;
+    m_free = node;
+    m_free_count++;
+}
+
+template <typename T> void NodePool<T>::reserve(size_t count) noexcept
+{
+    size_t const available = m_free_count + (size_t)(m_bump_end - m_bump);
+    if (count > available)
+    {
+        size_t const missing = count - available;
+        allocate_slab(
+            missing > m_next_slab_count ? missing : m_next_slab_count);
+    }
+}
+
+template <typename T> void NodePool<T>::release() noexcept
+{
+    while (m_slabs != nullptr)
+    {
+        Slab *next = m_slabs->next;
+        m_allocator.deallocate(m_slabs);
+        m_slabs = next;
+    }
+    m_free = nullptr;
+    m_free_count = 0;
+    m_bump = nullptr;
+    m_bump_end = nullptr;
+    m_next_slab_count = s_min_slab_count;
+}
+
+template <typename T> void NodePool<T>::allocate_slab(size_t count) noexcept
+{
+    // The untouched tail of the previous slab would be lost otherwise
+    while (m_bump != m_bump_end)
+    {
+        Node *node = m_bump++;
+        node->next = m_free;
+        m_free = node;
+        m_free_count++;
+    }
+
+    uint8_t *data = (uint8_t *)m_allocator.allocate(
+        s_slab_header_size + count * sizeof(Node));
+    WHEELS_ASSERT(data != nullptr);
+
+    Slab *slab = new (data) Slab{};
+    slab->next = m_slabs;
+    m_slabs = slab;
+
+    m_bump = (Node *)(data + s_slab_header_size);
+    m_bump_end = m_bump + count;
+
+    if (m_next_slab_count < s_max_slab_count)
+        m_next_slab_count *= 2;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+NodeHashMap<Key, Value, Hasher, Policy>::NodeHashMap(
+    Allocator &allocator, size_t initial_capacity) noexcept
+: m_allocator{allocator}
+, m_pool{allocator}
+{
+    if (initial_capacity > 0)
+        reallocate(initial_capacity);
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+NodeHashMap<Key, Value, Hasher, Policy>::~NodeHashMap()
+{
+    destroy();
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+NodeHashMap<Key, Value, Hasher, Policy>::NodeHashMap(
+    NodeHashMap &&other) noexcept
+: m_allocator{other.m_allocator}
+, m_pool{WHEELS_MOV(other.m_pool)}
+, m_nodes{other.m_nodes}
+, m_metadata{other.m_metadata}
+, m_size{other.m_size}
+, m_capacity{other.m_capacity}
+, m_hasher{WHEELS_MOV(other.m_hasher)}
+{
+    other.m_nodes = nullptr;
+    other.m_metadata = nullptr;
+    other.m_size = 0;
+    other.m_capacity = 0;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+NodeHashMap<Key, Value, Hasher, Policy> &NodeHashMap<
+    Key, Value, Hasher, Policy>::operator=(NodeHashMap &&other) noexcept
+{
+    WHEELS_ASSERT(
+        &m_allocator == &other.m_allocator &&
+        "Move assigning a container with different allocators can lead to "
+        "nasty bugs. Use the same allocator or copy the content instead.");
+
+    if (this != &other)
+    {
+        destroy();
+
+        m_pool = WHEELS_MOV(other.m_pool);
+        m_nodes = other.m_nodes;
+        m_metadata = other.m_metadata;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        m_hasher = WHEELS_MOV(other.m_hasher);
+
+        other.m_nodes = nullptr;
+        other.m_metadata = nullptr;
+        other.m_size = 0;
+        other.m_capacity = 0;
+    }
+    return *this;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+typename NodeHashMap<Key, Value, Hasher, Policy>::Iterator NodeHashMap<
+    Key, Value, Hasher, Policy>::begin() noexcept
+{
+    return Iterator{
+        .map = *this,
+        .pos = next_full_ctrl(m_metadata, 0, m_capacity),
+    };
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+typename NodeHashMap<Key, Value, Hasher, Policy>::ConstIterator NodeHashMap<
+    Key, Value, Hasher, Policy>::begin() const noexcept
+{
+    return ConstIterator{
+        .map = *this,
+        .pos = next_full_ctrl(m_metadata, 0, m_capacity),
+    };
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+typename NodeHashMap<Key, Value, Hasher, Policy>::Iterator NodeHashMap<
+    Key, Value, Hasher, Policy>::end() noexcept
+{
+    return Iterator{
+        .map = *this,
+        .pos = m_capacity,
+    };
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+typename NodeHashMap<Key, Value, Hasher, Policy>::ConstIterator NodeHashMap<
+    Key, Value, Hasher, Policy>::end() const noexcept
+{
+    return ConstIterator{
+        .map = *this,
+        .pos = m_capacity,
+    };
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+bool NodeHashMap<Key, Value, Hasher, Policy>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+size_t NodeHashMap<Key, Value, Hasher, Policy>::size() const noexcept
+{
+    return m_size;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+size_t NodeHashMap<Key, Value, Hasher, Policy>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+void NodeHashMap<Key, Value, Hasher, Policy>::reserve(size_t size) noexcept
+{
+    size_t const capacity = Policy::s_capacity_for(size);
+    if (capacity > m_capacity)
+        reallocate(capacity);
+    if (size > m_size)
+        m_pool.reserve(size - m_size);
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+bool NodeHashMap<Key, Value, Hasher, Policy>::contains(
+    Key const &key) const noexcept
+{
+    return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+Value const *NodeHashMap<Key, Value, Hasher, Policy>::find(
+    Key const &key) const noexcept
+{
+    if (m_size == 0)
+        return nullptr;
+
+    size_t const pos = find_pos(m_hasher(key), key);
+    if (pos == m_capacity)
+        return nullptr;
+
+    return &m_nodes[pos]->second;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+Value *NodeHashMap<Key, Value, Hasher, Policy>::find(Key const &key) noexcept
+{
+    if (m_size == 0)
+        return nullptr;
+
+    size_t const pos = find_pos(m_hasher(key), key);
+    if (pos == m_capacity)
+        return nullptr;
+
+    return &m_nodes[pos]->second;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+void NodeHashMap<Key, Value, Hasher, Policy>::clear() noexcept
+{
+    // There's no table before the first insert
+    if (m_metadata == nullptr)
+        return;
+
+    if (m_size > 0)
+    {
+        for (size_t group_pos = 0; group_pos < m_capacity;
+             group_pos += s_ctrl_group_width)
+        {
+            uint64_t full_mask = full_ctrl_mask(m_metadata + group_pos);
+            while (full_mask != 0)
+            {
+                size_t const pos =
+                    group_pos + (size_t)std::countr_zero(full_mask) / 8;
+                full_mask &= full_mask - 1;
+
+                Node *node = m_nodes[pos];
+                if constexpr (!std::is_trivially_destructible_v<Node>)
+                    node->~Node();
+                m_pool.deallocate(node);
+            }
+        }
+        m_size = 0;
+    }
+    memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+template <typename K, typename V>
+    requires(SameAs<K, Key> && SameAs<V, Value>)
+Value *NodeHashMap<Key, Value, Hasher, Policy>::insert_or_assign(
+    K &&key, V &&value) noexcept
+{
+    if (is_over_max_load())
+        reallocate(m_capacity * 2);
+
+    uint64_t const hash = m_hasher(key);
+    uint8_t const h2 = s_h2(hash);
+    // The whole probe sequence has to be checked for the key before a Deleted
+    // slot can be reused
+    // Capacity is a power of 2 so this mask just works
+    size_t const start_pos = s_h1(hash) & (m_capacity - 1);
+    size_t pos = start_pos;
+    size_t free_pos = m_capacity;
+    while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
+    {
+        uint8_t const meta = m_metadata[pos];
+        if (h2 == meta && m_nodes[pos]->first == key)
+        {
+            Value *node_value = &m_nodes[pos]->second;
+            node_value->~Value();
+            new (node_value) Value{WHEELS_FWD(value)};
+            return node_value;
+        }
+        if (meta == (uint8_t)Ctrl::Deleted && free_pos == m_capacity)
+            free_pos = pos;
+
+        // Capacity is a power of 2 so this mask just works
+        pos = (pos + 1) & (m_capacity - 1);
+        if (pos == start_pos) [[unlikely]]
+            break;
+    }
+    if (free_pos == m_capacity)
+        free_pos = pos;
+    WHEELS_ASSERT(s_empty_pos(m_metadata, free_pos));
+
+    Node *node = m_pool.allocate();
+    new (node) Node{WHEELS_FWD(key), WHEELS_FWD(value)};
+    m_nodes[free_pos] = node;
+    m_metadata[free_pos] = h2;
+    m_size++;
+
+    return &node->second;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+void NodeHashMap<Key, Value, Hasher, Policy>::remove(Key const &key) noexcept
+{
+    if (m_size == 0)
+        return;
+
+    size_t const pos = find_pos(m_hasher(key), key);
+    if (pos == m_capacity)
+        return;
+
+    Node *node = m_nodes[pos];
+    if constexpr (!std::is_trivially_destructible_v<Node>)
+        node->~Node();
+    m_pool.deallocate(node);
+    m_metadata[pos] = (uint8_t)Ctrl::Deleted;
+    m_size--;
+
+    // Find for missing value gets really bad if all slots are Deleted so let's
+    // clean up to be safe
+    if (m_size == 0) [[unlikely]]
+        clear();
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+template <typename F>
+void NodeHashMap<Key, Value, Hasher, Policy>::for_each(F &&f) noexcept
+{
+    // Full slots are found a group of control bytes at a time so sparse tables
+    // are cheap to scan
+    for (size_t group_pos = 0; group_pos < m_capacity;
+         group_pos += s_ctrl_group_width)
+    {
+        uint64_t full_mask = full_ctrl_mask(m_metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            Node *node = m_nodes[pos];
+            Key const &key = node->first;
+            f(key, node->second);
+        }
+    }
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+template <typename F>
+void NodeHashMap<Key, Value, Hasher, Policy>::for_each(F &&f) const noexcept
+{
+    // Full slots are found a group of control bytes at a time so sparse tables
+    // are cheap to scan
+    for (size_t group_pos = 0; group_pos < m_capacity;
+         group_pos += s_ctrl_group_width)
+    {
+        uint64_t full_mask = full_ctrl_mask(m_metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            Node const *node = m_nodes[pos];
+            Key const &key = node->first;
+            Value const &value = node->second;
+            f(key, value);
+        }
+    }
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+bool NodeHashMap<Key, Value, Hasher, Policy>::is_over_max_load() const noexcept
+{
+    return m_capacity == 0 || Policy::s_over_max_load(m_size, m_capacity);
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+size_t NodeHashMap<Key, Value, Hasher, Policy>::find_pos(
+    uint64_t hash, Key const &key) const noexcept
+{
+    uint8_t const h2 = s_h2(hash);
+    // Keep track of start pos so we can break out before looping again if all
+    // slots are full or deleted.
+    // Capacity is a power of 2 so this mask just works
+    size_t const start_pos = s_h1(hash) & (m_capacity - 1);
+    size_t pos = start_pos;
+    while (m_metadata[pos] != (uint8_t)Ctrl::Empty)
+    {
+        uint8_t const meta = m_metadata[pos];
+        if (h2 == meta && m_nodes[pos]->first == key)
+            return pos;
+
+        // Capacity is a power of 2 so this mask just works
+        pos = (pos + 1) & (m_capacity - 1);
+        if (pos == start_pos) [[unlikely]]
+            break;
+    }
+
+    return m_capacity;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+size_t NodeHashMap<Key, Value, Hasher, Policy>::insert_unique_slot(
+    uint64_t hash) noexcept
+{
+    // Capacity is a power of 2 so this mask just works
+    size_t pos = s_h1(hash) & (m_capacity - 1);
+    while (!s_empty_pos(m_metadata, pos))
+        pos = (pos + 1) & (m_capacity - 1);
+
+    m_metadata[pos] = s_h2(hash);
+    return pos;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+void NodeHashMap<Key, Value, Hasher, Policy>::reallocate(
+    size_t capacity) noexcept
+{
+    // The policy's min capacity ensures we always grow in time so that there
+    // always is at least 1 Empty slot to end find iteration
+    if (capacity < Policy::s_min_capacity)
+        capacity = Policy::s_min_capacity;
+    // Have capacity be a power of two so we can avoid modulus operations on
+    // the hash
+    capacity = round_up_power_of_two(capacity);
+
+    WHEELS_ASSERT(!Policy::s_over_max_load(m_size, capacity));
+
+    Node **old_nodes = m_nodes;
+    uint8_t *old_metadata = m_metadata;
+    size_t const old_capacity = m_capacity;
+
+    // Node pointers and metadata share the allocation
+    uint8_t *data = (uint8_t *)m_allocator.allocate(
+        capacity * (sizeof(Node *) + sizeof(uint8_t)));
+    WHEELS_ASSERT(data != nullptr);
+    m_nodes = (Node **)data;
+    m_metadata = data + capacity * sizeof(Node *);
+    m_capacity = capacity;
+
+    memset(m_metadata, (uint8_t)Ctrl::Empty, m_capacity * sizeof(uint8_t));
+
+    // Only the node pointers move, the nodes themselves stay put. Deleted
+    // slots are dropped.
+    for (size_t group_pos = 0; group_pos < old_capacity;
+         group_pos += s_ctrl_group_width)
+    {
+        uint64_t full_mask = full_ctrl_mask(old_metadata + group_pos);
+        while (full_mask != 0)
+        {
+            size_t const old_pos =
+                group_pos + (size_t)std::countr_zero(full_mask) / 8;
+            full_mask &= full_mask - 1;
+
+            Node *node = old_nodes[old_pos];
+            size_t const pos = insert_unique_slot(m_hasher(node->first));
+            m_nodes[pos] = node;
+        }
+    }
+
+    if (old_nodes != nullptr)
+        m_allocator.deallocate(old_nodes);
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+void NodeHashMap<Key, Value, Hasher, Policy>::destroy() noexcept
+{
+    if (m_nodes != nullptr)
+    {
+        clear();
+        m_allocator.deallocate(m_nodes);
+        m_nodes = nullptr;
+        m_metadata = nullptr;
+        m_capacity = 0;
+    }
+    m_pool.release();
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+typename NodeHashMap<Key, Value, Hasher, Policy>::Iterator NodeHashMap<
+    Key, Value, Hasher, Policy>::Iterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < map.capacity());
+    pos = next_full_ctrl(map.m_metadata, pos + 1, map.capacity());
+    return *this;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+typename NodeHashMap<Key, Value, Hasher, Policy>::Iterator NodeHashMap<
+    Key, Value, Hasher, Policy>::Iterator::operator++(int) noexcept
+{
+    Iterator const ret = *this;
+    WHEELS_ASSERT(pos < map.capacity());
+    pos = next_full_ctrl(map.m_metadata, pos + 1, map.capacity());
+    return ret;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+Pair<Key const *, Value *> NodeHashMap<
+    Key, Value, Hasher, Policy>::Iterator::operator*() noexcept
+{
+    WHEELS_ASSERT(pos < map.capacity());
+    WHEELS_ASSERT(!map.s_empty_pos(map.m_metadata, pos));
+
+    Node *node = map.m_nodes[pos];
+    Key const *key = &node->first;
+    Value *value = &node->second;
+    return make_pair(key, value);
+};
+
+template <typename Key, typename Value, class Hasher, class Policy>
+Pair<Key const *, Value const *> NodeHashMap<
+    Key, Value, Hasher, Policy>::Iterator::operator*() const noexcept
+{
+    WHEELS_ASSERT(pos < map.capacity());
+    WHEELS_ASSERT(!map.s_empty_pos(map.m_metadata, pos));
+
+    Node const *node = map.m_nodes[pos];
+    Key const *key = &node->first;
+    Value const *value = &node->second;
+    return make_pair(key, value);
+};
+
+template <typename Key, typename Value, class Hasher, class Policy>
+bool NodeHashMap<Key, Value, Hasher, Policy>::Iterator::operator!=(
+    Iterator const &other) const noexcept
+{
+    return pos != other.pos;
+};
+
+template <typename Key, typename Value, class Hasher, class Policy>
+bool NodeHashMap<Key, Value, Hasher, Policy>::Iterator::operator==(
+    Iterator const &other) const noexcept
+{
+    return pos == other.pos;
+};
+
+template <typename Key, typename Value, class Hasher, class Policy>
+typename NodeHashMap<Key, Value, Hasher, Policy>::ConstIterator NodeHashMap<
+    Key, Value, Hasher, Policy>::ConstIterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < map.capacity());
+    pos = next_full_ctrl(map.m_metadata, pos + 1, map.capacity());
+    return *this;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+typename NodeHashMap<Key, Value, Hasher, Policy>::ConstIterator NodeHashMap<
+    Key, Value, Hasher, Policy>::ConstIterator::operator++(int) noexcept
+{
+    ConstIterator const ret = *this;
+    WHEELS_ASSERT(pos < map.capacity());
+    pos = next_full_ctrl(map.m_metadata, pos + 1, map.capacity());
+    return ret;
+}
+
+template <typename Key, typename Value, class Hasher, class Policy>
+Pair<Key const *, Value const *> NodeHashMap<
+    Key, Value, Hasher, Policy>::ConstIterator::operator*() const noexcept
+{
+    WHEELS_ASSERT(pos < map.capacity());
+    WHEELS_ASSERT(!map.s_empty_pos(map.m_metadata, pos));
+
+    Node const *node = map.m_nodes[pos];
+    Key const *key = &node->first;
+    Value const *value = &node->second;
+    return make_pair(key, value);
+};
+
+template <typename Key, typename Value, class Hasher, class Policy>
+bool NodeHashMap<Key, Value, Hasher, Policy>::ConstIterator::operator!=(
+    ConstIterator const &other) const noexcept
+{
+    return pos != other.pos;
+};
+
+template <typename Key, typename Value, class Hasher, class Policy>
+bool NodeHashMap<Key, Value, Hasher, Policy>::ConstIterator::operator==(
+    ConstIterator const &other) const noexcept
+{
+    return pos == other.pos;
+};
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_NODE_HASH_MAP_HPP
@@ -3,6 +3,7 @@
 
 #include "../assert.hpp"
 #include "../utils.hpp"
+#include "hash.hpp"
 #include <new>
 
 namespace wheels
@@ -237,6 +238,16 @@ bool operator!=(Optional<T> const &lhs, Optional<T> const &rhs) noexcept
     return !(lhs == rhs);
 }
 
+template <typename T> struct Hash<Optional<T>>
+{
+    [[nodiscard]] uint64_t operator()(Optional<T> const &value) const noexcept
+    {
+        if (!value.has_value())
+            return 0;
+        return hash_combine(1, Hash<T>{}(*value));
+    }
+};
+
 } // namespace wheels
 
 #endif // WHEELS_CONTAINERS_OPTIONAL_HPP
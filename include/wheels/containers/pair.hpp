@@ -4,6 +4,8 @@
 #include "../utils.hpp"
 
 #include "concepts.hpp"
+#include "hash.hpp"
+#include "utils.hpp"
 
 namespace wheels
 {
@@ -32,6 +34,13 @@ template <typename T, typename V> struct Pair
     constexpr Pair<T, V> &operator=(Pair<U, W> &&other) noexcept;
 };
 
+template <typename T, typename V>
+struct is_trivially_relocatable<Pair<T, V>>
+: std::bool_constant<
+      is_trivially_relocatable_v<T> && is_trivially_relocatable_v<V>>
+{
+};
+
 template <typename T, typename V>
 [[nodiscard]] constexpr Pair<T, V> make_pair(T &&first, V &&second)
 {
@@ -81,6 +90,23 @@ template <typename T, typename V>
     return lhs.first != rhs.first || lhs.second != rhs.second;
 }
 
+template <typename T, typename V>
+inline constexpr bool byte_hashable<Pair<T, V>> =
+    byte_hashable<T> && byte_hashable<V> &&
+    std::has_unique_object_representations_v<Pair<T, V>>;
+
+template <typename T, typename V> struct Hash<Pair<T, V>>
+{
+    [[nodiscard]] uint64_t operator()(Pair<T, V> const &value) const noexcept
+    {
+        if constexpr (byte_hashable<Pair<T, V>>)
+            return wyhash(&value, sizeof(value), 0, _wyp);
+        else
+            return hash_combine(
+                Hash<T>{}(value.first), Hash<V>{}(value.second));
+    }
+};
+
 } // namespace wheels
 
 #endif // WHEELS_CONTAINERS_PAIR_HPP
@@ -0,0 +1,88 @@
+#ifndef WHEELS_CONTAINERS_QUEUE_STORAGE_HPP
+#define WHEELS_CONTAINERS_QUEUE_STORAGE_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+
+#include <bit>
+#include <cstdint>
+
+namespace wheels
+{
+
+// Uninitialized slots for the concurrent queues, which construct and destroy
+// the values in them. Stored inline when N is given and allocated from an
+// Allocator when N is 0. The capacity is a power of two in both cases so that
+// queue positions map to slots with a mask.
+template <typename Slot, size_t N> class QueueStorage
+{
+    static_assert(
+        std::has_single_bit(N), "Queue capacity has to be a power of two");
+
+  public:
+    QueueStorage() noexcept = default;
+    ~QueueStorage() = default;
+
+    // The queues hand out no pointers to the slots but they hold atomics
+    QueueStorage(QueueStorage const &other) = delete;
+    QueueStorage(QueueStorage &&other) = delete;
+    QueueStorage &operator=(QueueStorage const &other) = delete;
+    QueueStorage &operator=(QueueStorage &&other) = delete;
+
+    [[nodiscard]] Slot *data() noexcept { return (Slot *)m_data; }
+    [[nodiscard]] Slot const *data() const noexcept
+    {
+        return (Slot const *)m_data;
+    }
+    [[nodiscard]] static constexpr size_t capacity() noexcept { return N; }
+
+  private:
+    alignas(Slot) uint8_t m_data[N * sizeof(Slot)];
+};
+
+template <typename Slot> class QueueStorage<Slot, 0>
+{
+  public:
+    // capacity is rounded up to a power of two
+    QueueStorage(Allocator &allocator, size_t capacity) noexcept;
+    ~QueueStorage();
+
+    QueueStorage(QueueStorage const &other) = delete;
+    QueueStorage(QueueStorage &&other) = delete;
+    QueueStorage &operator=(QueueStorage const &other) = delete;
+    QueueStorage &operator=(QueueStorage &&other) = delete;
+
+    [[nodiscard]] Slot *data() noexcept { return m_data; }
+    [[nodiscard]] Slot const *data() const noexcept { return m_data; }
+    [[nodiscard]] size_t capacity() const noexcept { return m_capacity; }
+
+  private:
+    Allocator &m_allocator;
+    Slot *m_data{nullptr};
+    size_t m_capacity{0};
+};
+
+template <typename Slot>
+QueueStorage<Slot, 0>::QueueStorage(
+    Allocator &allocator, size_t capacity) noexcept
+: m_allocator{allocator}
+, m_capacity{std::bit_ceil(capacity)}
+{
+    static_assert(
+        alignof(Slot) <= alignof(std::max_align_t) &&
+        "Aligned allocations beyond std::max_align_t aren't supported");
+    WHEELS_ASSERT(capacity > 0);
+
+    m_data = (Slot *)m_allocator.allocate(m_capacity * sizeof(Slot));
+    WHEELS_ASSERT(m_data != nullptr);
+}
+
+template <typename Slot> QueueStorage<Slot, 0>::~QueueStorage()
+{
+    m_allocator.deallocate(m_data);
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_QUEUE_STORAGE_HPP
@@ -0,0 +1,644 @@
+
+#ifndef WHEELS_CONTAINERS_RING_BUFFER_HPP
+#define WHEELS_CONTAINERS_RING_BUFFER_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "pair.hpp"
+#include "span.hpp"
+#include "utils.hpp"
+
+#include <cstring>
+
+namespace wheels
+{
+
+// Double-ended queue in a single allocation that wraps around at the end.
+// Values are pushed and popped at either end in O(1) and the storage grows
+// like Array when it runs out. The values are in at most two contiguous
+// segments, exposed by spans() for copying them out in bulk.
+template <typename T, typename Growth = DefaultArrayGrowth> class RingBuffer
+{
+    // Use a static assert instead of a concepts constraint as this will produce
+    // a more understandable error message
+    static_assert(
+        (std::is_trivially_copyable_v<T> || std::move_constructible<T>),
+        "Reallocation requires T to be either trivially copyable or move "
+        "constructible");
+
+  public:
+    using value_type = T;
+
+    struct Iterator
+    {
+        Iterator operator++() noexcept;
+        Iterator operator++(int) noexcept;
+        [[nodiscard]] T &operator*() const noexcept;
+        [[nodiscard]] T *operator->() const noexcept;
+        [[nodiscard]] bool operator!=(Iterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(Iterator const &other) const noexcept;
+
+        RingBuffer &buffer;
+        // Index from the front of the buffer
+        size_t pos{0};
+    };
+
+    struct ConstIterator
+    {
+        ConstIterator operator++() noexcept;
+        ConstIterator operator++(int) noexcept;
+        [[nodiscard]] T const &operator*() const noexcept;
+        [[nodiscard]] T const *operator->() const noexcept;
+        [[nodiscard]] bool operator!=(
+            ConstIterator const &other) const noexcept;
+        [[nodiscard]] bool operator==(
+            ConstIterator const &other) const noexcept;
+
+        RingBuffer const &buffer;
+        // Index from the front of the buffer
+        size_t pos{0};
+    };
+
+    RingBuffer(Allocator &allocator, size_t initial_capacity = 0) noexcept;
+    ~RingBuffer();
+
+    RingBuffer(RingBuffer<T, Growth> const &) = delete;
+    RingBuffer(RingBuffer<T, Growth> &&other) noexcept;
+    RingBuffer<T, Growth> &operator=(RingBuffer<T, Growth> const &) = delete;
+    RingBuffer<T, Growth> &operator=(RingBuffer<T, Growth> &&other) noexcept;
+
+    // Indexed from the front
+    [[nodiscard]] T &operator[](size_t i) noexcept;
+    [[nodiscard]] T const &operator[](size_t i) const noexcept;
+    [[nodiscard]] T &front() noexcept;
+    [[nodiscard]] T const &front() const noexcept;
+    [[nodiscard]] T &back() noexcept;
+    [[nodiscard]] T const &back() const noexcept;
+
+    [[nodiscard]] Iterator begin() noexcept;
+    [[nodiscard]] ConstIterator begin() const noexcept;
+    [[nodiscard]] Iterator end() noexcept;
+    [[nodiscard]] ConstIterator end() const noexcept;
+
+    // Returns the values from front to back as two contiguous segments. The
+    // second one is empty unless the values wrap around the end of the
+    // storage.
+    [[nodiscard]] Pair<Span<T>, Span<T>> mut_spans() noexcept;
+    [[nodiscard]] Pair<Span<T const>, Span<T const>> spans() const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    void reserve(size_t capacity) noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    void clear() noexcept;
+
+    template <typename U>
+    // Let's be pedantic and disallow implicit conversions
+        requires SameAs<U, T>
+    void push_back(U &&value) noexcept;
+    template <typename U>
+    // Let's be pedantic and disallow implicit conversions
+        requires SameAs<U, T>
+    void push_front(U &&value) noexcept;
+
+    template <typename... Args> void emplace_back(Args &&...args) noexcept;
+    template <typename... Args> void emplace_front(Args &&...args) noexcept;
+
+    // Copies the values to the back, with at most two memcpys if T is
+    // trivially copyable. values can't point into this buffer.
+    void extend(Span<T const> values) noexcept;
+
+    T pop_back() noexcept;
+    T pop_front() noexcept;
+    // Moves dst.size() values from the front into dst, with at most two
+    // memcpys if T is trivially copyable
+    void pop_front_into(Span<T> dst) noexcept;
+    // Destroys count values from the front, e.g. after reading them through
+    // spans()
+    void drop_front(size_t count) noexcept;
+
+  private:
+    // Maps an index from the front into the storage
+    [[nodiscard]] size_t wrap(size_t i) const noexcept;
+    void grow(size_t required_capacity) noexcept;
+    void reallocate(size_t capacity) noexcept;
+    void destroy() noexcept;
+
+    Allocator &m_allocator;
+    T *m_data{nullptr};
+    size_t m_capacity{0};
+    size_t m_head{0};
+    size_t m_size{0};
+};
+
+// Only points to its heap allocation and the allocator, neither of which move
+// with the buffer
+template <typename T, typename Growth>
+struct is_trivially_relocatable<RingBuffer<T, Growth>> : std::true_type
+{
+};
+
+template <typename T, typename Growth>
+RingBuffer<T, Growth>::RingBuffer(
+    Allocator &allocator, size_t initial_capacity) noexcept
+: m_allocator{allocator}
+{
+    static_assert(
+        alignof(T) <= alignof(std::max_align_t) &&
+        "Aligned allocations beyond std::max_align_t aren't supported");
+
+    if (initial_capacity > 0)
+        reallocate(initial_capacity);
+}
+
+template <typename T, typename Growth> RingBuffer<T, Growth>::~RingBuffer()
+{
+    destroy();
+}
+
+template <typename T, typename Growth>
+RingBuffer<T, Growth>::RingBuffer(RingBuffer<T, Growth> &&other) noexcept
+: m_allocator{other.m_allocator}
+, m_data{other.m_data}
+, m_capacity{other.m_capacity}
+, m_head{other.m_head}
+, m_size{other.m_size}
+{
+    other.m_data = nullptr;
+    other.m_capacity = 0;
+    other.m_head = 0;
+    other.m_size = 0;
+}
+
+template <typename T, typename Growth>
+RingBuffer<T, Growth> &RingBuffer<T, Growth>::operator=(
+    RingBuffer<T, Growth> &&other) noexcept
+{
+    WHEELS_ASSERT(
+        &m_allocator == &other.m_allocator &&
+        "Move assigning a container with different allocators can lead to "
+        "nasty bugs. Use the same allocator or copy the content instead.");
+
+    if (this != &other)
+    {
+        destroy();
+
+        m_data = other.m_data;
+        m_capacity = other.m_capacity;
+        m_head = other.m_head;
+        m_size = other.m_size;
+
+        other.m_data = nullptr;
+        other.m_capacity = 0;
+        other.m_head = 0;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+template <typename T, typename Growth>
+T &RingBuffer<T, Growth>::operator[](size_t i) noexcept
+{
+    WHEELS_ASSERT(i < m_size);
+    return m_data[wrap(i)];
+}
+
+template <typename T, typename Growth>
+T const &RingBuffer<T, Growth>::operator[](size_t i) const noexcept
+{
+    WHEELS_ASSERT(i < m_size);
+    return m_data[wrap(i)];
+}
+
+template <typename T, typename Growth>
+T &RingBuffer<T, Growth>::front() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return m_data[m_head];
+}
+
+template <typename T, typename Growth>
+T const &RingBuffer<T, Growth>::front() const noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return m_data[m_head];
+}
+
+template <typename T, typename Growth> T &RingBuffer<T, Growth>::back() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return m_data[wrap(m_size - 1)];
+}
+
+template <typename T, typename Growth>
+T const &RingBuffer<T, Growth>::back() const noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return m_data[wrap(m_size - 1)];
+}
+
+template <typename T, typename Growth>
+typename RingBuffer<T, Growth>::Iterator RingBuffer<T, Growth>::begin() noexcept
+{
+    return Iterator{
+        .buffer = *this,
+        .pos = 0,
+    };
+}
+
+template <typename T, typename Growth>
+typename RingBuffer<T, Growth>::ConstIterator RingBuffer<
+    T, Growth>::begin() const noexcept
+{
+    return ConstIterator{
+        .buffer = *this,
+        .pos = 0,
+    };
+}
+
+template <typename T, typename Growth>
+typename RingBuffer<T, Growth>::Iterator RingBuffer<T, Growth>::end() noexcept
+{
+    return Iterator{
+        .buffer = *this,
+        .pos = m_size,
+    };
+}
+
+template <typename T, typename Growth>
+typename RingBuffer<T, Growth>::ConstIterator RingBuffer<
+    T, Growth>::end() const noexcept
+{
+    return ConstIterator{
+        .buffer = *this,
+        .pos = m_size,
+    };
+}
+
+template <typename T, typename Growth>
+Pair<Span<T>, Span<T>> RingBuffer<T, Growth>::mut_spans() noexcept
+{
+    size_t const first_size =
+        m_size < m_capacity - m_head ? m_size : m_capacity - m_head;
+    return Pair<Span<T>, Span<T>>{
+        Span<T>{m_data + m_head, first_size},
+        Span<T>{m_data, m_size - first_size},
+    };
+}
+
+template <typename T, typename Growth>
+Pair<Span<T const>, Span<T const>> RingBuffer<T, Growth>::spans() const noexcept
+{
+    size_t const first_size =
+        m_size < m_capacity - m_head ? m_size : m_capacity - m_head;
+    return Pair<Span<T const>, Span<T const>>{
+        Span<T const>{m_data + m_head, first_size},
+        Span<T const>{m_data, m_size - first_size},
+    };
+}
+
+template <typename T, typename Growth>
+bool RingBuffer<T, Growth>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <typename T, typename Growth>
+size_t RingBuffer<T, Growth>::size() const noexcept
+{
+    return m_size;
+}
+
+template <typename T, typename Growth>
+void RingBuffer<T, Growth>::reserve(size_t capacity) noexcept
+{
+    if (capacity > m_capacity)
+        reallocate(capacity);
+}
+
+template <typename T, typename Growth>
+size_t RingBuffer<T, Growth>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template <typename T, typename Growth>
+void RingBuffer<T, Growth>::clear() noexcept
+{
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        for (T &v : *this)
+            v.~T();
+    }
+    m_head = 0;
+    m_size = 0;
+}
+
+template <typename T, typename Growth>
+template <typename U>
+    requires SameAs<U, T>
+void RingBuffer<T, Growth>::push_back(U &&value) noexcept
+{
+    if (m_size == m_capacity)
+        grow(m_size + 1);
+
+    new (m_data + wrap(m_size)) T{WHEELS_FWD(value)};
+    m_size++;
+}
+
+template <typename T, typename Growth>
+template <typename U>
+    requires SameAs<U, T>
+void RingBuffer<T, Growth>::push_front(U &&value) noexcept
+{
+    if (m_size == m_capacity)
+        grow(m_size + 1);
+
+    m_head = m_head == 0 ? m_capacity - 1 : m_head - 1;
+    new (m_data + m_head) T{WHEELS_FWD(value)};
+    m_size++;
+}
+
+template <typename T, typename Growth>
+template <typename... Args>
+void RingBuffer<T, Growth>::emplace_back(Args &&...args) noexcept
+{
+    if (m_size == m_capacity)
+        grow(m_size + 1);
+
+    new (m_data + wrap(m_size)) T{WHEELS_FWD(args)...};
+    m_size++;
+}
+
+template <typename T, typename Growth>
+template <typename... Args>
+void RingBuffer<T, Growth>::emplace_front(Args &&...args) noexcept
+{
+    if (m_size == m_capacity)
+        grow(m_size + 1);
+
+    m_head = m_head == 0 ? m_capacity - 1 : m_head - 1;
+    new (m_data + m_head) T{WHEELS_FWD(args)...};
+    m_size++;
+}
+
+template <typename T, typename Growth>
+void RingBuffer<T, Growth>::extend(Span<T const> values) noexcept
+{
+    size_t const count = values.size();
+    if (count == 0)
+        return;
+
+    size_t const required_size = m_size + count;
+    if (required_size > m_capacity)
+        grow(required_size);
+
+    size_t const tail = wrap(m_size);
+    size_t const first_count =
+        count < m_capacity - tail ? count : m_capacity - tail;
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+        memcpy(m_data + tail, values.data(), first_count * sizeof(T));
+        memcpy(
+            m_data, values.data() + first_count,
+            (count - first_count) * sizeof(T));
+    }
+    else
+    {
+        for (size_t i = 0; i < first_count; ++i)
+            new (m_data + tail + i) T{values[i]};
+        for (size_t i = first_count; i < count; ++i)
+            new (m_data + i - first_count) T{values[i]};
+    }
+    m_size += count;
+}
+
+template <typename T, typename Growth>
+T RingBuffer<T, Growth>::pop_back() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    m_size--;
+
+    T *value = m_data + wrap(m_size);
+    T ret = WHEELS_MOV(*value);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        // Moved from value might still require dtor
+        value->~T();
+
+    return ret;
+}
+
+template <typename T, typename Growth>
+T RingBuffer<T, Growth>::pop_front() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+
+    T *value = m_data + m_head;
+    T ret = WHEELS_MOV(*value);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        // Moved from value might still require dtor
+        value->~T();
+
+    m_head = wrap(1);
+    m_size--;
+
+    return ret;
+}
+
+template <typename T, typename Growth>
+void RingBuffer<T, Growth>::pop_front_into(Span<T> dst) noexcept
+{
+    size_t const count = dst.size();
+    WHEELS_ASSERT(count <= m_size);
+    if (count == 0)
+        return;
+
+    size_t const first_count =
+        count < m_capacity - m_head ? count : m_capacity - m_head;
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+        memcpy(dst.data(), m_data + m_head, first_count * sizeof(T));
+        memcpy(
+            dst.data() + first_count, m_data,
+            (count - first_count) * sizeof(T));
+        m_head = wrap(count);
+        m_size -= count;
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = WHEELS_MOV((*this)[i]);
+        // Moved from values might still require dtors
+        drop_front(count);
+    }
+}
+
+template <typename T, typename Growth>
+void RingBuffer<T, Growth>::drop_front(size_t count) noexcept
+{
+    WHEELS_ASSERT(count <= m_size);
+
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        for (size_t i = 0; i < count; ++i)
+            m_data[wrap(i)].~T();
+    }
+    m_head = count == m_size ? 0 : wrap(count);
+    m_size -= count;
+}
+
+template <typename T, typename Growth>
+size_t RingBuffer<T, Growth>::wrap(size_t i) const noexcept
+{
+    // Cheaper than a modulo as the index never goes past twice the capacity
+    size_t const ret = m_head + i;
+    return ret >= m_capacity ? ret - m_capacity : ret;
+}
+
+template <typename T, typename Growth>
+void RingBuffer<T, Growth>::grow(size_t required_capacity) noexcept
+{
+    size_t const capacity =
+        Growth::grown_capacity(m_capacity, required_capacity, sizeof(T));
+    WHEELS_ASSERT(capacity >= required_capacity);
+
+    reallocate(capacity);
+}
+
+template <typename T, typename Growth>
+void RingBuffer<T, Growth>::reallocate(size_t capacity) noexcept
+{
+    WHEELS_ASSERT(capacity >= m_size);
+
+    AllocationResult allocation;
+    if constexpr (Growth::s_use_allocation_slack)
+        allocation = m_allocator.allocate_at_least(capacity * sizeof(T));
+    else
+        allocation = AllocationResult{
+            .ptr = m_allocator.allocate(capacity * sizeof(T)),
+            .num_bytes = capacity * sizeof(T),
+        };
+    T *data = (T *)allocation.ptr;
+    WHEELS_ASSERT(data != nullptr);
+
+    if (m_data != nullptr)
+    {
+        // Unwrap the values to the start of the new storage
+        Pair<Span<T>, Span<T>> segments = mut_spans();
+        relocate_n(data, segments.first.data(), segments.first.size());
+        relocate_n(
+            data + segments.first.size(), segments.second.data(),
+            segments.second.size());
+        m_allocator.deallocate(m_data);
+    }
+
+    m_data = data;
+    m_capacity = allocation.num_bytes / sizeof(T);
+    m_head = 0;
+}
+
+template <typename T, typename Growth>
+void RingBuffer<T, Growth>::destroy() noexcept
+{
+    if (m_data != nullptr)
+    {
+        clear();
+        m_allocator.deallocate(m_data);
+        m_data = nullptr;
+    }
+}
+
+template <typename T, typename Growth>
+typename RingBuffer<T, Growth>::Iterator RingBuffer<
+    T, Growth>::Iterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < buffer.m_size);
+    pos++;
+    return *this;
+}
+
+template <typename T, typename Growth>
+typename RingBuffer<T, Growth>::Iterator RingBuffer<
+    T, Growth>::Iterator::operator++(int) noexcept
+{
+    Iterator const ret = *this;
+    ++*this;
+    return ret;
+}
+
+template <typename T, typename Growth>
+T &RingBuffer<T, Growth>::Iterator::operator*() const noexcept
+{
+    return buffer[pos];
+}
+
+template <typename T, typename Growth>
+T *RingBuffer<T, Growth>::Iterator::operator->() const noexcept
+{
+    return &buffer[pos];
+}
+
+template <typename T, typename Growth>
+bool RingBuffer<T, Growth>::Iterator::operator!=(
+    Iterator const &other) const noexcept
+{
+    return pos != other.pos;
+}
+
+template <typename T, typename Growth>
+bool RingBuffer<T, Growth>::Iterator::operator==(
+    Iterator const &other) const noexcept
+{
+    return pos == other.pos;
+}
+
+template <typename T, typename Growth>
+typename RingBuffer<T, Growth>::ConstIterator RingBuffer<
+    T, Growth>::ConstIterator::operator++() noexcept
+{
+    WHEELS_ASSERT(pos < buffer.m_size);
+    pos++;
+    return *this;
+}
+
+template <typename T, typename Growth>
+typename RingBuffer<T, Growth>::ConstIterator RingBuffer<
+    T, Growth>::ConstIterator::operator++(int) noexcept
+{
+    ConstIterator const ret = *this;
+    ++*this;
+    return ret;
+}
+
+template <typename T, typename Growth>
+T const &RingBuffer<T, Growth>::ConstIterator::operator*() const noexcept
+{
+    return buffer[pos];
+}
+
+template <typename T, typename Growth>
+T const *RingBuffer<T, Growth>::ConstIterator::operator->() const noexcept
+{
+    return &buffer[pos];
+}
+
+template <typename T, typename Growth>
+bool RingBuffer<T, Growth>::ConstIterator::operator!=(
+    ConstIterator const &other) const noexcept
+{
+    return pos != other.pos;
+}
+
+template <typename T, typename Growth>
+bool RingBuffer<T, Growth>::ConstIterator::operator==(
+    ConstIterator const &other) const noexcept
+{
+    return pos == other.pos;
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_RING_BUFFER_HPP
@@ -0,0 +1,668 @@
+#ifndef WHEELS_CONTAINERS_SMALL_ARRAY_HPP
+#define WHEELS_CONTAINERS_SMALL_ARRAY_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "span.hpp"
+#include "utils.hpp"
+
+#include <cstring>
+
+namespace wheels
+{
+
+// Array that stores up to N values inline and spills to the allocator when it
+// grows past that. Moving an inline array relocates its values while a spilled
+// one just hands its allocation over.
+// Growth is a policy like ArrayGrowth that picks the capacity to grow to when
+// push_back(), emplace_back() or extend() run out of it
+template <typename T, size_t N, typename Growth = DefaultArrayGrowth>
+class SmallArray
+{
+    static_assert(N > 0, "Use Array if there's no need for inline storage");
+    // Use a static assert instead of a concepts constraint as this will produce
+    // a more understandable error message
+    static_assert(
+        (std::is_trivially_copyable_v<T> || std::move_constructible<T>),
+        "Reallocation requires T to be either trivially copyable or move "
+        "constructible");
+
+  public:
+    using value_type = T;
+
+    // Spills right away if initial_capacity is over N
+    SmallArray(Allocator &allocator, size_t initial_capacity = 0) noexcept;
+    ~SmallArray();
+
+    SmallArray(SmallArray<T, N, Growth> const &) = delete;
+    SmallArray(SmallArray<T, N, Growth> &&other) noexcept;
+    SmallArray<T, N, Growth> &operator=(
+        SmallArray<T, N, Growth> const &) = delete;
+    SmallArray<T, N, Growth> &operator=(
+        SmallArray<T, N, Growth> &&other) noexcept;
+
+    [[nodiscard]] T &operator[](size_t i) noexcept;
+    [[nodiscard]] T const &operator[](size_t i) const noexcept;
+    [[nodiscard]] T &front() noexcept;
+    [[nodiscard]] T const &front() const noexcept;
+    [[nodiscard]] T &back() noexcept;
+    [[nodiscard]] T const &back() const noexcept;
+    [[nodiscard]] T *data() noexcept;
+    [[nodiscard]] T const *data() const noexcept;
+
+    [[nodiscard]] T *begin() noexcept;
+    [[nodiscard]] T const *begin() const noexcept;
+    [[nodiscard]] T *end() noexcept;
+    [[nodiscard]] T const *end() const noexcept;
+
+    // Template type inference can't seem to follow T with the inner const so
+    // let's have explicit methods for const and mutable spans
+
+    [[nodiscard]] Span<T> mut_span() noexcept;
+    [[nodiscard]] Span<T const> span() const noexcept;
+    [[nodiscard]] Span<T> mut_span(size_t begin_i, size_t end_i) noexcept;
+    [[nodiscard]] Span<T const> span(
+        size_t begin_i, size_t end_i) const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    void reserve(size_t capacity) noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+    // True if the values are in the inline storage
+    [[nodiscard]] bool is_inline() const noexcept;
+    // Moves the values back to the inline storage if they fit, frees the
+    // unused capacity otherwise
+    void shrink_to_fit() noexcept;
+
+    void clear() noexcept;
+
+    template <typename U>
+    // Let's be pedantic and disallow implicit conversions
+        requires SameAs<U, T>
+    void push_back(U &&value) noexcept;
+
+    template <typename... Args> void emplace_back(Args &&...args) noexcept;
+
+    void extend(Span<const T> values) noexcept;
+
+    // Inserts the values before index, shifting the ones after it. values
+    // can't point into this array.
+    void insert(size_t index, Span<const T> values) noexcept;
+
+    T pop_back() noexcept;
+    // Preserves the order, takes O(n) for n elements after index
+    void erase(size_t index) noexcept;
+    // Doesn't preserve the order, runs in O(1)
+    void erase_swap_last(size_t index) noexcept;
+    // Erases [begin_i, end_i) and shifts the rest over it in one go
+    void erase(size_t begin_i, size_t end_i) noexcept;
+    // Removes the values for which pred(T const &) returns true in a single
+    // pass, preserving the order of the rest. Returns the number of removed
+    // values.
+    template <typename F> size_t erase_if(F &&pred) noexcept;
+    // Keeps only the values for which pred(T const &) returns true. Returns the
+    // number of removed values.
+    template <typename F> size_t retain(F &&pred) noexcept;
+
+    void resize(size_t size) noexcept;
+    void resize(size_t size, T const &value) noexcept;
+    // Like resize() but leaves the new values uninitialized, for buffers that
+    // are written to right after
+    void resize_uninitialized(size_t size) noexcept;
+    // Adds count uninitialized values to the back and returns a span for
+    // filling them in
+    [[nodiscard]] Span<T> append_uninitialized(size_t count) noexcept;
+
+    operator Span<T const>() const noexcept;
+
+  private:
+    [[nodiscard]] T *inline_data() noexcept;
+    // Takes the values of other, this has to be empty and inline
+    void take_values(SmallArray<T, N, Growth> &other) noexcept;
+    void grow(size_t required_capacity) noexcept;
+    void reallocate(size_t capacity) noexcept;
+    void destroy() noexcept;
+
+    Allocator &m_allocator;
+    // Points to either m_inline_data or an allocation
+    T *m_data{nullptr};
+    size_t m_capacity{N};
+    size_t m_size{0};
+    alignas(T) uint8_t m_inline_data[N * sizeof(T)];
+};
+
+template <typename T, size_t N, typename Growth>
+SmallArray<T, N, Growth>::SmallArray(
+    Allocator &allocator, size_t initial_capacity) noexcept
+: m_allocator{allocator}
+, m_data{inline_data()}
+{
+    static_assert(
+        alignof(T) <= alignof(std::max_align_t) &&
+        "Aligned allocations beyond std::max_align_t aren't supported");
+
+    if (initial_capacity > N)
+        reallocate(initial_capacity);
+}
+
+template <typename T, size_t N, typename Growth>
+SmallArray<T, N, Growth>::~SmallArray()
+{
+    destroy();
+}
+
+template <typename T, size_t N, typename Growth>
+SmallArray<T, N, Growth>::SmallArray(SmallArray<T, N, Growth> &&other) noexcept
+: m_allocator{other.m_allocator}
+, m_data{inline_data()}
+{
+    take_values(other);
+}
+
+template <typename T, size_t N, typename Growth>
+SmallArray<T, N, Growth> &SmallArray<T, N, Growth>::operator=(
+    SmallArray<T, N, Growth> &&other) noexcept
+{
+    WHEELS_ASSERT(
+        &m_allocator == &other.m_allocator &&
+        "Move assigning a container with different allocators can lead to "
+        "nasty bugs. Use the same allocator or copy the content instead.");
+
+    if (this != &other)
+    {
+        destroy();
+        take_values(other);
+    }
+    return *this;
+}
+
+template <typename T, size_t N, typename Growth>
+T &SmallArray<T, N, Growth>::operator[](size_t i) noexcept
+{
+    WHEELS_ASSERT(i < m_size);
+    return m_data[i];
+}
+
+template <typename T, size_t N, typename Growth>
+T const &SmallArray<T, N, Growth>::operator[](size_t i) const noexcept
+{
+    WHEELS_ASSERT(i < m_size);
+    return m_data[i];
+}
+
+template <typename T, size_t N, typename Growth>
+T &SmallArray<T, N, Growth>::front() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return *m_data;
+}
+
+template <typename T, size_t N, typename Growth>
+T const &SmallArray<T, N, Growth>::front() const noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return *m_data;
+}
+
+template <typename T, size_t N, typename Growth>
+T &SmallArray<T, N, Growth>::back() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return m_data[m_size - 1];
+}
+
+template <typename T, size_t N, typename Growth>
+T const &SmallArray<T, N, Growth>::back() const noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    return m_data[m_size - 1];
+}
+
+template <typename T, size_t N, typename Growth>
+T *SmallArray<T, N, Growth>::data() noexcept
+{
+    return m_data;
+}
+
+template <typename T, size_t N, typename Growth>
+T const *SmallArray<T, N, Growth>::data() const noexcept
+{
+    return m_data;
+}
+
+template <typename T, size_t N, typename Growth>
+T *SmallArray<T, N, Growth>::begin() noexcept
+{
+    return m_data;
+}
+
+template <typename T, size_t N, typename Growth>
+T const *SmallArray<T, N, Growth>::begin() const noexcept
+{
+    return m_data;
+}
+
+template <typename T, size_t N, typename Growth>
+T *SmallArray<T, N, Growth>::end() noexcept
+{
+    return m_data + m_size;
+}
+
+template <typename T, size_t N, typename Growth>
+T const *SmallArray<T, N, Growth>::end() const noexcept
+{
+    return m_data + m_size;
+}
+
+template <typename T, size_t N, typename Growth>
+Span<T> SmallArray<T, N, Growth>::mut_span() noexcept
+{
+    return Span{begin(), m_size};
+}
+
+template <typename T, size_t N, typename Growth>
+Span<T const> SmallArray<T, N, Growth>::span() const noexcept
+{
+    return Span<T const>{begin(), m_size};
+}
+
+template <typename T, size_t N, typename Growth>
+Span<T> SmallArray<T, N, Growth>::mut_span(
+    size_t begin_i, size_t end_i) noexcept
+{
+    WHEELS_ASSERT(begin_i < m_size);
+    WHEELS_ASSERT(end_i <= m_size);
+    return Span{begin() + begin_i, end_i - begin_i};
+}
+
+template <typename T, size_t N, typename Growth>
+Span<T const> SmallArray<T, N, Growth>::span(
+    size_t begin_i, size_t end_i) const noexcept
+{
+    WHEELS_ASSERT(begin_i < m_size);
+    WHEELS_ASSERT(end_i <= m_size);
+    return Span<T const>{begin() + begin_i, end_i - begin_i};
+}
+
+template <typename T, size_t N, typename Growth>
+bool SmallArray<T, N, Growth>::empty() const noexcept
+{
+    return m_size == 0;
+}
+
+template <typename T, size_t N, typename Growth>
+size_t SmallArray<T, N, Growth>::size() const noexcept
+{
+    return m_size;
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::reserve(size_t capacity) noexcept
+{
+    if (capacity > m_capacity)
+        reallocate(capacity);
+}
+
+template <typename T, size_t N, typename Growth>
+size_t SmallArray<T, N, Growth>::capacity() const noexcept
+{
+    return m_capacity;
+}
+
+template <typename T, size_t N, typename Growth>
+bool SmallArray<T, N, Growth>::is_inline() const noexcept
+{
+    return m_data == (T const *)m_inline_data;
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::shrink_to_fit() noexcept
+{
+    if (is_inline() || m_size == m_capacity)
+        return;
+
+    if (m_size <= N)
+    {
+        T *data = m_data;
+        relocate_n(inline_data(), data, m_size);
+        m_allocator.deallocate(data);
+
+        m_data = inline_data();
+        m_capacity = N;
+    }
+    else
+        reallocate(m_size);
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::clear() noexcept
+{
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        for (auto &v : *this)
+            v.~T();
+    }
+    m_size = 0;
+}
+
+template <typename T, size_t N, typename Growth>
+template <typename U>
+    requires SameAs<U, T>
+void SmallArray<T, N, Growth>::push_back(U &&value) noexcept
+{
+    if (m_size == m_capacity)
+        grow(m_size + 1);
+
+    new (m_data + m_size++) T{WHEELS_FWD(value)};
+}
+
+template <typename T, size_t N, typename Growth>
+template <typename... Args>
+void SmallArray<T, N, Growth>::emplace_back(Args &&...args) noexcept
+{
+    if (m_size == m_capacity)
+        grow(m_size + 1);
+
+    new (m_data + m_size++) T{WHEELS_FWD(args)...};
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::extend(Span<const T> values) noexcept
+{
+    const size_t required_size = m_size + values.size();
+    if (required_size > m_capacity)
+        grow(required_size);
+
+    if constexpr (std::is_trivially_copyable_v<T>)
+        memcpy(m_data + m_size, values.data(), values.size() * sizeof(T));
+    else
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+            new (m_data + m_size + i) T{values[i]};
+    }
+    m_size += values.size();
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::insert(
+    size_t index, Span<const T> values) noexcept
+{
+    WHEELS_ASSERT(index <= m_size);
+    WHEELS_ASSERT(
+        (values.data() + values.size() <= data() ||
+         values.data() >= data() + capacity()) &&
+        "Inserting values from the array itself isn't supported");
+
+    size_t const count = values.size();
+    if (count == 0)
+        return;
+
+    size_t const required_size = m_size + count;
+    if (required_size > m_capacity)
+        grow(required_size);
+
+    relocate_overlapping(
+        m_data + index + count, m_data + index, m_size - index);
+
+    if constexpr (std::is_trivially_copyable_v<T>)
+        memcpy(m_data + index, values.data(), count * sizeof(T));
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            new (m_data + index + i) T{values[i]};
+    }
+    m_size += count;
+}
+
+template <typename T, size_t N, typename Growth>
+T SmallArray<T, N, Growth>::pop_back() noexcept
+{
+    WHEELS_ASSERT(m_size > 0);
+    m_size--;
+
+    T ret = WHEELS_MOV(m_data[m_size]);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        // Moved from value might still require dtor
+        m_data[m_size].~T();
+
+    return ret;
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::erase(size_t index) noexcept
+{
+    WHEELS_ASSERT(index < m_size);
+
+    erase(index, index + 1);
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::erase(size_t begin_i, size_t end_i) noexcept
+{
+    WHEELS_ASSERT(begin_i <= end_i);
+    WHEELS_ASSERT(end_i <= m_size);
+
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        for (size_t i = begin_i; i < end_i; ++i)
+            m_data[i].~T();
+    }
+
+    relocate_overlapping(m_data + begin_i, m_data + end_i, m_size - end_i);
+    m_size -= end_i - begin_i;
+}
+
+template <typename T, size_t N, typename Growth>
+template <typename F>
+size_t SmallArray<T, N, Growth>::erase_if(F &&pred) noexcept
+{
+    size_t const kept_count = remove_values_if(m_data, m_size, pred);
+    size_t const removed_count = m_size - kept_count;
+    m_size = kept_count;
+
+    return removed_count;
+}
+
+template <typename T, size_t N, typename Growth>
+template <typename F>
+size_t SmallArray<T, N, Growth>::retain(F &&pred) noexcept
+{
+    return erase_if([&](T const &value) { return !pred(value); });
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::erase_swap_last(size_t index) noexcept
+{
+    WHEELS_ASSERT(index < m_size);
+
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        m_data[index].~T();
+
+    if (index < m_size - 1)
+        relocate(m_data + index, m_data + m_size - 1);
+    m_size--;
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::resize(size_t size) noexcept
+{
+    if (size < m_size)
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            for (size_t i = size; i < m_size; ++i)
+                m_data[i].~T();
+        }
+        m_size = size;
+    }
+    else
+    {
+        reserve(size);
+        if constexpr (std::is_class_v<T>)
+        {
+            for (size_t i = m_size; i < size; ++i)
+                new (m_data + i) T{};
+        }
+        m_size = size;
+    }
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::resize(size_t size, T const &value) noexcept
+{
+    if (size < m_size)
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            for (size_t i = size; i < m_size; ++i)
+                m_data[i].~T();
+        }
+        m_size = size;
+    }
+    else
+    {
+        reserve(size);
+        for (size_t i = m_size; i < size; ++i)
+            new (m_data + i) T{value};
+        m_size = size;
+    }
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::resize_uninitialized(size_t size) noexcept
+{
+    static_assert(
+        std::is_trivially_default_constructible_v<T>,
+        "Skipping initialization is only valid for trivially default "
+        "constructible types");
+
+    if (size <= m_size)
+        resize(size);
+    else
+    {
+        if (size > m_capacity)
+            grow(size);
+        m_size = size;
+    }
+}
+
+template <typename T, size_t N, typename Growth>
+Span<T> SmallArray<T, N, Growth>::append_uninitialized(size_t count) noexcept
+{
+    static_assert(
+        std::is_trivially_default_constructible_v<T>,
+        "Skipping initialization is only valid for trivially default "
+        "constructible types");
+
+    size_t const required_size = m_size + count;
+    if (required_size > m_capacity)
+        grow(required_size);
+
+    Span<T> const ret{m_data + m_size, count};
+    m_size = required_size;
+
+    return ret;
+}
+
+template <typename T, size_t N, typename Growth>
+SmallArray<T, N, Growth>::operator Span<T const>() const noexcept
+{
+    return Span{m_data, m_size};
+}
+
+template <typename T, size_t N, typename Growth>
+T *SmallArray<T, N, Growth>::inline_data() noexcept
+{
+    return (T *)m_inline_data;
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::take_values(
+    SmallArray<T, N, Growth> &other) noexcept
+{
+    WHEELS_ASSERT(is_inline() && m_size == 0);
+
+    if (other.is_inline())
+        relocate_n(m_data, other.m_data, other.m_size);
+    else
+    {
+        m_data = other.m_data;
+        m_capacity = other.m_capacity;
+
+        other.m_data = other.inline_data();
+        other.m_capacity = N;
+    }
+    m_size = other.m_size;
+
+    other.m_size = 0;
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::grow(size_t required_capacity) noexcept
+{
+    size_t const capacity =
+        Growth::grown_capacity(m_capacity, required_capacity, sizeof(T));
+    WHEELS_ASSERT(capacity >= required_capacity);
+
+    reallocate(capacity);
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::reallocate(size_t capacity) noexcept
+{
+    WHEELS_ASSERT(capacity > N);
+    WHEELS_ASSERT(capacity >= m_size);
+
+    if constexpr (is_trivially_relocatable_v<T>)
+    {
+        if (!is_inline())
+        {
+            // Allocators that support it might be able to grow in place or
+            // remap the pages instead of copying everything over
+            T *data =
+                (T *)m_allocator.reallocate(m_data, capacity * sizeof(T));
+            if (data != nullptr)
+            {
+                m_data = data;
+                m_capacity = capacity;
+                return;
+            }
+        }
+    }
+
+    AllocationResult allocation;
+    if constexpr (Growth::s_use_allocation_slack)
+        allocation = m_allocator.allocate_at_least(capacity * sizeof(T));
+    else
+        allocation = AllocationResult{
+            .ptr = m_allocator.allocate(capacity * sizeof(T)),
+            .num_bytes = capacity * sizeof(T),
+        };
+    T *data = (T *)allocation.ptr;
+    WHEELS_ASSERT(data != nullptr);
+
+    relocate_n(data, m_data, m_size);
+    if (!is_inline())
+        m_allocator.deallocate(m_data);
+
+    m_data = data;
+    m_capacity = allocation.num_bytes / sizeof(T);
+}
+
+template <typename T, size_t N, typename Growth>
+void SmallArray<T, N, Growth>::destroy() noexcept
+{
+    clear();
+    if (!is_inline())
+    {
+        m_allocator.deallocate(m_data);
+        m_data = inline_data();
+        m_capacity = N;
+    }
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_SMALL_ARRAY_HPP
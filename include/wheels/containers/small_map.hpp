@@ -6,11 +6,16 @@
 #include "concepts.hpp"
 #include "inline_array.hpp"
 #include "pair.hpp"
+#include "utils.hpp"
 
 namespace wheels
 {
 
-template <typename K, typename V, size_t N> class SmallMap
+// Sorted storage requires K to have operator< and iterates in key order
+template <
+    typename K, typename V, size_t N,
+    SmallStorage Storage = SmallStorage::Unsorted>
+class SmallMap
 {
   public:
     using key_type = K;
@@ -19,12 +24,16 @@ template <typename K, typename V, size_t N> class SmallMap
     using value_type = V;
 
     SmallMap() noexcept {};
-    ~SmallMap();
+    // Defaulted so that these are trivial when the values are trivially
+    // copyable
+    ~SmallMap() = default;
 
-    SmallMap(SmallMap<K, V, N> const &other) noexcept;
-    SmallMap(SmallMap<K, V, N> &&other) noexcept;
-    SmallMap<K, V, N> &operator=(SmallMap<K, V, N> const &other) noexcept;
-    SmallMap<K, V, N> &operator=(SmallMap<K, V, N> &&other) noexcept;
+    SmallMap(SmallMap<K, V, N, Storage> const &other) noexcept = default;
+    SmallMap(SmallMap<K, V, N, Storage> &&other) noexcept = default;
+    SmallMap<K, V, N, Storage> &operator=(
+        SmallMap<K, V, N, Storage> const &other) noexcept = default;
+    SmallMap<K, V, N, Storage> &operator=(
+        SmallMap<K, V, N, Storage> &&other) noexcept = default;
 
     [[nodiscard]] Pair<K, V> *begin() noexcept;
     [[nodiscard]] Pair<K, V> const *begin() const noexcept;
@@ -43,158 +52,182 @@ template <typename K, typename V, size_t N> class SmallMap
     template <typename Key, typename Value>
     // Let's be pedantic and disallow implicit conversions
         requires(SameAs<K, Key> && SameAs<V, Value>)
-    void insert_or_assign(Key &&key, Value &&value) noexcept;
+    V *insert_or_assign(Key &&key, Value &&value) noexcept;
     void remove(K const &key) noexcept;
 
   private:
-    InlineArray<Pair<K, V>, N> m_data;
-};
-
-template <typename K, typename V, size_t N> SmallMap<K, V, N>::~SmallMap()
-{
-    clear();
-}
-
-template <typename K, typename V, size_t N>
-SmallMap<K, V, N>::SmallMap(SmallMap<K, V, N> const &other) noexcept
-: m_data{other.m_data}
-{
-}
-
-template <typename K, typename V, size_t N>
-SmallMap<K, V, N>::SmallMap(SmallMap<K, V, N> &&other) noexcept
-: m_data{WHEELS_MOV(other.m_data)}
-{
-}
-
-template <typename K, typename V, size_t N>
-SmallMap<K, V, N> &SmallMap<K, V, N>::operator=(
-    SmallMap<K, V, N> const &other) noexcept
-{
-    if (this != &other)
-        m_data = other.m_data;
-
-    return *this;
-}
+    // Keys can be searched for in place when they're at the start of small
+    // enough pairs
+    static constexpr bool s_simd_search =
+        SimdSearchable<K> && std::is_standard_layout_v<Pair<K, V>> &&
+        std::has_single_bit(sizeof(Pair<K, V>)) && sizeof(Pair<K, V>) <= 8;
 
-template <typename K, typename V, size_t N>
-SmallMap<K, V, N> &SmallMap<K, V, N>::operator=(
-    SmallMap<K, V, N> &&other) noexcept
-{
-    if (this != &other)
-        m_data = WHEELS_MOV(other.m_data);
+    // Returns the index of key or size() if it's not in the map
+    [[nodiscard]] size_t find_index(K const &key) const noexcept;
+    [[nodiscard]] size_t lower_bound(K const &key) const noexcept;
 
-    return *this;
-}
+    InlineArray<Pair<K, V>, N> m_data;
+};
 
-template <typename K, typename V, size_t N>
-Pair<K, V> *SmallMap<K, V, N>::begin() noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+Pair<K, V> *SmallMap<K, V, N, Storage>::begin() noexcept
 {
     return m_data.begin();
 }
 
-template <typename K, typename V, size_t N>
-Pair<K, V> const *SmallMap<K, V, N>::begin() const noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+Pair<K, V> const *SmallMap<K, V, N, Storage>::begin() const noexcept
 {
     return m_data.begin();
 }
 
-template <typename K, typename V, size_t N>
-Pair<K, V> *SmallMap<K, V, N>::end() noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+Pair<K, V> *SmallMap<K, V, N, Storage>::end() noexcept
 {
     return m_data.end();
 }
 
-template <typename K, typename V, size_t N>
-Pair<K, V> const *SmallMap<K, V, N>::end() const noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+Pair<K, V> const *SmallMap<K, V, N, Storage>::end() const noexcept
 {
     return m_data.end();
 }
 
-template <typename K, typename V, size_t N>
-bool SmallMap<K, V, N>::empty() const noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+bool SmallMap<K, V, N, Storage>::empty() const noexcept
 {
     return m_data.empty();
 }
 
-template <typename K, typename V, size_t N>
-size_t SmallMap<K, V, N>::size() const noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+size_t SmallMap<K, V, N, Storage>::size() const noexcept
 {
     return m_data.size();
 }
 
-template <typename K, typename V, size_t N>
-size_t SmallMap<K, V, N>::capacity() const noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+size_t SmallMap<K, V, N, Storage>::capacity() const noexcept
 {
     return m_data.capacity();
 }
 
-template <typename K, typename V, size_t N>
-bool SmallMap<K, V, N>::contains(K const &key) const noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+bool SmallMap<K, V, N, Storage>::contains(K const &key) const noexcept
 {
-    for (auto const &kv : m_data)
-    {
-        if (kv.first == key)
-            return true;
-    }
-
-    return false;
+    return find_index(key) < m_data.size();
 }
 
-template <typename K, typename V, size_t N>
-V *SmallMap<K, V, N>::find(K const &key) noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+V *SmallMap<K, V, N, Storage>::find(K const &key) noexcept
 {
-    for (auto &kv : m_data)
-    {
-        if (kv.first == key)
-            return &kv.second;
-    }
+    size_t const index = find_index(key);
+    if (index == m_data.size())
+        return nullptr;
 
-    return nullptr;
+    return &m_data[index].second;
 }
 
-template <typename K, typename V, size_t N>
-V const *SmallMap<K, V, N>::find(K const &key) const noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+V const *SmallMap<K, V, N, Storage>::find(K const &key) const noexcept
 {
-    for (auto const &kv : m_data)
-    {
-        if (kv.first == key)
-            return &kv.second;
-    }
+    size_t const index = find_index(key);
+    if (index == m_data.size())
+        return nullptr;
 
-    return nullptr;
+    return &m_data[index].second;
 }
 
-template <typename K, typename V, size_t N>
-void SmallMap<K, V, N>::clear() noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+void SmallMap<K, V, N, Storage>::clear() noexcept
 {
     m_data.clear();
 }
 
-template <typename K, typename V, size_t N>
+template <typename K, typename V, size_t N, SmallStorage Storage>
 template <typename Key, typename Value>
 // Let's be pedantic and disallow implicit conversions
     requires(SameAs<K, Key> && SameAs<V, Value>)
-void SmallMap<K, V, N>::insert_or_assign(Key &&key, Value &&value) noexcept
+V *SmallMap<K, V, N, Storage>::insert_or_assign(
+    Key &&key, Value &&value) noexcept
 {
-    if (V *v = find(key); v != nullptr)
-        *v = value;
+    if constexpr (Storage == SmallStorage::Sorted)
+    {
+        size_t const index = lower_bound(key);
+        if (index < m_data.size() && m_data[index].first == key)
+            m_data[index].second = value;
+        else
+        {
+            // key wasn't found but value might be one of the shifted ones
+            void const *const value_ptr = &value;
+            if (value_ptr >= (void const *)m_data.begin() &&
+                value_ptr < (void const *)m_data.end())
+            {
+                V value_copy{value};
+                m_data.emplace(index, WHEELS_FWD(key), WHEELS_MOV(value_copy));
+            }
+            else
+                m_data.emplace(index, WHEELS_FWD(key), WHEELS_FWD(value));
+        }
+        return &m_data[index].second;
+    }
     else
+    {
+        if (V *v = find(key); v != nullptr)
+        {
+            *v = value;
+            return v;
+        }
         m_data.emplace_back(WHEELS_FWD(key), WHEELS_FWD(value));
+        return &m_data.back().second;
+    }
+}
+
+template <typename K, typename V, size_t N, SmallStorage Storage>
+void SmallMap<K, V, N, Storage>::remove(K const &key) noexcept
+{
+    size_t const index = find_index(key);
+    if (index == m_data.size())
+        return;
+
+    if constexpr (Storage == SmallStorage::Sorted)
+        m_data.erase(index);
+    else
+    {
+        std::swap(m_data[index], m_data.back());
+        m_data.pop_back();
+    }
 }
 
-template <typename K, typename V, size_t N>
-void SmallMap<K, V, N>::remove(K const &key) noexcept
+template <typename K, typename V, size_t N, SmallStorage Storage>
+size_t SmallMap<K, V, N, Storage>::find_index(K const &key) const noexcept
 {
-    for (auto &v : m_data)
+    size_t const size = m_data.size();
+    if constexpr (Storage == SmallStorage::Sorted)
+    {
+        size_t const index = lower_bound(key);
+        if (index < size && m_data[index].first == key)
+            return index;
+    }
+    else if constexpr (s_simd_search)
+        return find_first_key<K, sizeof(Pair<K, V>)>(m_data.data(), size, key);
+    else
     {
-        if (v.first == key)
+        for (size_t i = 0; i < size; ++i)
         {
-            std::swap(v, m_data.back());
-            m_data.pop_back();
-            return;
+            if (m_data[i].first == key)
+                return i;
         }
     }
+
+    return size;
+}
+
+template <typename K, typename V, size_t N, SmallStorage Storage>
+size_t SmallMap<K, V, N, Storage>::lower_bound(K const &key) const noexcept
+{
+    return branchless_lower_bound(
+        m_data.data(), m_data.size(), key,
+        [](Pair<K, V> const &kv) -> K const & { return kv.first; });
 }
 
 } // namespace wheels
@@ -3,23 +3,31 @@
 #define WHEELS_CONTAINERS_SMALL_SET_HPP
 
 #include "../utils.hpp"
+#include "concepts.hpp"
 #include "inline_array.hpp"
+#include "utils.hpp"
 
 namespace wheels
 {
 
-template <typename T, size_t N> class SmallSet
+// Sorted storage requires T to have operator< and iterates in sorted order
+template <typename T, size_t N, SmallStorage Storage = SmallStorage::Unsorted>
+class SmallSet
 {
   public:
     using value_type = T;
 
     SmallSet() noexcept {};
-    ~SmallSet();
+    // Defaulted so that these are trivial when the values are trivially
+    // copyable
+    ~SmallSet() = default;
 
-    SmallSet(SmallSet<T, N> const &other) noexcept;
-    SmallSet(SmallSet<T, N> &&other) noexcept;
-    SmallSet<T, N> &operator=(SmallSet<T, N> const &other) noexcept;
-    SmallSet<T, N> &operator=(SmallSet<T, N> &&other) noexcept;
+    SmallSet(SmallSet<T, N, Storage> const &other) noexcept = default;
+    SmallSet(SmallSet<T, N, Storage> &&other) noexcept = default;
+    SmallSet<T, N, Storage> &operator=(
+        SmallSet<T, N, Storage> const &other) noexcept = default;
+    SmallSet<T, N, Storage> &operator=(
+        SmallSet<T, N, Storage> &&other) noexcept = default;
 
     [[nodiscard]] T *begin() noexcept;
     [[nodiscard]] T const *begin() const noexcept;
@@ -38,119 +46,146 @@ template <typename T, size_t N> class SmallSet
     void remove(T const &value) noexcept;
 
   private:
+    // Returns the index of value or size() if it's not in the set
+    [[nodiscard]] size_t find_index(T const &value) const noexcept;
+    [[nodiscard]] size_t lower_bound(T const &value) const noexcept;
+    template <typename U> void insert_value(U &&value) noexcept;
+
     InlineArray<T, N> m_data;
 };
 
-template <typename T, size_t N> SmallSet<T, N>::~SmallSet() { clear(); }
-
-template <typename T, size_t N>
-SmallSet<T, N>::SmallSet(SmallSet<T, N> const &other) noexcept
-: m_data{other.m_data}
+template <typename T, size_t N, SmallStorage Storage>
+T *SmallSet<T, N, Storage>::begin() noexcept
 {
+    return m_data.begin();
 }
 
-template <typename T, size_t N>
-SmallSet<T, N>::SmallSet(SmallSet<T, N> &&other) noexcept
-: m_data{WHEELS_MOV(other.m_data)}
+template <typename T, size_t N, SmallStorage Storage>
+T const *SmallSet<T, N, Storage>::begin() const noexcept
 {
+    return m_data.begin();
 }
 
-template <typename T, size_t N>
-SmallSet<T, N> &SmallSet<T, N>::operator=(SmallSet<T, N> const &other) noexcept
+template <typename T, size_t N, SmallStorage Storage>
+T *SmallSet<T, N, Storage>::end() noexcept
 {
-    if (this != &other)
-        m_data = other.m_data;
-
-    return *this;
+    return m_data.end();
 }
 
-template <typename T, size_t N>
-SmallSet<T, N> &SmallSet<T, N>::operator=(SmallSet<T, N> &&other) noexcept
+template <typename T, size_t N, SmallStorage Storage>
+T const *SmallSet<T, N, Storage>::end() const noexcept
 {
-    if (this != &other)
-        m_data = WHEELS_MOV(other.m_data);
-
-    return *this;
+    return m_data.end();
 }
 
-template <typename T, size_t N> T *SmallSet<T, N>::begin() noexcept
+template <typename T, size_t N, SmallStorage Storage>
+bool SmallSet<T, N, Storage>::empty() const noexcept
 {
-    return m_data.begin();
+    return m_data.empty();
 }
 
-template <typename T, size_t N> T const *SmallSet<T, N>::begin() const noexcept
+template <typename T, size_t N, SmallStorage Storage>
+size_t SmallSet<T, N, Storage>::size() const noexcept
 {
-    return m_data.begin();
+    return m_data.size();
 }
 
-template <typename T, size_t N> T *SmallSet<T, N>::end() noexcept
+template <typename T, size_t N, SmallStorage Storage>
+size_t SmallSet<T, N, Storage>::capacity() const noexcept
 {
-    return m_data.end();
+    return m_data.capacity();
 }
 
-template <typename T, size_t N> T const *SmallSet<T, N>::end() const noexcept
+template <typename T, size_t N, SmallStorage Storage>
+bool SmallSet<T, N, Storage>::contains(T const &value) const noexcept
 {
-    return m_data.end();
+    return find_index(value) < m_data.size();
 }
 
-template <typename T, size_t N> bool SmallSet<T, N>::empty() const noexcept
+template <typename T, size_t N, SmallStorage Storage>
+void SmallSet<T, N, Storage>::clear() noexcept
 {
-    return m_data.empty();
+    m_data.clear();
 }
 
-template <typename T, size_t N> size_t SmallSet<T, N>::size() const noexcept
+template <typename T, size_t N, SmallStorage Storage>
+void SmallSet<T, N, Storage>::insert(T const &value) noexcept
 {
-    return m_data.size();
+    insert_value(value);
 }
 
-template <typename T, size_t N> size_t SmallSet<T, N>::capacity() const noexcept
+template <typename T, size_t N, SmallStorage Storage>
+void SmallSet<T, N, Storage>::insert(T &&value) noexcept
 {
-    return m_data.capacity();
+    insert_value(WHEELS_MOV(value));
 }
 
-template <typename T, size_t N>
-bool SmallSet<T, N>::contains(T const &value) const noexcept
+template <typename T, size_t N, SmallStorage Storage>
+void SmallSet<T, N, Storage>::remove(T const &value) noexcept
 {
-    for (auto const &v : m_data)
+    size_t const index = find_index(value);
+    if (index == m_data.size())
+        return;
+
+    if constexpr (Storage == SmallStorage::Sorted)
+        m_data.erase(index);
+    else
     {
-        if (v == value)
-            return true;
+        std::swap(m_data[index], m_data.back());
+        m_data.pop_back();
     }
-
-    return false;
 }
 
-template <typename T, size_t N> void SmallSet<T, N>::clear() noexcept
+template <typename T, size_t N, SmallStorage Storage>
+size_t SmallSet<T, N, Storage>::find_index(T const &value) const noexcept
 {
-    m_data.clear();
-}
+    size_t const size = m_data.size();
+    if constexpr (Storage == SmallStorage::Sorted)
+    {
+        size_t const index = lower_bound(value);
+        if (index < size && m_data[index] == value)
+            return index;
+    }
+    else if constexpr (SimdSearchable<T>)
+        return find_first_key(m_data.data(), size, value);
+    else
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (m_data[i] == value)
+                return i;
+        }
+    }
 
-template <typename T, size_t N>
-void SmallSet<T, N>::insert(T const &value) noexcept
-{
-    if (contains(value))
-        return;
-    m_data.push_back(value);
+    return size;
 }
 
-template <typename T, size_t N> void SmallSet<T, N>::insert(T &&value) noexcept
+template <typename T, size_t N, SmallStorage Storage>
+size_t SmallSet<T, N, Storage>::lower_bound(T const &value) const noexcept
 {
-    if (contains(value))
-        return;
-    m_data.push_back(WHEELS_FWD(value));
+    return branchless_lower_bound(
+        m_data.data(), m_data.size(), value,
+        [](T const &v) -> T const & { return v; });
 }
 
-template <typename T, size_t N>
-void SmallSet<T, N>::remove(T const &value) noexcept
+template <typename T, size_t N, SmallStorage Storage>
+template <typename U>
+void SmallSet<T, N, Storage>::insert_value(U &&value) noexcept
 {
-    for (auto &v : m_data)
+    if constexpr (Storage == SmallStorage::Sorted)
     {
-        if (v == value)
-        {
-            std::swap(v, m_data.back());
-            m_data.pop_back();
+        size_t const index = lower_bound(value);
+        if (index < m_data.size() && m_data[index] == value)
             return;
-        }
+
+        // value can't point into the set as it would have been found above
+        m_data.emplace(index, WHEELS_FWD(value));
+    }
+    else
+    {
+        if (contains(value))
+            return;
+        m_data.push_back(WHEELS_FWD(value));
     }
 }
 
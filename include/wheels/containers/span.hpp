@@ -4,6 +4,7 @@
 
 #include "../assert.hpp"
 #include "concepts.hpp"
+#include "hash.hpp"
 #include "optional.hpp"
 
 #include <cstddef>
@@ -375,6 +376,19 @@ inline bool operator!=(StrSpan lhs, StrSpan rhs) noexcept
     return !(lhs == rhs);
 }
 
+// Hashes up to the first null to match operator==. This is the same hash as
+// Hash<String> for strings without embedded nulls.
+template <> struct Hash<StrSpan>
+{
+    [[nodiscard]] uint64_t operator()(StrSpan const &value) const noexcept
+    {
+        size_t const len = value.data() == nullptr
+                               ? 0
+                               : strnlen(value.data(), value.size());
+        return wyhash(value.data(), len, 0, _wyp);
+    }
+};
+
 } // namespace wheels
 
 #endif // WHEELS_CONTAINERS_SPAN_HPP
@@ -0,0 +1,264 @@
+#ifndef WHEELS_CONTAINERS_SPSC_QUEUE_HPP
+#define WHEELS_CONTAINERS_SPSC_QUEUE_HPP
+
+#include "../allocators/allocator.hpp"
+#include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+#include "optional.hpp"
+#include "queue_storage.hpp"
+#include "span.hpp"
+
+#include <atomic>
+#include <cstring>
+
+namespace wheels
+{
+
+// Bounded queue for passing values from one producer thread to one consumer
+// thread. Pushes and pops are wait-free and never lock.
+// The producer owns the write index and the consumer the read index, each on
+// its own cache line. Both also keep a cached copy of the other's index and
+// only reload it when the cached one says the queue is full or empty, so
+// neither side touches the other's cache line while there's room to work.
+// The values are stored inline when N is given and allocated from an Allocator
+// when it's 0. The capacity is a power of two.
+
+template <typename T, size_t N = 0> class SpscQueue
+{
+  public:
+    using value_type = T;
+
+    SpscQueue() noexcept
+        requires(N > 0)
+    = default;
+    // capacity is rounded up to a power of two
+    SpscQueue(Allocator &allocator, size_t capacity) noexcept
+        requires(N == 0);
+    // Has to be quiescent when destroyed
+    ~SpscQueue();
+
+    // Indices are atomics
+    SpscQueue(SpscQueue const &other) = delete;
+    SpscQueue(SpscQueue &&other) = delete;
+    SpscQueue &operator=(SpscQueue const &other) = delete;
+    SpscQueue &operator=(SpscQueue &&other) = delete;
+
+    // These are only a snapshot if the producer or the consumer is active
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    // Producer only. Returns false if the queue is full.
+    template <typename U>
+    // Let's be pedantic and disallow implicit conversions
+        requires SameAs<U, T>
+    [[nodiscard]] bool try_push(U &&value) noexcept;
+    template <typename... Args>
+    [[nodiscard]] bool try_emplace(Args &&...args) noexcept;
+    // Producer only. Pushes as many of the values as fit and publishes them
+    // all at once. Returns the number of pushed values.
+    [[nodiscard]] size_t try_push_batch(Span<T const> values) noexcept;
+
+    // Consumer only. Returns an empty Optional if the queue is empty.
+    [[nodiscard]] Optional<T> try_pop() noexcept;
+    // Consumer only. Moves up to dst.size() values into dst and frees their
+    // slots all at once. Returns the number of popped values.
+    [[nodiscard]] size_t try_pop_batch(Span<T> dst) noexcept;
+
+  private:
+    // Avoid false sharing between the producer and the consumer
+    static constexpr size_t s_cache_line_size = 64;
+
+    [[nodiscard]] T *slot(size_t index) noexcept;
+    // Number of slots the producer can write to, reloading the read index if
+    // the cached one leaves less than count
+    [[nodiscard]] size_t free_count(size_t write_index, size_t count) noexcept;
+    // Number of values the consumer can read, reloading the write index if the
+    // cached one leaves less than count
+    [[nodiscard]] size_t ready_count(size_t read_index, size_t count) noexcept;
+
+    QueueStorage<T, N> m_slots;
+
+    // The indices only ever grow and are masked into slots
+    alignas(s_cache_line_size) std::atomic<size_t> m_write_index{0};
+    size_t m_cached_read_index{0};
+
+    alignas(s_cache_line_size) std::atomic<size_t> m_read_index{0};
+    size_t m_cached_write_index{0};
+};
+
+template <typename T, size_t N>
+SpscQueue<T, N>::SpscQueue(Allocator &allocator, size_t capacity) noexcept
+    requires(N == 0)
+: m_slots{allocator, capacity}
+{
+}
+
+template <typename T, size_t N> SpscQueue<T, N>::~SpscQueue()
+{
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        size_t const write_index =
+            m_write_index.load(std::memory_order_acquire);
+        for (size_t i = m_read_index.load(std::memory_order_relaxed);
+             i < write_index; ++i)
+            slot(i)->~T();
+    }
+}
+
+template <typename T, size_t N> bool SpscQueue<T, N>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <typename T, size_t N> size_t SpscQueue<T, N>::size() const noexcept
+{
+    // Load the read index first so that the write index can't be behind it
+    size_t const read_index = m_read_index.load(std::memory_order_acquire);
+    size_t const write_index = m_write_index.load(std::memory_order_acquire);
+    return write_index - read_index;
+}
+
+template <typename T, size_t N>
+size_t SpscQueue<T, N>::capacity() const noexcept
+{
+    return m_slots.capacity();
+}
+
+template <typename T, size_t N>
+template <typename U>
+    requires SameAs<U, T>
+bool SpscQueue<T, N>::try_push(U &&value) noexcept
+{
+    return try_emplace(WHEELS_FWD(value));
+}
+
+template <typename T, size_t N>
+template <typename... Args>
+bool SpscQueue<T, N>::try_emplace(Args &&...args) noexcept
+{
+    size_t const write_index = m_write_index.load(std::memory_order_relaxed);
+    if (free_count(write_index, 1) == 0)
+        return false;
+
+    new (slot(write_index)) T{WHEELS_FWD(args)...};
+    m_write_index.store(write_index + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <typename T, size_t N>
+size_t SpscQueue<T, N>::try_push_batch(Span<T const> values) noexcept
+{
+    size_t const write_index = m_write_index.load(std::memory_order_relaxed);
+    size_t const free = free_count(write_index, values.size());
+    size_t const count = values.size() < free ? values.size() : free;
+    if (count == 0)
+        return 0;
+
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+        // The slots wrap around at most once
+        size_t const begin = write_index & (capacity() - 1);
+        size_t const first_count =
+            count < capacity() - begin ? count : capacity() - begin;
+        memcpy(slot(begin), values.data(), first_count * sizeof(T));
+        memcpy(
+            slot(0), values.data() + first_count,
+            (count - first_count) * sizeof(T));
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            new (slot(write_index + i)) T{values[i]};
+    }
+    m_write_index.store(write_index + count, std::memory_order_release);
+
+    return count;
+}
+
+template <typename T, size_t N> Optional<T> SpscQueue<T, N>::try_pop() noexcept
+{
+    size_t const read_index = m_read_index.load(std::memory_order_relaxed);
+    if (ready_count(read_index, 1) == 0)
+        return Optional<T>{};
+
+    T *value = slot(read_index);
+    Optional<T> ret{WHEELS_MOV(*value)};
+    if constexpr (!std::is_trivially_destructible_v<T>)
+        // Moved from value might still require dtor
+        value->~T();
+    m_read_index.store(read_index + 1, std::memory_order_release);
+
+    return ret;
+}
+
+template <typename T, size_t N>
+size_t SpscQueue<T, N>::try_pop_batch(Span<T> dst) noexcept
+{
+    size_t const read_index = m_read_index.load(std::memory_order_relaxed);
+    size_t const ready = ready_count(read_index, dst.size());
+    size_t const count = dst.size() < ready ? dst.size() : ready;
+    if (count == 0)
+        return 0;
+
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+        // The slots wrap around at most once
+        size_t const begin = read_index & (capacity() - 1);
+        size_t const first_count =
+            count < capacity() - begin ? count : capacity() - begin;
+        memcpy(dst.data(), slot(begin), first_count * sizeof(T));
+        memcpy(
+            dst.data() + first_count, slot(0),
+            (count - first_count) * sizeof(T));
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            T *value = slot(read_index + i);
+            dst[i] = WHEELS_MOV(*value);
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                // Moved from value might still require dtor
+                value->~T();
+        }
+    }
+    m_read_index.store(read_index + count, std::memory_order_release);
+
+    return count;
+}
+
+template <typename T, size_t N> T *SpscQueue<T, N>::slot(size_t index) noexcept
+{
+    return m_slots.data() + (index & (capacity() - 1));
+}
+
+template <typename T, size_t N>
+size_t SpscQueue<T, N>::free_count(size_t write_index, size_t count) noexcept
+{
+    size_t free = capacity() - (write_index - m_cached_read_index);
+    if (free < count)
+    {
+        m_cached_read_index = m_read_index.load(std::memory_order_acquire);
+        free = capacity() - (write_index - m_cached_read_index);
+    }
+    return free;
+}
+
+template <typename T, size_t N>
+size_t SpscQueue<T, N>::ready_count(size_t read_index, size_t count) noexcept
+{
+    size_t ready = m_cached_write_index - read_index;
+    if (ready < count)
+    {
+        m_cached_write_index = m_write_index.load(std::memory_order_acquire);
+        ready = m_cached_write_index - read_index;
+    }
+    return ready;
+}
+
+} // namespace wheels
+
+#endif // WHEELS_CONTAINERS_SPSC_QUEUE_HPP
@@ -4,6 +4,7 @@
 
 #include "../assert.hpp"
 #include "../utils.hpp"
+#include "hash.hpp"
 #include "span.hpp"
 
 #include <cstring>
@@ -288,6 +289,42 @@ constexpr void StaticArray<T, N>::init(T const *src) noexcept
         m_data[i] = src[i];
 }
 
+template <typename T, size_t N>
+[[nodiscard]] bool operator==(
+    StaticArray<T, N> const &lhs, StaticArray<T, N> const &rhs) noexcept
+{
+    return lhs.span() == rhs.span();
+}
+
+template <typename T, size_t N>
+[[nodiscard]] bool operator!=(
+    StaticArray<T, N> const &lhs, StaticArray<T, N> const &rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+// The elements are tightly packed so there's no padding beyond what T has
+template <typename T, size_t N>
+inline constexpr bool byte_hashable<StaticArray<T, N>> = byte_hashable<T>;
+
+template <typename T, size_t N> struct Hash<StaticArray<T, N>>
+{
+    [[nodiscard]] uint64_t operator()(
+        StaticArray<T, N> const &value) const noexcept
+    {
+        if constexpr (byte_hashable<StaticArray<T, N>>)
+            return wyhash(value.data(), N * sizeof(T), 0, _wyp);
+        else
+        {
+            Hash<T> const hasher;
+            uint64_t ret = 0;
+            for (T const &v : value)
+                ret = hash_combine(ret, hasher(v));
+            return ret;
+        }
+    }
+};
+
 } // namespace wheels
 
 #endif // WHEELS_CONTAINERS_STATIC_ARRAY_HPP
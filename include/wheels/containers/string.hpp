@@ -64,6 +64,12 @@ class String
     char pop_back() noexcept;
 
     void resize(size_t size, char ch = '\0') noexcept;
+    // Like resize() but leaves the new characters uninitialized, for buffers
+    // that are written to right after. The final null is still written.
+    void resize_uninitialized(size_t size) noexcept;
+    // Adds count uninitialized characters to the back and returns a span for
+    // filling them in. The final null is written after them.
+    [[nodiscard]] Span<char> append_uninitialized(size_t count) noexcept;
 
     // No operator+ as it returns a new String and reusing the internal
     // allocator would make the lifetime of the new thing ambiguous. Use
@@ -115,6 +121,9 @@ class String
     StrSpan span(size_t begin, size_t end) const noexcept;
 
   private:
+    // Like reserve() but at least doubles the capacity to keep repeated
+    // appends amortized O(1)
+    void grow(size_t capacity) noexcept;
     void reallocate(size_t capacity) noexcept;
     void destroy() noexcept;
 
@@ -124,6 +133,10 @@ class String
     size_t m_size{0};
 };
 
+template <> struct is_trivially_relocatable<String> : std::true_type
+{
+};
+
 inline String::String(Allocator &allocator, size_t initial_capacity) noexcept
 : m_allocator{allocator}
 {
@@ -294,6 +307,26 @@ inline void String::resize(size_t size, char ch) noexcept
     m_data[m_size] = '\0';
 }
 
+inline void String::resize_uninitialized(size_t size) noexcept
+{
+    if (size > m_size)
+        grow(size);
+    m_size = size;
+    m_data[m_size] = '\0';
+}
+
+inline Span<char> String::append_uninitialized(size_t count) noexcept
+{
+    size_t const required_size = m_size + count;
+    grow(required_size);
+
+    Span<char> const ret{m_data + m_size, count};
+    m_size = required_size;
+    m_data[m_size] = '\0';
+
+    return ret;
+}
+
 inline String &String::extend(StrSpan str) noexcept
 {
     reserve(m_size + str.size());
@@ -441,8 +474,30 @@ inline Array<StrSpan> String::split(
     return spans;
 }
 
+inline void String::grow(size_t capacity) noexcept
+{
+    if (capacity + 1 > m_capacity)
+    {
+        size_t const doubled_capacity = m_capacity * 2;
+        reallocate(
+            capacity + 1 > doubled_capacity ? capacity + 1 : doubled_capacity);
+    }
+}
+
 inline void String::reallocate(size_t capacity) noexcept
 {
+    if (m_data != nullptr)
+    {
+        char *data = (char *)m_allocator.reallocate(
+            m_data, capacity * sizeof(char));
+        if (data != nullptr)
+        {
+            m_data = data;
+            m_capacity = capacity;
+            return;
+        }
+    }
+
     char *data = (char *)m_allocator.allocate(capacity * sizeof(char));
     WHEELS_ASSERT(data != nullptr);
 
@@ -2,6 +2,23 @@
 #define WHEELS_CONTAINERS_UTILS_HPP
 
 #include "../assert.hpp"
+#include "../utils.hpp"
+#include "concepts.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define WHEELS_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WHEELS_SIMD_SSE2
+#endif
 
 namespace wheels
 {
@@ -21,6 +38,432 @@ namespace wheels
     return value;
 }
 
+// How clear() resets the table of HashMap and HashSet
+enum class HashClear
+{
+    // Resets the control bytes of the whole table
+    Full,
+    // Keeps a log of the control byte groups that have had values inserted
+    // since the last clear and only resets those. Clearing costs work
+    // proportional to the cleared size instead of the capacity, in exchange
+    // for a check on each insert and capacity / 2 bytes for the log.
+    Tracked,
+    // Full clear that also shrinks the table if it's more than
+    // s_clear_shrink_factor times what the cleared values needed. Keeps
+    // reused tables from staying at the size of a rare spike.
+    Shrink,
+};
+
+// How SmallSet and SmallMap store their values
+enum class SmallStorage
+{
+    // Values are appended and looked up with a linear scan that compares a
+    // SIMD register worth of integral or pointer keys at a time
+    Unsorted,
+    // Values are kept sorted by operator< and looked up with a branchless
+    // binary search. Pays off for larger N in exchange for shifting the values
+    // on insert and remove.
+    Sorted,
+};
+
+// Load policy for HashMap and HashSet. The table grows when inserting would
+// take it over a load of MaxLoadNumerator / MaxLoadDenominator. Capacities are
+// powers of two so growth always doubles.
+// A high max load minimizes the footprint while a lower one shortens the probe
+// sequences, especially for misses.
+template <
+    size_t MaxLoadNumerator, size_t MaxLoadDenominator,
+    HashClear Clear = HashClear::Full>
+struct HashPolicy
+{
+    static_assert(
+        MaxLoadNumerator > 0 && MaxLoadNumerator < MaxLoadDenominator,
+        "Max load has to be in (0, 1)");
+
+    static constexpr size_t s_max_load_numerator = MaxLoadNumerator;
+    static constexpr size_t s_max_load_denominator = MaxLoadDenominator;
+    static constexpr HashClear s_clear = Clear;
+    static constexpr size_t s_clear_shrink_factor = 4;
+    // Smallest capacity that always has at least one Empty slot left to end
+    // the probes, rounded up to a power of two that covers at least one group
+    // of control bytes
+    static constexpr size_t s_min_capacity = []()
+    {
+        size_t capacity = 8;
+        while (capacity * (MaxLoadDenominator - MaxLoadNumerator) <=
+               MaxLoadDenominator)
+            capacity *= 2;
+        return capacity;
+    }();
+
+    [[nodiscard]] static constexpr bool s_over_max_load(
+        size_t size, size_t capacity) noexcept
+    {
+        return MaxLoadDenominator * size > MaxLoadNumerator * capacity;
+    }
+
+    // Returns the smallest capacity that can fit size items without growing
+    [[nodiscard]] static size_t s_capacity_for(size_t size) noexcept
+    {
+        size_t const capacity =
+            (size * MaxLoadDenominator + MaxLoadNumerator - 1) /
+            MaxLoadNumerator;
+        if (capacity <= s_min_capacity)
+            return s_min_capacity;
+        return round_up_power_of_two(capacity);
+    }
+};
+
+// Magic factor from the SwissMap talk, matching the arbitrary offset SSE
+// version as reading one metadata byte at a time is basically the same
+using DefaultHashPolicy = HashPolicy<15, 16>;
+
+// Growth policy for Array. The capacity is multiplied by
+// GrowthNumerator / GrowthDenominator when it runs out, or set to the
+// required capacity if that's more, and never goes below MinCapacity.
+// Smaller factors waste less memory on large arrays at the cost of more
+// reallocations, a larger MinCapacity skips the smallest steps.
+template <
+    size_t GrowthNumerator, size_t GrowthDenominator, size_t MinCapacity = 4>
+struct ArrayGrowth
+{
+    static_assert(
+        GrowthNumerator > GrowthDenominator, "Growth factor has to be over 1");
+    static_assert(MinCapacity > 0);
+
+    // Use the extra capacity from allocators that round requests up
+    static constexpr bool s_use_allocation_slack = false;
+
+    // Returns the capacity to grow to from capacity when required_capacity
+    // elements of element_size bytes don't fit
+    [[nodiscard]] static constexpr size_t grown_capacity(
+        size_t capacity, size_t required_capacity,
+        size_t element_size) noexcept
+    {
+        (void)element_size;
+        size_t ret = capacity * GrowthNumerator / GrowthDenominator;
+        if (ret < required_capacity)
+            ret = required_capacity;
+        if (ret < MinCapacity)
+            ret = MinCapacity;
+        return ret;
+    }
+};
+
+using DefaultArrayGrowth = ArrayGrowth<2, 1>;
+
+// Rounds the capacities of Growth up to whole pages once they reach
+// MinPageCount pages. The OS hands out large allocations in pages so the
+// tail of the last page would be wasted otherwise.
+template <
+    typename Growth = DefaultArrayGrowth, size_t PageSize = 4096,
+    size_t MinPageCount = 16>
+struct PageRoundedGrowth
+{
+    static_assert(std::has_single_bit(PageSize), "Page size should be a pow2");
+
+    static constexpr bool s_use_allocation_slack =
+        Growth::s_use_allocation_slack;
+
+    [[nodiscard]] static constexpr size_t grown_capacity(
+        size_t capacity, size_t required_capacity,
+        size_t element_size) noexcept
+    {
+        size_t const ret = Growth::grown_capacity(
+            capacity, required_capacity, element_size);
+        size_t const byte_count = ret * element_size;
+        if (byte_count < PageSize * MinPageCount)
+            return ret;
+
+        size_t const page_byte_count =
+            (byte_count + PageSize - 1) & ~(PageSize - 1);
+        return page_byte_count / element_size;
+    }
+};
+
+// Makes Array use all of the memory it gets from allocators that round
+// requests up to size classes, like the blocks of TlsfAllocator. Note that
+// the extra capacity also compounds through the growth steps after it.
+template <typename Growth = DefaultArrayGrowth>
+struct SizeClassGrowth : Growth
+{
+    static constexpr bool s_use_allocation_slack = true;
+};
+
+// Types that can be moved to a new address by copying their bytes and ending
+// the lifetime of the source without calling its dtor. Containers relocate
+// these with memcpy or by reallocating their storage instead of moving and
+// destroying each element.
+// Can be specialized for types that aren't trivially copyable but don't point
+// into themselves, like most types that own heap memory.
+template <typename T>
+struct is_trivially_relocatable
+: std::bool_constant<std::is_trivially_copyable_v<T>>
+{
+};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+// Moves the object in src into uninitialized dst, ending the lifetime of src
+template <typename T> void relocate(T *dst, T *src) noexcept
+{
+    if constexpr (is_trivially_relocatable_v<T>)
+        memcpy((void *)dst, (void const *)src, sizeof(T));
+    else
+    {
+        new (dst) T{WHEELS_MOV(*src)};
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            // Moved from value might still require dtor
+            src->~T();
+    }
+}
+
+// Moves count objects from src into uninitialized dst, ending the lifetimes in
+// src. The ranges can't overlap.
+template <typename T>
+void relocate_n(T *dst, T *src, size_t count) noexcept
+{
+    if constexpr (is_trivially_relocatable_v<T>)
+        memcpy((void *)dst, (void const *)src, count * sizeof(T));
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            relocate(dst + i, src + i);
+    }
+}
+
+// Like relocate_n() but the ranges can overlap, as when shifting values
+// within an array. Objects in dst outside src have to be uninitialized.
+template <typename T>
+void relocate_overlapping(T *dst, T *src, size_t count) noexcept
+{
+    if (count == 0 || dst == src)
+        return;
+
+    if constexpr (is_trivially_relocatable_v<T>)
+        memmove((void *)dst, (void const *)src, count * sizeof(T));
+    else if (dst < src)
+    {
+        for (size_t i = 0; i < count; ++i)
+            relocate(dst + i, src + i);
+    }
+    else
+    {
+        // Go from the back so that the sources aren't overwritten before
+        // they are moved
+        for (size_t i = count; i > 0; --i)
+            relocate(dst + i - 1, src + i - 1);
+    }
+}
+
+// Destroys the values for which pred(T const &) returns true and compacts the
+// rest to the front in a single pass, keeping their order. Returns the number
+// of values left.
+template <typename T, typename F>
+[[nodiscard]] size_t remove_values_if(T *data, size_t size, F &&pred) noexcept
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        T const &value = data[i];
+        if (pred(value))
+        {
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                data[i].~T();
+        }
+        else
+        {
+            if (kept != i)
+                relocate(data + kept, data + i);
+            kept++;
+        }
+    }
+    return kept;
+}
+
+// Control bytes of HashMap and HashSet are processed in groups of 8 by loading
+// them as a single word
+constexpr size_t s_ctrl_group_width = sizeof(uint64_t);
+
+// Returns a mask with the high bit of byte i set if slot i in the group
+// starting from metadata is full. Full slots are the only ones with the high
+// bit cleared so this doesn't need to know about the other states.
+// The group can be walked with countr_zero(mask) / 8
+[[nodiscard]] inline uint64_t full_ctrl_mask(uint8_t const *metadata) noexcept
+{
+    static_assert(
+        std::endian::native == std::endian::little,
+        "Group byte order assumes a little endian target");
+
+    uint64_t group;
+    memcpy(&group, metadata, sizeof(group));
+    return ~group & 0x8080'8080'8080'8080;
+}
+
+// Returns true if all slots in the group starting from metadata are Empty
+[[nodiscard]] inline bool empty_ctrl_group(uint8_t const *metadata) noexcept
+{
+    uint64_t group;
+    memcpy(&group, metadata, sizeof(group));
+    return group == 0x8080'8080'8080'8080;
+}
+
+// Returns the first full slot at or after pos or capacity if there isn't one.
+// Skips over the empty and deleted slots a group at a time. Capacity has to be
+// a multiple of the group width.
+[[nodiscard]] inline size_t next_full_ctrl(
+    uint8_t const *metadata, size_t pos, size_t capacity) noexcept
+{
+    WHEELS_ASSERT(capacity % s_ctrl_group_width == 0);
+
+    // Groups are aligned to the group width so that the loads never go past
+    // the end of the metadata
+    size_t group_pos = pos & ~(s_ctrl_group_width - 1);
+    // Mask out the slots before pos in the first group
+    uint64_t const head_mask = ~0ull << ((pos - group_pos) * 8);
+    if (group_pos < capacity)
+    {
+        uint64_t const full_mask =
+            full_ctrl_mask(metadata + group_pos) & head_mask;
+        if (full_mask != 0)
+            return group_pos + (size_t)std::countr_zero(full_mask) / 8;
+        group_pos += s_ctrl_group_width;
+    }
+
+    for (; group_pos < capacity; group_pos += s_ctrl_group_width)
+    {
+        uint64_t const full_mask = full_ctrl_mask(metadata + group_pos);
+        if (full_mask != 0)
+            return group_pos + (size_t)std::countr_zero(full_mask) / 8;
+    }
+
+    return capacity;
+}
+
+// Collapses a mask of matching bytes into one bit at the first byte of each
+// element whose whole key matched
+template <typename K, size_t Stride>
+[[nodiscard]] constexpr uint32_t key_match_mask(uint32_t byte_mask) noexcept
+{
+    if constexpr (sizeof(K) >= 2)
+        byte_mask &= byte_mask >> 1;
+    if constexpr (sizeof(K) >= 4)
+        byte_mask &= byte_mask >> 2;
+    if constexpr (sizeof(K) >= 8)
+        byte_mask &= byte_mask >> 4;
+
+    uint32_t element_starts = 0;
+    for (size_t i = 0; i < 32; i += Stride)
+        element_starts |= 1u << i;
+
+    return byte_mask & element_starts;
+}
+
+// Returns the index of the first element that starts with key or count if
+// there isn't one. Elements are Stride bytes apart so this also works for keys
+// stored in front of their values. The bytes after the key in each element are
+// loaded but ignored.
+template <SimdSearchable K, size_t Stride = sizeof(K)>
+[[nodiscard]] size_t find_first_key(
+    void const *data, size_t count, K key) noexcept
+{
+    static_assert(std::has_single_bit(Stride) && Stride >= sizeof(K));
+    static_assert(Stride <= 8, "SIMD search wants at least two keys per load");
+
+    uint8_t const *bytes = static_cast<uint8_t const *>(data);
+    size_t i = 0;
+
+#if defined(WHEELS_SIMD_AVX2) || defined(WHEELS_SIMD_SSE2)
+    // Each key slot is filled with the key and the byte compare tells which
+    // elements match in full
+    using KeyBits = std::conditional_t<
+        sizeof(K) == 1, uint8_t,
+        std::conditional_t<
+            sizeof(K) == 2, uint16_t,
+            std::conditional_t<sizeof(K) == 4, uint32_t, uint64_t>>>;
+    KeyBits key_bits;
+    memcpy(&key_bits, &key, sizeof(K));
+
+#ifdef WHEELS_SIMD_AVX2
+    constexpr size_t register_width = 32;
+    __m256i needle;
+    if constexpr (sizeof(K) == 1)
+        needle = _mm256_set1_epi8((char)key_bits);
+    else if constexpr (sizeof(K) == 2)
+        needle = _mm256_set1_epi16((short)key_bits);
+    else if constexpr (sizeof(K) == 4)
+        needle = _mm256_set1_epi32((int)key_bits);
+    else
+        needle = _mm256_set1_epi64x((long long)key_bits);
+#else  // !WHEELS_SIMD_AVX2
+    constexpr size_t register_width = 16;
+    __m128i needle;
+    if constexpr (sizeof(K) == 1)
+        needle = _mm_set1_epi8((char)key_bits);
+    else if constexpr (sizeof(K) == 2)
+        needle = _mm_set1_epi16((short)key_bits);
+    else if constexpr (sizeof(K) == 4)
+        needle = _mm_set1_epi32((int)key_bits);
+    else
+        needle = _mm_set1_epi64x((long long)key_bits);
+#endif // WHEELS_SIMD_AVX2
+
+    constexpr size_t elements_per_load = register_width / Stride;
+    for (; i + elements_per_load <= count; i += elements_per_load)
+    {
+#ifdef WHEELS_SIMD_AVX2
+        __m256i const values =
+            _mm256_loadu_si256((__m256i const *)(bytes + i * Stride));
+        uint32_t const byte_mask =
+            (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(values, needle));
+#else  // !WHEELS_SIMD_AVX2
+        __m128i const values =
+            _mm_loadu_si128((__m128i const *)(bytes + i * Stride));
+        uint32_t const byte_mask =
+            (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(values, needle));
+#endif // WHEELS_SIMD_AVX2
+
+        uint32_t const match_mask = key_match_mask<K, Stride>(byte_mask);
+        if (match_mask != 0)
+            return i + (size_t)std::countr_zero(match_mask) / Stride;
+    }
+#endif // WHEELS_SIMD_AVX2 || WHEELS_SIMD_SSE2
+
+    for (; i < count; ++i)
+    {
+        K element_key;
+        memcpy(&element_key, bytes + i * Stride, sizeof(K));
+        if (element_key == key)
+            return i;
+    }
+
+    return count;
+}
+
+// Returns the index of the first value whose key isn't less than key or size if
+// there isn't one. get_key(T const &) returns the key of a value. The loop only
+// depends on size so the compare compiles into a conditional move instead of a
+// hard to predict branch.
+template <typename T, typename K, typename F>
+[[nodiscard]] size_t branchless_lower_bound(
+    T const *data, size_t size, K const &key, F &&get_key) noexcept
+{
+    if (size == 0)
+        return 0;
+
+    T const *base = data;
+    while (size > 1)
+    {
+        size_t const half = size / 2;
+        base = get_key(base[half]) < key ? base + half : base;
+        size -= half;
+    }
+
+    return (size_t)(base - data) + (get_key(*base) < key ? 1 : 0);
+}
+
 } // namespace wheels
 
 #endif // WHEELS_CONTAINERS_UTILS_HPP
@@ -2,6 +2,7 @@
 #define WHEELS_OWNING_PTR_HPP
 
 #include "allocators/allocator.hpp"
+#include "containers/utils.hpp"
 #include "utils.hpp"
 
 #include <cstddef>
@@ -42,6 +43,11 @@ template <typename T> class OwningPtr
     T *_data{nullptr};
 };
 
+template <typename T>
+struct is_trivially_relocatable<OwningPtr<T>> : std::true_type
+{
+};
+
 template <typename T>
 template <typename... Args>
 OwningPtr<T>::OwningPtr(Allocator &alloc, Args &&...args) noexcept
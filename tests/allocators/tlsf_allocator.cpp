@@ -52,6 +52,21 @@ TEST_CASE("TlsfAllocator")
         allocator.deallocate(alloc);
     }
 
+    {
+        // Small allocations get a whole min size block and all of it should
+        // be usable and preserved by reallocate
+        AllocationResult const alloc = allocator.allocate_at_least(16);
+        REQUIRE(alloc.ptr != nullptr);
+        REQUIRE(alloc.num_bytes >= 16);
+        memset(alloc.ptr, 0x12, alloc.num_bytes);
+
+        uint8_t *new_alloc = (uint8_t *)allocator.reallocate(alloc.ptr, 4096);
+        REQUIRE(new_alloc != nullptr);
+        for (size_t i = 0; i < alloc.num_bytes; ++i)
+            REQUIRE(new_alloc[i] == 0x12);
+        allocator.deallocate(new_alloc);
+    }
+
     {
         AlignedObj *aligned_alloc0 =
             (AlignedObj *)allocator.allocate(sizeof(AlignedObj));
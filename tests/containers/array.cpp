@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/allocators/tlsf_allocator.hpp>
 #include <wheels/containers/array.hpp>
 
 #include "common.hpp"
@@ -32,8 +33,42 @@ Array<DtorObj> init_test_arr_dtor(Allocator &allocator, size_t size)
     return arr;
 }
 
+// Owns heap memory so isn't trivially copyable, but nothing points into it
+struct RelocatableObj
+{
+    static uint64_t &s_move_ctor_counter()
+    {
+        static uint64_t counter = 0;
+        return counter;
+    }
+
+    RelocatableObj(uint32_t value)
+    : data{new uint32_t{value}}
+    {
+    }
+
+    ~RelocatableObj() { delete data; }
+
+    RelocatableObj(RelocatableObj const &other) = delete;
+    RelocatableObj(RelocatableObj &&other)
+    : data{other.data}
+    {
+        other.data = nullptr;
+        s_move_ctor_counter()++;
+    }
+    RelocatableObj &operator=(RelocatableObj const &other) = delete;
+    RelocatableObj &operator=(RelocatableObj &&other) = delete;
+
+    uint32_t *data{nullptr};
+};
+
 } // namespace
 
+template <>
+struct wheels::is_trivially_relocatable<RelocatableObj> : std::true_type
+{
+};
+
 TEST_CASE("Array::allocate_copy")
 {
     CstdlibAllocator allocator;
@@ -106,13 +141,173 @@ TEST_CASE("Array::reserve")
     REQUIRE(arr.size() == 1);
     REQUIRE(arr.capacity() == 1);
     REQUIRE(arr[0] == 10);
-    uint32_t *initial_data = arr.data();
 
     arr.reserve(10);
     REQUIRE(arr.size() == 1);
     REQUIRE(arr.capacity() == 10);
     REQUIRE(arr[0] == 10);
-    REQUIRE(initial_data != arr.data());
+}
+
+TEST_CASE("Array::reallocate")
+{
+    { // Trivially relocatable values should grow through reallocate
+        CountingAllocator allocator{true};
+        Array<uint32_t> arr{allocator};
+        for (uint32_t i = 0; i < 100; ++i)
+            arr.push_back(i);
+        REQUIRE(allocator.allocation_count == 1);
+        REQUIRE(allocator.reallocation_count > 0);
+        for (uint32_t i = 0; i < 100; ++i)
+            REQUIRE(arr[i] == i);
+    }
+
+    { // Allocators without reallocate should fall back to a new allocation
+        CountingAllocator allocator{false};
+        Array<uint32_t> arr{allocator, 1};
+        arr.push_back(10u);
+        uint32_t *initial_data = arr.data();
+
+        arr.reserve(10);
+        REQUIRE(allocator.allocation_count == 2);
+        REQUIRE(allocator.reallocation_count == 0);
+        REQUIRE(arr[0] == 10);
+        REQUIRE(initial_data != arr.data());
+    }
+
+    { // Specialized types should be relocated without moves or dtors
+        CountingAllocator allocator{true};
+        RelocatableObj::s_move_ctor_counter() = 0;
+        Array<RelocatableObj> arr{allocator};
+        for (uint32_t i = 0; i < 100; ++i)
+            arr.emplace_back(i);
+        REQUIRE(allocator.allocation_count == 1);
+        REQUIRE(allocator.reallocation_count > 0);
+        REQUIRE(RelocatableObj::s_move_ctor_counter() == 0);
+        for (uint32_t i = 0; i < 100; ++i)
+            REQUIRE(*arr[i].data == i);
+    }
+
+    { // Other types should still be moved into a new allocation
+        CountingAllocator allocator{true};
+        init_dtor_counters();
+        {
+            Array<DtorObj> arr{allocator};
+            for (uint32_t i = 0; i < 100; ++i)
+                arr.emplace_back(i);
+            REQUIRE(allocator.allocation_count > 1);
+            REQUIRE(allocator.reallocation_count == 0);
+            REQUIRE(DtorObj::s_move_ctor_counter() > 0);
+        }
+        REQUIRE(
+            DtorObj::s_ctor_counter() ==
+            DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+    }
+}
+
+TEST_CASE("Array::growth")
+{
+    CstdlibAllocator allocator;
+
+    { // Default policy should double from 4
+        Array<uint32_t> arr{allocator};
+        arr.push_back(0u);
+        REQUIRE(arr.capacity() == 4);
+        for (uint32_t i = 1; i < 5; ++i)
+            arr.push_back(i);
+        REQUIRE(arr.capacity() == 8);
+        // Extending past the doubled capacity should go straight to the
+        // required one
+        uint32_t const values[20]{};
+        arr.extend(Span<uint32_t const>{values, 20});
+        REQUIRE(arr.capacity() == 25);
+    }
+
+    { // Custom factor and min capacity
+        Array<uint32_t, ArrayGrowth<3, 2, 16>> arr{allocator};
+        arr.push_back(0u);
+        REQUIRE(arr.capacity() == 16);
+        for (uint32_t i = 1; i < 17; ++i)
+            arr.push_back(i);
+        REQUIRE(arr.capacity() == 24);
+        for (uint32_t i = 17; i < 25; ++i)
+            arr.push_back(i);
+        REQUIRE(arr.capacity() == 36);
+        for (uint32_t i = 0; i < 25; ++i)
+            REQUIRE(arr[i] == i);
+    }
+
+    { // Large buffers should be rounded up to whole pages
+        using Growth = PageRoundedGrowth<ArrayGrowth<3, 2>, 4096, 4>;
+        Array<uint32_t, Growth> arr{allocator, 3000};
+        arr.resize(3000);
+        REQUIRE(arr.capacity() == 3000);
+        arr.push_back(0u);
+        // 4500 * 4 bytes rounded up to 5 pages
+        REQUIRE(arr.capacity() == 5 * 1024);
+
+        // Small ones are left alone
+        Array<uint32_t, Growth> small_arr{allocator};
+        small_arr.push_back(0u);
+        REQUIRE(small_arr.capacity() == 4);
+    }
+
+    { // Allocator slack should be used when the policy allows it
+        TlsfAllocator tlsf{megabytes(1)};
+        {
+            Array<uint32_t, SizeClassGrowth<>> arr{tlsf};
+            arr.push_back(0u);
+            size_t const capacity = arr.capacity();
+            REQUIRE(capacity > 4);
+            for (uint32_t i = 1; i < capacity; ++i)
+                arr.push_back(i);
+            REQUIRE(arr.capacity() == capacity);
+            arr.push_back((uint32_t)capacity);
+            REQUIRE(arr.capacity() >= capacity * 2);
+            for (uint32_t i = 0; i <= capacity; ++i)
+                REQUIRE(arr[i] == i);
+        }
+        {
+            Array<uint32_t> arr{tlsf};
+            arr.push_back(0u);
+            REQUIRE(arr.capacity() == 4);
+        }
+    }
+}
+
+TEST_CASE("Array::shrink_to_fit")
+{
+    CountingAllocator allocator{false};
+
+    init_dtor_counters();
+    {
+        Array<DtorObj> arr = init_test_arr_dtor(allocator, 5);
+        arr.reserve(100);
+        REQUIRE(arr.capacity() == 100);
+
+        arr.shrink_to_fit();
+        REQUIRE(arr.capacity() == 5);
+        REQUIRE(arr.size() == 5);
+        for (uint32_t i = 0; i < 5; ++i)
+            REQUIRE(arr[i].data == 10 * (i + 1));
+
+        // No-op when already tight
+        size_t const allocation_count = allocator.allocation_count;
+        arr.shrink_to_fit();
+        REQUIRE(allocator.allocation_count == allocation_count);
+
+        // Empty arrays should release their memory
+        arr.clear();
+        arr.shrink_to_fit();
+        REQUIRE(arr.capacity() == 0);
+        REQUIRE(arr.data() == nullptr);
+
+        arr.emplace_back(1u);
+        REQUIRE(arr.size() == 1);
+        REQUIRE(arr[0].data == 1);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
 }
 
 TEST_CASE("Array::front_back")
@@ -291,6 +486,121 @@ TEST_CASE("Array::erase")
     }
 }
 
+TEST_CASE("Array::insert")
+{
+    CstdlibAllocator allocator;
+
+    {
+        auto arr = init_test_arr_u32(allocator, 3);
+        uint32_t const values[]{1, 2, 3};
+        // Middle
+        arr.insert(1, Span<uint32_t const>{values, 3});
+        REQUIRE(arr.size() == 6);
+        uint32_t const expected0[]{10, 1, 2, 3, 20, 30};
+        for (size_t i = 0; i < 6; ++i)
+            REQUIRE(arr[i] == expected0[i]);
+        // Front and back
+        arr.insert(0, Span<uint32_t const>{values, 1});
+        arr.insert(arr.size(), Span<uint32_t const>{values + 2, 1});
+        uint32_t const expected1[]{1, 10, 1, 2, 3, 20, 30, 3};
+        REQUIRE(arr.size() == 8);
+        for (size_t i = 0; i < 8; ++i)
+            REQUIRE(arr[i] == expected1[i]);
+        // Empty
+        arr.insert(4, Span<uint32_t const>{values, 0});
+        REQUIRE(arr.size() == 8);
+    }
+
+    init_dtor_counters();
+    {
+        auto arr = init_test_arr_dtor(allocator, 3);
+        DtorObj const values[]{DtorObj{1}, DtorObj{2}};
+        arr.insert(2, Span<DtorObj const>{values, 2});
+        REQUIRE(arr.size() == 5);
+        uint32_t const expected[]{10, 20, 1, 2, 30};
+        for (size_t i = 0; i < 5; ++i)
+            REQUIRE(arr[i].data == expected[i]);
+        REQUIRE(DtorObj::s_copy_ctor_counter() == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("Array::erase_range")
+{
+    CstdlibAllocator allocator;
+
+    {
+        auto arr = init_test_arr_u32(allocator, 3);
+        arr.erase(1, 2);
+        REQUIRE(arr.size() == 2);
+        REQUIRE(arr[0] == 10);
+        REQUIRE(arr[1] == 30);
+        arr.erase(1, 1);
+        REQUIRE(arr.size() == 2);
+        arr.erase(0, 2);
+        REQUIRE(arr.empty());
+    }
+
+    init_dtor_counters();
+    {
+        auto arr = init_test_arr_dtor(allocator, 3);
+        arr.erase(0, 2);
+        REQUIRE(arr.size() == 1);
+        REQUIRE(arr[0].data == 30);
+        REQUIRE(DtorObj::s_dtor_counter() == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("Array::erase_if")
+{
+    CstdlibAllocator allocator;
+
+    {
+        auto arr = init_test_arr_u32(allocator, 3);
+        uint32_t const values[]{1, 2, 3, 4, 5};
+        arr.insert(3, Span<uint32_t const>{values, 5});
+
+        // Stable compaction of everything that's left
+        size_t const removed_count =
+            arr.erase_if([](uint32_t const &v) { return v % 2 == 0; });
+        REQUIRE(removed_count == 5);
+        uint32_t const expected[]{1, 3, 5};
+        REQUIRE(arr.size() == 3);
+        for (size_t i = 0; i < 3; ++i)
+            REQUIRE(arr[i] == expected[i]);
+
+        REQUIRE(arr.retain([](uint32_t const &v) { return v > 1; }) == 1);
+        REQUIRE(arr.size() == 2);
+        REQUIRE(arr[0] == 3);
+        REQUIRE(arr[1] == 5);
+
+        REQUIRE(arr.erase_if([](uint32_t const &) { return false; }) == 0);
+        REQUIRE(arr.size() == 2);
+    }
+
+    init_dtor_counters();
+    {
+        auto arr = init_test_arr_dtor(allocator, 3);
+        size_t const removed_count =
+            arr.erase_if([](DtorObj const &v) { return v.data == 10; });
+        REQUIRE(removed_count == 1);
+        REQUIRE(arr.size() == 2);
+        REQUIRE(arr[0].data == 20);
+        REQUIRE(arr[1].data == 30);
+        REQUIRE(DtorObj::s_dtor_counter() == 1);
+        // Moves within the array shouldn't copy
+        REQUIRE(DtorObj::s_copy_ctor_counter() == 0);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
 TEST_CASE("Array::erase_swap_last")
 {
     {
@@ -397,6 +707,58 @@ TEST_CASE("Array::resize")
         DtorObj::s_ctor_counter() - DtorObj::s_move_ctor_counter());
 }
 
+TEST_CASE("Array::resize_uninitialized")
+{
+    CountingAllocator allocator{false};
+
+    Array<uint32_t> arr{allocator};
+    arr.push_back(1u);
+    arr.push_back(2u);
+
+    arr.resize_uninitialized(100);
+    REQUIRE(arr.size() == 100);
+    REQUIRE(arr.capacity() >= 100);
+    REQUIRE(arr[0] == 1);
+    REQUIRE(arr[1] == 2);
+    for (uint32_t i = 2; i < 100; ++i)
+        arr[i] = i + 1;
+
+    // Growing a bit past capacity should still be amortized
+    size_t const capacity = arr.capacity();
+    arr.resize_uninitialized(capacity + 1);
+    REQUIRE(arr.capacity() >= capacity * 2);
+    REQUIRE(allocator.allocation_count == 3);
+    for (uint32_t i = 0; i < 100; ++i)
+        REQUIRE(arr[i] == i + 1);
+
+    arr.resize_uninitialized(5);
+    REQUIRE(arr.size() == 5);
+    REQUIRE(arr.capacity() >= capacity * 2);
+    REQUIRE(arr[4] == 5);
+}
+
+TEST_CASE("Array::append_uninitialized")
+{
+    CountingAllocator allocator{false};
+
+    Array<uint32_t> arr{allocator};
+    arr.push_back(1u);
+
+    Span<uint32_t> span = arr.append_uninitialized(10);
+    REQUIRE(span.size() == 10);
+    REQUIRE(span.data() == arr.data() + 1);
+    REQUIRE(arr.size() == 11);
+    for (uint32_t i = 0; i < 10; ++i)
+        span[i] = i + 2;
+
+    span = arr.append_uninitialized(0);
+    REQUIRE(span.empty());
+    REQUIRE(arr.size() == 11);
+
+    for (uint32_t i = 0; i < 11; ++i)
+        REQUIRE(arr[i] == i + 1);
+}
+
 TEST_CASE("Array::range_for")
 {
     CstdlibAllocator allocator;
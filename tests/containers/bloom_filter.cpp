@@ -0,0 +1,137 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/bloom_filter.hpp>
+
+#include "common.hpp"
+
+using namespace wheels;
+
+TEST_CASE("BloomFilter::insert_contains")
+{
+    CstdlibAllocator allocator;
+
+    BloomFilter<uint32_t> filter{allocator, 10000};
+    REQUIRE(filter.block_count() > 0);
+    REQUIRE(filter.bit_count() >= 10000 * 12);
+    REQUIRE(!filter.maybe_contains(0));
+
+    for (uint32_t i = 0; i < 10000; ++i)
+        filter.insert(2 * i);
+
+    // No false negatives
+    for (uint32_t i = 0; i < 10000; ++i)
+        REQUIRE(filter.maybe_contains(2 * i));
+
+    // Few false positives, ~0.5% expected
+    uint32_t false_positives = 0;
+    for (uint32_t i = 0; i < 10000; ++i)
+    {
+        if (filter.maybe_contains(2 * i + 1))
+            false_positives++;
+    }
+    REQUIRE(false_positives < 200);
+
+    filter.clear();
+    for (uint32_t i = 0; i < 10000; ++i)
+        REQUIRE(!filter.maybe_contains(2 * i));
+
+    BloomFilter<uint32_t> filter_move_constructed{WHEELS_MOV(filter)};
+    filter_move_constructed.insert(1u);
+    REQUIRE(filter_move_constructed.maybe_contains(1));
+
+    BloomFilter<uint32_t> filter_move_assigned{allocator, 1};
+    filter_move_assigned = WHEELS_MOV(filter_move_constructed);
+    filter_move_assigned = WHEELS_MOV(filter_move_assigned);
+    REQUIRE(filter_move_assigned.maybe_contains(1));
+}
+
+TEST_CASE("BloomFilter::batch")
+{
+    CstdlibAllocator allocator;
+
+    // Not a multiple of the batch size
+    Array<uint32_t> values{allocator};
+    for (uint32_t i = 0; i < 1001; ++i)
+        values.push_back(3 * i);
+
+    BloomFilter<uint32_t> filter{allocator, values.size()};
+    filter.insert(values);
+    BloomFilter<uint32_t> single_filter{allocator, values.size()};
+    for (uint32_t v : values)
+        single_filter.insert(v);
+
+    Array<bool> results{allocator};
+    results.resize(values.size());
+    filter.maybe_contains(values, results.mut_span());
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        REQUIRE(results[i]);
+        REQUIRE(single_filter.maybe_contains(values[i]));
+    }
+
+    Array<uint32_t> misses{allocator};
+    for (uint32_t i = 0; i < 1001; ++i)
+        misses.push_back(3 * i + 1);
+    filter.maybe_contains(misses, results.mut_span());
+    for (size_t i = 0; i < misses.size(); ++i)
+        REQUIRE(results[i] == single_filter.maybe_contains(misses[i]));
+}
+
+TEST_CASE("BloomFilter::merge")
+{
+    CstdlibAllocator allocator;
+
+    BloomFilter<uint32_t> evens{allocator, 1000};
+    BloomFilter<uint32_t> odds{allocator, 1000};
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        if (i % 2 == 0)
+            evens.insert(i);
+        else
+            odds.insert(i);
+    }
+
+    evens.merge(odds);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        REQUIRE(evens.maybe_contains(i));
+        if (i % 2 == 1)
+            REQUIRE(odds.maybe_contains(i));
+    }
+}
+
+TEST_CASE("BloomFilter::serialize")
+{
+    CstdlibAllocator allocator;
+
+    BloomFilter<DtorObj, DtorHash> filter{allocator, 1000, 16};
+    for (uint32_t i = 0; i < 1000; ++i)
+        filter.insert(DtorObj{i});
+
+    Array<uint8_t> const data = filter.serialize(allocator);
+    Optional<BloomFilter<DtorObj, DtorHash>> const loaded =
+        BloomFilter<DtorObj, DtorHash>::deserialize(allocator, data.span());
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->block_count() == filter.block_count());
+    for (uint32_t i = 0; i < 2000; ++i)
+        REQUIRE(
+            loaded->maybe_contains(DtorObj{i}) ==
+            filter.maybe_contains(DtorObj{i}));
+
+    // Truncated
+    REQUIRE(!BloomFilter<DtorObj, DtorHash>::deserialize(
+                 allocator, Span<uint8_t const>{data.data(), data.size() - 1})
+                 .has_value());
+    REQUIRE(!BloomFilter<DtorObj, DtorHash>::deserialize(
+                 allocator, Span<uint8_t const>{data.data(), 4})
+                 .has_value());
+
+    // Corrupted magic
+    Array<uint8_t> corrupted{allocator, data.size()};
+    corrupted.extend(data.span());
+    corrupted[0] ^= 0xFF;
+    REQUIRE(!BloomFilter<DtorObj, DtorHash>::deserialize(
+                 allocator, corrupted.span())
+                 .has_value());
+}
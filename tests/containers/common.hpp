@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <wheels/allocators/cstdlib_allocator.hpp>
 #include <wyhash.h>
 
 struct alignas(std::max_align_t) AlignedObj
@@ -214,6 +215,11 @@ inline bool operator==(DtorObj const &lhs, DtorObj const &rhs)
     return lhs.data == rhs.data;
 }
 
+inline bool operator<(DtorObj const &lhs, DtorObj const &rhs)
+{
+    return lhs.data < rhs.data;
+}
+
 struct DtorHash
 {
     /// Delete implementation for types that don't specifically override
@@ -224,4 +230,57 @@ struct DtorHash
     }
 };
 
+struct CountedHash
+{
+    static uint64_t &s_call_counter()
+    {
+        static uint64_t counter = 0;
+        return counter;
+    }
+
+    uint64_t operator()(uint32_t const &value) const noexcept
+    {
+        s_call_counter()++;
+        return wyhash(&value, sizeof(value), 0, _wyp);
+    }
+};
+
+// Forwards to CstdlibAllocator, optionally without reallocation support, and
+// counts the calls
+class CountingAllocator : public wheels::Allocator
+{
+  public:
+    CountingAllocator(bool supports_reallocate) noexcept
+    : m_supports_reallocate{supports_reallocate}
+    {
+    }
+
+    [[nodiscard]] virtual void *allocate(size_t num_bytes) noexcept override
+    {
+        allocation_count++;
+        return m_allocator.allocate(num_bytes);
+    }
+
+    [[nodiscard]] virtual void *reallocate(
+        void *ptr, size_t num_bytes) noexcept override
+    {
+        if (!m_supports_reallocate)
+            return nullptr;
+        reallocation_count++;
+        return m_allocator.reallocate(ptr, num_bytes);
+    }
+
+    virtual void deallocate(void *ptr) noexcept override
+    {
+        m_allocator.deallocate(ptr);
+    }
+
+    size_t allocation_count{0};
+    size_t reallocation_count{0};
+
+  private:
+    wheels::CstdlibAllocator m_allocator;
+    bool m_supports_reallocate{false};
+};
+
 #endif // WHEELS_TESTS_CONTAINERS_COMMON_HPP
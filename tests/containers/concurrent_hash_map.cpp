@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/array.hpp>
+#include <wheels/containers/concurrent_hash_map.hpp>
+
+#include "common.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace wheels;
+
+TEST_CASE("ConcurrentHashMap::insert_find_remove")
+{
+    CstdlibAllocator allocator;
+
+    ConcurrentHashMap<uint32_t, uint32_t> map{allocator};
+    REQUIRE(map.empty());
+    REQUIRE(map.size() == 0);
+    REQUIRE(!map.contains(10));
+    REQUIRE(!map.find(10).has_value());
+
+    map.insert_or_assign(10u, 11u);
+    map.insert_or_assign(20u, 21u);
+    map.insert_or_assign(30u, 31u);
+    REQUIRE(!map.empty());
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.contains(10));
+    REQUIRE(*map.find(10) == 11);
+    REQUIRE(*map.find(20) == 21);
+    REQUIRE(*map.find(30) == 31);
+    REQUIRE(!map.find(40).has_value());
+
+    map.insert_or_assign(20u, 22u);
+    REQUIRE(map.size() == 3);
+    REQUIRE(*map.find(20) == 22);
+
+    uint32_t visited = 0;
+    REQUIRE(map.visit(30, [&](uint32_t const &v) { visited = v; }));
+    REQUIRE(visited == 31);
+    REQUIRE(!map.visit(40, [&](uint32_t const &) { visited = 0; }));
+    REQUIRE(visited == 31);
+
+    map.remove(10);
+    REQUIRE(map.size() == 2);
+    REQUIRE(!map.contains(10));
+    map.remove(10);
+    REQUIRE(map.size() == 2);
+
+    uint32_t key_sum = 0;
+    uint32_t value_sum = 0;
+    map.for_each(
+        [&](uint32_t const &k, uint32_t const &v)
+        {
+            key_sum += k;
+            value_sum += v;
+        });
+    REQUIRE(key_sum == 50);
+    REQUIRE(value_sum == 53);
+
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(!map.contains(20));
+}
+
+TEST_CASE("ConcurrentHashMap::dtor")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        ConcurrentHashMap<DtorObj, DtorObj, DtorHash, 4> map{allocator, 16};
+        for (uint32_t i = 0; i < 100; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+        REQUIRE(map.size() == 100);
+        REQUIRE(map.find(DtorObj{50})->data == 51);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("ConcurrentHashMap::threads")
+{
+    CstdlibAllocator allocator;
+
+    ConcurrentHashMap<uint32_t, uint32_t> map{allocator};
+
+    uint32_t const thread_count = 4;
+    uint32_t const per_thread_count = 10'000;
+    std::atomic<uint32_t> missing_count{0};
+    std::atomic<uint32_t> wrong_count{0};
+
+    {
+        Array<std::thread> threads{allocator, thread_count};
+        for (uint32_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back(
+                [&, t]()
+                {
+                    uint32_t const begin = t * per_thread_count;
+                    for (uint32_t i = begin; i < begin + per_thread_count; ++i)
+                    {
+                        map.insert_or_assign(i, i * 2);
+                        // Read back own writes and whatever the others have
+                        // written so far
+                        Optional<uint32_t> const own = map.find(i);
+                        if (!own.has_value())
+                            missing_count++;
+                        uint32_t const other =
+                            (i + per_thread_count) %
+                            (thread_count * per_thread_count);
+                        Optional<uint32_t> const other_value = map.find(other);
+                        if (other_value.has_value() &&
+                            *other_value != other * 2)
+                            wrong_count++;
+                    }
+                    for (uint32_t i = begin; i < begin + per_thread_count;
+                         i += 2)
+                        map.remove(i);
+                });
+        }
+        for (std::thread &t : threads)
+            t.join();
+    }
+
+    REQUIRE(missing_count == 0);
+    REQUIRE(wrong_count == 0);
+    REQUIRE(map.size() == thread_count * per_thread_count / 2);
+    for (uint32_t i = 0; i < thread_count * per_thread_count; ++i)
+    {
+        if (i % 2 == 0)
+            REQUIRE(!map.contains(i));
+        else
+            REQUIRE(*map.find(i) == i * 2);
+    }
+}
@@ -0,0 +1,201 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/dense_hash_map.hpp>
+
+#include "common.hpp"
+
+#include <cstring>
+
+using namespace wheels;
+
+TEST_CASE("DenseHashMap::allocate_copy")
+{
+    CstdlibAllocator allocator;
+
+    { // Initial capacity should be allocated, potentially rounded up
+        size_t const cap = 8;
+        DenseHashMap<uint32_t, uint16_t> map{allocator, cap};
+        REQUIRE(map.empty());
+        REQUIRE(map.size() == 0);
+        REQUIRE(map.capacity() >= cap);
+    }
+
+    DenseHashMap<uint32_t, uint16_t> map{allocator};
+    REQUIRE(map.empty());
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.capacity() == 0);
+    REQUIRE(map.find(0) == nullptr);
+    REQUIRE(map.begin() == map.end());
+
+    DenseHashMap<uint32_t, uint16_t> const &const_map = map;
+    REQUIRE(const_map.find(0) == nullptr);
+
+    map.insert_or_assign(10u, (uint16_t)11);
+    map.insert_or_assign(20u, (uint16_t)21);
+    map.insert_or_assign(30u, (uint16_t)31);
+    REQUIRE(!map.empty());
+    REQUIRE(map.size() == 3);
+
+    REQUIRE(map.contains(10));
+    REQUIRE(map.contains(20));
+    REQUIRE(map.contains(30));
+    REQUIRE(!map.contains(40));
+    REQUIRE(*map.find(10) == 11);
+    REQUIRE(*const_map.find(20) == 21);
+    REQUIRE(*map.find(30) == 31);
+    REQUIRE(map.find(40) == nullptr);
+
+    DenseHashMap<uint32_t, uint16_t> map_move_constructed{WHEELS_MOV(map)};
+    REQUIRE(*map_move_constructed.find(10) == 11);
+    REQUIRE(*map_move_constructed.find(20) == 21);
+    REQUIRE(*map_move_constructed.find(30) == 31);
+    REQUIRE(map_move_constructed.size() == 3);
+
+    DenseHashMap<uint32_t, uint16_t> map_move_assigned{allocator};
+    map_move_assigned = WHEELS_MOV(map_move_constructed);
+    map_move_assigned = WHEELS_MOV(map_move_assigned);
+    REQUIRE(*map_move_assigned.find(10) == 11);
+    REQUIRE(*map_move_assigned.find(20) == 21);
+    REQUIRE(*map_move_assigned.find(30) == 31);
+    REQUIRE(map_move_assigned.size() == 3);
+}
+
+TEST_CASE("DenseHashMap::insertion_order")
+{
+    CstdlibAllocator allocator;
+
+    DenseHashMap<uint32_t, uint32_t> map{allocator};
+    for (uint32_t i = 0; i < 100; ++i)
+        map.insert_or_assign(100 - i, i);
+    // Assigning shouldn't move the entry
+    map.insert_or_assign(50u, 1000u);
+
+    REQUIRE(map.keys().size() == 100);
+    REQUIRE(map.values().size() == 100);
+    uint32_t i = 0;
+    for (auto const kv : map)
+    {
+        REQUIRE(*kv.first == 100 - i);
+        REQUIRE(map.keys()[i] == 100 - i);
+        if (*kv.first == 50)
+            REQUIRE(*kv.second == 1000);
+        else
+            REQUIRE(*kv.second == i);
+        i++;
+    }
+    REQUIRE(i == 100);
+
+    for (uint32_t &v : map.mut_values())
+        v += 1;
+    for (auto kv : map)
+        *kv.second -= 1;
+    DenseHashMap<uint32_t, uint32_t> const &const_map = map;
+    i = 0;
+    for (auto const kv : const_map)
+    {
+        REQUIRE(const_map.values()[i] == *kv.second);
+        i++;
+    }
+    REQUIRE(*map.find(50) == 1000);
+    REQUIRE(*map.find(100) == 0);
+}
+
+TEST_CASE("DenseHashMap::remove")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        DenseHashMap<DtorObj, DtorObj, DtorHash> map{allocator};
+        for (uint32_t i = 0; i < 10; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+
+        // The last entry should be moved into the removed slot
+        map.remove(DtorObj{3});
+        REQUIRE(map.size() == 9);
+        REQUIRE(!map.contains(DtorObj{3}));
+        REQUIRE(map.keys()[3].data == 9);
+        REQUIRE(map.values()[3].data == 10);
+        REQUIRE(map.find(DtorObj{9})->data == 10);
+
+        // Removing the last entry
+        map.remove(DtorObj{8});
+        REQUIRE(map.size() == 8);
+        REQUIRE(!map.contains(DtorObj{8}));
+        REQUIRE(map.keys().size() == 8);
+
+        // Missing key
+        map.remove(DtorObj{8});
+        REQUIRE(map.size() == 8);
+
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            if (i == 3 || i == 8)
+                REQUIRE(!map.contains(DtorObj{i}));
+            else
+                REQUIRE(map.find(DtorObj{i})->data == i + 1);
+        }
+
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE(map.find(DtorObj{0}) == nullptr);
+        REQUIRE(
+            DtorObj::s_ctor_counter() ==
+            DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+
+        map.insert_or_assign(DtorObj{3}, DtorObj{4});
+        REQUIRE(map.find(DtorObj{3})->data == 4);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("DenseHashMap::churn")
+{
+    CstdlibAllocator allocator;
+
+    // Removals interleaved with inserts leave Deleted slots in the index
+    // table, which shouldn't make the map lose or duplicate keys or grow
+    // without bounds
+    DenseHashMap<uint32_t, uint32_t> map{allocator};
+    // Keys missing from the map are marked with 0xFFFFFFFF
+    uint32_t reference[256];
+    memset(reference, 0xFF, sizeof(reference));
+    size_t reference_size = 0;
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        state = state * 1664525 + 1013904223;
+        uint32_t const key = (state >> 8) % 256;
+        if ((state >> 4) % 3 == 0)
+        {
+            map.remove(key);
+            if (reference[key] != 0xFFFF'FFFF)
+                reference_size--;
+            reference[key] = 0xFFFF'FFFF;
+        }
+        else
+        {
+            map.insert_or_assign(key, i);
+            if (reference[key] == 0xFFFF'FFFF)
+                reference_size++;
+            reference[key] = i;
+        }
+        REQUIRE(map.size() == reference_size);
+    }
+    REQUIRE(map.capacity() <= 512);
+
+    for (uint32_t key = 0; key < 256; ++key)
+    {
+        uint32_t const *value = map.find(key);
+        if (reference[key] == 0xFFFF'FFFF)
+            REQUIRE(value == nullptr);
+        else
+        {
+            REQUIRE(value != nullptr);
+            REQUIRE(*value == reference[key]);
+        }
+    }
+}
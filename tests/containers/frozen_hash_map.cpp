@@ -0,0 +1,184 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/frozen_hash_map.hpp>
+
+#include "common.hpp"
+
+using namespace wheels;
+
+TEST_CASE("FrozenHashMap::freeze_view")
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint64_t> map{allocator};
+    for (uint32_t i = 0; i < 1000; ++i)
+        map.insert_or_assign(3 * i, (uint64_t)i << 32);
+    // Removed keys shouldn't make it into the frozen map
+    for (uint32_t i = 0; i < 1000; i += 10)
+        map.remove(3 * i);
+
+    Array<uint8_t> const data =
+        FrozenHashMap<uint32_t, uint64_t>::freeze(allocator, map);
+    Optional<FrozenHashMap<uint32_t, uint64_t>> const frozen =
+        FrozenHashMap<uint32_t, uint64_t>::view(data.span());
+    REQUIRE(frozen.has_value());
+    REQUIRE(!frozen->empty());
+    REQUIRE(frozen->size() == map.size());
+    // Should be packed tighter than the map
+    REQUIRE(frozen->capacity() <= map.capacity());
+    REQUIRE(frozen->capacity() * 7 <= frozen->size() * 8 + 7);
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        uint64_t const *value = frozen->find(3 * i);
+        if (i % 10 == 0)
+        {
+            REQUIRE(value == nullptr);
+            REQUIRE(!frozen->contains(3 * i));
+        }
+        else
+        {
+            REQUIRE(value != nullptr);
+            REQUIRE(*value == (uint64_t)i << 32);
+            REQUIRE(frozen->contains(3 * i));
+        }
+        REQUIRE(frozen->find(3 * i + 1) == nullptr);
+    }
+
+    size_t visited = 0;
+    frozen->for_each(
+        [&](uint32_t const &key, uint64_t const &value)
+        {
+            REQUIRE(map.find(key) != nullptr);
+            REQUIRE(*map.find(key) == value);
+            visited++;
+        });
+    REQUIRE(visited == map.size());
+
+    // The buffer should be usable as is after a trip through a file or mmap,
+    // modeled here with a copy into a different allocation
+    Array<uint8_t> loaded{allocator, data.size()};
+    loaded.extend(data.span());
+    Optional<FrozenHashMap<uint32_t, uint64_t>> const loaded_frozen =
+        FrozenHashMap<uint32_t, uint64_t>::view(loaded.span());
+    REQUIRE(loaded_frozen.has_value());
+    REQUIRE(loaded_frozen->size() == map.size());
+    for (auto const kv : map)
+    {
+        uint64_t const *value = loaded_frozen->find(*kv.first);
+        REQUIRE(value != nullptr);
+        REQUIRE(*value == *kv.second);
+    }
+
+    // Freezing is deterministic
+    Array<uint8_t> const data2 =
+        FrozenHashMap<uint32_t, uint64_t>::freeze(allocator, map);
+    REQUIRE(data2.size() == data.size());
+    REQUIRE(memcmp(data2.data(), data.data(), data.size()) == 0);
+}
+
+TEST_CASE("FrozenHashMap::empty")
+{
+    CstdlibAllocator allocator;
+
+    FrozenHashMap<uint32_t, uint32_t> const default_frozen;
+    REQUIRE(default_frozen.empty());
+    REQUIRE(default_frozen.size() == 0);
+    REQUIRE(default_frozen.find(0) == nullptr);
+
+    HashMap<uint32_t, uint32_t> const map{allocator};
+    Array<uint8_t> const data =
+        FrozenHashMap<uint32_t, uint32_t>::freeze(allocator, map);
+    Optional<FrozenHashMap<uint32_t, uint32_t>> const frozen =
+        FrozenHashMap<uint32_t, uint32_t>::view(data.span());
+    REQUIRE(frozen.has_value());
+    REQUIRE(frozen->empty());
+    REQUIRE(frozen->find(0) == nullptr);
+}
+
+TEST_CASE("FrozenHashMap::invalid_data")
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint32_t> map{allocator};
+    for (uint32_t i = 0; i < 100; ++i)
+        map.insert_or_assign(i, i + 1);
+
+    Array<uint8_t> data =
+        FrozenHashMap<uint32_t, uint32_t>::freeze(allocator, map);
+    REQUIRE(FrozenHashMap<uint32_t, uint32_t>::view(data.span()).has_value());
+
+    // Different types
+    REQUIRE(!FrozenHashMap<uint32_t, uint64_t>::view(data.span()).has_value());
+    REQUIRE(!FrozenHashMap<uint64_t, uint32_t>::view(data.span()).has_value());
+
+    // Truncated
+    REQUIRE(!FrozenHashMap<uint32_t, uint32_t>::view(
+                 Span<uint8_t const>{data.data(), data.size() - 1})
+                 .has_value());
+    REQUIRE(!FrozenHashMap<uint32_t, uint32_t>::view(
+                 Span<uint8_t const>{data.data(), 4})
+                 .has_value());
+
+    // Corrupted magic
+    data[0] ^= 0xFF;
+    REQUIRE(!FrozenHashMap<uint32_t, uint32_t>::view(data.span()).has_value());
+}
+
+TEST_CASE("FrozenHashMap::equal_hashes")
+{
+    CstdlibAllocator allocator;
+
+    struct CollidingHash
+    {
+        uint64_t operator()(uint32_t const &) const noexcept { return 0; }
+    };
+    HashMap<uint32_t, uint32_t, CollidingHash> map{allocator};
+    map.insert_or_assign(1u, 2u);
+
+    // A single key is fine even with a degenerate hasher
+    {
+        Array<uint8_t> const data =
+            FrozenHashMap<uint32_t, uint32_t, CollidingHash>::freeze(
+                allocator, map);
+        Optional<FrozenHashMap<uint32_t, uint32_t, CollidingHash>> const frozen =
+            FrozenHashMap<uint32_t, uint32_t, CollidingHash>::view(data.span());
+        REQUIRE(frozen.has_value());
+        REQUIRE(frozen->size() == 1);
+        REQUIRE(*frozen->find(1) == 2);
+    }
+
+    // Keys with equal hashes can't be placed
+    map.insert_or_assign(3u, 4u);
+    Array<uint8_t> const data =
+        FrozenHashMap<uint32_t, uint32_t, CollidingHash>::freeze(allocator, map);
+    REQUIRE(data.empty());
+    REQUIRE(!FrozenHashMap<uint32_t, uint32_t, CollidingHash>::view(data.span())
+                 .has_value());
+}
+
+TEST_CASE("FrozenHashMap::aligned")
+{
+    CstdlibAllocator allocator;
+
+    HashMap<AlignedObj, AlignedObj, AlignedHash, InterleavedLayout> map{
+        allocator};
+    for (uint32_t i = 0; i < 64; ++i)
+        map.insert_or_assign(AlignedObj{i, {}}, AlignedObj{i + 1, {}});
+
+    Array<uint8_t> const data =
+        FrozenHashMap<AlignedObj, AlignedObj, AlignedHash>::freeze(
+            allocator, map);
+    Optional<FrozenHashMap<AlignedObj, AlignedObj, AlignedHash>> const frozen =
+        FrozenHashMap<AlignedObj, AlignedObj, AlignedHash>::view(data.span());
+    REQUIRE(frozen.has_value());
+    REQUIRE(frozen->size() == 64);
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        AlignedObj const *value = frozen->find(AlignedObj{i, {}});
+        REQUIRE(value != nullptr);
+        REQUIRE(((uintptr_t)value % alignof(AlignedObj)) == 0);
+        REQUIRE(value->value == i + 1);
+    }
+}
@@ -1,6 +1,17 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <wheels/allocators/cstdlib_allocator.hpp>
 #include <wheels/containers/hash.hpp>
+#include <wheels/containers/hash_map.hpp>
+#include <wheels/containers/hash_set.hpp>
+#include <wheels/containers/inline_array.hpp>
+#include <wheels/containers/optional.hpp>
+#include <wheels/containers/pair.hpp>
+#include <wheels/containers/span.hpp>
+#include <wheels/containers/static_array.hpp>
+#include <wheels/containers/string.hpp>
+
+#include <cstring>
 
 using namespace wheels;
 
@@ -53,3 +64,187 @@ HASH_TEST_IMPLEMENTATION(double);
 #undef HASH_TEST_IMPLEMENTATIOn
 #undef STR
 #undef STR2
+
+TEST_CASE("hash::mix", "[hash]")
+{
+    {
+        MixHash<uint32_t> const hasher;
+        REQUIRE(hasher(0) == hasher(0));
+        REQUIRE(hasher(1) != hasher(0));
+        REQUIRE(hasher(1u << 31) != hasher(0));
+    }
+
+    { // No collisions over the full range of small types
+        CstdlibAllocator allocator;
+        MixHash<uint16_t> const hasher;
+        HashSet<uint64_t> hashes{allocator};
+        for (uint32_t i = 0; i <= UINT16_MAX; ++i)
+            hashes.insert(hasher((uint16_t)i));
+        REQUIRE(hashes.size() == UINT16_MAX + 1);
+    }
+
+    { // Both position and H2 bits should vary with sequential keys
+        MixHash<uint64_t> const hasher;
+        uint64_t low_bits_or = 0;
+        uint64_t low_bits_and = ~0ull;
+        for (uint64_t i = 0; i < 64; ++i)
+        {
+            low_bits_or |= hasher(i) & 0x7F;
+            low_bits_and &= hasher(i) & 0x7F;
+        }
+        REQUIRE(low_bits_or == 0x7F);
+        REQUIRE(low_bits_and == 0);
+    }
+
+    {
+        MixHash<int32_t> const hasher;
+        REQUIRE(hasher(-1) == hasher(-1));
+        REQUIRE(hasher(-1) != hasher(1));
+    }
+
+    {
+        MixHash<uint64_t const *> const hasher;
+        uint64_t const values[2] = {0, 0};
+        REQUIRE(hasher(&values[0]) == hasher(&values[0]));
+        REQUIRE(hasher(&values[0]) != hasher(&values[1]));
+    }
+
+    {
+        enum class Enum : uint8_t
+        {
+            A,
+            B,
+        };
+        MixHash<Enum> const hasher;
+        REQUIRE(hasher(Enum::A) != hasher(Enum::B));
+    }
+
+    {
+        CstdlibAllocator allocator;
+        HashSet<uint32_t, MixHash<uint32_t>> set{allocator};
+        for (uint32_t i = 0; i < 1000; ++i)
+            set.insert(i * 4096);
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            REQUIRE(set.contains(i * 4096));
+            REQUIRE(!set.contains(i * 4096 + 1));
+        }
+    }
+}
+
+TEST_CASE("hash::composite", "[hash]")
+{
+    {
+        static_assert(byte_hashable<Pair<uint32_t, uint32_t>>);
+        Hash<Pair<uint32_t, uint32_t>> const hasher;
+        Pair<uint32_t, uint32_t> const value{1u, 2u};
+        REQUIRE(hasher(value) == wyhash(&value, sizeof(value), 0, _wyp));
+        REQUIRE(hasher(value) == hasher(Pair<uint32_t, uint32_t>{1u, 2u}));
+        REQUIRE(hasher(value) != hasher(Pair<uint32_t, uint32_t>{2u, 1u}));
+    }
+
+    {
+        // Padding after first shouldn't leak into the hash
+        static_assert(!byte_hashable<Pair<uint8_t, uint32_t>>);
+        Hash<Pair<uint8_t, uint32_t>> const hasher;
+        alignas(Pair<uint8_t, uint32_t>) uint8_t
+            storage0[sizeof(Pair<uint8_t, uint32_t>)];
+        alignas(Pair<uint8_t, uint32_t>) uint8_t
+            storage1[sizeof(Pair<uint8_t, uint32_t>)];
+        memset(storage0, 0x00, sizeof(storage0));
+        memset(storage1, 0xFF, sizeof(storage1));
+        auto *value0 = new (storage0)
+            Pair<uint8_t, uint32_t>{(uint8_t)1, 2u};
+        auto *value1 = new (storage1)
+            Pair<uint8_t, uint32_t>{(uint8_t)1, 2u};
+        REQUIRE(hasher(*value0) == hasher(*value1));
+        REQUIRE(
+            hasher(*value0) != hasher(Pair<uint8_t, uint32_t>{(uint8_t)2, 1u}));
+    }
+
+    {
+        // Floats are hashed field-wise
+        static_assert(!byte_hashable<StaticArray<float, 3>>);
+        static_assert(byte_hashable<StaticArray<uint32_t, 3>>);
+        Hash<StaticArray<float, 3>> const hasher;
+        StaticArray<float, 3> const value{{1.f, 2.f, 3.f}};
+        StaticArray<float, 3> const same{{1.f, 2.f, 3.f}};
+        StaticArray<float, 3> const reversed{{3.f, 2.f, 1.f}};
+        REQUIRE(hasher(value) == hasher(same));
+        REQUIRE(hasher(value) != hasher(reversed));
+    }
+
+    {
+        // Only the live elements are hashed
+        Hash<InlineArray<uint32_t, 4>> const hasher;
+        InlineArray<uint32_t, 4> arr0;
+        arr0.push_back(1u);
+        arr0.push_back(2u);
+        arr0.push_back(3u);
+        arr0.pop_back();
+        InlineArray<uint32_t, 4> arr1;
+        arr1.push_back(1u);
+        arr1.push_back(2u);
+        REQUIRE(arr0 == arr1);
+        REQUIRE(hasher(arr0) == hasher(arr1));
+        arr1.push_back(4u);
+        REQUIRE(arr0 != arr1);
+        REQUIRE(hasher(arr0) != hasher(arr1));
+
+        Hash<InlineArray<float, 4>> const float_hasher;
+        InlineArray<float, 4> float_arr0;
+        InlineArray<float, 4> float_arr1;
+        float_arr1.push_back(0.f);
+        REQUIRE(float_hasher(float_arr0) != float_hasher(float_arr1));
+    }
+
+    {
+        Hash<Optional<uint32_t>> const hasher;
+        Optional<uint32_t> const empty;
+        Optional<uint32_t> const zero{0u};
+        REQUIRE(hasher(empty) == hasher(Optional<uint32_t>{}));
+        REQUIRE(hasher(empty) != hasher(zero));
+        REQUIRE(hasher(zero) == hasher(Optional<uint32_t>{0u}));
+        REQUIRE(hasher(zero) != hasher(Optional<uint32_t>{1u}));
+    }
+
+    {
+        // Should match operator== that treats the span as a c-string
+        CstdlibAllocator allocator;
+        Hash<StrSpan> const hasher;
+        char const *str = "abcdef";
+        StrSpan const view{str, 3};
+        StrSpan const nulled{"abc\0xyz", 7};
+        REQUIRE(view == StrSpan{"abc"});
+        REQUIRE(hasher(view) == hasher(StrSpan{"abc"}));
+        REQUIRE(view == nulled);
+        REQUIRE(hasher(view) == hasher(nulled));
+        REQUIRE(hasher(view) != hasher(StrSpan{str}));
+        REQUIRE(hasher(view) == Hash<String>{}(String{allocator, "abc"}));
+        REQUIRE(hasher(StrSpan{}) == hasher(StrSpan{}));
+    }
+
+    {
+        CstdlibAllocator allocator;
+        HashMap<Pair<uint32_t, uint32_t>, uint32_t> map{allocator};
+        for (uint32_t i = 0; i < 100; ++i)
+            map.insert_or_assign(Pair<uint32_t, uint32_t>{i, i + 1}, i);
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            uint32_t const *value =
+                map.find(Pair<uint32_t, uint32_t>{i, i + 1});
+            REQUIRE(value != nullptr);
+            REQUIRE(*value == i);
+            REQUIRE(!map.contains(Pair<uint32_t, uint32_t>{i + 1, i}));
+        }
+
+        HashSet<StaticArray<float, 3>> set{allocator};
+        for (uint32_t i = 0; i < 100; ++i)
+            set.insert(StaticArray<float, 3>{{(float)i, 0.f, 1.f}});
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            REQUIRE(set.contains(StaticArray<float, 3>{{(float)i, 0.f, 1.f}}));
+            REQUIRE(!set.contains(StaticArray<float, 3>{{(float)i, 1.f, 0.f}}));
+        }
+    }
+}
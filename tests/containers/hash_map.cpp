@@ -341,6 +341,388 @@ TEST_CASE("HashMap::iterator_increment")
     }
 }
 
+TEST_CASE("HashMap::iterate_sparse")
+{
+    CstdlibAllocator allocator;
+
+    // Most groups of control bytes are empty or deleted
+    HashMap<uint32_t, uint32_t> map{allocator};
+    for (uint32_t i = 0; i < 1000; ++i)
+        map.insert_or_assign(i, i + 1);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        if (i % 97 != 0)
+            map.remove(i);
+    }
+    REQUIRE(map.size() == 11);
+
+    uint32_t visited = 0;
+    for (auto const kv : map)
+    {
+        REQUIRE(*kv.first % 97 == 0);
+        REQUIRE(*kv.second == *kv.first + 1);
+        visited++;
+    }
+    REQUIRE(visited == 11);
+
+    HashMap<uint32_t, uint32_t> const &const_map = map;
+    visited = 0;
+    for (auto const kv : const_map)
+    {
+        REQUIRE(*kv.first % 97 == 0);
+        visited++;
+    }
+    REQUIRE(visited == 11);
+}
+
+TEST_CASE("HashMap::for_each")
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint32_t> map{allocator};
+    map.for_each([](uint32_t const &, uint32_t &) { REQUIRE(false); });
+
+    for (uint32_t i = 0; i < 100; ++i)
+        map.insert_or_assign(i, i);
+
+    map.for_each([](uint32_t const &key, uint32_t &value)
+                 { value = 2 * key + 1; });
+
+    HashMap<uint32_t, uint32_t> const &const_map = map;
+    uint32_t visited = 0;
+    uint32_t key_sum = 0;
+    const_map.for_each(
+        [&](uint32_t const &key, uint32_t const &value)
+        {
+            REQUIRE(value == 2 * key + 1);
+            key_sum += key;
+            visited++;
+        });
+    REQUIRE(visited == 100);
+    REQUIRE(key_sum == 99 * 100 / 2);
+}
+
+TEST_CASE("HashMap::erase_if")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        HashMap<DtorObj, DtorObj, DtorHash> map{allocator};
+        REQUIRE(
+            map.erase_if([](DtorObj const &, DtorObj const &)
+                         { return true; }) == 0);
+
+        for (uint32_t i = 0; i < 100; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+
+        uint64_t const dtors_before = DtorObj::s_dtor_counter();
+        size_t const erased = map.erase_if(
+            [](DtorObj const &key, DtorObj const &value)
+            {
+                REQUIRE(value.data == key.data + 1);
+                return key.data % 3 == 0;
+            });
+        REQUIRE(erased == 34);
+        REQUIRE(map.size() == 66);
+        REQUIRE(DtorObj::s_dtor_counter() == dtors_before + 2 * 34);
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            if (i % 3 == 0)
+                REQUIRE(!map.contains(DtorObj{i}));
+            else
+                REQUIRE(map.find(DtorObj{i})->data == i + 1);
+        }
+
+        // Erased slots should be reused
+        map.insert_or_assign(DtorObj{3}, DtorObj{4});
+        REQUIRE(map.find(DtorObj{3})->data == 4);
+
+        REQUIRE(
+            map.erase_if([](DtorObj const &, DtorObj const &)
+                         { return true; }) == 67);
+        REQUIRE(map.empty());
+        REQUIRE(map.begin() == map.end());
+        REQUIRE(!map.contains(DtorObj{1}));
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("HashMap::reserve_shrink")
+{
+    CstdlibAllocator allocator;
+
+    HashMap<uint32_t, uint32_t> map{allocator};
+    map.reserve(1000);
+    size_t const reserved_capacity = map.capacity();
+    REQUIRE(reserved_capacity >= 1000);
+    for (uint32_t i = 0; i < 1000; ++i)
+        map.insert_or_assign(i, i + 1);
+    REQUIRE(map.capacity() == reserved_capacity);
+
+    // Smaller reservations shouldn't shrink
+    map.reserve(10);
+    REQUIRE(map.capacity() == reserved_capacity);
+
+    // Rehashing should keep the pairs and can grow or shrink the table
+    map.rehash(4 * reserved_capacity);
+    REQUIRE(map.capacity() == 4 * reserved_capacity);
+    REQUIRE(map.size() == 1000);
+    map.rehash(0);
+    REQUIRE(map.capacity() == reserved_capacity);
+    for (uint32_t i = 0; i < 1000; ++i)
+        REQUIRE(*map.find(i) == i + 1);
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        if (i % 100 != 0)
+            map.remove(i);
+    }
+    REQUIRE(map.capacity() == reserved_capacity);
+    map.shrink_to_fit();
+    REQUIRE(map.capacity() == DefaultHashPolicy::s_min_capacity);
+    REQUIRE(map.size() == 10);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        if (i % 100 == 0)
+            REQUIRE(*map.find(i) == i + 1);
+        else
+            REQUIRE(!map.contains(i));
+    }
+
+    // Empty map should release its table
+    map.clear();
+    map.shrink_to_fit();
+    REQUIRE(map.capacity() == 0);
+    REQUIRE(map.begin() == map.end());
+    REQUIRE(!map.contains(0));
+    map.insert_or_assign(1u, 2u);
+    REQUIRE(*map.find(1) == 2);
+
+    init_dtor_counters();
+    {
+        HashMap<DtorObj, DtorObj, DtorHash> dtor_map{allocator};
+        for (uint32_t i = 0; i < 100; ++i)
+            dtor_map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+        for (uint32_t i = 0; i < 90; ++i)
+            dtor_map.remove(DtorObj{i});
+        dtor_map.shrink_to_fit();
+        REQUIRE(dtor_map.size() == 10);
+        for (uint32_t i = 90; i < 100; ++i)
+            REQUIRE(dtor_map.find(DtorObj{i})->data == i + 1);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("HashMap::policy")
+{
+    CstdlibAllocator allocator;
+
+    using HalfLoad = HashPolicy<1, 2>;
+    static_assert(HalfLoad::s_min_capacity == 8);
+
+    HashMap<uint32_t, uint32_t, Hash<uint32_t>, SplitLayout, HalfLoad> map{
+        allocator};
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        map.insert_or_assign(i, i + 1);
+        // Load is checked before inserting so it can be one over
+        REQUIRE(2 * (map.size() - 1) <= map.capacity());
+    }
+    for (uint32_t i = 0; i < 1000; ++i)
+        REQUIRE(*map.find(i) == i + 1);
+    REQUIRE(!map.contains(1000));
+
+    map.reserve(2000);
+    REQUIRE(map.capacity() >= 4000);
+}
+
+TEST_CASE("HashMap::clear_tracked")
+{
+    CstdlibAllocator allocator;
+
+    using Tracked = HashPolicy<15, 16, HashClear::Tracked>;
+
+    init_dtor_counters();
+    {
+        HashMap<DtorObj, DtorObj, DtorHash, SplitLayout, Tracked> map{
+            allocator};
+        map.clear();
+
+        // Large table that holds few items between clears
+        for (uint32_t i = 0; i < 1000; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+        size_t const capacity = map.capacity();
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE(map.begin() == map.end());
+        REQUIRE(
+            DtorObj::s_ctor_counter() ==
+            DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+
+        for (uint32_t round = 0; round < 100; ++round)
+        {
+            for (uint32_t i = 0; i < 5; ++i)
+                map.insert_or_assign(
+                    DtorObj{round * 7 + i}, DtorObj{round + i});
+            // Deleted slots are also reset
+            map.remove(DtorObj{round * 7});
+            REQUIRE(map.size() == 4);
+            for (uint32_t i = 1; i < 5; ++i)
+                REQUIRE(map.find(DtorObj{round * 7 + i})->data == round + i);
+            REQUIRE(!map.contains(DtorObj{round * 7}));
+            // Stale items from the previous round shouldn't be visible
+            if (round > 0)
+                REQUIRE(!map.contains(DtorObj{round * 7 - 6}));
+
+            uint32_t visited = 0;
+            for (auto const kv : map)
+            {
+                (void)kv;
+                visited++;
+            }
+            REQUIRE(visited == 4);
+
+            map.clear();
+            REQUIRE(map.empty());
+        }
+        REQUIRE(map.capacity() == capacity);
+
+        // Growing relogs the relocated items
+        for (uint32_t i = 0; i < 2000; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i});
+        map.clear();
+        for (uint32_t i = 0; i < 2000; ++i)
+            REQUIRE(!map.contains(DtorObj{i}));
+        map.insert_or_assign(DtorObj{1}, DtorObj{2});
+        REQUIRE(map.find(DtorObj{1})->data == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("HashMap::clear_shrink")
+{
+    CstdlibAllocator allocator;
+
+    using Shrink = HashPolicy<15, 16, HashClear::Shrink>;
+
+    init_dtor_counters();
+    {
+        HashMap<DtorObj, DtorObj, DtorHash, SplitLayout, Shrink> map{
+            allocator};
+        for (uint32_t i = 0; i < 1000; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+        size_t const capacity = map.capacity();
+
+        // The table fits what it held so it's kept
+        map.clear();
+        REQUIRE(map.capacity() == capacity);
+
+        // Clearing an empty table doesn't tell how much it's needed
+        map.clear();
+        REQUIRE(map.capacity() == capacity);
+
+        for (uint32_t i = 0; i < 10; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE(map.capacity() == Shrink::s_min_capacity);
+        REQUIRE(!map.contains(DtorObj{0}));
+
+        map.insert_or_assign(DtorObj{1}, DtorObj{2});
+        REQUIRE(map.find(DtorObj{1})->data == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("HashMap::with_hash")
+{
+    CstdlibAllocator allocator;
+
+    // One hash drives the lookups into both layers
+    HashMap<uint32_t, uint32_t, CountedHash> l0{allocator};
+    HashMap<uint32_t, uint32_t, CountedHash> l1{allocator};
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        uint64_t const hash = l0.hash_of(i);
+        if (i % 2 == 0)
+            l0.insert_or_assign_with_hash(i, i + 1, hash);
+        else
+            l1.insert_or_assign_with_hash(i, i + 2, hash);
+    }
+
+    CountedHash::s_call_counter() = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        uint64_t const hash = l0.hash_of(i);
+        REQUIRE(hash == l1.hash_of(i));
+        REQUIRE(l0.contains_with_hash(i, hash) == (i % 2 == 0));
+        uint32_t const *value = l0.find_with_hash(i, hash);
+        if (value == nullptr)
+            value = l1.find_with_hash(i, hash);
+        REQUIRE(value != nullptr);
+        REQUIRE(*value == (i % 2 == 0 ? i + 1 : i + 2));
+    }
+    REQUIRE(CountedHash::s_call_counter() == 200);
+
+    HashMap<uint32_t, uint32_t, CountedHash> const &const_l1 = l1;
+    REQUIRE(*const_l1.find_with_hash(1, l1.hash_of(1)) == 3);
+
+    *l1.find_with_hash(1, l1.hash_of(1)) = 10;
+    REQUIRE(*l1.find(1) == 10);
+    l1.insert_or_assign_with_hash(1u, 11u, l1.hash_of(1));
+    REQUIRE(*l1.find(1) == 11);
+    REQUIRE(l1.size() == 50);
+
+    l1.remove_with_hash(1, l1.hash_of(1));
+    REQUIRE(!l1.contains(1));
+    REQUIRE(l1.size() == 49);
+    l1.remove_with_hash(1, l1.hash_of(1));
+    REQUIRE(l1.size() == 49);
+}
+
+TEST_CASE("HashMap::reinsert_after_remove")
+{
+    CstdlibAllocator allocator;
+
+    // Keys colliding on the same home slot form a single probe sequence.
+    // Reinserting a key that is past a Deleted slot in the sequence should
+    // assign the existing one instead of adding a second copy.
+    struct CollidingHash
+    {
+        uint64_t operator()(uint32_t const &) const noexcept { return 0; }
+    };
+    HashMap<uint32_t, uint32_t, CollidingHash> map{allocator};
+    for (uint32_t i = 0; i < 4; ++i)
+        map.insert_or_assign(i, i);
+    map.remove(1);
+    map.insert_or_assign(3u, 30u);
+    REQUIRE(map.size() == 3);
+    REQUIRE(*map.find(3) == 30);
+    map.remove(3);
+    REQUIRE(!map.contains(3));
+
+    // The freed slots are still reused
+    map.insert_or_assign(5u, 5u);
+    map.insert_or_assign(6u, 6u);
+    REQUIRE(map.size() == 4);
+    uint32_t visited = 0;
+    for (auto const kv : map)
+    {
+        REQUIRE(*kv.first == *kv.second);
+        visited++;
+    }
+    REQUIRE(visited == 4);
+}
+
 TEST_CASE("HashMap::aligned")
 {
     CstdlibAllocator allocator;
@@ -358,3 +740,113 @@ TEST_CASE("HashMap::aligned")
         sum += v.second->value;
     REQUIRE(sum == 32);
 }
+
+TEST_CASE("HashMap::interleaved_layout")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        HashMap<DtorObj, DtorObj, DtorHash, InterleavedLayout> map{allocator};
+        for (uint32_t i = 0; i < 100; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+        REQUIRE(map.size() == 100);
+        REQUIRE(map.capacity() >= 100);
+
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            REQUIRE(map.contains(DtorObj{i}));
+            REQUIRE(map.find(DtorObj{i})->data == i + 1);
+        }
+        REQUIRE(!map.contains(DtorObj{100}));
+
+        map.insert_or_assign(DtorObj{10}, DtorObj{0});
+        REQUIRE(map.size() == 100);
+        REQUIRE(map.find(DtorObj{10})->data == 0);
+
+        map.remove(DtorObj{20});
+        REQUIRE(map.size() == 99);
+        REQUIRE(!map.contains(DtorObj{20}));
+
+        uint64_t key_sum = 0;
+        uint64_t value_sum = 0;
+        for (auto const v : map)
+        {
+            key_sum += v.first->data;
+            value_sum += v.second->data;
+        }
+        REQUIRE(key_sum == 4950 - 20);
+        REQUIRE(value_sum == 5050 - 21 - 11);
+
+        HashMap<DtorObj, DtorObj, DtorHash, InterleavedLayout> map_moved{
+            WHEELS_MOV(map)};
+        REQUIRE(map_moved.size() == 99);
+        REQUIRE(map_moved.find(DtorObj{99})->data == 100);
+    }
+    // All live objects should have been destroyed exactly once
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+
+    HashMap<AlignedObj, AlignedObj, AlignedHash, InterleavedLayout>
+        aligned_map{allocator};
+    aligned_map.insert_or_assign(AlignedObj{10}, AlignedObj{11});
+    aligned_map.insert_or_assign(AlignedObj{20}, AlignedObj{21});
+    REQUIRE(aligned_map.find({10})->value == 11);
+    REQUIRE(aligned_map.find({20})->value == 21);
+    for (auto const v : aligned_map)
+        REQUIRE(((uintptr_t)v.second % alignof(AlignedObj)) == 0);
+}
+
+TEST_CASE("HashMap::stored_hash")
+{
+    CstdlibAllocator allocator;
+
+    { // Hashes are computed only once per insert, not again on grow
+        CountedHash::s_call_counter() = 0;
+        HashMap<uint32_t, uint32_t, StoredHash<CountedHash>> map{allocator};
+        for (uint32_t i = 0; i < 1000; ++i)
+            map.insert_or_assign(i, i + 1);
+        REQUIRE(map.size() == 1000);
+        REQUIRE(CountedHash::s_call_counter() == 1000);
+
+        for (uint32_t i = 0; i < 1000; ++i)
+            REQUIRE(*map.find(i) == i + 1);
+        REQUIRE(map.find(1000) == nullptr);
+        REQUIRE(CountedHash::s_call_counter() == 2001);
+
+        for (uint32_t i = 0; i < 1000; i += 2)
+            map.remove(i);
+        REQUIRE(map.size() == 500);
+        for (uint32_t i = 0; i < 1000; ++i)
+            REQUIRE(map.contains(i) == (i % 2 == 1));
+
+        HashMap<uint32_t, uint32_t, StoredHash<CountedHash>> map_moved{
+            WHEELS_MOV(map)};
+        REQUIRE(*map_moved.find(1) == 2);
+        map_moved.insert_or_assign(1u, 3u);
+        REQUIRE(*map_moved.find(1) == 3);
+        REQUIRE(map_moved.size() == 500);
+    }
+
+    { // The plain hasher rehashes on grow
+        CountedHash::s_call_counter() = 0;
+        HashMap<uint32_t, uint32_t, CountedHash> map{allocator};
+        for (uint32_t i = 0; i < 1000; ++i)
+            map.insert_or_assign(i, i + 1);
+        REQUIRE(CountedHash::s_call_counter() > 1000);
+    }
+
+    {
+        init_dtor_counters();
+        HashMap<DtorObj, DtorObj, StoredHash<DtorHash>, InterleavedLayout> map{
+            allocator};
+        for (uint32_t i = 0; i < 100; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+        for (uint32_t i = 0; i < 100; ++i)
+            REQUIRE(map.find(DtorObj{i})->data == i + 1);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
@@ -127,6 +127,31 @@ TEST_CASE("HashSet::grow")
         REQUIRE(set.contains(i * 10));
 }
 
+TEST_CASE("HashSet::grow_relocate")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        HashSet<DtorObj, DtorHash> set{allocator};
+        for (uint32_t i = 0; i < 1000; ++i)
+            set.insert(DtorObj{i});
+        REQUIRE(set.size() == 1000);
+        // Growth should move the values and destroy the moved from ones
+        REQUIRE(DtorObj::s_copy_ctor_counter() == 0);
+        REQUIRE(DtorObj::s_dtor_counter() == 0);
+        REQUIRE(
+            DtorObj::s_ctor_counter() ==
+            DtorObj::s_moved_from_dtor_counter() + set.size());
+
+        for (uint32_t i = 0; i < 1000; ++i)
+            REQUIRE(set.contains(DtorObj{i}));
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
 TEST_CASE("HashSet::reinsert")
 {
     CstdlibAllocator allocator;
@@ -218,6 +243,82 @@ TEST_CASE("HashSet::iterator_increment")
     }
 }
 
+TEST_CASE("HashSet::iterate_sparse")
+{
+    CstdlibAllocator allocator;
+
+    // Most groups of control bytes are empty or deleted
+    HashSet<uint32_t> set{allocator};
+    for (uint32_t i = 0; i < 1000; ++i)
+        set.insert(i);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        if (i % 97 != 0)
+            set.remove(i);
+    }
+    REQUIRE(set.size() == 11);
+
+    uint32_t visited = 0;
+    for (uint32_t const v : set)
+    {
+        REQUIRE(v % 97 == 0);
+        visited++;
+    }
+    REQUIRE(visited == 11);
+}
+
+TEST_CASE("HashSet::for_each")
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t> set{allocator};
+    set.for_each([](uint32_t const &) { REQUIRE(false); });
+
+    for (uint32_t i = 0; i < 100; ++i)
+        set.insert(i);
+
+    uint32_t visited = 0;
+    uint32_t sum = 0;
+    set.for_each(
+        [&](uint32_t const &v)
+        {
+            sum += v;
+            visited++;
+        });
+    REQUIRE(visited == 100);
+    REQUIRE(sum == 99 * 100 / 2);
+}
+
+TEST_CASE("HashSet::erase_if")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        HashSet<DtorObj, DtorHash> set{allocator};
+        REQUIRE(set.erase_if([](DtorObj const &) { return true; }) == 0);
+
+        for (uint32_t i = 0; i < 100; ++i)
+            set.insert(DtorObj{i});
+
+        uint64_t const dtors_before = DtorObj::s_dtor_counter();
+        size_t const erased =
+            set.erase_if([](DtorObj const &v) { return v.data % 3 == 0; });
+        REQUIRE(erased == 34);
+        REQUIRE(set.size() == 66);
+        REQUIRE(DtorObj::s_dtor_counter() == dtors_before + 34);
+        for (uint32_t i = 0; i < 100; ++i)
+            REQUIRE(set.contains(DtorObj{i}) == (i % 3 != 0));
+
+        REQUIRE(set.erase_if([](DtorObj const &) { return true; }) == 66);
+        REQUIRE(set.empty());
+        REQUIRE(set.begin() == set.end());
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
 TEST_CASE("HashSet::clear")
 {
     CstdlibAllocator allocator;
@@ -291,6 +392,192 @@ TEST_CASE("HashSet::range_for")
     REQUIRE(sum == 60);
 }
 
+TEST_CASE("HashSet::reserve_shrink")
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t> set{allocator};
+    set.reserve(1000);
+    size_t const reserved_capacity = set.capacity();
+    REQUIRE(reserved_capacity >= 1000);
+    for (uint32_t i = 0; i < 1000; ++i)
+        set.insert(i);
+    REQUIRE(set.capacity() == reserved_capacity);
+
+    set.rehash(4 * reserved_capacity);
+    REQUIRE(set.capacity() == 4 * reserved_capacity);
+    set.rehash(0);
+    REQUIRE(set.capacity() == reserved_capacity);
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        if (i % 100 != 0)
+            set.remove(i);
+    }
+    set.shrink_to_fit();
+    REQUIRE(set.capacity() == DefaultHashPolicy::s_min_capacity);
+    for (uint32_t i = 0; i < 1000; ++i)
+        REQUIRE(set.contains(i) == (i % 100 == 0));
+
+    set.clear();
+    set.shrink_to_fit();
+    REQUIRE(set.capacity() == 0);
+    REQUIRE(set.begin() == set.end());
+    REQUIRE(!set.contains(0));
+    set.insert(1u);
+    REQUIRE(set.contains(1));
+}
+
+TEST_CASE("HashSet::policy")
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t, Hash<uint32_t>, HashPolicy<1, 2>> set{allocator};
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        set.insert(i);
+        // Load is checked before inserting so it can be one over
+        REQUIRE(2 * (set.size() - 1) <= set.capacity());
+    }
+    for (uint32_t i = 0; i < 1000; ++i)
+        REQUIRE(set.contains(i));
+    REQUIRE(!set.contains(1000));
+}
+
+TEST_CASE("HashSet::clear_tracked")
+{
+    CstdlibAllocator allocator;
+
+    using Tracked = HashPolicy<15, 16, HashClear::Tracked>;
+
+    init_dtor_counters();
+    {
+        HashSet<DtorObj, DtorHash, Tracked> set{allocator};
+        set.clear();
+
+        for (uint32_t i = 0; i < 1000; ++i)
+            set.insert(DtorObj{i});
+        size_t const capacity = set.capacity();
+        set.clear();
+        REQUIRE(set.empty());
+        REQUIRE(set.begin() == set.end());
+
+        for (uint32_t round = 0; round < 100; ++round)
+        {
+            for (uint32_t i = 0; i < 5; ++i)
+                set.insert(DtorObj{round * 7 + i});
+            set.remove(DtorObj{round * 7});
+            REQUIRE(set.size() == 4);
+            for (uint32_t i = 1; i < 5; ++i)
+                REQUIRE(set.contains(DtorObj{round * 7 + i}));
+            REQUIRE(!set.contains(DtorObj{round * 7}));
+            if (round > 0)
+                REQUIRE(!set.contains(DtorObj{round * 7 - 6}));
+
+            set.clear();
+            REQUIRE(set.empty());
+        }
+        REQUIRE(set.capacity() == capacity);
+
+        for (uint32_t i = 0; i < 2000; ++i)
+            set.insert(DtorObj{i});
+        set.clear();
+        for (uint32_t i = 0; i < 2000; ++i)
+            REQUIRE(!set.contains(DtorObj{i}));
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("HashSet::clear_shrink")
+{
+    CstdlibAllocator allocator;
+
+    using Shrink = HashPolicy<15, 16, HashClear::Shrink>;
+
+    HashSet<uint32_t, Hash<uint32_t>, Shrink> set{allocator};
+    for (uint32_t i = 0; i < 1000; ++i)
+        set.insert(i);
+    size_t const capacity = set.capacity();
+    set.clear();
+    REQUIRE(set.capacity() == capacity);
+
+    for (uint32_t i = 0; i < 10; ++i)
+        set.insert(i);
+    set.clear();
+    REQUIRE(set.empty());
+    REQUIRE(set.capacity() == Shrink::s_min_capacity);
+    REQUIRE(!set.contains(0));
+    set.insert(1u);
+    REQUIRE(set.contains(1));
+}
+
+TEST_CASE("HashSet::with_hash")
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t, CountedHash> evens{allocator};
+    HashSet<uint32_t, CountedHash> odds{allocator};
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        uint64_t const hash = evens.hash_of(i);
+        if (i % 2 == 0)
+            evens.insert_with_hash(i, hash);
+        else
+            odds.insert_with_hash(i, hash);
+    }
+
+    CountedHash::s_call_counter() = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        uint64_t const hash = evens.hash_of(i);
+        REQUIRE(evens.contains_with_hash(i, hash) == (i % 2 == 0));
+        REQUIRE(odds.contains_with_hash(i, hash) == (i % 2 == 1));
+        if (i % 2 == 0)
+            REQUIRE(*evens.find_with_hash(i, hash) == i);
+        else
+            REQUIRE(evens.find_with_hash(i, hash) == evens.end());
+    }
+    REQUIRE(CountedHash::s_call_counter() == 100);
+
+    evens.insert_with_hash(0u, evens.hash_of(0));
+    REQUIRE(evens.size() == 50);
+    evens.remove_with_hash(0, evens.hash_of(0));
+    REQUIRE(!evens.contains(0));
+    REQUIRE(evens.size() == 49);
+}
+
+TEST_CASE("HashSet::reinsert_after_remove")
+{
+    CstdlibAllocator allocator;
+
+    struct CollidingHash
+    {
+        uint64_t operator()(uint32_t const &) const noexcept { return 0; }
+    };
+    HashSet<uint32_t, CollidingHash> set{allocator};
+    for (uint32_t i = 0; i < 4; ++i)
+        set.insert(i);
+    set.remove(1);
+    set.insert(3u);
+    REQUIRE(set.size() == 3);
+    set.remove(3);
+    REQUIRE(!set.contains(3));
+
+    set.insert(5u);
+    set.insert(6u);
+    REQUIRE(set.size() == 4);
+    uint32_t visited = 0;
+    for (uint32_t const v : set)
+    {
+        REQUIRE(v != 1);
+        REQUIRE(v != 3);
+        visited++;
+    }
+    REQUIRE(visited == 4);
+}
+
 TEST_CASE("HashSet::aligned")
 {
     CstdlibAllocator allocator;
@@ -308,3 +595,180 @@ TEST_CASE("HashSet::aligned")
         sum += v.value;
     REQUIRE(sum == 30);
 }
+
+TEST_CASE("HashSet::stored_hash")
+{
+    CstdlibAllocator allocator;
+
+    { // Hashes are computed only once per insert, not again on grow
+        CountedHash::s_call_counter() = 0;
+        HashSet<uint32_t, StoredHash<CountedHash>> set{allocator};
+        for (uint32_t i = 0; i < 1000; ++i)
+            set.insert(i);
+        REQUIRE(set.size() == 1000);
+        REQUIRE(CountedHash::s_call_counter() == 1000);
+
+        for (uint32_t i = 0; i < 1000; ++i)
+            REQUIRE(set.contains(i));
+        REQUIRE(!set.contains(1000));
+        REQUIRE(CountedHash::s_call_counter() == 2001);
+
+        for (uint32_t i = 0; i < 1000; i += 2)
+            set.remove(i);
+        REQUIRE(set.size() == 500);
+        for (uint32_t i = 0; i < 1000; ++i)
+            REQUIRE(set.contains(i) == (i % 2 == 1));
+
+        HashSet<uint32_t, StoredHash<CountedHash>> set_moved{WHEELS_MOV(set)};
+        REQUIRE(set_moved.contains(1));
+        set_moved.insert(1u);
+        REQUIRE(set_moved.size() == 500);
+    }
+
+    { // The plain hasher rehashes on grow
+        CountedHash::s_call_counter() = 0;
+        HashSet<uint32_t, CountedHash> set{allocator};
+        for (uint32_t i = 0; i < 1000; ++i)
+            set.insert(i);
+        REQUIRE(CountedHash::s_call_counter() > 1000);
+    }
+}
+
+TEST_CASE("HashSet::merge")
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t> set{allocator};
+    HashSet<uint32_t> other{allocator};
+    set.merge(other);
+    REQUIRE(set.empty());
+
+    for (uint32_t i = 0; i < 100; ++i)
+        set.insert(i);
+    for (uint32_t i = 50; i < 200; ++i)
+        other.insert(i);
+
+    set.merge(other);
+    REQUIRE(set.size() == 200);
+    REQUIRE(other.size() == 150);
+    for (uint32_t i = 0; i < 200; ++i)
+        REQUIRE(set.contains(i));
+    set.merge(set);
+    REQUIRE(set.size() == 200);
+
+    init_dtor_counters();
+    {
+        HashSet<DtorObj, DtorHash> dtor_set{allocator};
+        HashSet<DtorObj, DtorHash> dtor_other{allocator};
+        for (uint32_t i = 0; i < 10; ++i)
+            dtor_set.insert(DtorObj{i});
+        for (uint32_t i = 5; i < 20; ++i)
+            dtor_other.insert(DtorObj{i});
+
+        dtor_set.merge(WHEELS_MOV(dtor_other));
+        REQUIRE(dtor_set.size() == 20);
+        REQUIRE(dtor_other.empty());
+        for (uint32_t i = 0; i < 20; ++i)
+            REQUIRE(dtor_set.contains(DtorObj{i}));
+
+        // Empty set takes over the other table
+        HashSet<DtorObj, DtorHash> dtor_empty{allocator};
+        dtor_empty.merge(WHEELS_MOV(dtor_set));
+        REQUIRE(dtor_empty.size() == 20);
+        REQUIRE(dtor_set.empty());
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("HashSet::intersect_subtract")
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t> evens{allocator};
+    HashSet<uint32_t> threes{allocator};
+    for (uint32_t i = 0; i < 300; ++i)
+    {
+        if (i % 2 == 0)
+            evens.insert(i);
+        if (i % 3 == 0)
+            threes.insert(i);
+    }
+
+    {
+        HashSet<uint32_t> set{allocator};
+        set.merge(evens);
+        set.intersect_with(threes);
+        REQUIRE(set.size() == 50);
+        for (uint32_t i = 0; i < 300; ++i)
+            REQUIRE(set.contains(i) == (i % 6 == 0));
+
+        set.intersect_with(HashSet<uint32_t>{allocator});
+        REQUIRE(set.empty());
+    }
+
+    { // Iterates the other set when it's smaller
+        HashSet<uint32_t> set{allocator};
+        set.merge(evens);
+        set.subtract(threes);
+        REQUIRE(set.size() == 100);
+        for (uint32_t i = 0; i < 300; ++i)
+            REQUIRE(set.contains(i) == (i % 2 == 0 && i % 3 != 0));
+    }
+
+    { // Iterates this set when it's smaller
+        HashSet<uint32_t> set{allocator};
+        set.merge(threes);
+        set.subtract(evens);
+        REQUIRE(set.size() == 50);
+        for (uint32_t i = 0; i < 300; ++i)
+            REQUIRE(set.contains(i) == (i % 3 == 0 && i % 2 != 0));
+
+        set.subtract(set);
+        REQUIRE(set.empty());
+    }
+}
+
+TEST_CASE("HashSet::intersection_difference")
+{
+    CstdlibAllocator allocator;
+
+    HashSet<uint32_t, StoredHash<CountedHash>> a{allocator};
+    HashSet<uint32_t, StoredHash<CountedHash>> b{allocator};
+    for (uint32_t i = 0; i < 1000; ++i)
+        a.insert(i);
+    for (uint32_t i = 900; i < 1100; ++i)
+        b.insert(i);
+
+    // Stored hashes are reused so no values get hashed
+    CountedHash::s_call_counter() = 0;
+    HashSet<uint32_t, StoredHash<CountedHash>> const a_and_b =
+        intersection(allocator, a, b);
+    HashSet<uint32_t, StoredHash<CountedHash>> const b_and_a =
+        intersection(allocator, b, a);
+    HashSet<uint32_t, StoredHash<CountedHash>> const a_minus_b =
+        difference(allocator, a, b);
+    HashSet<uint32_t, StoredHash<CountedHash>> const b_minus_a =
+        difference(allocator, b, a);
+    REQUIRE(CountedHash::s_call_counter() == 0);
+
+    REQUIRE(a_and_b.size() == 100);
+    REQUIRE(b_and_a.size() == 100);
+    REQUIRE(a_minus_b.size() == 900);
+    REQUIRE(b_minus_a.size() == 100);
+    for (uint32_t i = 0; i < 1100; ++i)
+    {
+        REQUIRE(a_and_b.contains(i) == (i >= 900 && i < 1000));
+        REQUIRE(b_and_a.contains(i) == (i >= 900 && i < 1000));
+        REQUIRE(a_minus_b.contains(i) == (i < 900));
+        REQUIRE(b_minus_a.contains(i) == (i >= 1000));
+    }
+    // The results are presized
+    REQUIRE(a_and_b.capacity() <= b.capacity());
+
+    HashSet<uint32_t, StoredHash<CountedHash>> const empty{allocator};
+    REQUIRE(intersection(allocator, a, empty).empty());
+    REQUIRE(difference(allocator, empty, a).empty());
+    REQUIRE(difference(allocator, a, empty).size() == 1000);
+}
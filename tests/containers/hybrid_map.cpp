@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/hybrid_map.hpp>
+
+#include "common.hpp"
+
+using namespace wheels;
+
+TEST_CASE("HybridMap::inline")
+{
+    CountingAllocator allocator{false};
+
+    HybridMap<uint32_t, uint32_t, 4> map{allocator};
+    REQUIRE(map.empty());
+    REQUIRE(map.is_inline());
+    REQUIRE(map.begin() == map.end());
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        uint32_t *value = map.insert_or_assign(i, 10 * i);
+        REQUIRE(*value == 10 * i);
+    }
+    // Assigning to an existing key in a full map shouldn't spill
+    uint32_t *value = map.insert_or_assign(2u, 200u);
+    REQUIRE(*value == 200);
+    REQUIRE(map.size() == 4);
+    REQUIRE(map.is_inline());
+    REQUIRE(allocator.allocation_count == 0);
+
+    REQUIRE(*map.find(2) == 200);
+    REQUIRE(map.find(4) == nullptr);
+
+    map.remove(0);
+    REQUIRE(map.size() == 3);
+    REQUIRE(!map.contains(0));
+
+    for (auto kv : map)
+        (*kv.second)++;
+
+    HybridMap<uint32_t, uint32_t, 4> const &const_map = map;
+    uint32_t sum = 0;
+    for (auto kv : const_map)
+        sum += *kv.first + *kv.second;
+    REQUIRE(sum == (1 + 11) + (2 + 201) + (3 + 31));
+}
+
+TEST_CASE("HybridMap::spill")
+{
+    CountingAllocator allocator{false};
+
+    HybridMap<uint32_t, uint32_t, 4> map{allocator};
+    for (uint32_t i = 0; i < 5; ++i)
+        map.insert_or_assign(i, i + 1);
+    REQUIRE(!map.is_inline());
+    REQUIRE(map.size() == 5);
+    REQUIRE(allocator.allocation_count > 0);
+    for (uint32_t i = 0; i < 5; ++i)
+        REQUIRE(*map.find(i) == i + 1);
+
+    for (uint32_t i = 5; i < 1000; ++i)
+        map.insert_or_assign(i, i + 1);
+    uint32_t *value = map.insert_or_assign(500u, 0u);
+    REQUIRE(*value == 0);
+    REQUIRE(map.size() == 1000);
+
+    for (auto kv : map)
+        *kv.second = *kv.first * 2;
+    uint32_t count = 0;
+    HybridMap<uint32_t, uint32_t, 4> const &const_map = map;
+    for (auto kv : const_map)
+    {
+        REQUIRE(*kv.second == *kv.first * 2);
+        count++;
+    }
+    REQUIRE(count == 1000);
+
+    for (uint32_t i = 0; i < 1000; i += 2)
+        map.remove(i);
+    REQUIRE(map.size() == 500);
+    REQUIRE(!map.contains(0));
+    REQUIRE(*map.find(1) == 2);
+
+    // Clearing keeps the table
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(!map.is_inline());
+    REQUIRE(map.begin() == map.end());
+}
+
+TEST_CASE("HybridMap::shrink_to_fit")
+{
+    CstdlibAllocator allocator;
+
+    HybridMap<uint32_t, uint32_t, 4> map{allocator};
+    for (uint32_t i = 0; i < 100; ++i)
+        map.insert_or_assign(i, i + 1);
+    for (uint32_t i = 3; i < 100; ++i)
+        map.remove(i);
+    map.shrink_to_fit();
+    REQUIRE(map.is_inline());
+    REQUIRE(map.size() == 3);
+    for (uint32_t i = 0; i < 3; ++i)
+        REQUIRE(*map.find(i) == i + 1);
+}
+
+TEST_CASE("HybridMap::move_dtors")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        HybridMap<uint32_t, DtorObj, 4> inline_map{allocator};
+        inline_map.insert_or_assign(1u, DtorObj{10});
+
+        HybridMap<uint32_t, DtorObj, 4> map{WHEELS_MOV(inline_map)};
+        REQUIRE(map.is_inline());
+        REQUIRE(map.find(1)->data == 10);
+        REQUIRE(inline_map.empty());
+
+        HybridMap<uint32_t, DtorObj, 4> spilled_map{allocator};
+        for (uint32_t i = 0; i < 20; ++i)
+            spilled_map.insert_or_assign(i, DtorObj{i});
+        REQUIRE(!spilled_map.is_inline());
+
+        map = WHEELS_MOV(spilled_map);
+        map = WHEELS_MOV(map);
+        REQUIRE(!map.is_inline());
+        REQUIRE(map.size() == 20);
+        REQUIRE(map.find(19)->data == 19);
+        REQUIRE(spilled_map.empty());
+
+        for (uint32_t i = 2; i < 20; ++i)
+            map.remove(i);
+        map.shrink_to_fit();
+        REQUIRE(map.is_inline());
+        REQUIRE(map.find(1)->data == 1);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
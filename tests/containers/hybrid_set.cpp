@@ -0,0 +1,179 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/hybrid_set.hpp>
+
+#include "common.hpp"
+
+using namespace wheels;
+
+TEST_CASE("HybridSet::inline")
+{
+    CountingAllocator allocator{false};
+
+    // The storages overlap
+    static_assert(
+        sizeof(HybridSet<uint32_t, 8>) <
+        sizeof(SmallSet<uint32_t, 8>) + sizeof(HashSet<uint32_t>));
+
+    HybridSet<uint32_t, 4> set{allocator};
+    REQUIRE(set.empty());
+    REQUIRE(set.is_inline());
+    REQUIRE(set.capacity() == 4);
+    REQUIRE(set.begin() == set.end());
+
+    for (uint32_t i = 0; i < 4; ++i)
+        set.insert(10 * (i + 1));
+    // Inserting an existing value into a full set shouldn't spill
+    set.insert(20u);
+    REQUIRE(set.size() == 4);
+    REQUIRE(set.is_inline());
+    REQUIRE(allocator.allocation_count == 0);
+
+    REQUIRE(set.contains(10));
+    REQUIRE(set.contains(40));
+    REQUIRE(!set.contains(50));
+
+    set.remove(10);
+    REQUIRE(set.size() == 3);
+    REQUIRE(!set.contains(10));
+
+    uint32_t sum = 0;
+    for (uint32_t v : set)
+        sum += v;
+    REQUIRE(sum == 20 + 30 + 40);
+}
+
+TEST_CASE("HybridSet::spill")
+{
+    CountingAllocator allocator{false};
+
+    HybridSet<uint32_t, 4> set{allocator};
+    for (uint32_t i = 0; i < 4; ++i)
+        set.insert(i);
+    REQUIRE(set.is_inline());
+
+    set.insert(4u);
+    REQUIRE(!set.is_inline());
+    REQUIRE(set.size() == 5);
+    REQUIRE(allocator.allocation_count > 0);
+    for (uint32_t i = 0; i < 5; ++i)
+        REQUIRE(set.contains(i));
+
+    for (uint32_t i = 5; i < 1000; ++i)
+        set.insert(i);
+    set.insert(500u);
+    REQUIRE(set.size() == 1000);
+    for (uint32_t i = 0; i < 1000; ++i)
+        REQUIRE(set.contains(i));
+    REQUIRE(!set.contains(1000));
+
+    uint32_t count = 0;
+    uint64_t sum = 0;
+    for (uint32_t v : set)
+    {
+        count++;
+        sum += v;
+    }
+    REQUIRE(count == 1000);
+    REQUIRE(sum == 999 * 1000 / 2);
+
+    for (uint32_t i = 0; i < 1000; i += 2)
+        set.remove(i);
+    REQUIRE(set.size() == 500);
+    REQUIRE(!set.contains(0));
+    REQUIRE(set.contains(1));
+
+    // Clearing keeps the table
+    set.clear();
+    REQUIRE(set.empty());
+    REQUIRE(!set.is_inline());
+    REQUIRE(set.begin() == set.end());
+}
+
+TEST_CASE("HybridSet::shrink_to_fit")
+{
+    CountingAllocator allocator{false};
+
+    HybridSet<uint32_t, 4> set{allocator};
+    for (uint32_t i = 0; i < 100; ++i)
+        set.insert(i);
+    REQUIRE(!set.is_inline());
+    size_t const capacity = set.capacity();
+
+    for (uint32_t i = 10; i < 100; ++i)
+        set.remove(i);
+    set.shrink_to_fit();
+    REQUIRE(!set.is_inline());
+    REQUIRE(set.capacity() < capacity);
+    REQUIRE(set.size() == 10);
+
+    for (uint32_t i = 3; i < 10; ++i)
+        set.remove(i);
+    set.shrink_to_fit();
+    REQUIRE(set.is_inline());
+    REQUIRE(set.size() == 3);
+    for (uint32_t i = 0; i < 3; ++i)
+        REQUIRE(set.contains(i));
+}
+
+TEST_CASE("HybridSet::move")
+{
+    CstdlibAllocator allocator;
+
+    HybridSet<uint32_t, 4> inline_set{allocator};
+    inline_set.insert(1u);
+    inline_set.insert(2u);
+
+    HybridSet<uint32_t, 4> set_move_constructed{WHEELS_MOV(inline_set)};
+    REQUIRE(set_move_constructed.is_inline());
+    REQUIRE(set_move_constructed.size() == 2);
+    REQUIRE(set_move_constructed.contains(2));
+    REQUIRE(inline_set.empty());
+
+    HybridSet<uint32_t, 4> spilled_set{allocator};
+    for (uint32_t i = 0; i < 10; ++i)
+        spilled_set.insert(i);
+
+    set_move_constructed = WHEELS_MOV(spilled_set);
+    set_move_constructed = WHEELS_MOV(set_move_constructed);
+    REQUIRE(!set_move_constructed.is_inline());
+    REQUIRE(set_move_constructed.size() == 10);
+    REQUIRE(set_move_constructed.contains(9));
+    REQUIRE(spilled_set.empty());
+
+    HybridSet<uint32_t, 4> set_move_assigned{allocator};
+    set_move_assigned.insert(5u);
+    for (uint32_t i = 0; i < 10; ++i)
+        set_move_assigned.insert(i + 100);
+    set_move_assigned = WHEELS_MOV(set_move_constructed);
+    REQUIRE(set_move_assigned.size() == 10);
+    REQUIRE(!set_move_assigned.contains(100));
+}
+
+TEST_CASE("HybridSet::dtors")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        HybridSet<DtorObj, 4, DtorHash> set{allocator};
+        for (uint32_t i = 0; i < 20; ++i)
+            set.insert(DtorObj{i});
+        REQUIRE(!set.is_inline());
+        for (uint32_t i = 0; i < 20; ++i)
+            REQUIRE(set.contains(DtorObj{i}));
+
+        for (uint32_t i = 2; i < 20; ++i)
+            set.remove(DtorObj{i});
+        set.shrink_to_fit();
+        REQUIRE(set.is_inline());
+        REQUIRE(set.contains(DtorObj{1}));
+
+        HybridSet<DtorObj, 4, DtorHash> moved_set{WHEELS_MOV(set)};
+        REQUIRE(moved_set.size() == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
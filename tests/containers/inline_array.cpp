@@ -96,6 +96,42 @@ TEST_CASE("InlineArray::allocate_copy")
         REQUIRE(e == 0xDEADCAFE);
 }
 
+TEST_CASE("InlineArray::trivially_copyable")
+{
+    static_assert(std::is_trivially_copyable_v<InlineArray<uint32_t, 4>>);
+    static_assert(std::is_trivially_copyable_v<InlineArray<AlignedObj, 4>>);
+    static_assert(!std::is_trivially_copyable_v<InlineArray<DtorObj, 4>>);
+    static_assert(std::is_trivially_copyable_v<InlineArray<int, 1024>>);
+    // Value-initialization shouldn't zero the whole storage
+    static_assert(
+        !std::is_trivially_default_constructible_v<InlineArray<int, 1024>>);
+
+    struct Snapshot
+    {
+        uint32_t id{0};
+        InlineArray<uint32_t, 4> values;
+    };
+    static_assert(std::is_trivially_copyable_v<Snapshot>);
+
+    Snapshot src;
+    src.id = 1;
+    src.values.push_back(10u);
+    src.values.push_back(20u);
+
+    Snapshot dst;
+    memcpy(&dst, &src, sizeof(Snapshot));
+    REQUIRE(dst.id == 1);
+    REQUIRE(dst.values.size() == 2);
+    REQUIRE(dst.values.data() != src.values.data());
+    REQUIRE(dst.values[0] == 10);
+    REQUIRE(dst.values[1] == 20);
+
+    // Moved from arrays keep their values when the move is a plain copy
+    InlineArray<uint32_t, 4> moved{WHEELS_MOV(src.values)};
+    REQUIRE(moved.size() == 2);
+    REQUIRE(moved[1] == 20);
+}
+
 TEST_CASE("InlineArray::push_lvalue")
 {
     init_dtor_counters();
@@ -185,6 +221,32 @@ TEST_CASE("InlineArray::emplace")
     REQUIRE(arr[1].m_data == 20);
     REQUIRE(arr[2].m_data == 30);
     REQUIRE(arr.size() == 3);
+
+    {
+        auto arr = init_test_static_arr_u32<10>(3);
+        // Middle, front and back
+        arr.emplace(1, 15u);
+        arr.emplace(0, 5u);
+        arr.emplace(arr.size(), 35u);
+        uint32_t const expected[]{5, 10, 15, 20, 30, 35};
+        REQUIRE(arr.size() == 6);
+        for (size_t i = 0; i < 6; ++i)
+            REQUIRE(arr[i] == expected[i]);
+    }
+
+    init_dtor_counters();
+    {
+        auto arr = init_test_static_arr_dtor<10>(3);
+        arr.emplace(1, 15u);
+        REQUIRE(arr.size() == 4);
+        uint32_t const expected[]{10, 15, 20, 30};
+        for (size_t i = 0; i < 4; ++i)
+            REQUIRE(arr[i].data == expected[i]);
+        REQUIRE(DtorObj::s_copy_ctor_counter() == 0);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
 }
 
 TEST_CASE("InlineArray::pop_back")
@@ -222,6 +284,115 @@ TEST_CASE("InlineArray::pop_back")
     REQUIRE(arr.size() == 0);
 }
 
+TEST_CASE("InlineArray::insert")
+{
+    {
+        auto arr = init_test_static_arr_u32<10>(3);
+        uint32_t const values[]{1, 2, 3};
+        // Middle
+        arr.insert(1, Span<uint32_t const>{values, 3});
+        REQUIRE(arr.size() == 6);
+        uint32_t const expected0[]{10, 1, 2, 3, 20, 30};
+        for (size_t i = 0; i < 6; ++i)
+            REQUIRE(arr[i] == expected0[i]);
+        // Front and back
+        arr.insert(0, Span<uint32_t const>{values, 1});
+        arr.insert(arr.size(), Span<uint32_t const>{values + 2, 1});
+        uint32_t const expected1[]{1, 10, 1, 2, 3, 20, 30, 3};
+        REQUIRE(arr.size() == 8);
+        for (size_t i = 0; i < 8; ++i)
+            REQUIRE(arr[i] == expected1[i]);
+        // Empty
+        arr.insert(4, Span<uint32_t const>{values, 0});
+        REQUIRE(arr.size() == 8);
+    }
+
+    init_dtor_counters();
+    {
+        auto arr = init_test_static_arr_dtor<10>(3);
+        DtorObj const values[]{DtorObj{1}, DtorObj{2}};
+        arr.insert(2, Span<DtorObj const>{values, 2});
+        REQUIRE(arr.size() == 5);
+        uint32_t const expected[]{10, 20, 1, 2, 30};
+        for (size_t i = 0; i < 5; ++i)
+            REQUIRE(arr[i].data == expected[i]);
+        REQUIRE(DtorObj::s_copy_ctor_counter() == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("InlineArray::erase_range")
+{
+    {
+        auto arr = init_test_static_arr_u32<10>(3);
+        arr.erase(1, 2);
+        REQUIRE(arr.size() == 2);
+        REQUIRE(arr[0] == 10);
+        REQUIRE(arr[1] == 30);
+        arr.erase(1, 1);
+        REQUIRE(arr.size() == 2);
+        arr.erase(0, 2);
+        REQUIRE(arr.empty());
+    }
+
+    init_dtor_counters();
+    {
+        auto arr = init_test_static_arr_dtor<10>(3);
+        arr.erase(0, 2);
+        REQUIRE(arr.size() == 1);
+        REQUIRE(arr[0].data == 30);
+        REQUIRE(DtorObj::s_dtor_counter() == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("InlineArray::erase_if")
+{
+    {
+        auto arr = init_test_static_arr_u32<10>(3);
+        uint32_t const values[]{1, 2, 3, 4, 5};
+        arr.insert(3, Span<uint32_t const>{values, 5});
+
+        // Stable compaction of everything that's left
+        size_t const removed_count =
+            arr.erase_if([](uint32_t const &v) { return v % 2 == 0; });
+        REQUIRE(removed_count == 5);
+        uint32_t const expected[]{1, 3, 5};
+        REQUIRE(arr.size() == 3);
+        for (size_t i = 0; i < 3; ++i)
+            REQUIRE(arr[i] == expected[i]);
+
+        REQUIRE(arr.retain([](uint32_t const &v) { return v > 1; }) == 1);
+        REQUIRE(arr.size() == 2);
+        REQUIRE(arr[0] == 3);
+        REQUIRE(arr[1] == 5);
+
+        REQUIRE(arr.erase_if([](uint32_t const &) { return false; }) == 0);
+        REQUIRE(arr.size() == 2);
+    }
+
+    init_dtor_counters();
+    {
+        auto arr = init_test_static_arr_dtor<10>(3);
+        size_t const removed_count =
+            arr.erase_if([](DtorObj const &v) { return v.data == 10; });
+        REQUIRE(removed_count == 1);
+        REQUIRE(arr.size() == 2);
+        REQUIRE(arr[0].data == 20);
+        REQUIRE(arr[1].data == 30);
+        REQUIRE(DtorObj::s_dtor_counter() == 1);
+        // Moves within the array shouldn't copy
+        REQUIRE(DtorObj::s_copy_ctor_counter() == 0);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
 TEST_CASE("InlineArray::resize")
 {
     init_dtor_counters();
@@ -0,0 +1,137 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/containers/inline_ring_buffer.hpp>
+
+#include "common.hpp"
+
+using namespace wheels;
+
+TEST_CASE("InlineRingBuffer::push_pop")
+{
+    InlineRingBuffer<uint32_t, 4> buffer;
+    REQUIRE(buffer.empty());
+    REQUIRE(!buffer.full());
+    REQUIRE(buffer.size() == 0);
+    REQUIRE(buffer.capacity() == 4);
+    REQUIRE(buffer.begin() == buffer.end());
+
+    buffer.push_back(1u);
+    buffer.push_front(0u);
+    buffer.emplace_back(2u);
+    buffer.emplace_front(3u);
+    REQUIRE(buffer.full());
+    REQUIRE(buffer.front() == 3);
+    REQUIRE(buffer.back() == 2);
+    uint32_t const expected[]{3, 0, 1, 2};
+    size_t i = 0;
+    for (uint32_t v : buffer)
+        REQUIRE(v == expected[i++]);
+    REQUIRE(i == 4);
+
+    REQUIRE(buffer.pop_front() == 3);
+    REQUIRE(buffer.pop_back() == 2);
+    REQUIRE(buffer.size() == 2);
+
+    // Walk the values around the end of the storage a few times
+    uint32_t next_push = 2;
+    uint32_t next_pop = 0;
+    for (uint32_t j = 0; j < 10; ++j)
+    {
+        buffer.push_back(next_push++);
+        REQUIRE(buffer.pop_front() == next_pop++);
+    }
+    REQUIRE(buffer.size() == 2);
+    REQUIRE(buffer[0] == next_pop);
+    REQUIRE(buffer[1] == next_pop + 1);
+
+    buffer.clear();
+    REQUIRE(buffer.empty());
+}
+
+TEST_CASE("InlineRingBuffer::spans")
+{
+    InlineRingBuffer<uint32_t, 8> buffer;
+    for (uint32_t i = 0; i < 6; ++i)
+        buffer.push_back(i);
+    buffer.drop_front(4);
+
+    uint32_t const values[]{6, 7, 8, 9, 10};
+    buffer.extend(Span<uint32_t const>{values, 5});
+    REQUIRE(buffer.size() == 7);
+
+    Pair<Span<uint32_t const>, Span<uint32_t const>> const spans =
+        buffer.spans();
+    REQUIRE(spans.first.size() == 4);
+    REQUIRE(spans.second.size() == 3);
+    REQUIRE(spans.first[0] == 4);
+    REQUIRE(spans.second[2] == 10);
+
+    Pair<Span<uint32_t>, Span<uint32_t>> mut_spans = buffer.mut_spans();
+    mut_spans.first[0] = 40;
+    REQUIRE(buffer.front() == 40);
+
+    uint32_t popped[6]{};
+    buffer.pop_front_into(Span<uint32_t>{popped, 6});
+    uint32_t const expected[]{40, 5, 6, 7, 8, 9};
+    for (uint32_t i = 0; i < 6; ++i)
+        REQUIRE(popped[i] == expected[i]);
+    REQUIRE(buffer.size() == 1);
+    REQUIRE(buffer.front() == 10);
+}
+
+TEST_CASE("InlineRingBuffer::copy_move")
+{
+    InlineRingBuffer<uint32_t, 4> buffer;
+    buffer.push_back(1u);
+    buffer.push_back(2u);
+    buffer.push_front(0u);
+
+    static_assert(std::is_trivially_copyable_v<InlineRingBuffer<uint32_t, 4>>);
+    static_assert(!std::is_trivially_default_constructible_v<
+                  InlineRingBuffer<uint32_t, 1024>>);
+    InlineRingBuffer<uint32_t, 4> buffer_copy{buffer};
+    REQUIRE(buffer_copy.size() == 3);
+    for (uint32_t i = 0; i < 3; ++i)
+        REQUIRE(buffer_copy[i] == i);
+
+    init_dtor_counters();
+    {
+        InlineRingBuffer<DtorObj, 4> dtor_buffer;
+        dtor_buffer.emplace_back(1u);
+        dtor_buffer.emplace_back(2u);
+        dtor_buffer.emplace_front(0u);
+
+        InlineRingBuffer<DtorObj, 4> copy_constructed{dtor_buffer};
+        REQUIRE(copy_constructed.size() == 3);
+        for (uint32_t i = 0; i < 3; ++i)
+            REQUIRE(copy_constructed[i].data == i);
+
+        InlineRingBuffer<DtorObj, 4> move_constructed{WHEELS_MOV(dtor_buffer)};
+        REQUIRE(dtor_buffer.empty());
+        for (uint32_t i = 0; i < 3; ++i)
+            REQUIRE(move_constructed[i].data == i);
+
+        InlineRingBuffer<DtorObj, 4> assigned;
+        assigned.push_front(DtorObj{10});
+        assigned = copy_constructed;
+        REQUIRE(assigned.size() == 3);
+        assigned = WHEELS_MOV(move_constructed);
+        REQUIRE(move_constructed.empty());
+        REQUIRE(assigned.back().data == 2);
+
+        DtorObj const values[]{DtorObj{3}};
+        assigned.extend(Span<DtorObj const>{values, 1});
+        REQUIRE(assigned.full());
+        REQUIRE(assigned.pop_front().data == 0);
+        assigned.push_back(DtorObj{4});
+
+        DtorObj popped[2];
+        assigned.pop_front_into(Span<DtorObj>{popped, 2});
+        REQUIRE(popped[1].data == 2);
+        REQUIRE(assigned.pop_back().data == 4);
+        REQUIRE(assigned.size() == 1);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
@@ -0,0 +1,188 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/array.hpp>
+#include <wheels/containers/mpmc_queue.hpp>
+
+#include "common.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace wheels;
+
+TEST_CASE("MpmcQueue::push_pop")
+{
+    CountingAllocator allocator{false};
+
+    // Rounded up to a power of two
+    MpmcQueue<uint32_t> queue{allocator, 3};
+    REQUIRE(queue.capacity() == 4);
+    REQUIRE(queue.empty());
+    REQUIRE(allocator.allocation_count == 1);
+    REQUIRE(!queue.try_pop().has_value());
+
+    // Walk the values around the end of the storage a few times
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        while (queue.try_push(next_push))
+            next_push++;
+        REQUIRE(queue.size() == 4);
+
+        Optional<uint32_t> value = queue.try_pop();
+        REQUIRE(value.has_value());
+        REQUIRE(*value == next_pop++);
+        value = queue.try_pop();
+        REQUIRE(*value == next_pop++);
+        REQUIRE(queue.size() == 2);
+    }
+
+    REQUIRE(queue.try_emplace(next_push++));
+    for (Optional<uint32_t> value = queue.try_pop(); value.has_value();
+         value = queue.try_pop())
+        REQUIRE(*value == next_pop++);
+    REQUIRE(next_pop == next_push);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("MpmcQueue::batch")
+{
+    MpmcQueue<uint32_t, 8> queue;
+    REQUIRE(queue.capacity() == 8);
+
+    uint32_t values[12];
+    for (uint32_t i = 0; i < 12; ++i)
+        values[i] = i;
+
+    REQUIRE(queue.try_push_batch(Span<uint32_t const>{values, 6}) == 6);
+    uint32_t popped[12]{};
+    REQUIRE(queue.try_pop_batch(Span<uint32_t>{popped, 4}) == 4);
+    for (uint32_t i = 0; i < 4; ++i)
+        REQUIRE(popped[i] == i);
+
+    // Only the free slots are filled, wrapping around the end
+    REQUIRE(queue.try_push_batch(Span<uint32_t const>{values + 6, 6}) == 6);
+    REQUIRE(queue.try_push_batch(Span<uint32_t const>{values, 1}) == 0);
+    REQUIRE(queue.size() == 8);
+
+    REQUIRE(queue.try_pop_batch(Span<uint32_t>{popped, 12}) == 8);
+    for (uint32_t i = 0; i < 8; ++i)
+        REQUIRE(popped[i] == i + 4);
+    REQUIRE(queue.try_pop_batch(Span<uint32_t>{popped, 12}) == 0);
+}
+
+TEST_CASE("MpmcQueue::dtors")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        MpmcQueue<DtorObj> queue{allocator, 4};
+        REQUIRE(queue.try_emplace(0u));
+        REQUIRE(queue.try_push(DtorObj{1}));
+        REQUIRE(queue.try_pop()->data == 0);
+
+        DtorObj const values[]{DtorObj{2}, DtorObj{3}, DtorObj{4}};
+        REQUIRE(queue.try_push_batch(Span<DtorObj const>{values, 3}) == 3);
+
+        DtorObj popped[2];
+        REQUIRE(queue.try_pop_batch(Span<DtorObj>{popped, 2}) == 2);
+        REQUIRE(popped[0].data == 1);
+        REQUIRE(popped[1].data == 2);
+        // The rest should be destroyed with the queue
+        REQUIRE(queue.size() == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("MpmcQueue::threads")
+{
+    CstdlibAllocator allocator;
+
+    MpmcQueue<uint32_t> queue{allocator, 64};
+
+    uint32_t const thread_count = 4;
+    uint32_t const per_thread_count = 20'000;
+    uint32_t const total_count = thread_count * per_thread_count;
+    std::atomic<uint32_t> popped_count{0};
+    Array<Array<uint32_t>> popped_values{allocator, thread_count};
+    for (uint32_t t = 0; t < thread_count; ++t)
+        popped_values.emplace_back(allocator, total_count);
+
+    {
+        Array<std::thread> threads{allocator, 2 * thread_count};
+        for (uint32_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back(
+                [&, t]()
+                {
+                    uint32_t next = t * per_thread_count;
+                    uint32_t const end = next + per_thread_count;
+                    uint32_t batch[8];
+                    while (next < end)
+                    {
+                        // Mix single and batch pushes
+                        if (next % 2 == 0)
+                        {
+                            if (queue.try_push(next))
+                                next++;
+                            continue;
+                        }
+                        uint32_t const batch_size =
+                            end - next < 8 ? end - next : 8;
+                        for (uint32_t i = 0; i < batch_size; ++i)
+                            batch[i] = next + i;
+                        next += (uint32_t)queue.try_push_batch(
+                            Span<uint32_t const>{batch, batch_size});
+                    }
+                });
+            threads.emplace_back(
+                [&, t]()
+                {
+                    Array<uint32_t> &popped = popped_values[t];
+                    uint32_t batch[8];
+                    while (popped_count.load() < total_count)
+                    {
+                        if (t % 2 == 0)
+                        {
+                            Optional<uint32_t> const value = queue.try_pop();
+                            if (value.has_value())
+                            {
+                                popped.push_back(*value);
+                                popped_count++;
+                            }
+                            continue;
+                        }
+                        size_t const count =
+                            queue.try_pop_batch(Span<uint32_t>{batch, 8});
+                        popped.extend(Span<uint32_t const>{batch, count});
+                        popped_count += (uint32_t)count;
+                    }
+                });
+        }
+        for (std::thread &t : threads)
+            t.join();
+    }
+
+    REQUIRE(popped_count == total_count);
+    REQUIRE(queue.empty());
+    // Each value should have been popped exactly once
+    Array<uint32_t> pop_counts{allocator, total_count};
+    pop_counts.resize(total_count, 0u);
+    for (Array<uint32_t> const &popped : popped_values)
+    {
+        for (uint32_t value : popped)
+            pop_counts[value]++;
+    }
+    uint32_t wrong_count = 0;
+    for (uint32_t count : pop_counts)
+    {
+        if (count != 1)
+            wrong_count++;
+    }
+    REQUIRE(wrong_count == 0);
+}
@@ -0,0 +1,208 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/node_hash_map.hpp>
+
+#include "common.hpp"
+
+#include <cstring>
+
+using namespace wheels;
+
+TEST_CASE("NodePool::allocate")
+{
+    CstdlibAllocator allocator;
+
+    NodePool<uint64_t> pool{allocator};
+    uint64_t *ptrs[100];
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        ptrs[i] = pool.allocate();
+        *ptrs[i] = i;
+    }
+    for (uint32_t i = 0; i < 100; ++i)
+        REQUIRE(*ptrs[i] == i);
+
+    // Freed storage is reused
+    pool.deallocate(ptrs[10]);
+    REQUIRE(pool.allocate() == ptrs[10]);
+
+    NodePool<uint64_t> pool_moved{WHEELS_MOV(pool)};
+    pool_moved.deallocate(ptrs[20]);
+    REQUIRE(pool_moved.allocate() == ptrs[20]);
+
+    pool_moved.reserve(1000);
+    uint64_t *reserved = pool_moved.allocate();
+    *reserved = 1;
+    REQUIRE(*ptrs[99] == 99);
+
+    pool_moved.release();
+    uint64_t *fresh = pool_moved.allocate();
+    *fresh = 2;
+    REQUIRE(*fresh == 2);
+}
+
+TEST_CASE("NodeHashMap::allocate_copy")
+{
+    CstdlibAllocator allocator;
+
+    { // Initial capacity should be allocated, potentially rounded up
+        size_t const cap = 8;
+        NodeHashMap<uint32_t, uint16_t> map{allocator, cap};
+        REQUIRE(map.empty());
+        REQUIRE(map.size() == 0);
+        REQUIRE(map.capacity() >= cap);
+    }
+
+    NodeHashMap<uint32_t, uint16_t> map{allocator};
+    REQUIRE(map.empty());
+    REQUIRE(map.capacity() == 0);
+    REQUIRE(map.find(0) == nullptr);
+    REQUIRE(map.begin() == map.end());
+
+    NodeHashMap<uint32_t, uint16_t> const &const_map = map;
+    REQUIRE(const_map.find(0) == nullptr);
+    REQUIRE(const_map.begin() == const_map.end());
+
+    map.insert_or_assign(10u, (uint16_t)11);
+    map.insert_or_assign(20u, (uint16_t)21);
+    map.insert_or_assign(30u, (uint16_t)31);
+    REQUIRE(!map.empty());
+    REQUIRE(map.size() == 3);
+
+    REQUIRE(map.contains(10));
+    REQUIRE(!map.contains(40));
+    REQUIRE(*map.find(10) == 11);
+    REQUIRE(*const_map.find(20) == 21);
+    REQUIRE(*map.find(30) == 31);
+
+    uint16_t const *value_ptr = map.find(20);
+    NodeHashMap<uint32_t, uint16_t> map_move_constructed{WHEELS_MOV(map)};
+    REQUIRE(map_move_constructed.find(20) == value_ptr);
+    REQUIRE(map_move_constructed.size() == 3);
+
+    NodeHashMap<uint32_t, uint16_t> map_move_assigned{allocator};
+    map_move_assigned = WHEELS_MOV(map_move_constructed);
+    map_move_assigned = WHEELS_MOV(map_move_assigned);
+    REQUIRE(map_move_assigned.find(20) == value_ptr);
+    REQUIRE(*map_move_assigned.find(10) == 11);
+    REQUIRE(*map_move_assigned.find(30) == 31);
+    REQUIRE(map_move_assigned.size() == 3);
+
+    uint32_t sum = 0;
+    for (auto kv : map_move_assigned)
+    {
+        *kv.second += 1;
+        sum += *kv.first;
+    }
+    REQUIRE(sum == 60);
+    REQUIRE(*map_move_assigned.find(10) == 12);
+}
+
+TEST_CASE("NodeHashMap::pointer_stability")
+{
+    CstdlibAllocator allocator;
+
+    NodeHashMap<uint32_t, uint32_t> map{allocator};
+    uint32_t *ptrs[1000];
+    for (uint32_t i = 0; i < 1000; ++i)
+        ptrs[i] = map.insert_or_assign(i, i + 1);
+    REQUIRE(map.size() == 1000);
+
+    // Pointers survive the grows, other removals and assigns
+    for (uint32_t i = 0; i < 1000; i += 2)
+        map.remove(i);
+    map.insert_or_assign(1u, 100u);
+    for (uint32_t i = 1000; i < 2000; ++i)
+        map.insert_or_assign(i, i + 1);
+    map.reserve(10000);
+    for (uint32_t i = 1; i < 1000; i += 2)
+    {
+        REQUIRE(map.find(i) == ptrs[i]);
+        REQUIRE(*ptrs[i] == (i == 1 ? 100 : i + 1));
+    }
+    for (uint32_t i = 0; i < 1000; i += 2)
+        REQUIRE(!map.contains(i));
+}
+
+TEST_CASE("NodeHashMap::dtors")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        NodeHashMap<DtorObj, DtorObj, DtorHash> map{allocator};
+        for (uint32_t i = 0; i < 100; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i + 1});
+        map.insert_or_assign(DtorObj{5}, DtorObj{50});
+        REQUIRE(map.size() == 100);
+        REQUIRE(map.find(DtorObj{5})->data == 50);
+
+        for (uint32_t i = 0; i < 50; ++i)
+            map.remove(DtorObj{i});
+        REQUIRE(map.size() == 50);
+
+        uint32_t visited = 0;
+        map.for_each(
+            [&](DtorObj const &key, DtorObj &value)
+            {
+                REQUIRE(value.data == key.data + 1);
+                visited++;
+            });
+        REQUIRE(visited == 50);
+
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE(
+            DtorObj::s_ctor_counter() ==
+            DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+
+        for (uint32_t i = 0; i < 10; ++i)
+            map.insert_or_assign(DtorObj{i}, DtorObj{i});
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("NodeHashMap::churn")
+{
+    CstdlibAllocator allocator;
+
+    // Removals interleaved with inserts leave Deleted slots in the table,
+    // which shouldn't make the map lose or duplicate keys
+    NodeHashMap<uint32_t, uint32_t> map{allocator};
+    // Keys missing from the map are marked with 0xFFFFFFFF
+    uint32_t reference[256];
+    memset(reference, 0xFF, sizeof(reference));
+    size_t reference_size = 0;
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        state = state * 1664525 + 1013904223;
+        uint32_t const key = (state >> 8) % 256;
+        if ((state >> 4) % 3 == 0)
+        {
+            map.remove(key);
+            if (reference[key] != 0xFFFF'FFFF)
+                reference_size--;
+            reference[key] = 0xFFFF'FFFF;
+        }
+        else
+        {
+            map.insert_or_assign(key, i);
+            if (reference[key] == 0xFFFF'FFFF)
+                reference_size++;
+            reference[key] = i;
+        }
+        REQUIRE(map.size() == reference_size);
+    }
+
+    size_t visited = 0;
+    for (auto const kv : map)
+    {
+        REQUIRE(reference[*kv.first] == *kv.second);
+        visited++;
+    }
+    REQUIRE(visited == reference_size);
+}
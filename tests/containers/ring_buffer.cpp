@@ -0,0 +1,209 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/ring_buffer.hpp>
+
+#include "common.hpp"
+
+using namespace wheels;
+
+TEST_CASE("RingBuffer::push_pop")
+{
+    CountingAllocator allocator{false};
+
+    RingBuffer<uint32_t> buffer{allocator};
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.size() == 0);
+    REQUIRE(buffer.capacity() == 0);
+    REQUIRE(buffer.begin() == buffer.end());
+    REQUIRE(allocator.allocation_count == 0);
+
+    buffer.push_back(2u);
+    buffer.push_back(3u);
+    buffer.push_front(1u);
+    buffer.emplace_front(0u);
+    buffer.emplace_back(4u);
+    REQUIRE(buffer.size() == 5);
+    REQUIRE(buffer.front() == 0);
+    REQUIRE(buffer.back() == 4);
+    for (uint32_t i = 0; i < 5; ++i)
+        REQUIRE(buffer[i] == i);
+
+    uint32_t expected = 0;
+    for (uint32_t v : buffer)
+        REQUIRE(v == expected++);
+    REQUIRE(expected == 5);
+
+    REQUIRE(buffer.pop_front() == 0);
+    REQUIRE(buffer.pop_back() == 4);
+    REQUIRE(buffer.size() == 3);
+    REQUIRE(buffer.front() == 1);
+    REQUIRE(buffer.back() == 3);
+
+    buffer.clear();
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.capacity() > 0);
+}
+
+TEST_CASE("RingBuffer::wrap_grow")
+{
+    CountingAllocator allocator{false};
+
+    RingBuffer<uint32_t> buffer{allocator, 4};
+    REQUIRE(buffer.capacity() == 4);
+    REQUIRE(allocator.allocation_count == 1);
+
+    // Walk the values around the end of the storage a few times
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    for (uint32_t i = 0; i < 3; ++i)
+        buffer.push_back(next_push++);
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        buffer.push_back(next_push++);
+        REQUIRE(buffer.pop_front() == next_pop++);
+    }
+    REQUIRE(buffer.capacity() == 4);
+    REQUIRE(allocator.allocation_count == 1);
+
+    // Growing a wrapped buffer should keep the order
+    for (uint32_t i = 0; i < 5; ++i)
+        buffer.push_back(next_push++);
+    REQUIRE(buffer.size() == 8);
+    REQUIRE(buffer.capacity() == 8);
+    REQUIRE(allocator.allocation_count == 2);
+    for (uint32_t i = 0; i < 8; ++i)
+        REQUIRE(buffer[i] == next_pop + i);
+
+    // Push front should wrap backwards from the start of the storage
+    RingBuffer<uint32_t> front_buffer{allocator, 4};
+    front_buffer.push_front(1u);
+    front_buffer.push_back(2u);
+    front_buffer.push_front(0u);
+    REQUIRE(front_buffer[0] == 0);
+    REQUIRE(front_buffer[1] == 1);
+    REQUIRE(front_buffer[2] == 2);
+}
+
+TEST_CASE("RingBuffer::spans")
+{
+    CstdlibAllocator allocator;
+
+    RingBuffer<uint32_t> buffer{allocator, 8};
+    {
+        Pair<Span<uint32_t const>, Span<uint32_t const>> const spans =
+            buffer.spans();
+        REQUIRE(spans.first.empty());
+        REQUIRE(spans.second.empty());
+    }
+
+    for (uint32_t i = 0; i < 6; ++i)
+        buffer.push_back(i);
+    buffer.drop_front(4);
+    REQUIRE(buffer.size() == 2);
+    REQUIRE(buffer.front() == 4);
+
+    uint32_t const values[]{6, 7, 8, 9, 10};
+    buffer.extend(Span<uint32_t const>{values, 5});
+    REQUIRE(buffer.size() == 7);
+    REQUIRE(buffer.capacity() == 8);
+
+    {
+        Pair<Span<uint32_t const>, Span<uint32_t const>> const spans =
+            buffer.spans();
+        REQUIRE(spans.first.size() == 4);
+        REQUIRE(spans.second.size() == 3);
+        for (uint32_t i = 0; i < 4; ++i)
+            REQUIRE(spans.first[i] == 4 + i);
+        for (uint32_t i = 0; i < 3; ++i)
+            REQUIRE(spans.second[i] == 8 + i);
+    }
+
+    {
+        Pair<Span<uint32_t>, Span<uint32_t>> spans = buffer.mut_spans();
+        spans.second[0] = 80;
+        REQUIRE(buffer[4] == 80);
+    }
+
+    uint32_t popped[5]{};
+    buffer.pop_front_into(Span<uint32_t>{popped, 5});
+    uint32_t const expected[]{4, 5, 6, 7, 80};
+    for (uint32_t i = 0; i < 5; ++i)
+        REQUIRE(popped[i] == expected[i]);
+    REQUIRE(buffer.size() == 2);
+    REQUIRE(buffer.front() == 9);
+    REQUIRE(buffer.back() == 10);
+
+    // Bulk pushes that don't fit should grow and unwrap
+    uint32_t const more_values[10]{};
+    buffer.extend(Span<uint32_t const>{more_values, 10});
+    REQUIRE(buffer.size() == 12);
+    REQUIRE(buffer.spans().second.empty());
+    REQUIRE(buffer[0] == 9);
+    REQUIRE(buffer[1] == 10);
+    REQUIRE(buffer[11] == 0);
+}
+
+TEST_CASE("RingBuffer::move")
+{
+    CountingAllocator allocator{false};
+
+    RingBuffer<uint32_t> buffer{allocator};
+    for (uint32_t i = 0; i < 5; ++i)
+        buffer.push_back(i);
+    REQUIRE(allocator.allocation_count == 2);
+
+    RingBuffer<uint32_t> buffer_move_constructed{WHEELS_MOV(buffer)};
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer_move_constructed.size() == 5);
+    REQUIRE(buffer_move_constructed[4] == 4);
+
+    RingBuffer<uint32_t> buffer_move_assigned{allocator};
+    buffer_move_assigned.push_back(1u);
+    buffer_move_assigned = WHEELS_MOV(buffer_move_constructed);
+    buffer_move_assigned = WHEELS_MOV(buffer_move_assigned);
+    REQUIRE(buffer_move_assigned.size() == 5);
+    for (uint32_t i = 0; i < 5; ++i)
+        REQUIRE(buffer_move_assigned[i] == i);
+    REQUIRE(allocator.allocation_count == 3);
+}
+
+TEST_CASE("RingBuffer::dtors")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        RingBuffer<DtorObj> buffer{allocator, 4};
+        for (uint32_t i = 0; i < 3; ++i)
+            buffer.emplace_back(i);
+        REQUIRE(buffer.pop_front().data == 0);
+        REQUIRE(buffer.pop_front().data == 1);
+        for (uint32_t i = 3; i < 6; ++i)
+            buffer.emplace_back(i);
+        // Grows while wrapped
+        buffer.emplace_front(1u);
+        buffer.push_back(DtorObj{6});
+        REQUIRE(buffer.size() == 6);
+        for (uint32_t i = 0; i < 6; ++i)
+            REQUIRE(buffer[i].data == i + 1);
+
+        DtorObj const values[]{DtorObj{7}, DtorObj{8}};
+        buffer.extend(Span<DtorObj const>{values, 2});
+        REQUIRE(buffer.pop_back().data == 8);
+
+        DtorObj popped[3];
+        buffer.pop_front_into(Span<DtorObj>{popped, 3});
+        REQUIRE(popped[0].data == 1);
+        REQUIRE(popped[2].data == 3);
+        buffer.drop_front(2);
+        REQUIRE(buffer.size() == 2);
+        REQUIRE(buffer.front().data == 6);
+
+        RingBuffer<DtorObj> moved_buffer{WHEELS_MOV(buffer)};
+        REQUIRE(moved_buffer.back().data == 7);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
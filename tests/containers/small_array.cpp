@@ -0,0 +1,312 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/small_array.hpp>
+
+#include "common.hpp"
+
+using namespace wheels;
+
+namespace
+{
+
+template <size_t N>
+SmallArray<DtorObj, N> init_test_arr_dtor(Allocator &allocator, size_t size)
+{
+    SmallArray<DtorObj, N> arr{allocator};
+    for (uint32_t i = 0; i < size; ++i)
+        arr.emplace_back(10 * (i + 1));
+
+    return arr;
+}
+
+} // namespace
+
+TEST_CASE("SmallArray::allocate_copy")
+{
+    CountingAllocator allocator{true};
+
+    {
+        SmallArray<uint32_t, 4> arr{allocator};
+        REQUIRE(arr.empty());
+        REQUIRE(arr.size() == 0);
+        REQUIRE(arr.capacity() == 4);
+        REQUIRE(arr.is_inline());
+        REQUIRE(arr.begin() == arr.end());
+    }
+    REQUIRE(allocator.allocation_count == 0);
+
+    { // Initial capacity over N should spill right away
+        SmallArray<uint32_t, 4> arr{allocator, 10};
+        REQUIRE(arr.capacity() == 10);
+        REQUIRE(!arr.is_inline());
+        REQUIRE(allocator.allocation_count == 1);
+    }
+
+    SmallArray<uint32_t, 4> arr{allocator};
+    arr.push_back(10u);
+    arr.push_back(20u);
+    arr.push_back(30u);
+    REQUIRE(arr.size() == 3);
+    REQUIRE(arr.is_inline());
+
+    { // Inline values should be moved over
+        SmallArray<uint32_t, 4> arr_move_constructed{WHEELS_MOV(arr)};
+        REQUIRE(arr_move_constructed.is_inline());
+        REQUIRE(arr_move_constructed.size() == 3);
+        REQUIRE(arr_move_constructed[0] == 10);
+        REQUIRE(arr_move_constructed[1] == 20);
+        REQUIRE(arr_move_constructed[2] == 30);
+        REQUIRE(arr.empty());
+        REQUIRE(arr.is_inline());
+
+        SmallArray<uint32_t, 4> arr_move_assigned{allocator};
+        arr_move_assigned.push_back(1u);
+        arr_move_assigned = WHEELS_MOV(arr_move_constructed);
+        arr_move_assigned = WHEELS_MOV(arr_move_assigned);
+        REQUIRE(arr_move_assigned.size() == 3);
+        REQUIRE(arr_move_assigned[0] == 10);
+        REQUIRE(arr_move_assigned[2] == 30);
+    }
+
+    { // Spilled allocations should be handed over
+        for (uint32_t i = 0; i < 10; ++i)
+            arr.push_back(i);
+        REQUIRE(!arr.is_inline());
+        uint32_t const *data = arr.data();
+        size_t const allocation_count = allocator.allocation_count;
+
+        SmallArray<uint32_t, 4> arr_move_constructed{WHEELS_MOV(arr)};
+        REQUIRE(arr_move_constructed.data() == data);
+        REQUIRE(arr_move_constructed.size() == 10);
+        REQUIRE(arr.empty());
+        REQUIRE(arr.is_inline());
+        REQUIRE(arr.capacity() == 4);
+
+        SmallArray<uint32_t, 4> arr_move_assigned{allocator, 8};
+        arr_move_assigned = WHEELS_MOV(arr_move_constructed);
+        REQUIRE(arr_move_assigned.data() == data);
+        REQUIRE(arr_move_assigned.size() == 10);
+        for (uint32_t i = 0; i < 10; ++i)
+            REQUIRE(arr_move_assigned[i] == i);
+        REQUIRE(allocator.allocation_count == allocation_count + 1);
+    }
+}
+
+TEST_CASE("SmallArray::spill")
+{
+    CountingAllocator allocator{false};
+
+    SmallArray<uint32_t, 8> arr{allocator};
+    for (uint32_t i = 0; i < 8; ++i)
+        arr.push_back(i);
+    REQUIRE(arr.is_inline());
+    REQUIRE(allocator.allocation_count == 0);
+
+    arr.push_back(8u);
+    REQUIRE(!arr.is_inline());
+    REQUIRE(arr.capacity() == 16);
+    REQUIRE(allocator.allocation_count == 1);
+    for (uint32_t i = 0; i < 9; ++i)
+        REQUIRE(arr[i] == i);
+
+    uint32_t const values[20]{};
+    arr.extend(Span<uint32_t const>{values, 20});
+    REQUIRE(arr.size() == 29);
+    REQUIRE(arr.capacity() == 32);
+    for (uint32_t i = 0; i < 9; ++i)
+        REQUIRE(arr[i] == i);
+    for (uint32_t i = 9; i < 29; ++i)
+        REQUIRE(arr[i] == 0);
+
+    // Clearing keeps the allocation
+    arr.clear();
+    REQUIRE(!arr.is_inline());
+    REQUIRE(arr.capacity() == 32);
+}
+
+TEST_CASE("SmallArray::dtors")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        SmallArray<DtorObj, 4> arr = init_test_arr_dtor<4>(allocator, 3);
+        REQUIRE(arr.is_inline());
+        REQUIRE(DtorObj::s_value_ctor_counter() == 3);
+
+        for (uint32_t i = 3; i < 10; ++i)
+            arr.emplace_back(10 * (i + 1));
+        REQUIRE(!arr.is_inline());
+        for (uint32_t i = 0; i < 10; ++i)
+            REQUIRE(arr[i].data == 10 * (i + 1));
+
+        SmallArray<DtorObj, 4> inline_arr =
+            init_test_arr_dtor<4>(allocator, 2);
+        SmallArray<DtorObj, 4> moved_arr{WHEELS_MOV(inline_arr)};
+        REQUIRE(moved_arr.size() == 2);
+        REQUIRE(moved_arr[1].data == 20);
+
+        moved_arr = WHEELS_MOV(arr);
+        REQUIRE(moved_arr.size() == 10);
+
+        DtorObj const popped = moved_arr.pop_back();
+        REQUIRE(popped.data == 100);
+        moved_arr.resize(5);
+        REQUIRE(moved_arr.size() == 5);
+        moved_arr.resize(7, DtorObj{1});
+        REQUIRE(moved_arr[6].data == 1);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("SmallArray::erase")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        SmallArray<DtorObj, 4> arr = init_test_arr_dtor<4>(allocator, 6);
+
+        arr.erase(1);
+        REQUIRE(arr.size() == 5);
+        REQUIRE(arr[0].data == 10);
+        REQUIRE(arr[1].data == 30);
+        REQUIRE(arr[4].data == 60);
+
+        arr.erase_swap_last(0);
+        REQUIRE(arr.size() == 4);
+        REQUIRE(arr[0].data == 60);
+        REQUIRE(arr[1].data == 30);
+
+        arr.erase_swap_last(3);
+        REQUIRE(arr.size() == 3);
+        REQUIRE(arr.back().data == 40);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+
+    SmallArray<uint32_t, 4> arr{allocator};
+    for (uint32_t i = 0; i < 6; ++i)
+        arr.push_back(i);
+    arr.erase(0);
+    REQUIRE(arr.size() == 5);
+    for (uint32_t i = 0; i < 5; ++i)
+        REQUIRE(arr[i] == i + 1);
+    arr.erase(4);
+    REQUIRE(arr.size() == 4);
+    REQUIRE(arr.back() == 4);
+}
+
+TEST_CASE("SmallArray::insert_erase_if")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        SmallArray<DtorObj, 4> arr = init_test_arr_dtor<4>(allocator, 3);
+        DtorObj const values[]{DtorObj{1}, DtorObj{2}, DtorObj{3}};
+        // Spills in the middle of the insert
+        arr.insert(1, Span<DtorObj const>{values, 3});
+        REQUIRE(!arr.is_inline());
+        uint32_t const expected0[]{10, 1, 2, 3, 20, 30};
+        REQUIRE(arr.size() == 6);
+        for (size_t i = 0; i < 6; ++i)
+            REQUIRE(arr[i].data == expected0[i]);
+
+        arr.erase(2, 4);
+        size_t const erased_count =
+            arr.erase_if([](DtorObj const &v) { return v.data == 1; });
+        REQUIRE(erased_count == 1);
+        size_t const retain_erased_count =
+            arr.retain([](DtorObj const &v) { return v.data > 10; });
+        REQUIRE(retain_erased_count == 1);
+        uint32_t const expected1[]{20, 30};
+        REQUIRE(arr.size() == 2);
+        for (size_t i = 0; i < 2; ++i)
+            REQUIRE(arr[i].data == expected1[i]);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("SmallArray::shrink_to_fit")
+{
+    CountingAllocator allocator{false};
+
+    init_dtor_counters();
+    {
+        SmallArray<DtorObj, 4> arr = init_test_arr_dtor<4>(allocator, 10);
+        REQUIRE(!arr.is_inline());
+
+        arr.resize(6);
+        arr.shrink_to_fit();
+        REQUIRE(!arr.is_inline());
+        REQUIRE(arr.capacity() == 6);
+
+        // Values that fit should go back inline
+        arr.resize(3);
+        arr.shrink_to_fit();
+        REQUIRE(arr.is_inline());
+        REQUIRE(arr.capacity() == 4);
+        for (uint32_t i = 0; i < 3; ++i)
+            REQUIRE(arr[i].data == 10 * (i + 1));
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("SmallArray::append_uninitialized")
+{
+    CountingAllocator allocator{false};
+
+    SmallArray<uint32_t, 4> arr{allocator};
+    Span<uint32_t> span = arr.append_uninitialized(3);
+    REQUIRE(arr.is_inline());
+    for (uint32_t i = 0; i < 3; ++i)
+        span[i] = i;
+
+    // Spills in the middle of the append
+    span = arr.append_uninitialized(3);
+    REQUIRE(!arr.is_inline());
+    REQUIRE(span.data() == arr.data() + 3);
+    for (uint32_t i = 0; i < 3; ++i)
+        span[i] = i + 3;
+
+    arr.resize_uninitialized(8);
+    REQUIRE(arr.size() == 8);
+    arr.resize_uninitialized(2);
+    REQUIRE(arr.size() == 2);
+    arr.resize_uninitialized(6);
+    for (uint32_t i = 0; i < 6; ++i)
+        REQUIRE(arr[i] == i);
+}
+
+TEST_CASE("SmallArray::span_conversion")
+{
+    CstdlibAllocator allocator;
+
+    SmallArray<uint32_t, 2> arr{allocator};
+    for (uint32_t i = 0; i < 5; ++i)
+        arr.push_back(i);
+
+    Span<uint32_t const> const span = arr;
+    REQUIRE(span.data() == arr.data());
+    REQUIRE(span.size() == 5);
+
+    Span<uint32_t> mut_span = arr.mut_span(1, 3);
+    REQUIRE(mut_span.size() == 2);
+    mut_span[0] = 10;
+    REQUIRE(arr[1] == 10);
+    REQUIRE(arr.span(3, 5)[1] == 4);
+
+    uint32_t sum = 0;
+    for (uint32_t v : arr)
+        sum += v;
+    REQUIRE(sum == 0 + 10 + 2 + 3 + 4);
+}
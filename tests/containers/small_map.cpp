@@ -33,6 +33,29 @@ SmallMap<DtorObj, DtorObj, N> init_test_small_map_dtor(size_t initial_size)
     return map;
 }
 
+template <typename K, typename V> void test_search_every_position()
+{
+    // Hits at every position catch off-by-ones both in the SIMD blocks and the
+    // scalar tail
+    for (uint32_t size = 0; size <= 37; ++size)
+    {
+        SmallMap<K, V, 37> map;
+        for (uint32_t i = 0; i < size; ++i)
+            // Values that equal the keys shouldn't be matched
+            map.insert_or_assign((K)(2 * i + 1), (V)(2 * i + 2));
+        REQUIRE(map.size() == size);
+
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            V const *value = map.find((K)(2 * i + 1));
+            REQUIRE(value != nullptr);
+            REQUIRE(*value == (V)(2 * i + 2));
+            REQUIRE(!map.contains((K)(2 * i + 2)));
+        }
+        REQUIRE(!map.contains((K)0));
+    }
+}
+
 } // namespace
 
 TEST_CASE("SmallMap::allocate_copy")
@@ -86,6 +109,21 @@ TEST_CASE("SmallMap::allocate_copy")
     REQUIRE(map_move_assigned.size() == 3);
 }
 
+TEST_CASE("SmallMap::trivially_copyable")
+{
+    static_assert(std::is_trivially_copyable_v<SmallMap<uint32_t, float, 4>>);
+    static_assert(!std::is_trivially_copyable_v<SmallMap<DtorObj, float, 4>>);
+    static_assert(
+        !std::is_trivially_copyable_v<SmallMap<uint32_t, DtorObj, 4>>);
+
+    SmallMap<uint32_t, uint32_t, 4> const map = init_test_small_map_u32<4>(3);
+    SmallMap<uint32_t, uint32_t, 4> map_copy;
+    memcpy(&map_copy, &map, sizeof(map));
+    REQUIRE(map_copy.size() == 3);
+    for (uint32_t i = 0; i < 3; ++i)
+        REQUIRE(*map_copy.find(10 * (i + 1)) == 10 * (i + 1) + 1);
+}
+
 TEST_CASE("SmallMap::insert_lvalue")
 {
     init_dtor_counters();
@@ -154,6 +192,75 @@ TEST_CASE("SmallMap::remove")
     REQUIRE(map.contains(30));
 }
 
+TEST_CASE("SmallMap::simd_search")
+{
+    test_search_every_position<uint8_t, uint8_t>();
+    test_search_every_position<uint16_t, uint16_t>();
+    test_search_every_position<uint16_t, uint8_t>();
+    test_search_every_position<uint32_t, uint32_t>();
+    test_search_every_position<uint32_t, uint16_t>();
+    // Pairs that are too large for the SIMD search
+    test_search_every_position<uint64_t, uint64_t>();
+    test_search_every_position<uint32_t, DtorObj>();
+}
+
+TEST_CASE("SmallMap::sorted")
+{
+    SmallMap<uint32_t, uint32_t, 64, SmallStorage::Sorted> map;
+    // Insert in a scrambled order
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        uint32_t const key = (i * 37) % 64;
+        map.insert_or_assign(key, key + 1);
+    }
+    map.insert_or_assign(5u, 100u);
+    REQUIRE(map.size() == 64);
+
+    uint32_t expected = 0;
+    for (auto const &kv : map)
+        REQUIRE(kv.first == expected++);
+    for (uint32_t i = 0; i < 64; ++i)
+        REQUIRE(*map.find(i) == (i == 5 ? 100 : i + 1));
+    REQUIRE(map.find(64) == nullptr);
+
+    map.remove(0u);
+    map.remove(31u);
+    map.remove(63u);
+    map.remove(100u);
+    REQUIRE(map.size() == 61);
+    REQUIRE(!map.contains(0));
+    REQUIRE(!map.contains(31));
+    REQUIRE(!map.contains(63));
+    uint32_t prev = 0;
+    for (auto const &kv : map)
+    {
+        REQUIRE(kv.first > prev);
+        REQUIRE(kv.second == (kv.first == 5 ? 100 : kv.first + 1));
+        prev = kv.first;
+    }
+
+    // The inserted value can be one of the pairs that get shifted
+    map.insert_or_assign(0u, *map.find(2u));
+    REQUIRE(*map.find(0) == 3);
+    REQUIRE(*map.find(2) == 3);
+
+    init_dtor_counters();
+    {
+        SmallMap<DtorObj, DtorObj, 8, SmallStorage::Sorted> dtor_map;
+        for (uint32_t i = 8; i > 0; --i)
+            dtor_map.insert_or_assign(DtorObj{i}, DtorObj{10 * i});
+        dtor_map.remove(DtorObj{4});
+        REQUIRE(dtor_map.size() == 7);
+        REQUIRE(dtor_map.begin()->first.data == 1);
+        REQUIRE((dtor_map.end() - 1)->second.data == 80);
+        REQUIRE(dtor_map.find(DtorObj{5})->data == 50);
+        REQUIRE(!dtor_map.contains(DtorObj{4}));
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
 TEST_CASE("SmallMap::range_for")
 {
     SmallMap<uint32_t, uint32_t, 5> map;
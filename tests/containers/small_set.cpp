@@ -33,6 +33,26 @@ SmallSet<DtorObj, N> init_test_small_set_dtor(size_t initial_size)
     return set;
 }
 
+template <typename T> void test_search_every_position()
+{
+    // Hits at every position catch off-by-ones both in the SIMD blocks and the
+    // scalar tail
+    for (uint32_t size = 0; size <= 67; ++size)
+    {
+        SmallSet<T, 67> set;
+        for (uint32_t i = 0; i < size; ++i)
+            set.insert((T)(2 * i + 1));
+        REQUIRE(set.size() == size);
+
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            REQUIRE(set.contains((T)(2 * i + 1)));
+            REQUIRE(!set.contains((T)(2 * i + 2)));
+        }
+        REQUIRE(!set.contains((T)0));
+    }
+}
+
 } // namespace
 
 TEST_CASE("SmallSet::allocate_copy")
@@ -86,6 +106,21 @@ TEST_CASE("SmallSet::allocate_copy")
     REQUIRE(set_move_assigned.capacity() == 4);
 }
 
+TEST_CASE("SmallSet::trivially_copyable")
+{
+    static_assert(std::is_trivially_copyable_v<SmallSet<uint32_t, 4>>);
+    static_assert(!std::is_trivially_copyable_v<SmallSet<DtorObj, 4>>);
+
+    SmallSet<uint32_t, 4> set;
+    set.insert(10u);
+    set.insert(20u);
+    SmallSet<uint32_t, 4> set_copy;
+    memcpy(&set_copy, &set, sizeof(set));
+    REQUIRE(set_copy.size() == 2);
+    REQUIRE(set_copy.contains(10));
+    REQUIRE(set_copy.contains(20));
+}
+
 TEST_CASE("SmallSet::insert_lvalue")
 {
     init_dtor_counters();
@@ -151,6 +186,86 @@ TEST_CASE("SmallSet::remove")
     REQUIRE(set.contains(30));
 }
 
+TEST_CASE("SmallSet::simd_search")
+{
+    test_search_every_position<uint8_t>();
+    test_search_every_position<uint16_t>();
+    test_search_every_position<uint32_t>();
+    test_search_every_position<uint64_t>();
+    test_search_every_position<int32_t>();
+
+    { // Partial matches within a key shouldn't count
+        SmallSet<uint32_t, 16> set;
+        for (uint32_t i = 0; i < 16; ++i)
+            set.insert(0xABAB'0000 | i);
+        REQUIRE(!set.contains(0xABAB'ABAB));
+        REQUIRE(!set.contains(0x0000'0001));
+        REQUIRE(set.contains(0xABAB'000F));
+    }
+
+    { // Pointers
+        uint32_t values[20]{};
+        SmallSet<uint32_t *, 20> set;
+        for (uint32_t i = 0; i < 20; i += 2)
+            set.insert(&values[i]);
+        for (uint32_t i = 0; i < 20; ++i)
+            REQUIRE(set.contains(&values[i]) == (i % 2 == 0));
+
+        set.remove(&values[0]);
+        REQUIRE(!set.contains(&values[0]));
+        REQUIRE(set.contains(&values[18]));
+        REQUIRE(set.size() == 9);
+    }
+}
+
+TEST_CASE("SmallSet::sorted")
+{
+    SmallSet<uint32_t, 64, SmallStorage::Sorted> set;
+    // Insert in a scrambled order
+    for (uint32_t i = 0; i < 64; ++i)
+        set.insert((i * 37) % 64);
+    set.insert(5u);
+    REQUIRE(set.size() == 64);
+
+    uint32_t expected = 0;
+    for (uint32_t v : set)
+        REQUIRE(v == expected++);
+    for (uint32_t i = 0; i < 64; ++i)
+        REQUIRE(set.contains(i));
+    REQUIRE(!set.contains(64));
+
+    set.remove(0u);
+    set.remove(31u);
+    set.remove(63u);
+    set.remove(100u);
+    REQUIRE(set.size() == 61);
+    REQUIRE(!set.contains(0));
+    REQUIRE(!set.contains(31));
+    REQUIRE(!set.contains(63));
+    uint32_t prev = 0;
+    for (uint32_t v : set)
+    {
+        REQUIRE(v > prev);
+        prev = v;
+    }
+
+    init_dtor_counters();
+    {
+        SmallSet<DtorObj, 8, SmallStorage::Sorted> dtor_set;
+        for (uint32_t i = 8; i > 0; --i)
+            dtor_set.insert(DtorObj{i});
+        dtor_set.remove(DtorObj{4});
+        REQUIRE(dtor_set.size() == 7);
+        REQUIRE(dtor_set.begin()->data == 1);
+        REQUIRE((dtor_set.end() - 1)->data == 8);
+        REQUIRE(dtor_set.contains(DtorObj{5}));
+        REQUIRE(!dtor_set.contains(DtorObj{4}));
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
 TEST_CASE("SmallSet::range_for")
 {
     SmallSet<uint32_t, 5> set;
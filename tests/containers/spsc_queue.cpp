@@ -0,0 +1,156 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <wheels/allocators/cstdlib_allocator.hpp>
+#include <wheels/containers/spsc_queue.hpp>
+
+#include "common.hpp"
+
+#include <thread>
+
+using namespace wheels;
+
+TEST_CASE("SpscQueue::push_pop")
+{
+    CountingAllocator allocator{false};
+
+    // Rounded up to a power of two
+    SpscQueue<uint32_t> queue{allocator, 3};
+    REQUIRE(queue.capacity() == 4);
+    REQUIRE(queue.empty());
+    REQUIRE(allocator.allocation_count == 1);
+    REQUIRE(!queue.try_pop().has_value());
+
+    // Walk the values around the end of the storage a few times
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        while (queue.try_push(next_push))
+            next_push++;
+        REQUIRE(queue.size() == 4);
+
+        Optional<uint32_t> value = queue.try_pop();
+        REQUIRE(value.has_value());
+        REQUIRE(*value == next_pop++);
+        value = queue.try_pop();
+        REQUIRE(*value == next_pop++);
+        REQUIRE(queue.size() == 2);
+    }
+
+    REQUIRE(queue.try_emplace(next_push++));
+    for (Optional<uint32_t> value = queue.try_pop(); value.has_value();
+         value = queue.try_pop())
+        REQUIRE(*value == next_pop++);
+    REQUIRE(next_pop == next_push);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("SpscQueue::batch")
+{
+    SpscQueue<uint32_t, 8> queue;
+    REQUIRE(queue.capacity() == 8);
+
+    uint32_t values[12];
+    for (uint32_t i = 0; i < 12; ++i)
+        values[i] = i;
+
+    REQUIRE(queue.try_push_batch(Span<uint32_t const>{values, 6}) == 6);
+    uint32_t popped[12]{};
+    REQUIRE(queue.try_pop_batch(Span<uint32_t>{popped, 4}) == 4);
+    for (uint32_t i = 0; i < 4; ++i)
+        REQUIRE(popped[i] == i);
+
+    // Only the free slots are filled, wrapping around the end
+    REQUIRE(queue.try_push_batch(Span<uint32_t const>{values + 6, 6}) == 6);
+    REQUIRE(queue.try_push_batch(Span<uint32_t const>{values, 1}) == 0);
+    REQUIRE(queue.size() == 8);
+
+    REQUIRE(queue.try_pop_batch(Span<uint32_t>{popped, 12}) == 8);
+    for (uint32_t i = 0; i < 8; ++i)
+        REQUIRE(popped[i] == i + 4);
+    REQUIRE(queue.try_pop_batch(Span<uint32_t>{popped, 12}) == 0);
+}
+
+TEST_CASE("SpscQueue::dtors")
+{
+    CstdlibAllocator allocator;
+
+    init_dtor_counters();
+    {
+        SpscQueue<DtorObj> queue{allocator, 4};
+        REQUIRE(queue.try_emplace(0u));
+        REQUIRE(queue.try_push(DtorObj{1}));
+        REQUIRE(queue.try_pop()->data == 0);
+
+        DtorObj const values[]{DtorObj{2}, DtorObj{3}, DtorObj{4}};
+        REQUIRE(queue.try_push_batch(Span<DtorObj const>{values, 3}) == 3);
+
+        DtorObj popped[2];
+        REQUIRE(queue.try_pop_batch(Span<DtorObj>{popped, 2}) == 2);
+        REQUIRE(popped[0].data == 1);
+        REQUIRE(popped[1].data == 2);
+        // The rest should be destroyed with the queue
+        REQUIRE(queue.size() == 2);
+    }
+    REQUIRE(
+        DtorObj::s_ctor_counter() ==
+        DtorObj::s_dtor_counter() + DtorObj::s_moved_from_dtor_counter());
+}
+
+TEST_CASE("SpscQueue::threads")
+{
+    SpscQueue<uint32_t, 64> queue;
+
+    uint32_t const count = 100'000;
+    uint32_t out_of_order_count = 0;
+
+    std::thread consumer{
+        [&]()
+        {
+            uint32_t expected = 0;
+            uint32_t batch[16];
+            while (expected < count)
+            {
+                // Mix single and batch pops
+                if (expected % 2 == 0)
+                {
+                    Optional<uint32_t> const value = queue.try_pop();
+                    if (value.has_value() && *value != expected++)
+                        out_of_order_count++;
+                }
+                else
+                {
+                    size_t const popped =
+                        queue.try_pop_batch(Span<uint32_t>{batch, 16});
+                    for (size_t i = 0; i < popped; ++i)
+                    {
+                        if (batch[i] != expected++)
+                            out_of_order_count++;
+                    }
+                }
+            }
+        }};
+
+    uint32_t next = 0;
+    uint32_t batch[8];
+    while (next < count)
+    {
+        if (next % 3 == 0)
+        {
+            if (queue.try_push(next))
+                next++;
+        }
+        else
+        {
+            uint32_t batch_size = count - next < 8 ? count - next : 8;
+            for (uint32_t i = 0; i < batch_size; ++i)
+                batch[i] = next + i;
+            next += (uint32_t)queue.try_push_batch(
+                Span<uint32_t const>{batch, batch_size});
+        }
+    }
+    consumer.join();
+
+    REQUIRE(out_of_order_count == 0);
+    REQUIRE(queue.empty());
+}
@@ -380,6 +380,74 @@ TEST_CASE("Resize", "[String]")
     }
 }
 
+TEST_CASE("Resize uninitialized", "[String]")
+{
+    CstdlibAllocator allocator;
+
+    {
+        String str{allocator, "test"};
+        str.resize_uninitialized(8);
+        REQUIRE(str.size() == 8);
+        REQUIRE(str.capacity() >= 8);
+        REQUIRE(str.c_str()[8] == '\0');
+        memcpy(str.data() + 4, "ing!", 4);
+        REQUIRE(str == "testing!");
+
+        str.resize_uninitialized(4);
+        REQUIRE(str.size() == 4);
+        REQUIRE(str == "test");
+        REQUIRE(str.c_str()[4] == '\0');
+    }
+
+    {
+        String str{allocator, "test"};
+        Span<char> span = str.append_uninitialized(3);
+        REQUIRE(span.size() == 3);
+        REQUIRE(span.data() == str.data() + 4);
+        REQUIRE(str.size() == 7);
+        REQUIRE(str.c_str()[7] == '\0');
+        span[0] = 'i';
+        span[1] = 'n';
+        span[2] = 'g';
+        REQUIRE(str == "testing");
+
+        // Repeated appends should grow geometrically
+        size_t const capacity = str.capacity();
+        span = str.append_uninitialized(capacity - str.size() + 1);
+        REQUIRE(str.capacity() >= capacity * 2);
+        REQUIRE(str.size() == capacity + 1);
+        REQUIRE(str.c_str()[capacity + 1] == '\0');
+    }
+}
+
+TEST_CASE("Reallocate", "[String]")
+{
+    { // Growth should go through reallocate when it's supported
+        CountingAllocator allocator{true};
+        String str{allocator};
+        for (size_t i = 0; i < 100; ++i)
+            str.push_back((char)('a' + i % 26));
+        REQUIRE(allocator.allocation_count == 1);
+        REQUIRE(allocator.reallocation_count > 0);
+        REQUIRE(str.size() == 100);
+        for (size_t i = 0; i < 100; ++i)
+            REQUIRE(str[i] == (char)('a' + i % 26));
+        REQUIRE(str.c_str()[100] == '\0');
+    }
+
+    { // And fall back to a new allocation when it isn't
+        CountingAllocator allocator{false};
+        String str{allocator};
+        for (size_t i = 0; i < 100; ++i)
+            str.push_back((char)('a' + i % 26));
+        REQUIRE(allocator.allocation_count > 1);
+        REQUIRE(allocator.reallocation_count == 0);
+        for (size_t i = 0; i < 100; ++i)
+            REQUIRE(str[i] == (char)('a' + i % 26));
+        REQUIRE(str.c_str()[100] == '\0');
+    }
+}
+
 TEST_CASE("Extend", "[String]")
 {
     CstdlibAllocator allocator;